@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "allocationCounter.hpp"
+#include "arena.hpp"
+#include "ast.hpp"
+#include "corpus.hpp"
+#include "error.hpp"
+#include "interpreter.hpp"
+#include "optimizer.hpp"
+#include "outputStream.hpp"
+#include "tokenizer.hpp"
+#include "vm.hpp"
+
+// Runs every program of the corpus through the Tokenizer, the Parser and an engine, and reports for
+// each phase how long it took, how many heap allocations it made and how much heap it needed at once
+//
+// BrainBench [--iterations N] [--engine interpreter|vm] [--json] [program...]
+//
+// --json prints one JSON document to stdout so results can be kept and compared between commits
+//
+// Heap use comes from allocationCounter, so this is built with ALLOCATION_TRACKING
+// The Arena gets its chunks from malloc, so the AST is measured through the arena's own counters instead
+
+//================================================================================================
+// Measurements
+//================================================================================================
+
+// What one phase of one run cost
+struct PhaseResult {
+    double nanoseconds;
+    size_t allocations;  // Calls to operator new
+    size_t bytes;        // Requested from operator new
+    size_t peakBytes;    // Most heap held at once above what was held when the phase started
+    size_t arenaBytes;   // Taken from astArena
+};
+
+class PhaseMeter {
+   public:
+    void start() {
+        startCounts = allocationCounter.getTotal();
+        startLiveBytes = allocationCounter.getLiveBytes();
+        allocationCounter.resetPeak();
+        startArenaBytes = astArena.getBytesUsed();
+        startTime = std::chrono::steady_clock::now();
+    }
+
+    PhaseResult stop() {
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        AllocationCounts counts = allocationCounter.getTotal();
+
+        PhaseResult result;
+        result.nanoseconds = std::chrono::duration<double, std::nano>(end - startTime).count();
+        result.allocations = counts.allocations - startCounts.allocations;
+        result.bytes = counts.bytes - startCounts.bytes;
+        result.peakBytes = allocationCounter.getPeakLiveBytes() - startLiveBytes;
+        result.arenaBytes = astArena.getBytesUsed() - startArenaBytes;
+        return result;
+    }
+
+   private:
+    AllocationCounts startCounts;
+    size_t startLiveBytes;
+    size_t startArenaBytes;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+enum class Engine {
+    INTERPRETER,
+    VM
+};
+
+static const char* engineName(Engine engine) {
+    return engine == Engine::INTERPRETER ? "interpreter" : "vm";
+}
+
+// Printed output would dominate the timings, so it is only counted
+class NullOutputStream : public OutputStream {
+   public:
+    size_t bytesWritten = 0;
+
+    void write(const std::string& message) override { bytesWritten += message.size(); }
+};
+
+enum Phase {
+    TOKENIZE,
+    PARSE,    // Including the Optimizer, like an upload
+    EXECUTE,  // Including the Resolver and the Compiler, which run when the engine is created
+    PHASE_COUNT
+};
+
+static const char* phaseNames[PHASE_COUNT] = {"tokenize", "parse", "execute"};
+
+struct RunResult {
+    PhaseResult phases[PHASE_COUNT];
+    size_t nodeAllocations[AST_NODE_TYPE_COUNT];  // While executing, by the node being interpreted (tree-walking only)
+    size_t tokenCount;
+    bool failed;
+};
+
+static RunResult runOnce(const BenchProgram& program, Engine engine, OutputStream& outputStream) {
+    RunResult run;
+    PhaseMeter meter;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    astArena.reset();
+
+    meter.start();
+    Tokenizer tokenizer(program.sourceCode);
+    std::vector<Token> tokens = tokenizer.tokenize();
+    run.phases[TOKENIZE] = meter.stop();
+    run.tokenCount = tokens.size();
+
+    meter.start();
+    Parser parser(tokens, outputStream, errorHandler);
+    BlockNode* block = parser.parseProgram();
+    if (block != nullptr) {
+        Optimizer optimizer;
+        optimizer.optimize(*block);
+    }
+    run.phases[PARSE] = meter.stop();
+
+    if (block == nullptr) {
+        run.failed = true;
+        return run;
+    }
+
+    allocationCounter.reset();
+
+    meter.start();
+    if (engine == Engine::INTERPRETER) {
+        Interpreter interpreter(*block, outputStream, errorHandler);
+        interpreter.interpret();
+    } else {
+        VirtualMachine vm(*block, outputStream, errorHandler);
+        vm.interpret();
+    }
+    run.phases[EXECUTE] = meter.stop();
+
+    for (size_t type = 0; type < AST_NODE_TYPE_COUNT; type++) {
+        run.nodeAllocations[type] = allocationCounter.getNodeType((ASTNodeType)type).allocations;
+    }
+
+    run.failed = errorHandler.shouldStopExecution();
+    return run;
+}
+
+struct BenchResult {
+    std::string program;
+    Engine engine;
+    size_t sourceBytes;
+    size_t tokenCount;
+    double medianNanoseconds[PHASE_COUNT];
+    double minNanoseconds[PHASE_COUNT];
+    PhaseResult memory[PHASE_COUNT];  // Of the last run, once the warm up has filled the symbol table
+    size_t nodeAllocations[AST_NODE_TYPE_COUNT];
+};
+
+static bool benchmark(const BenchProgram& program, Engine engine, int iterations, BenchResult& result) {
+    NullOutputStream outputStream;
+
+    // Warm up, this is also where new names are added to the symbol table
+    if (runOnce(program, engine, outputStream).failed) {
+        // Run it again where the error can be seen
+        StandardOutputStream standardOutputStream;
+        runOnce(program, engine, standardOutputStream);
+        fprintf(stderr, "%s failed on the %s\n", program.name.c_str(), engineName(engine));
+        return false;
+    }
+
+    std::vector<double> times[PHASE_COUNT];
+    RunResult run;
+
+    for (int i = 0; i < iterations; i++) {
+        run = runOnce(program, engine, outputStream);
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            times[phase].push_back(run.phases[phase].nanoseconds);
+        }
+    }
+
+    result.program = program.name;
+    result.engine = engine;
+    result.sourceBytes = program.sourceCode.size();
+    result.tokenCount = run.tokenCount;
+
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        std::sort(times[phase].begin(), times[phase].end());
+        result.medianNanoseconds[phase] = times[phase][times[phase].size() / 2];
+        result.minNanoseconds[phase] = times[phase].front();
+        result.memory[phase] = run.phases[phase];
+    }
+
+    std::copy(run.nodeAllocations, run.nodeAllocations + AST_NODE_TYPE_COUNT, result.nodeAllocations);
+
+    astArena.reset();
+    return true;
+}
+
+//================================================================================================
+// Output
+//================================================================================================
+
+static void printTable(const std::vector<BenchResult>& results, int iterations) {
+    printf("BrainBench, median of %d runs\n\n", iterations);
+    printf("%-16s %-12s %-9s %12s %12s %12s %12s %12s\n", "program", "engine", "phase", "median us", "allocations", "heap bytes", "peak heap", "arena bytes");
+
+    for (const BenchResult& result : results) {
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            const PhaseResult& memory = result.memory[phase];
+            printf("%-16s %-12s %-9s %12.1f %12zu %12zu %12zu %12zu\n", result.program.c_str(), engineName(result.engine), phaseNames[phase],
+                   result.medianNanoseconds[phase] / 1000, memory.allocations, memory.bytes, memory.peakBytes, memory.arenaBytes);
+        }
+    }
+}
+
+static void printJson(const std::vector<BenchResult>& results, int iterations) {
+    printf("{\n  \"benchmark\": \"BrainBench\",\n  \"iterations\": %d,\n  \"results\": [\n", iterations);
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        printf("    {\"program\": \"%s\", \"engine\": \"%s\", \"sourceBytes\": %zu, \"tokens\": %zu", result.program.c_str(), engineName(result.engine), result.sourceBytes, result.tokenCount);
+
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            const PhaseResult& memory = result.memory[phase];
+            printf(",\n     \"%s\": {\"medianNs\": %.0f, \"minNs\": %.0f, \"allocations\": %zu, \"heapBytes\": %zu, \"peakHeapBytes\": %zu, \"arenaBytes\": %zu}", phaseNames[phase],
+                   result.medianNanoseconds[phase], result.minNanoseconds[phase], memory.allocations, memory.bytes, memory.peakBytes, memory.arenaBytes);
+        }
+
+        // Only the node types that allocated anything
+        printf(",\n     \"executeAllocationsByNode\": {");
+        const char* separator = "";
+        for (size_t type = 0; type < AST_NODE_TYPE_COUNT; type++) {
+            if (result.nodeAllocations[type] > 0) {
+                printf("%s\"%s\": %zu", separator, nodeTypeToString((ASTNodeType)type), result.nodeAllocations[type]);
+                separator = ", ";
+            }
+        }
+
+        printf("}}%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    printf("  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10;
+    bool json = false;
+    std::vector<Engine> engines = {Engine::INTERPRETER, Engine::VM};
+    std::vector<std::string> selected;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+
+        if (argument == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else if (argument == "--json") {
+            json = true;
+        } else if (argument == "--engine" && i + 1 < argc) {
+            std::string engine = argv[++i];
+            engines = {engine == "vm" ? Engine::VM : Engine::INTERPRETER};
+        } else if (argument.compare(0, 2, "--") == 0) {
+            fprintf(stderr, "usage: %s [--iterations N] [--engine interpreter|vm] [--json] [program...]\n", argv[0]);
+            return 2;
+        } else {
+            selected.push_back(argument);
+        }
+    }
+
+    std::vector<BenchResult> results;
+    bool failed = false;
+
+    for (const BenchProgram& program : benchCorpus()) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), program.name) == selected.end()) {
+            continue;
+        }
+
+        for (Engine engine : engines) {
+            BenchResult result;
+            if (benchmark(program, engine, iterations, result)) {
+                results.push_back(result);
+            } else {
+                failed = true;
+            }
+        }
+    }
+
+    if (json) {
+        printJson(results, iterations);
+    } else {
+        printTable(results, iterations);
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,95 @@
+#include "corpus.hpp"
+
+// What the web app generates for a long chain of blocks: one statement per line, nested bodies
+// indented by two spaces and no parentheses around binary operations
+static std::string blocklyScript(int blocks) {
+    std::string script = "{\nint total = 0;\nfloat scale = 1.5;\n";
+
+    for (int i = 0; i < blocks; i++) {
+        std::string name = "v" + std::to_string(i);
+        std::string previous = i == 0 ? "total" : "v" + std::to_string(i - 1);
+
+        script += "int " + name + " = " + previous + " + " + std::to_string(i % 7) + " * 3 % 11;\n";
+        script += "if (" + name + " > " + std::to_string(i % 5) + ") {\n";
+        script += "  total = total + " + name + " % 4;\n";
+        script += "  scale = scale * 1.01 + " + name + " / 100;\n";
+        script += "}\n";
+
+        if (i % 10 == 9) {
+            script += "int count" + std::to_string(i) + " = 0;\n";
+            script += "while (count" + std::to_string(i) + " < 5) {\n";
+            script += "  count" + std::to_string(i) + " = count" + std::to_string(i) + " + 1;\n";
+            script += "  total = total + count" + std::to_string(i) + ";\n";
+            script += "}\n";
+            script += "print(total);\n";
+        }
+    }
+
+    script += "print(scale);\n}";
+    return script;
+}
+
+std::vector<BenchProgram> benchCorpus() {
+    return {
+        {"collatz",
+         "{"
+         "    int steps = 0;"
+         "    for (int start = 1; start < 2000; start = start + 1) {"
+         "        int n = start;"
+         "        while (n > 1) {"
+         "            if (n % 2) { n = 3 * n + 1; } else { n = n / 2; }"
+         "            steps = steps + 1;"
+         "        }"
+         "    }"
+         "    print(steps);"
+         "}"},
+
+        {"fibonacci",
+         "{"
+         "    int fib(int n) {"
+         "        if (n < 2) { return n; }"
+         "        return fib(n - 1) + fib(n - 2);"
+         "    }"
+         "    print(fib(20));"
+         "}"},
+
+        {"nested_loops",
+         "{"
+         "    int sum = 0;"
+         "    for (int i = 0; i < 60; i = i + 1) {"
+         "        for (int j = 0; j < 60; j = j + 1) {"
+         "            int k = 0;"
+         "            while (k < 60) {"
+         "                if (i + j > k && (i * j) % 3 == 0) { sum = sum + 1; } else { sum = sum - 1; }"
+         "                k = k + 1;"
+         "            }"
+         "        }"
+         "    }"
+         "    print(sum);"
+         "}"},
+
+        // Stays below the VM's call depth limit
+        {"deep_recursion",
+         "{"
+         "    int depth(int n) {"
+         "        if (n == 0) { return 0; }"
+         "        return depth(n - 1) + 1;"
+         "    }"
+         "    int total = 0;"
+         "    for (int i = 0; i < 200; i = i + 1) { total = total + depth(200); }"
+         "    print(total);"
+         "}"},
+
+        {"builtin_math",
+         "{"
+         "    float acc = 0.0;"
+         "    for (int i = 1; i < 20000; i = i + 1) {"
+         "        float x = i / 1000.0;"
+         "        acc = acc + sin(x) * cos(x) + sqrt(x) - pow(x, 0.5) + atan2(x, 2) + abs(log(x)) + min(x, 3) - max(x, 1);"
+         "    }"
+         "    print(round(acc, 2));"
+         "}"},
+
+        {"blockly_large", blocklyScript(400)},
+    };
+}
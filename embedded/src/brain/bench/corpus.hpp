@@ -0,0 +1,17 @@
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <string>
+#include <vector>
+
+// A program BrainBench runs, named so results can be compared between commits
+struct BenchProgram {
+    std::string name;
+    std::string sourceCode;
+};
+
+// Representative programs: tight loops, calls, recursion, builtin math and a large Blockly style upload
+// Every program runs without errors on both engines
+std::vector<BenchProgram> benchCorpus();
+
+#endif  // CORPUS_HPP
@@ -0,0 +1,55 @@
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+#include "error.hpp"
+#include "outputStream.hpp"
+
+// Every engine checks shouldStopExecution after nearly every evaluation,
+// so this compares the check in a tight loop before and after it became an atomic
+
+// The stop flag as it was: a global guarded by a mutex
+static bool lockedStopExecution = false;
+static std::mutex lockedStopExecutionMutex;
+
+// noinline so both checks pay a call, like the engines calling into error.cpp did
+__attribute__((noinline)) static bool lockedShouldStopExecution() {
+    std::lock_guard<std::mutex> lock(lockedStopExecutionMutex);
+    return lockedStopExecution;
+}
+
+static const long ITERATIONS = 10000000;
+
+template <typename Check>
+static double nanosecondsPerCheck(Check check) {
+    volatile long stops = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long i = 0; i < ITERATIONS; i++) {
+        if (check()) {
+            stops = stops + 1;
+        }
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+int main() {
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    // Warm up so neither side pays for the first page faults
+    nanosecondsPerCheck(lockedShouldStopExecution);
+
+    double locked = nanosecondsPerCheck(lockedShouldStopExecution);
+    double atomic = nanosecondsPerCheck([&errorHandler]() { return errorHandler.shouldStopExecution(); });
+
+    printf("iterations: %ld\n", ITERATIONS);
+    printf("mutex:  %.2f ns/check\n", locked);
+    printf("atomic: %.2f ns/check\n", atomic);
+    printf("speedup: %.1fx\n", locked / atomic);
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Opt-in accounting of heap allocations, by phase and by the AST node being interpreted
+// Build with -DALLOCATION_TRACKING=1 to replace the global operator new and delete with counting ones.
+// Disabled, the scopes below compile to nothing and every count stays 0.
+
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <atomic>
+#include <cstddef>
+
+#include "ast.hpp"
+
+#ifndef ALLOCATION_TRACKING
+#define ALLOCATION_TRACKING 0
+#endif
+
+// What was running when an allocation was made
+enum class AllocationPhase {
+    OTHER,      // Outside any of the phases below, Ex. receiving an upload
+    TOKENIZE,   // Tokenizer::tokenize
+    PARSE,      // Parser::parseProgram
+    COMPILE,    // The Optimizer, and creating an engine: the Resolver, and the Compiler for the VM
+    INTERPRET,  // Interpreter::interpret or VirtualMachine::interpret
+    COUNT
+};
+
+struct AllocationCounts {
+    std::size_t allocations;
+    std::size_t bytes;
+};
+
+/**
+ * @brief Counts allocations made through operator new while ALLOCATION_TRACKING is on
+ *
+ * Each allocation is attributed to the phase the allocating thread is in and, while interpreting,
+ * to the type of the innermost AST node the Interpreter is evaluating. The counts are shared by
+ * every thread, so on the ESP32 allocations of the BLE task show up under OTHER.
+ *
+ * Ex. a loop allocates nothing per iteration if the INTERPRET count does not change with its length.
+ *
+ */
+class AllocationCounter {
+   public:
+    static constexpr bool isEnabled() { return ALLOCATION_TRACKING != 0; }
+
+    // Since the last reset
+    AllocationCounts getTotal() const;
+    AllocationCounts getPhase(AllocationPhase phase) const;
+    AllocationCounts getNodeType(ASTNodeType type) const;
+
+    // Bytes allocated and not yet freed, and the most there were at once since resetPeak
+    std::size_t getLiveBytes() const;
+    std::size_t getPeakLiveBytes() const;
+    void resetPeak();
+
+    // Zeroes the counts, the live bytes are kept since those blocks are still allocated
+    void reset();
+
+    // Called by the operator new and delete replacements
+    void recordAllocation(std::size_t size);
+    void recordFree(std::size_t size);
+
+   private:
+    struct Counts {
+        std::atomic<std::size_t> allocations;
+        std::atomic<std::size_t> bytes;
+    };
+
+    // There is no constructor, the global counter is zeroed before any allocation can be counted,
+    // even those made by the constructors of other globals
+    Counts phases[(std::size_t)AllocationPhase::COUNT];
+    Counts nodeTypes[AST_NODE_TYPE_COUNT];
+
+    std::atomic<std::size_t> liveBytes;
+    std::atomic<std::size_t> peakLiveBytes;
+
+    static AllocationCounts load(const Counts& counts);
+};
+
+extern AllocationCounter allocationCounter;
+
+// Attributes the current thread's allocations to phase until the scope ends
+class AllocationPhaseScope {
+   public:
+    explicit AllocationPhaseScope(AllocationPhase phase);
+    ~AllocationPhaseScope();
+
+   private:
+    AllocationPhase previous;
+};
+
+// Attributes the current thread's allocations to the type of node until the scope ends
+class AllocationNodeScope {
+   public:
+    explicit AllocationNodeScope(const ASTNode* node);
+    ~AllocationNodeScope();
+
+   private:
+    int previous;
+};
+
+#if ALLOCATION_TRACKING
+#define ALLOCATION_PHASE(phase) AllocationPhaseScope allocationPhaseScope(phase)
+#define ALLOCATION_NODE(node) AllocationNodeScope allocationNodeScope(node)
+#else
+#define ALLOCATION_PHASE(phase) \
+    do {                        \
+    } while (0)
+#define ALLOCATION_NODE(node) \
+    do {                      \
+    } while (0)
+#endif
+
+#endif  // ALLOCATION_COUNTER_HPP
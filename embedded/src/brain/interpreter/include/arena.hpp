@@ -0,0 +1,106 @@
+// Bump allocator for everything that lives as long as one program, Ex. the AST
+// Parsing makes a few chunk sized allocations instead of one per node, and the whole program is freed at once with reset()
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Bytes requested from the heap at a time, larger allocations get a chunk of their own
+#define ARENA_CHUNK_SIZE 4096
+
+/**
+ * @brief Hands out memory from large chunks and frees it all at once
+ *
+ * Nothing allocated from an arena is freed or destroyed on its own. reset() gives every chunk but one
+ * back to the heap, so it costs one free per chunk no matter how many objects were allocated.
+ *
+ */
+class Arena {
+   public:
+    Arena();
+    Arena(std::size_t chunkSize);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Returns size bytes aligned to alignment, alignment must be a power of two
+    void* allocate(std::size_t size, std::size_t alignment);
+
+    // Copies value into the arena as a null terminated string
+    const char* copyString(const std::string& value);
+    const char* copyString(const char* characters, std::size_t length);
+
+    // Frees everything allocated so far, keeping the first chunk for the next program
+    void reset();
+
+    // Usage statistics
+    std::size_t getBytesUsed() const;       // Requested since the last reset, including alignment padding
+    std::size_t getBytesReserved() const;   // Held from the heap right now
+    std::size_t getPeakBytesUsed() const;   // Most bytes used at once since the arena was created
+    std::size_t getChunkCount() const;
+    std::size_t getAllocationCount() const; // Allocations since the last reset
+
+   private:
+    struct Chunk {
+        Chunk* next;  // The chunk allocated before this one
+        std::size_t size;
+        std::size_t used;
+    };
+
+    std::size_t chunkSize;
+    Chunk* chunks;  // Newest first, allocations come from the front
+
+    std::size_t bytesUsed;
+    std::size_t bytesReserved;
+    std::size_t peakBytesUsed;
+    std::size_t chunkCount;
+    std::size_t allocationCount;
+
+    Chunk* newChunk(std::size_t minimumSize);
+};
+
+/**
+ * @brief A fixed size array whose items live in an Arena
+ *
+ * Used by AST nodes for their children, it never grows after construction but items can be replaced.
+ * T must be trivially copyable, it is never destroyed.
+ *
+ */
+template <typename T>
+class ArenaArray {
+   public:
+    ArenaArray() : items(nullptr), count(0) {}
+
+    // Copies source from index first on, Ex. the top of a stack shared by nested constructs
+    ArenaArray(Arena& arena, const std::vector<T>& source, std::size_t first = 0) : items(nullptr), count(source.size() - first) {
+        if (count > 0) {
+            items = (T*)arena.allocate(sizeof(T) * count, alignof(T));
+            std::copy(source.begin() + first, source.end(), items);
+        }
+    }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T& operator[](std::size_t index) { return items[index]; }
+    const T& operator[](std::size_t index) const { return items[index]; }
+    const T& back() const { return items[count - 1]; }
+
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+
+   private:
+    T* items;
+    std::size_t count;
+};
+
+// The arena the Parser and Optimizer allocate the program's AST from unless given another
+extern Arena astArena;
+
+#endif  // ARENA_HPP
@@ -6,8 +6,10 @@
 #include <unordered_set>
 #include <vector>
 
+#include "arena.hpp"
 #include "error.hpp"
 #include "outputStream.hpp"
+#include "symbols.hpp"
 #include "tokenizer.hpp"
 
 /**
@@ -30,7 +32,63 @@ enum class ASTNodeType {
     FUNCTION_DECLARATION_NODE,
     FUNCTION_CALL_NODE,
     RETURN_NODE,
-    EMPTY_EXPRESSION_NODE
+    EMPTY_EXPRESSION_NODE,
+    CONVERSION_NODE  // Keep last, AST_NODE_TYPE_COUNT depends on it
+};
+
+#define AST_NODE_TYPE_COUNT ((size_t)ASTNodeType::CONVERSION_NODE + 1)
+
+// Ex. "WHILE_NODE", for reports
+const char* nodeTypeToString(ASTNodeType type);
+
+// Tags for the various types of values that can be stored in a variable
+enum class ValueType {
+    INTEGER,
+    FLOAT,
+    FUNCTION,
+    VOID  // no value, Ex. a bare return
+};
+
+// Operators decoded once by the Parser so evaluation can switch on them instead of comparing strings
+enum class Operator {
+    ADD,            // +
+    SUBTRACT,       // -
+    MULTIPLY,       // *
+    DIVIDE,         // /
+    MODULO,         // %
+    GREATER,        // >
+    LESS,           // <
+    GREATER_EQUAL,  // >=
+    LESS_EQUAL,     // <=
+    EQUAL,          // ==
+    NOT_EQUAL,      // !=
+    AND,            // &&
+    OR,             // ||
+    NOT,            // !
+    UNKNOWN         // Any other lexeme, Ex. =
+};
+
+Operator operatorFromLexeme(StringView lexeme);
+std::string operatorToString(Operator op);
+
+// Conversions the Resolver inserts wherever a value has to change type, mirroring the VM's conversion opcodes
+enum class Conversion {
+    INT_TO_FLOAT,
+    FLOAT_TO_INT,   // Truncates, Ex. int x = 2.7; stores 2
+    FLOAT_TO_TRUTH  // 1 if the float is not 0, for conditions and logical operators
+};
+
+/**
+ * @brief Where the Resolver found a variable and what it holds
+ *
+ * depth is how many frames out from the current one the variable lives, 0 being the current frame
+ * slot is the variable's index within that frame
+ *
+ */
+struct VariableLocation {
+    int depth;
+    int slot;
+    ValueType type;
 };
 
 // Forward declarations of AST node classes
@@ -72,20 +130,39 @@ class FunctionDeclarationNode;
 class FunctionCallNode;
 class ReturnNode;
 class EmptyExpressionNode;
+class ConversionNode;
+
+// Described in builtins.hpp, which needs ValueType from here
+struct BuiltinSignature;
+
+// Marks a token without a matching brace or parenthesis
+#define NO_MATCHING_BRACKET ((size_t)-1)
+
+// Starts the names genNewIdentifier makes up
+// The tokenizer never puts a # in an identifier, so they cannot clash with the script's names
+#define GENERATED_IDENTIFIER_PREFIX "obfuscated#"
 
 class Parser {
    public:
-    Parser(const std::vector<Token>& tokens, OutputStream& outputStream, ErrorHandler& errorHandler);
+    // Nodes are allocated from arena, the program is freed with arena.reset() rather than delete
+    Parser(const std::vector<Token>& tokens, OutputStream& outputStream, ErrorHandler& errorHandler, Arena& arena = astArena);
     ~Parser();
 
     BlockNode* parseProgram();  // Entry point for parsing a program into an AST
 
+    // Streaming, when tokens is still growing, Ex. Tokenizer::getTokens() while chunks are fed
+    // Parses every statement of the program block that is complete so far and returns how many there are
+    // parseProgram parses the rest once the last token is in
+    size_t parseAvailableStatements();
+
     // The functions to parse each type of AST node
     BlockNode* parseBlock();
+    ASTNode* parseStatement();  // One statement of a block, dispatched on its first token
     VariableDeclarationNode* parseVariableDeclaration();
     AssignmentNode* parseAssignment(TokenType terminator); // terminator is the token that terminates the expression (e.g. semicolon in most use cases)
     VariableAccessNode* parseVariableAccess();
     NumberNode* parseConstant();
+    NumberNode* parseNumber(const Token& token);  // Decodes an INTEGER or FLOAT token, reports out of range integers
     IfNode* parseIfStatement();
     WhileNode* parseWhile();
     ForNode* parseFor();
@@ -97,36 +174,94 @@ class Parser {
 
     // Helper functions
 
-    // Gather tokens until a token of the specified type is encountered
-    // Does not consume the token of the specified type
-    // Is used to gather tokens for expressions (we need all tokens in order to perform order of operations)
-    std::vector<const Token*> gatherTokensUntil(TokenType endTokenType);
-
-    ASTNode* parseExpression(const std::vector<const Token*>& expressionTokens, bool canBeEmpty);  // Should result in a single AST node for an expression, constant or variable access
-    int getPrecedence(const std::string& lexeme);
+    // Parses an expression in place from the current token and eats the terminator after it
+    // Should result in a single AST node for an expression, constant or variable access
+    ASTNode* parseExpression(TokenType terminator);
+    int getPrecedence(Operator op);
 
     void eatToken(TokenType expectedTokenType);
 
-    void syntaxError(const std::string& message) const;
+    void syntaxError(const std::string& message) const;  // At the current token
+    void syntaxError(size_t tokenIndex, const std::string& message) const;
+
+    // Index of the brace or parenthesis matching the one at tokenIndex
+    // NO_MATCHING_BRACKET if it is unmatched or not a brace or parenthesis
+    size_t getMatchingBracket(size_t tokenIndex) const;
 
    private:
 
-    std::string genNewIdentifier(); // Generate a new identifier for use in obfuscation or optimization
+    Symbol genNewIdentifier(); // Generate a new identifier for use in obfuscation or optimization
+    uint32_t generatedIdentifiers;  // Made up by this Parser so far
+
+    // Pieces of parseExpression, none of them eat a terminator
+    ASTNode* parseBinaryOperation(int minimumPrecedence);  // Operators with a lower precedence are left for the caller
+    ASTNode* parseOperand();
+    FunctionCallNode* parseCall();
+
+    // The rest of a block whose leading brace is eaten, up to and including its closing brace
+    // Its statements are pushed onto statements from index first, and popped again once the block is made
+    BlockNode* finishBlock(size_t blockEnd, std::vector<ASTNode*>& statements, size_t first);
+
+    // Children of the blocks and calls being parsed, innermost last
+    // Shared so a nested block or call does not allocate a vector of its own
+    std::vector<ASTNode*> pendingNodes;
 
     const std::vector<Token>& tokens;
     OutputStream& outputStream;
     ErrorHandler& errorHandler;
+    Arena& arena;
     size_t currentTokenIndex;
-    std::vector<std::string> userIdentifiers; // Identifiers that have been declared -- should not be used when optimizing/obfuscating
+
+    // Filled in by the constructor so blocks and parenthesized regions are delimited without rescanning them
+    // Extended over new tokens when they are streamed in
+    void matchBrackets();
+    void checkUnclosedBrackets();
+    std::vector<size_t> matchingBrackets;
+    std::vector<size_t> openBrackets;  // Not matched yet
+    size_t bracketErrorIndex;  // First unbalanced brace or parenthesis, or NO_MATCHING_BRACKET
+    std::string bracketError;
+
+    // Gives node the location of token and returns it
+    template <typename T>
+    T* locate(T* node, const Token& token) const {
+        node->setSourceLocation(token.location);
+        return node;
+    }
+
+    // Streaming
+    size_t findStatementEnd(size_t start) const;
+    std::vector<ASTNode*> programStatements;  // Parsed ahead of parseProgram
+    bool streamFailed;                        // A statement parsed ahead reported an error
 };
 
 // Base class for all nodes
+// Nodes only hold trivially destructible members, so they are never destroyed one by one
+// Instead the Arena they were allocated from is reset, delete on a node does not compile
 class ASTNode {
    public:
     virtual std::string toString() const = 0; // Should not be called when an error node is encountered
-    virtual ~ASTNode() = default;
+
+    static void* operator new(size_t size, Arena& arena) { return arena.allocate(size, alignof(std::max_align_t)); }
+    static void operator delete(void*, Arena&) {}  // Only called if a constructor throws
+    static void operator delete(void*) = delete;
     virtual ASTNodeType getNodeType() const = 0;
-    virtual void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) = 0;
+    virtual void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) = 0;
+
+    // Where the node starts in the script, set by the Parser and reported with errors
+    SourceLocation getSourceLocation() const { return sourceLocation; }
+    void setSourceLocation(SourceLocation location) { sourceLocation = location; }
+
+    // The static type of an expression, INTEGER or FLOAT, set by the Resolver
+    // Statements and expressions that were never resolved are VOID
+    ValueType getValueType() const { return valueType; }
+    void setValueType(ValueType type) { valueType = type; }
+
+   protected:
+    ~ASTNode() = default;
+
+   private:
+    SourceLocation sourceLocation = {0, 0};
+    ValueType valueType = ValueType::VOID;
 };
 
 // Define a class for housing a block of code
@@ -134,122 +269,163 @@ class ASTNode {
 // Variables declared in a block are scoped to that block
 class BlockNode : public ASTNode {
    public:
-    BlockNode(const std::vector<ASTNode*>& statements);
+    BlockNode(const ArenaArray<ASTNode*>& statements);
     std::string toString() const override;
-    std::vector<ASTNode*> getStatements() const;
+    const ArenaArray<ASTNode*>& getStatements() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~BlockNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Number of variable slots the block's frame needs, set by the Resolver
+    int getFrameSize() const;
+    void setFrameSize(int frameSize);
 
    private:
-    std::vector<ASTNode*> statements;
+    ArenaArray<ASTNode*> statements;
+    int frameSize;
 };
 
 class VariableDeclarationNode : public ASTNode {
    public:
-    VariableDeclarationNode(const std::string& identifier, const std::string& type, ASTNode* initializer);
+    VariableDeclarationNode(Symbol identifier, Symbol type, ASTNode* initializer);
     std::string toString() const override;
-    std::string getIdentifier() const;
-    std::string getType() const;
+    const std::string& getIdentifier() const;  // For messages, compare getSymbol() instead
+    Symbol getSymbol() const;
+    const std::string& getType() const;
     ASTNode* getInitializer() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~VariableDeclarationNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Used by the Optimizer to swap in a simplified expression, the old one is not deleted
+    void setInitializer(ASTNode* initializer);
+
+    // Set by the Resolver
+    const VariableLocation& getLocation() const;
+    void setLocation(const VariableLocation& location);
 
    private:
-    std::string identifier;
-    std::string type;
+    Symbol identifier;
+    Symbol type;
     ASTNode* initializer;
+    VariableLocation location;
 };
 
 class AssignmentNode : public ASTNode {
    public:
-    AssignmentNode(const std::string& identifier, ASTNode* expression);
+    AssignmentNode(Symbol identifier, ASTNode* expression);
     ASTNodeType getNodeType() const override;
     std::string toString() const override;
-    std::string getIdentifier() const;
+    const std::string& getIdentifier() const;  // For messages, compare getSymbol() instead
+    Symbol getSymbol() const;
     ASTNode* getExpression() const;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~AssignmentNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Used by the Optimizer to swap in a simplified expression, the old one is not deleted
+    void setExpression(ASTNode* expression);
+
+    // Set by the Resolver
+    const VariableLocation& getLocation() const;
+    void setLocation(const VariableLocation& location);
 
    private:
-    std::string identifier;
+    Symbol identifier;
     ASTNode* expression;
+    VariableLocation location;
 };
 
 class VariableAccessNode : public ASTNode {
    public:
-    VariableAccessNode(const std::string& identifier);
+    VariableAccessNode(Symbol identifier);
     std::string toString() const override;
-    std::string getIdentifier() const;
+    const std::string& getIdentifier() const;  // For messages, compare getSymbol() instead
+    Symbol getSymbol() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~VariableAccessNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Set by the Resolver
+    const VariableLocation& getLocation() const;
+    void setLocation(const VariableLocation& location);
 
    private:
-    std::string identifier;
+    Symbol identifier;
+    VariableLocation location;
 };
 
 class NumberNode : public ASTNode {
    public:
-    NumberNode(std::string val, TokenType type);
+    // val must outlive the node, the Parser and Optimizer copy it into their Arena
+    NumberNode(const char* val, int intValue);
+    NumberNode(const char* val, float floatValue);
     std::string toString() const override;
     ASTNodeType getNodeType() const override;
     TokenType getType() const;
-    std::string getValue() const;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~NumberNode();
+    std::string getValue() const;  // The literal as written
+    int getIntValue() const;       // Only meaningful for TokenType::INTEGER
+    float getFloatValue() const;   // Only meaningful for TokenType::FLOAT
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
 
    private:
-    std::string value;
+    const char* value;
     TokenType type;
+
+    // Decoded once by the Parser, so evaluating a literal is a plain load
+    union {
+        int intValue;
+        float floatValue;
+    };
 };
 
 class BinaryOperationNode : public ASTNode {
    public:
-    BinaryOperationNode(ASTNode* left, std::string op, ASTNode* right);
+    BinaryOperationNode(ASTNode* left, Operator op, ASTNode* right);
     std::string toString() const override;
     ASTNode* getLeftExpression() const;
     ASTNode* getRightExpression() const;
-    std::string getOperator() const;
+    Operator getOperator() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~BinaryOperationNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Used by the Optimizer to swap in a simplified expression, the old one is not deleted
+    void setLeftExpression(ASTNode* left);
+    void setRightExpression(ASTNode* right);
 
    private:
     ASTNode* left;
-    std::string op;
+    Operator op;
     ASTNode* right;
 };
 
 class MonoOperationNode : public ASTNode {
    public:
-    MonoOperationNode(std::string op, ASTNode* expression);
+    MonoOperationNode(Operator op, ASTNode* expression);
     std::string toString() const override;
-    std::string getOperator() const;
+    Operator getOperator() const;
     ASTNode* getExpression() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~MonoOperationNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Used by the Optimizer to swap in a simplified expression, the old one is not deleted
+    void setExpression(ASTNode* expression);
 
    private:
-    std::string op;
+    Operator op;
     ASTNode* expression;
 };
 
 class IfNode : public ASTNode {
    public:
-    IfNode(std::vector<ASTNode*> expressions, std::vector<BlockNode*> bodies);
+    IfNode(const ArenaArray<ASTNode*>& expressions, const ArenaArray<BlockNode*>& bodies);
     std::string toString() const override;
-    std::vector<ASTNode*> getExpressions() const;
-    std::vector<BlockNode*> getBodies() const;
+    const ArenaArray<ASTNode*>& getExpressions() const;
+    const ArenaArray<BlockNode*>& getBodies() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~IfNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Used by the Optimizer to swap in a simplified expression, the old one is not deleted
+    void setExpression(size_t index, ASTNode* expression);
 
    private:
-    std::vector<ASTNode*> expressions; // expressions.size() == bodies.size() - 1 if there is an else clause
-    std::vector<BlockNode*> bodies;
+    ArenaArray<ASTNode*> expressions; // expressions.size() == bodies.size() - 1 if there is an else clause
+    ArenaArray<BlockNode*> bodies;
 };
 
 class WhileNode : public ASTNode {
@@ -259,8 +435,10 @@ class WhileNode : public ASTNode {
     ASTNode* getExpression() const;
     BlockNode* getBody() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~WhileNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Used by the Optimizer to swap in a simplified expression, the old one is not deleted
+    void setExpression(ASTNode* expression);
 
    private:
     ASTNode* expression;
@@ -276,8 +454,10 @@ class ForNode : public ASTNode {
     ASTNode* getIncrement() const;
     BlockNode* getBody() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~ForNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Used by the Optimizer to swap in a simplified expression, the old one is not deleted
+    void setCondition(ASTNode* condition);
 
    private:
     ASTNode* initializer;
@@ -291,8 +471,7 @@ class BreakNode : public ASTNode {
     BreakNode();
     std::string toString() const override;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~BreakNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
 };
 
 class ContinueNode : public ASTNode {
@@ -300,44 +479,62 @@ class ContinueNode : public ASTNode {
     ContinueNode();
     std::string toString() const override;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~ContinueNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
 };
 
 class FunctionDeclarationNode : public ASTNode {
    public:
-    FunctionDeclarationNode(const std::string& type, const std::string& name, const std::vector<std::string>& parameters, const std::vector<std::string>& parameterTypes, BlockNode* body);
+    FunctionDeclarationNode(Symbol type, Symbol name, const ArenaArray<Symbol>& parameters, const ArenaArray<Symbol>& parameterTypes, const ArenaArray<ValueType>& parameterValueTypes,
+                            BlockNode* body);
     std::string toString() const override;
-    std::string getType() const;
-    std::string getName() const;
-    std::vector<std::string> getParameters() const;
-    std::vector<std::string> getParameterTypes() const;
+    const std::string& getType() const;
+    const std::string& getName() const;  // For messages, compare getSymbol() instead
+    Symbol getSymbol() const;
+    const ArenaArray<Symbol>& getParameters() const;
+    const ArenaArray<Symbol>& getParameterTypes() const;  // Type names are interned too, Ex. symbolTable.name(getParameterTypes()[0]) == "int"
+    const ArenaArray<ValueType>& getParameterValueTypes() const;  // The same types decoded once by the Parser, so calls never compare names
     BlockNode* getBody() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~FunctionDeclarationNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
 
    private:
-    std::string type;
-    std::string name;
-    std::vector<std::string> parameters;
-    std::vector<std::string> parameterTypes;
+    Symbol type;
+    Symbol name;
+    ArenaArray<Symbol> parameters;
+    ArenaArray<Symbol> parameterTypes;
+    ArenaArray<ValueType> parameterValueTypes;
     BlockNode* body;
 };
 
 class FunctionCallNode : public ASTNode {
    public:
-    FunctionCallNode(const std::string& name, const std::vector<ASTNode*>& arguments);
+    FunctionCallNode(Symbol name, const ArenaArray<ASTNode*>& arguments, const BuiltinSignature* builtin);
     std::string toString() const override;
-    std::string getName() const;
-    std::vector<ASTNode*> getArguments() const;
+    const std::string& getName() const;  // For messages, compare getSymbol() instead
+    Symbol getSymbol() const;
+    const ArenaArray<ASTNode*>& getArguments() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~FunctionCallNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Used by the Optimizer to swap in a simplified expression, the old one is not deleted
+    void setArgument(size_t index, ASTNode* argument);
+
+    // The builtin being called, found by the Parser since builtin names can not be redeclared
+    // nullptr for user functions
+    const BuiltinSignature* getBuiltin() const;
+
+    // The user function being called and how many frames out it was declared, set by the Resolver
+    // The target stays nullptr for builtins
+    FunctionDeclarationNode* getTarget() const;
+    int getTargetDepth() const;
+    void setTarget(FunctionDeclarationNode* target, int depth);
 
    private:
-    std::string name;
-    std::vector<ASTNode*> arguments;
+    Symbol name;
+    ArenaArray<ASTNode*> arguments;
+    const BuiltinSignature* builtin;
+    FunctionDeclarationNode* target;
+    int targetDepth;
 };
 
 class ReturnNode : public ASTNode {
@@ -347,8 +544,10 @@ class ReturnNode : public ASTNode {
     std::string toString() const override;
     ASTNode* getExpression() const;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~ReturnNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+    // Used by the Optimizer to swap in a simplified expression, the old one is not deleted
+    void setExpression(ASTNode* expression);
 
    private:
     ASTNode* expression;
@@ -359,8 +558,23 @@ class EmptyExpressionNode : public ASTNode {
     EmptyExpressionNode();
     std::string toString() const override;
     ASTNodeType getNodeType() const override;
-    void replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) override;
-    ~EmptyExpressionNode();
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+};
+
+// Inserted by the Resolver around an expression whose static type is not the one needed
+// Ex. the 1 in 1 + 2.5, or the initializer of int x = 2.5;
+class ConversionNode : public ASTNode {
+   public:
+    ConversionNode(Conversion conversion, ASTNode* expression);
+    std::string toString() const override;
+    Conversion getConversion() const;
+    ASTNode* getExpression() const;
+    ASTNodeType getNodeType() const override;
+    void replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) override;
+
+   private:
+    Conversion conversion;
+    ASTNode* expression;
 };
 
 #endif  // AST_HPP
@@ -0,0 +1,134 @@
+// Compact binary encoding of a parsed program, and the loader that turns it back into an AST
+// Lets a program be compiled ahead of time, Ex. by the web app or host tools, and run without tokenizing or parsing it
+
+#ifndef AST_SERIALIZER_HPP
+#define AST_SERIALIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.hpp"
+#include "ast.hpp"
+#include "error.hpp"
+
+// Bump whenever the encoding below or ASTNodeType, Operator or Conversion change
+#define AST_FORMAT_VERSION 1
+
+// Deepest nesting the loader accepts, so a malicious payload cannot overflow the stack
+// Every node counts, Ex. a sum of n terms is n deep, and the serializer refuses to write anything deeper
+#define AST_MAX_DEPTH 200
+
+// Set in a node's tag when it starts on another line than the previous node with a location
+#define LINE_CHANGED_FLAG 0x40
+
+// Written in place of a missing child
+#define NULL_NODE_TAG 0x3F
+
+/**
+ * @brief Writes an AST in a compact binary form
+ *
+ * All integers are LEB128 varints, signed ones zigzag encoded first:
+ *
+ *   magic "BAST", version
+ *   count, then per name its length and characters, nodes refer to the nth name as n
+ *   the root block
+ *
+ * Names the Parser generated for parameters are written with length 0, the loader makes up new
+ * unused ones, so they do not cost 20 bytes each.
+ *
+ * A node is a tag byte, its ASTNodeType with LINE_CHANGED_FLAG added if its line differs from the
+ * previous node's, then the change in line (signed) if it does, its column and then its fields in
+ * declaration order: symbols as their index, operators and conversions as a byte, child counts,
+ * children as nodes, ints as signed varints and floats as their literal text. A missing child,
+ * Ex. the expression of a bare return, is the byte NULL_NODE_TAG.
+ *
+ * Errors are never reported at numbers, variable accesses, conversions, blocks, break, continue or
+ * empty expressions, so those have no line or column and take their parent's location.
+ *
+ * ConversionNodes the Resolver inserted are kept. Slots, frame sizes, static types and call targets
+ * are not, the engines resolve the loaded tree again.
+ *
+ * A program nested deeper than AST_MAX_DEPTH is reported through the ErrorHandler as a serialize
+ * error and gives an empty payload, the loader would reject it.
+ *
+ * Ex. std::string payload = ASTSerializer(errorHandler).serialize(*block);
+ *
+ */
+class ASTSerializer {
+   public:
+    explicit ASTSerializer(ErrorHandler& errorHandler);
+
+    // Empty if the program could not be written, the error has already been reported
+    std::string serialize(const BlockNode& program);
+
+   private:
+    ErrorHandler& errorHandler;
+    std::string nodes;
+    std::vector<Symbol> symbols;                     // In order of first use
+    std::unordered_map<Symbol, uint32_t> symbolIds;  // Their index in the payload
+    uint32_t previousLine;
+    int depth;
+    bool failed;
+
+    void writeNode(const ASTNode* node);
+    void writeSymbol(Symbol symbol);
+};
+
+/**
+ * @brief Rebuilds the AST an ASTSerializer wrote
+ *
+ * Nodes are allocated from arena in the order they were written, parents before their children, so
+ * a loaded program sits in a few contiguous chunks. Names are interned into symbolTable and builtin
+ * calls are tied to their BuiltinSignature like the Parser does.
+ *
+ * Anything malformed is reported through the ErrorHandler as a load error and nullptr is returned.
+ *
+ * Ex. BlockNode* block = ASTLoader(errorHandler).load(payload.data(), payload.size());
+ *
+ */
+class ASTLoader {
+   public:
+    ASTLoader(ErrorHandler& errorHandler, Arena& arena = astArena);
+
+    BlockNode* load(const char* data, size_t size);
+
+   private:
+    ErrorHandler& errorHandler;
+    Arena& arena;
+
+    const uint8_t* position;
+    const uint8_t* end;
+    std::vector<Symbol> symbols;  // Payload index to interned symbol
+    uint32_t previousLine;
+    SourceLocation parentLocation;  // Of the innermost node being read that has one
+    int depth;
+    bool failed;
+
+    void loadError(const std::string& message);
+
+    uint8_t readByte();
+    uint32_t readVarint();
+    int32_t readSignedVarint();
+    const char* readLiteral();  // Copied into the arena
+    Symbol readSymbol();
+
+    // Where a node appears, the engines cast children without checking so the loader has to
+    enum class Position {
+        STATEMENT,
+        EXPRESSION,
+        BLOCK,
+        DECLARATION,  // The initializer of a for loop
+        ASSIGNMENT,   // The increment of a for loop
+        RETURN_VALUE  // An expression, or nothing for a bare return
+    };
+
+    // nullptr with failed set on an error, or for a bare return's missing value
+    ASTNode* readNode(Position where);
+    BlockNode* readBlock();
+    ASTNode* readFields(ASTNodeType type);
+};
+
+#endif  // AST_SERIALIZER_HPP
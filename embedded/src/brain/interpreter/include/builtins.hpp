@@ -0,0 +1,45 @@
+// The builtin functions every part of the interpreter agrees on, described once in a constant table
+// The Parser ties each call to its entry, so nothing looks a builtin up by name while running
+
+#ifndef BUILTINS_HPP
+#define BUILTINS_HPP
+
+#include <cstddef>
+
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "stringView.hpp"
+
+// Kinds of argument a builtin accepts
+enum class ArgumentKind {
+    ANY,      // int or float, passed through as is
+    NUMBER,   // int or float, converted to float
+    INTEGER,  // must already be an int
+    FLOAT,    // must already be a float
+    TRUTHY    // int or float, passed as 1 or 0
+};
+
+/**
+ * @brief Everything known about a builtin before the program runs
+ *
+ * id picks the implementation, the VM switches on it and the Interpreter indexes its dispatch table with it.
+ * A pure builtin only depends on its arguments, so the Optimizer may fold a call with constant arguments.
+ *
+ */
+struct BuiltinSignature {
+    const char* name;
+    Builtin id;
+    int numArguments;
+    ArgumentKind arguments[2];
+    ValueType returnType;
+    bool pure;
+};
+
+// Constant initialized, so on the ESP32 it stays in flash instead of being built after each upload
+extern const BuiltinSignature builtinSignatures[];
+extern const std::size_t builtinCount;
+
+// nullptr if name is not a builtin
+const BuiltinSignature* findBuiltin(StringView name);
+
+#endif  // BUILTINS_HPP
@@ -0,0 +1,154 @@
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sourceLocation.hpp"
+
+/**
+ * @brief Opcodes understood by the VirtualMachine
+ *
+ * The VM is stack based. Every value on the stack is an untyped 32 bit slot; the compiler
+ * has already worked out whether it holds an int or a float, so each arithmetic opcode
+ * comes in a typed _INT and _FLOAT flavor and no type checks happen at runtime.
+ *
+ */
+enum class OpCode : uint8_t {
+    PUSH_INT,     // push operand as an int
+    PUSH_FLOAT,   // push operand reinterpreted as a float
+    POP,          // discard the top of the stack
+
+    LOAD_LOCAL,   // push slot operand of the current frame
+    STORE_LOCAL,  // pop into slot operand of the current frame
+    LOAD_OUTER,   // push slot (operand & 0xFFFF) of the latest frame at nesting level (operand >> 16)
+    STORE_OUTER,  // pop into slot (operand & 0xFFFF) of the latest frame at nesting level (operand >> 16)
+
+    INT_TO_FLOAT,         // convert the top of the stack
+    FLOAT_TO_INT,         // truncate the top of the stack
+    FLOAT_TRUTHY,         // replace the float on top of the stack with 1 if it is non-zero, else 0
+
+    ADD_INT,
+    SUB_INT,
+    MUL_INT,
+    DIV_INT,
+    MOD_INT,
+    GREATER_INT,
+    LESS_INT,
+    GREATER_EQUAL_INT,
+    LESS_EQUAL_INT,
+    EQUAL_INT,
+    NOT_EQUAL_INT,
+
+    ADD_FLOAT,
+    SUB_FLOAT,
+    MUL_FLOAT,
+    DIV_FLOAT,
+    MOD_FLOAT,  // (int)a % (int)b, produces an int like the tree-walking interpreter
+    GREATER_FLOAT,
+    LESS_FLOAT,
+    GREATER_EQUAL_FLOAT,
+    LESS_EQUAL_FLOAT,
+    EQUAL_FLOAT,
+    NOT_EQUAL_FLOAT,
+
+    AND,  // logical and of two ints
+    OR,   // logical or of two ints
+
+    JUMP,           // jump forward to operand
+    JUMP_IF_FALSE,  // pop an int and jump to operand if it is zero
+    LOOP,           // jump backward to operand; also the point where execution may be stopped or yield to other tasks
+
+    CALL,          // call user function operand, its arguments are already on the stack
+    CALL_BUILTIN,  // call builtin operand, its arguments are already on the stack
+    RETURN,        // pop the return value, tear down the frame and push the value for the caller
+    HALT           // end of program
+};
+
+/**
+ * @brief Builtins the VM implements natively, the operand of CALL_BUILTIN
+ *
+ * Also the id in each BuiltinSignature of builtins.hpp, the Interpreter indexes its dispatch table with it.
+ * float_to_int and int_to_float are listed for completeness but compile straight to conversion opcodes.
+ *
+ */
+enum class Builtin : uint8_t {
+    PRINT_INT,
+    PRINT_FLOAT,
+    WAIT,
+    RAND,
+    FLOAT_TO_INT,
+    INT_TO_FLOAT,
+    RUNTIME,
+    POW,
+    PI_VALUE,  // PI itself is taken by the macro in interpreter.hpp
+    EXP,
+    SIN,
+    COS,
+    TAN,
+    ASIN,
+    ACOS,
+    ATAN,
+    ATAN2,
+    SQRT,
+    ABS,
+    FLOOR,
+    CEIL,
+    MIN,
+    MAX,
+    LOG,
+    LOG10,
+    LOG2,
+    ROUND,
+    SEND_BOOL
+};
+
+/**
+ * @brief A single VM instruction
+ *
+ * Jump operands are absolute instruction indices once the Program is linked.
+ *
+ */
+struct Instruction {
+    OpCode op;
+    int32_t operand;
+};
+
+/**
+ * @brief Everything the VM needs to know to call a compiled function
+ *
+ * Function 0 is always the top level program.
+ *
+ */
+struct FunctionInfo {
+    std::string name;
+    size_t entry;        // Index of the first instruction in Program::code
+    int level;           // Lexical nesting depth, the top level program is 0
+    int parent;          // Index of the function it is declared in, -1 for the top level program
+    int numParameters;   // Parameters occupy the first slots of the frame
+    int numSlots;        // Parameters plus every local the body declares
+    int maxStackDepth;   // Deepest the operand stack gets above the slots
+};
+
+/**
+ * @brief Where the instructions from firstInstruction up to the next span were compiled from
+ *
+ */
+struct SourceSpan {
+    size_t firstInstruction;
+    SourceLocation location;
+};
+
+/**
+ * @brief A compiled program
+ *
+ */
+struct Program {
+    std::vector<Instruction> code;
+    std::vector<FunctionInfo> functions;
+    std::vector<SourceSpan> locations;  // In order of firstInstruction, only read to report a runtime error
+    int maxLevel;  // Deepest function nesting, sizes the VM's display
+};
+
+#endif  // BYTECODE_HPP
@@ -0,0 +1,122 @@
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "error.hpp"
+#include "interpreter.hpp"
+#include "outputStream.hpp"
+
+/**
+ * @brief Lowers the AST produced by Parser::parseProgram into bytecode for the VirtualMachine
+ *
+ * The Resolver runs first and is the only semantic pass: it reports undeclared names, clashes and
+ * type errors, gives every variable a slot in its block's frame, every expression its static type,
+ * inserts the conversions and ties each call to its declaration. The Compiler only lays those block
+ * frames out in the frame of the function owning them and picks the opcodes, so the VM never looks
+ * at names or types while running.
+ *
+ * Function bodies are compiled when the block declaring them closes, like the Resolver resolves them,
+ * so the blocks they can see are still laid out.
+ *
+ */
+class Compiler {
+   public:
+    Compiler(OutputStream& outputStream, ErrorHandler& errorHandler);
+    ~Compiler();
+
+    // Returns nullptr if the program could not be resolved or compiled, the error has already been reported
+    // The caller owns the returned Program
+    Program* compile(BlockNode& ast);
+
+   private:
+    // Where a block's frame lives in the frame of the function owning it
+    struct Frame {
+        int level;                         // Nesting level of the function owning the frame
+        int firstSlot;                     // Slots are reused once the block closes
+        std::vector<int> pendingFunctions; // Indices in Program::functions, compiled when the block closes
+    };
+
+    // Jumps waiting for the end of a loop to be known
+    struct Loop {
+        std::vector<size_t> breakJumps;
+        std::vector<size_t> continueJumps;
+    };
+
+    // State of the function currently being emitted
+    struct FunctionState {
+        int index;
+        int level;
+        ValueType returnType;
+        std::vector<Instruction> code;
+        std::vector<SourceSpan> locations;  // Indexed like code until linked
+        std::vector<Loop> loops;
+        int nextSlot;
+        int numSlots;
+        int stackDepth;
+        int maxStackDepth;
+    };
+
+    OutputStream& outputStream;
+    ErrorHandler& errorHandler;
+
+    Program* program;
+    bool hadError;
+
+    std::vector<Frame> frames;                                 // Innermost block is at the back
+    std::vector<FunctionState> functions;                      // Innermost function is at the back
+    std::vector<FunctionDeclarationNode*> declarations;        // Indexed like Program::functions
+    std::unordered_map<const FunctionDeclarationNode*, int> functionIndices;  // The other way around, for call targets
+    std::vector<std::vector<Instruction>> functionCode;        // Finished bodies, linked together at the end
+    std::vector<std::vector<SourceSpan>> functionLocations;    // Their locations, linked along with them
+
+    // Of the statement, call or operation being compiled, reported with errors and recorded for the VM
+    SourceLocation currentLocation;
+
+    void compileError(const std::string& message);
+
+    // Emitting
+    size_t emit(OpCode op, int32_t operand = 0);
+    size_t emit(OpCode op, int32_t operand, int stackEffect);
+    size_t emitJump(OpCode op);
+    void patchJump(size_t jump);
+    void emitLoop(size_t target);
+    void emitVariable(OpCode localOp, OpCode outerOp, const VariableLocation& location);
+    size_t currentOffset() const;
+    void link();
+
+    // Frames
+    void pushFrame(int frameSize);
+    void popFrame();
+
+    // Functions
+    void beginFunction(int index, int level, ValueType returnType);
+    void endFunction();
+    void compileFunctionBody(int index);
+
+    // Statements
+    void compileBlock(BlockNode* block);
+    void compileStatement(ASTNode* statement);
+    void compileVariableDeclaration(VariableDeclarationNode* variableDeclaration);
+    void compileAssignment(AssignmentNode* assignment);
+    void compileFunctionDeclaration(FunctionDeclarationNode* functionDeclaration);
+    void compileIf(IfNode* ifStatement);
+    void compileWhile(WhileNode* whileStatement);
+    void compileFor(ForNode* forStatement);
+    void compileReturn(ReturnNode* returnStatement);
+    void compileBreakOrContinue(bool isBreak);
+
+    // Expressions leave one value of the type the Resolver gave them on the stack
+    void compileExpression(ASTNode* expression);
+    void compileNumber(NumberNode* number);
+    void compileBinaryOperation(BinaryOperationNode* binaryExpression);
+    void compileConversion(ConversionNode* conversion);
+    void compileFunctionCall(FunctionCallNode* functionCall);
+    void compileBuiltinCall(FunctionCallNode* functionCall);
+};
+
+#endif  // COMPILER_HPP
@@ -6,11 +6,10 @@
 #ifndef ERROR_HANDLING_HPP
 #define ERROR_HANDLING_HPP
 
-#include "outputStream.hpp"
+#include <atomic>
 
-// Global flag for the interpreter to stop execution
-// Can be an error or an interrupt from the GUI
-extern bool stopExecution;
+#include "outputStream.hpp"
+#include "sourceLocation.hpp"
 
 class ErrorHandler {
    public:
@@ -19,7 +18,12 @@ class ErrorHandler {
     // Function to handle errors and exceptions
     void handleError(const std::string& errorMessage);
 
-    bool shouldStopExecution();
+    // Ex. "Runtime Error: Division by zero at line 3, column 12"
+    void handleError(const std::string& errorMessage, SourceLocation location);
+
+    // Checked after nearly every evaluation, so it is a relaxed load rather than a lock
+    // Only the flag itself is shared between tasks, nothing is published through it
+    bool shouldStopExecution() const { return stopExecution.load(std::memory_order_relaxed); }
 
     void triggerStopExecution();
 
@@ -27,6 +31,9 @@ class ErrorHandler {
 
    private:
     OutputStream& outputStream;
+
+    // Set by an error or an interrupt from the GUI, Ex. the BLE task stopping a program for a new upload
+    std::atomic<bool> stopExecution;
 };
 
 #endif  // ERROR_HANDLING_HPP
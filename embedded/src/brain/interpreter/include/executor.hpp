@@ -0,0 +1,70 @@
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <cstdint>
+#include <functional>
+
+// How an engine measures the slice it may run for before letting other tasks run
+enum class YieldPolicy {
+    INSTRUCTIONS,  // a number of blocks and statements (tree-walking) or backward jumps and calls (bytecode)
+    TIME           // a number of microseconds
+};
+
+#define DEFAULT_YIELD_POLICY YieldPolicy::TIME
+#define DEFAULT_YIELD_SLICE 20000  // microseconds
+
+// Under YieldPolicy::TIME the clock is only read once every this many budget checks
+#define YIELD_CLOCK_INTERVAL 64
+
+/**
+ * @brief Common interface of the engines that can run a parsed program
+ *
+ * Ex. the tree-walking Interpreter in interpreter.hpp or the bytecode VirtualMachine in vm.hpp
+ *
+ * Engines run cooperatively: they call checkBudget() at every point they may yield, and once the
+ * slice is used up the yield hook runs. On embedded the default hook delays a tick so the idle task
+ * and BLE can run, on host it does nothing, but tests can install their own to count yields.
+ *
+ */
+class Executor {
+   public:
+    Executor();
+    virtual void interpret() = 0;
+    virtual ~Executor() = default;
+
+    // The slice is a number of instructions or microseconds depending on the policy
+    void setYieldSlice(YieldPolicy policy, uint32_t slice);
+    YieldPolicy getYieldPolicy() const;
+    uint32_t getYieldSlice() const;
+
+    void setYieldHook(const std::function<void()>& hook);
+
+    // How many times the engine has yielded since it was created
+    uint32_t getYieldCount() const;
+
+   protected:
+    // Cheap enough to call on every statement, only does real work once the budget runs out
+    inline void checkBudget() {
+        if (--budget == 0) {
+            budgetExpired();
+        }
+    }
+
+    // Starts a fresh slice, engines call this when interpret() starts
+    void resetBudget();
+
+   private:
+    YieldPolicy yieldPolicy;
+    uint32_t yieldSlice;
+    uint32_t budget;     // Checks left until the next yield (INSTRUCTIONS) or clock read (TIME)
+    int64_t sliceStart;  // Microseconds, only used under YieldPolicy::TIME
+    uint32_t yieldCount;
+    std::function<void()> yieldHook;
+
+    void budgetExpired();
+    void yield();
+
+    static int64_t nowMicroseconds();
+};
+
+#endif  // EXECUTOR_HPP
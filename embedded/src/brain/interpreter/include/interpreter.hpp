@@ -2,14 +2,16 @@
 #define INTERPRETER_HPP
 
 #include <functional>
-#include <map>
 #include <unordered_map>
 #include <vector>
 
 #include "ast.hpp"
 #include "error.hpp"
+#include "executor.hpp"
 #include "outputStream.hpp"
+#include "profiler.hpp"
 #include "radioFormatter.hpp"
+#include "resolver.hpp"
 
 #define PI 3.14159265358979323846
 
@@ -18,192 +20,171 @@ enum class ExitingType {
     BREAK,     // break out of the current loop
     CONTINUE,  // continue to the next iteration of the current loop
     RETURN,    // return a value from a function
-    NONE       // no return value (e.g. for print statements or an if statement without break or continue)
+    NONE,      // no return value (e.g. for print statements or an if statement without break or continue)
+    ERROR      // execution has to stop, the error has already been reported
 };
 
-// Tags for the various types of values that can be stored in a variable
-enum class ValueType {
-    INTEGER,
-    FLOAT,
-    FUNCTION
+// Number of variable slots shared by every active frame
+#define INTERPRETER_STACK_SIZE 2048
+
+// Storage for one variable, the Resolver has already worked out whether it holds an int or a float
+union Slot {
+    int intValue;
+    float floatValue;
 };
 
+// The variables of one block, laid out in the slots the Resolver assigned
+// The slots themselves belong to the Interpreter, so entering a block does not allocate
 class StackFrame {
    public:
-    StackFrame(StackFrame* parent, OutputStream& outputStream, ErrorHandler& errorHandler);
+    StackFrame(StackFrame* parent, Slot* slots);
     ~StackFrame();
 
-    void allocateFloatVariable(std::string& name, float value);
-    void allocateIntVariable(std::string& name, int value);
-    void allocateFunction(std::string& name, FunctionDeclarationNode* function);
-
-    void setFloatVariable(std::string& name, float value);
-    void setIntVariable(std::string& name, int value);
-    // No setFunction
-
-    float getFloatVariable(std::string& name);
-    int getIntVariable(std::string& name);
-    FunctionDeclarationNode* getFunction(std::string& name);
-
-    // What type is stored in the variable
-    ValueType getType(std::string& name);
-
-    // Check if a variable is allocated in any of the stack frames
-    bool isAllocated(std::string& name);
-
-    std::map<std::string, FunctionDeclarationNode*>& getFunctions();
-
-   private:
-    std::map<std::string, float> float_variables;
-    std::map<std::string, int> int_variables;
-    std::map<std::string, FunctionDeclarationNode*> functions;
-    StackFrame* parent;
-    OutputStream& outputStream;
-    ErrorHandler& errorHandler;
-};
-
-// The objects returned by expressions or statements or functions
-class ReturnableObject {
-   public:
-    virtual ValueType getType() = 0;
-    virtual ~ReturnableObject() = default;
-};
+    // The frame depth levels out, 0 being this frame
+    StackFrame* getAncestor(int depth);
 
-class ReturnableFloat : public ReturnableObject {
-   public:
-    ReturnableFloat(float value);
-    ValueType getType() override;
-    float getValue();
-    ~ReturnableFloat();
+    Slot& getSlot(int slot);
 
    private:
-    float value;
+    StackFrame* parent;  // The enclosing block's frame, or for a function body the frame the function was declared in
+    Slot* slots;
 };
 
-class ReturnableInt : public ReturnableObject {
-   public:
-    ReturnableInt(int value);
-    ValueType getType() override;
-    int getValue();
-    ~ReturnableInt();
-
-   private:
-    int value;
+// The value returned by expressions or function calls
+// Small enough to be passed around by value, so evaluating an expression never touches the heap
+struct Returnable {
+    ValueType type;
+    union {
+        int intValue;
+        float floatValue;
+    };
+
+    static Returnable fromInt(int value) {
+        Returnable returnable;
+        returnable.type = ValueType::INTEGER;
+        returnable.intValue = value;
+        return returnable;
+    }
+
+    static Returnable fromFloat(float value) {
+        Returnable returnable;
+        returnable.type = ValueType::FLOAT;
+        returnable.floatValue = value;
+        return returnable;
+    }
+
+    static Returnable none() {
+        Returnable returnable;
+        returnable.type = ValueType::VOID;
+        returnable.intValue = 0;
+        return returnable;
+    }
 };
 
-// The objects returned by scopes and blocks, carried through the likes of if, while, for, function calls
+// The result of a statement or block, carried through the likes of if, while, for, function calls
 // Ex break, continue, return
-class ExitingObject {
-   public:
-    virtual ExitingType getType() = 0;
-    virtual ~ExitingObject() = default;
-};
+struct Exiting {
+    ExitingType type;
+    Returnable value;  // Only meaningful for RETURN
 
-class ExitingBreak : public ExitingObject {
-   public:
-    ExitingBreak();
-    ExitingType getType() override;
-    ~ExitingBreak();
+    static Exiting of(ExitingType type) { return {type, Returnable::none()}; }
+    static Exiting returning(Returnable value) { return {ExitingType::RETURN, value}; }
 };
 
-class ExitingContinue : public ExitingObject {
-   public:
-    ExitingContinue();
-    ExitingType getType() override;
-    ~ExitingContinue();
-};
-
-class ExitingReturn : public ExitingObject {
-   public:
-    ExitingReturn();
-    ExitingReturn(ReturnableObject* value);
-    ExitingType getType() override;
-    ReturnableObject* getValue();
-    ~ExitingReturn();
-
-   private:
-    ReturnableObject* value;
-};
-
-class ExitingNone : public ExitingObject {
-   public:
-    ExitingNone();
-    ExitingType getType() override;
-    ~ExitingNone();
-};
-
-class Interpreter {
+class Interpreter : public Executor {
    public:
     Interpreter(BlockNode& ast, OutputStream& outputStream, ErrorHandler& errorHandler);
     Interpreter(BlockNode& ast, OutputStream& outputStream, ErrorHandler& errorHandler, RadioFormatter& radioFormatter);
-    void interpret();
+    void interpret() override;
     ~Interpreter();
 
+    // Times every statement into profiler from now on, nullptr to stop
+    // The profiler is not owned and has to outlive the Interpreter or be detached first
+    void setProfiler(Profiler* profiler);
+
    private:
     BlockNode& ast;
     OutputStream& outputStream;
     ErrorHandler& errorHandler;
     RadioFormatter* radioFormatter;
+    Profiler* profiler;
+
+    // Indexed by the Builtin id of the call's BuiltinSignature, the table is constant and shared by every Interpreter
+    using BuiltinFunction = Returnable (Interpreter::*)(const ArenaArray<ASTNode*>&, std::vector<StackFrame*>&);
+    static const BuiltinFunction builtinFunctions[];
+
+    // Slots for the variables of every active frame, slotsUsed of them are taken
+    std::vector<Slot> slots;
+    size_t slotsUsed;
 
-    using FunctionPtr = std::function<ReturnableObject*(std::vector<ASTNode*>&, std::vector<StackFrame*>&)>;
-    std::unordered_map<std::string, FunctionPtr> functionMap;
+    void resolve();
 
-    void initBuiltInFunctions();
+    // Claims the slots for a new frame, nullptr if the stack is full
+    Slot* pushSlots(int count);
+    void popSlots(int count);
 
+    // Reported at the statement or builtin call being interpreted, or at node
     void runtimeError(const std::string& message) const;
+    void runtimeError(const ASTNode* node, const std::string& message) const;
+    SourceLocation currentLocation;
 
     void interpretVariableDeclaration(VariableDeclarationNode* variableDeclaration, std::vector<StackFrame*>& stack);
     void interpretAssignment(AssignmentNode* assignment, std::vector<StackFrame*>& stack);
     void interpretFunctionDeclaration(FunctionDeclarationNode* functionDeclaration, std::vector<StackFrame*>& stack);
 
-    bool interpretTruthiness(ReturnableObject* condition, std::vector<StackFrame*>& stack);
-
-    // Expressions can return a ReturnableFloat or a ReturnableInt
-    ReturnableObject* interpretExpression(ASTNode* expression, std::vector<StackFrame*>& stack);
-    ReturnableObject* interpretVariableAccess(VariableAccessNode* variableAccess, std::vector<StackFrame*>& stack);
-    ReturnableObject* interpretBinaryOperation(BinaryOperationNode* binaryExpression, std::vector<StackFrame*>& stack);
-    ReturnableObject* interpretNumber(NumberNode* number, std::vector<StackFrame*>& stack);
-    ReturnableObject* interpretFunctionCall(FunctionCallNode* functionCall, std::vector<StackFrame*>& stack);
-
-    // Statements with block nodes can possibly return a ExitingObject such as ExitingBreak, ExitingContinue, ExitingReturn
-    ExitingObject* interpretStatement(ASTNode* statement, std::vector<StackFrame*>& stack);
-    ExitingObject* interpretBlock(BlockNode* block, std::vector<StackFrame*>& stack);
-    ExitingObject* interpretIf(IfNode* ifStatement, std::vector<StackFrame*>& stack);
-    ExitingObject* interpretWhile(WhileNode* whileStatement, std::vector<StackFrame*>& stack);
-    ExitingObject* interpretFor(ForNode* forStatement, std::vector<StackFrame*>& stack);
-    ExitingObject* interpretReturn(ReturnNode* returnStatement, std::vector<StackFrame*>& stack);
+    bool interpretTruthiness(const Returnable& condition, std::vector<StackFrame*>& stack);
+
+    // Expressions return an int or a float Returnable, of the static type the Resolver gave the expression
+    Returnable interpretExpression(ASTNode* expression, std::vector<StackFrame*>& stack);
+    Returnable interpretVariableAccess(VariableAccessNode* variableAccess, std::vector<StackFrame*>& stack);
+    Returnable interpretBinaryOperation(BinaryOperationNode* binaryExpression, std::vector<StackFrame*>& stack);
+    Returnable interpretIntOperation(BinaryOperationNode* binaryExpression, int left, int right);
+    Returnable interpretFloatOperation(BinaryOperationNode* binaryExpression, float left, float right);
+    Returnable interpretConversion(ConversionNode* conversion, std::vector<StackFrame*>& stack);
+    Returnable interpretNumber(NumberNode* number, std::vector<StackFrame*>& stack);
+    Returnable interpretFunctionCall(FunctionCallNode* functionCall, std::vector<StackFrame*>& stack);
+
+    // Statements with block nodes can possibly exit with a break, continue or return
+    Exiting interpretStatement(ASTNode* statement, std::vector<StackFrame*>& stack);
+    Exiting dispatchStatement(ASTNode* statement, std::vector<StackFrame*>& stack);
+    Exiting interpretBlock(BlockNode* block, std::vector<StackFrame*>& stack);
+    Exiting interpretBlock(BlockNode* block, StackFrame* frame, std::vector<StackFrame*>& stack);  // Runs the block in a frame that is already set up
+    Exiting interpretIf(IfNode* ifStatement, std::vector<StackFrame*>& stack);
+    Exiting interpretWhile(WhileNode* whileStatement, std::vector<StackFrame*>& stack);
+    Exiting interpretFor(ForNode* forStatement, std::vector<StackFrame*>& stack);
+    Exiting interpretReturn(ReturnNode* returnStatement, std::vector<StackFrame*>& stack);
     // continue and break do not need dedicated functions because they don't have any associated values as does return
 
     // Built-in functions
-    ReturnableObject* _print(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // print to output stream
-    ReturnableObject* _wait(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // wait for a given number of milliseconds
-    ReturnableObject* _rand(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // returns a random number [0, 1)
-    ReturnableObject* _float_to_int(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);  // convert a float to an int
-    ReturnableObject* _int_to_float(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);  // convert an int to a float
-    ReturnableObject* _runtime(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);       // return the time since interpretation start in milliseconds
-    ReturnableObject* _pow(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the first argument raised to the power of the second argument
-    ReturnableObject* _pi(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);            // return the value of pi
-    ReturnableObject* _exp(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the value of pi
-    ReturnableObject* _sin(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the sine of the argument
-    ReturnableObject* _cos(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the cosine of the argument
-    ReturnableObject* _tan(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the tangent of the argument
-    ReturnableObject* _asin(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the arcsine of the argument
-    ReturnableObject* _acos(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the arccosine of the argument
-    ReturnableObject* _atan(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the arctangent of the argument
-    ReturnableObject* _atan2(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // return the atan2 of the two arguments
-    ReturnableObject* _sqrt(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the square root of the argument
-    ReturnableObject* _abs(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the absolute value of the argument
-    ReturnableObject* _floor(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // return the floor of the argument
-    ReturnableObject* _ceil(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the ceiling of the argument
-    ReturnableObject* _min(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the minimum of the two arguments
-    ReturnableObject* _max(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the maximum of the two arguments
-    ReturnableObject* _log(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the natural logarithm of the argument
-    ReturnableObject* _log10(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // return the base 10 logarithm of the argument
-    ReturnableObject* _log2(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the base 2 logarithm of the argument
-    ReturnableObject* _round(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // returns the first argument rounded to the number of decimal places specified by the second argument
+    Returnable _print(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // print to output stream
+    Returnable _wait(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // wait for a given number of milliseconds
+    Returnable _rand(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // returns a random number [0, 1)
+    Returnable _float_to_int(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);  // convert a float to an int
+    Returnable _int_to_float(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);  // convert an int to a float
+    Returnable _runtime(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);       // return the time since interpretation start in milliseconds
+    Returnable _pow(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the first argument raised to the power of the second argument
+    Returnable _pi(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);            // return the value of pi
+    Returnable _exp(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the value of pi
+    Returnable _sin(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the sine of the argument
+    Returnable _cos(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the cosine of the argument
+    Returnable _tan(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the tangent of the argument
+    Returnable _asin(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the arcsine of the argument
+    Returnable _acos(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the arccosine of the argument
+    Returnable _atan(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the arctangent of the argument
+    Returnable _atan2(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // return the atan2 of the two arguments
+    Returnable _sqrt(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the square root of the argument
+    Returnable _abs(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the absolute value of the argument
+    Returnable _floor(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // return the floor of the argument
+    Returnable _ceil(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the ceiling of the argument
+    Returnable _min(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the minimum of the two arguments
+    Returnable _max(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the maximum of the two arguments
+    Returnable _log(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);           // return the natural logarithm of the argument
+    Returnable _log10(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // return the base 10 logarithm of the argument
+    Returnable _log2(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);          // return the base 2 logarithm of the argument
+    Returnable _round(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);         // returns the first argument rounded to the number of decimal places specified by the second argument
 
     // Built-in tile functions
-    ReturnableObject* _sendBool(std::vector<ASTNode*>& arguments, std::vector<StackFrame*>& stack);  // send a boolean value to a tile; argument 1 is the tile index, argument 2 is the value
+    Returnable _sendBool(const ArenaArray<ASTNode*>& arguments, std::vector<StackFrame*>& stack);  // send a boolean value to a tile; argument 1 is the tile index, argument 2 is the value
 };
 
 #endif  // INTERPRETER_HPP
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include <string>
+#include <vector>
+
+#include "ast.hpp"
+#include "builtins.hpp"
+
+/**
+ * @brief Simplifies a parsed program before it is handed to an engine
+ *
+ * Binary and mono operations on constants are folded into a single NumberNode, as are calls to pure
+ * builtins (Ex. pi(), sin(1.5), int_to_float(5)) with constant arguments. Identities whose constant
+ * is an integer, like x * 1 or x + 0, are reduced to x.
+ *
+ * Anything that would fail at runtime (division by zero, sqrt of a negative, a builtin given the
+ * wrong type) is left in place so the engine still reports it, at the point it is reached.
+ *
+ */
+class Optimizer {
+   public:
+    // Folded constants are allocated from arena, which should be the one the program was parsed into
+    Optimizer(Arena& arena = astArena);
+    ~Optimizer();
+
+    // Simplifies the program in place
+    void optimize(BlockNode& ast);
+
+    // Number of nodes replaced by the last optimize()
+    int getFoldCount() const;
+
+   private:
+    Arena& arena;
+    int foldCount;
+
+    void optimizeBlock(BlockNode* block);
+    void optimizeStatement(ASTNode* statement);
+
+    // Each returns the expression to use in its place, a replaced node is left for the arena to free
+    ASTNode* optimizeExpression(ASTNode* expression);
+    ASTNode* optimizeBinaryOperation(BinaryOperationNode* binaryExpression);
+    ASTNode* optimizeMonoOperation(MonoOperationNode* monoExpression);
+    ASTNode* optimizeFunctionCall(FunctionCallNode* functionCall);
+
+    // Returns the folded constant, or nullptr if the operation can not be folded
+    NumberNode* foldBinaryOperation(Operator op, NumberNode* left, NumberNode* right) const;
+    NumberNode* foldBuiltin(Builtin builtin, const std::vector<NumberNode*>& arguments) const;
+
+    NumberNode* makeInt(int value) const;
+    NumberNode* makeFloat(float value) const;
+};
+
+#endif  // OPTIMIZER_HPP
@@ -0,0 +1,69 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.hpp"
+#include "outputStream.hpp"
+
+// Statements listed in a report sent to the web app, the hottest ones
+#define PROFILE_REPORT_LINES 10
+
+// What one statement cost, summed over every time it ran
+struct ProfileEntry {
+    const ASTNode* statement;
+    uint32_t count;              // Times it ran
+    int64_t totalNanoseconds;    // Including the statements nested in it and the functions it called
+    int64_t selfNanoseconds;     // Excluding those, what is left is spent in the statement itself
+};
+
+/**
+ * @brief Counts how often each statement runs and how long it takes, to find the hot spots of a program
+ *
+ * The Interpreter calls enter and exit around every statement while a profiler is attached with
+ * Interpreter::setProfiler. Detached, all it costs is one branch per statement.
+ *
+ * Entries are kept by node and reported with the node's source location, so statements sharing a
+ * line are told apart. A recursive call adds to the total time of a statement that is still running.
+ *
+ * Ex. Profiler profiler; interpreter.setProfiler(&profiler); interpreter.interpret(); profiler.report(outputStream);
+ *
+ */
+class Profiler {
+   public:
+    Profiler();
+
+    void enter(const ASTNode* statement);
+    void exit();
+
+    // Forgets every entry, Ex. when a new program is uploaded
+    void reset();
+
+    // Hottest first, by self time then by count
+    std::vector<ProfileEntry> getEntries() const;
+
+    // Ex. "3:5 ASSIGNMENT_NODE ran 1000 times, 812 us (self 640 us)", one line per entry up to limit
+    std::string toString(size_t limit = PROFILE_REPORT_LINES) const;
+
+    // Sends toString framed by PROFILE_FLAG
+    void report(OutputStream& outputStream, size_t limit = PROFILE_REPORT_LINES) const;
+
+   private:
+    // A statement that has been entered and not exited yet
+    struct Running {
+        ProfileEntry* entry;
+        int64_t start;
+        int64_t childNanoseconds;  // Spent in the statements it entered
+    };
+
+    // References to the entries stay valid as the map grows
+    std::unordered_map<const ASTNode*, ProfileEntry> entries;
+    std::vector<Running> running;
+
+    static int64_t nowNanoseconds();
+};
+
+#endif  // PROFILER_HPP
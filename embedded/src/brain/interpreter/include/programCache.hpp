@@ -0,0 +1,88 @@
+// Keeps compiled programs across uploads and reboots, keyed by a hash of their source
+// An identical script is then run from its cached bytecode instead of being tokenized, parsed and compiled again
+
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "bytecode.hpp"
+
+// Bump whenever the layout below, the opcodes or the builtins change, older entries are then ignored
+#define PROGRAM_CACHE_VERSION 3
+
+// Programs kept at once, a new one replaces whichever shares its slot
+#define PROGRAM_CACHE_SLOTS 4
+
+// Start of a hash, the FNV-1a offset basis
+#define SOURCE_HASH_SEED 14695981039346656037ull
+
+// Where the entries are kept, Ex. a file per slot on host or an NVS blob per slot on the ESP32
+class ProgramCacheStorage {
+   public:
+    virtual ~ProgramCacheStorage() = default;
+
+    // False if the slot is empty or cannot be read
+    virtual bool read(uint32_t slot, std::string& entry) = 0;
+    virtual bool write(uint32_t slot, const std::string& entry) = 0;
+};
+
+// Keeps slot i in directory/program<i>.bin
+class FileProgramCacheStorage : public ProgramCacheStorage {
+   public:
+    explicit FileProgramCacheStorage(const std::string& directory);
+
+    bool read(uint32_t slot, std::string& entry) override;
+    bool write(uint32_t slot, const std::string& entry) override;
+
+   private:
+    std::string directory;
+
+    std::string pathOf(uint32_t slot) const;
+};
+
+/**
+ * @brief Stores compiled programs by the hash of the source they were compiled from
+ *
+ * An entry is a fixed header followed by the Program, all integers little endian:
+ *
+ *   magic "BRPC", u16 version, u16 reserved, u64 source hash, u32 payload size, u32 CRC-32 of the payload
+ *   payload: i32 maxLevel,
+ *            u32 count, then per instruction u8 opcode, i32 operand
+ *            u32 count, then per function u32 name length, name, u32 entry, i32 level, i32 parent, i32 parameters, i32 slots, i32 stack depth
+ *            u32 count, then per source span u32 first instruction, u16 line, u16 column
+ *
+ * An entry of another version, for another source, with a bad checksum or that does not describe a
+ * runnable program is a miss, so the worst a stale or corrupt cache can do is cost a parse.
+ *
+ * Ex. Program* program = cache.load(source, size); if (program == nullptr) { ...compile...; cache.store(source, size, *compiled); }
+ *
+ */
+class ProgramCache {
+   public:
+    explicit ProgramCache(ProgramCacheStorage& storage);
+
+    // The cached program for this source, owned by the caller, or nullptr if there is none
+    Program* load(const char* source, size_t size);
+    Program* loadByHash(uint64_t sourceHash);
+
+    // Returns false if the entry could not be written
+    bool store(const char* source, size_t size, const Program& program);
+    bool storeByHash(uint64_t sourceHash, const Program& program);
+
+    // FNV-1a, pass the previous result as hash to hash a source that arrives in pieces
+    static uint64_t hashSource(const char* source, size_t size, uint64_t hash = SOURCE_HASH_SEED);
+
+    // The entry layout above, exposed for tests and host tools
+    static std::string serialize(uint64_t sourceHash, const Program& program);
+    static Program* deserialize(uint64_t sourceHash, const std::string& entry);
+
+   private:
+    ProgramCacheStorage& storage;
+
+    static uint32_t slotOf(uint64_t sourceHash);
+};
+
+#endif  // PROGRAM_CACHE_HPP
@@ -0,0 +1,105 @@
+#ifndef RESOLVER_HPP
+#define RESOLVER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.hpp"
+#include "error.hpp"
+#include "outputStream.hpp"
+#include "symbols.hpp"
+
+/**
+ * @brief Gives every variable a frame slot and a static type before either engine runs
+ *
+ * Each block gets a frame, and every VariableDeclarationNode, AssignmentNode and VariableAccessNode
+ * is told how many frames out its variable lives and at which slot. Function calls are tied to the
+ * declaration they call. The Interpreter then never looks a name up while running, and the Compiler
+ * lays the block frames out in its function frames.
+ *
+ * It is also the only type checker. Every expression is given its static type and a ConversionNode
+ * is inserted wherever a value has to change type: mixed operands, initializers, assignments,
+ * arguments, return values and conditions. Builtins are checked against their signature. The
+ * Interpreter then never checks a value's type while running, and the Compiler only picks opcodes.
+ *
+ * A function's parameters take the first slots of its body's frame. A for loop's variable is only
+ * visible inside the loop but is stored in the enclosing block's frame. Function bodies are resolved
+ * when the block declaring them closes, so they can see everything that block declares.
+ *
+ */
+class Resolver {
+   public:
+    // Conversions are allocated from arena, which should be the one the program was parsed into
+    Resolver(OutputStream& outputStream, ErrorHandler& errorHandler, Arena& arena = astArena);
+    ~Resolver();
+
+    // Returns false if the program could not be resolved, the error has already been reported
+    bool resolve(BlockNode& ast);
+
+   private:
+    struct Variable {
+        int slot;
+        ValueType type;
+    };
+
+    // A function whose body is resolved when the scope declaring it closes
+    struct PendingFunction {
+        FunctionDeclarationNode* declaration;
+        std::vector<int> visible;  // Names each enclosing scope had declared at the declaration, see visibleDeclarations
+    };
+
+    struct Scope {
+        std::unordered_map<Symbol, Variable> variables;
+        std::unordered_map<Symbol, FunctionDeclarationNode*> functions;
+        std::unordered_map<Symbol, int> declarationOrder;        // Of the variables and functions, 0 for the first declared
+        std::vector<PendingFunction> pendingFunctions;
+        bool ownsFrame;                                          // false for a for loop, whose variable lives in the enclosing block's frame
+        int frameSize;
+    };
+
+    OutputStream& outputStream;
+    ErrorHandler& errorHandler;
+    Arena& arena;
+
+    std::vector<Scope> scopes;
+
+    // While a deferred body is resolved, how many names of each enclosing scope count as clashes
+    // Ex. a local of a body does not clash with a variable its declaring block declares after the function
+    // Scopes past its end, the body's own, count every name
+    std::vector<int> visibleDeclarations;
+
+    bool hadError;
+    ValueType returnType;  // Of the function whose body is being resolved, VOID in the program block
+
+    void resolveError(const std::string& message);
+    SourceLocation currentLocation;  // Of the statement, variable or call being resolved, reported with errors
+
+    void pushScope(bool ownsFrame);
+    void popScope();
+    Scope& frameScope();
+    bool isDeclared(Symbol name) const;
+    void recordDeclaration(Symbol name);
+    bool declareVariable(Symbol name, const std::string& type, VariableLocation& location);
+    bool findVariable(Symbol name, VariableLocation& location) const;
+
+    // expression itself if it already has the type, otherwise a ConversionNode around it
+    ASTNode* convert(ASTNode* expression, ValueType type);
+    ASTNode* truthy(ASTNode* expression);  // An int for conditions and logical operators
+    static ValueType returnTypeOf(const FunctionDeclarationNode* function);
+
+    void resolveBlock(BlockNode* block, FunctionDeclarationNode* function);
+    void resolveStatement(ASTNode* statement);
+    void resolveVariableDeclaration(VariableDeclarationNode* variableDeclaration);
+    void resolveAssignment(AssignmentNode* assignment);
+    void resolveFunctionDeclaration(FunctionDeclarationNode* functionDeclaration);
+    void resolveFor(ForNode* forStatement);
+
+    // Expressions return their static type, which is also set on the node
+    ValueType resolveExpression(ASTNode* expression);
+    ValueType resolveBinaryOperation(BinaryOperationNode* binaryExpression);
+    ValueType resolveFunctionCall(FunctionCallNode* functionCall);
+    ValueType resolveBuiltinCall(FunctionCallNode* functionCall);
+};
+
+#endif  // RESOLVER_HPP
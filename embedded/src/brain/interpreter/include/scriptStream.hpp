@@ -0,0 +1,43 @@
+#ifndef SCRIPT_STREAM_HPP
+#define SCRIPT_STREAM_HPP
+
+#include <cstddef>
+#include <string>
+
+#include "ast.hpp"
+#include "tokenizer.hpp"
+
+/**
+ * @brief Tokenizes and parses a script while it is still arriving, Ex. over BLE
+ *
+ * Each chunk is tokenized as soon as it is fed, and every statement of the program block that is
+ * complete is parsed right away. Once the last chunk is in, finish() only has the tail of the script
+ * left to parse, so the program can start without waiting for a whole parse after the transfer.
+ *
+ * The result is the same as tokenizing and parsing the whole script at once, whatever the chunk sizes.
+ *
+ */
+class ScriptStream {
+   public:
+    // Nodes are allocated from arena, as with Parser
+    ScriptStream(OutputStream& outputStream, ErrorHandler& errorHandler, Arena& arena = astArena);
+
+    ScriptStream(const ScriptStream&) = delete;
+    ScriptStream& operator=(const ScriptStream&) = delete;
+
+    void feed(const char* chunk, std::size_t length);
+
+    // The parsed program, or ERROR_NODE after reporting what is wrong with it
+    BlockNode* finish();
+
+    const std::string& getSource() const;  // Every chunk fed so far
+    std::size_t getTokenCount() const;
+    std::size_t getStatementCount() const;  // Statements of the program block parsed so far
+
+   private:
+    Tokenizer tokenizer;
+    Parser parser;  // Reads the tokenizer's tokens as they grow
+    std::size_t statementCount;
+};
+
+#endif  // SCRIPT_STREAM_HPP
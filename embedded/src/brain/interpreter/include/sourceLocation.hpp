@@ -0,0 +1,19 @@
+// Where something is in a script, carried from the tokens to the AST so errors can point at it
+// Only the numbers are kept, never the source text
+
+#ifndef SOURCE_LOCATION_HPP
+#define SOURCE_LOCATION_HPP
+
+#include <cstdint>
+#include <string>
+
+// Both 1 based, line 0 when the location is unknown, Ex. a node made by the optimizer
+struct SourceLocation {
+    uint16_t line;
+    uint16_t column;
+};
+
+// Ex. " at line 3, column 12", or nothing if the location is unknown
+std::string locationToString(SourceLocation location);
+
+#endif  // SOURCE_LOCATION_HPP
@@ -0,0 +1,77 @@
+// A borrowed run of characters, Ex. a token's lexeme within the source it was read from
+// Stands in for std::string_view, which the C++11 the ESP32 component is built with does not have
+
+#ifndef STRING_VIEW_HPP
+#define STRING_VIEW_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief A pointer and a length into characters owned by someone else
+ *
+ * Nothing is copied or freed, so the characters have to outlive the view. The characters are not null
+ * terminated, use str() for anything that needs a std::string or a C string.
+ *
+ */
+class StringView {
+   public:
+    StringView() : characters(""), length(0) {}
+    StringView(const char* characters, std::size_t length) : characters(characters), length(length) {}
+    StringView(const char* characters) : characters(characters), length(std::strlen(characters)) {}
+    StringView(const std::string& string) : characters(string.data()), length(string.size()) {}
+
+    const char* data() const { return characters; }
+    std::size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    char operator[](std::size_t index) const { return characters[index]; }
+
+    const char* begin() const { return characters; }
+    const char* end() const { return characters + length; }
+
+    std::string str() const { return std::string(characters, length); }
+
+   private:
+    const char* characters;
+    std::size_t length;
+};
+
+inline bool operator==(StringView a, StringView b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+inline bool operator!=(StringView a, StringView b) { return !(a == b); }
+
+// For messages, Ex. "Unexpected token " + token.lexeme
+inline std::string operator+(const std::string& a, StringView b) {
+    std::string result;
+    result.reserve(a.size() + b.size());
+    result.append(a).append(b.data(), b.size());
+    return result;
+}
+
+inline std::string operator+(StringView a, const std::string& b) {
+    std::string result;
+    result.reserve(a.size() + b.size());
+    result.append(a.data(), a.size()).append(b);
+    return result;
+}
+
+inline std::ostream& operator<<(std::ostream& stream, StringView view) {
+    return stream.write(view.data(), view.size());
+}
+
+// FNV-1a, so views can key unordered containers
+struct StringViewHash {
+    std::size_t operator()(StringView view) const {
+        std::size_t hash = 2166136261u;
+        for (char character : view) {
+            hash = (hash ^ (unsigned char)character) * 16777619u;
+        }
+        return hash;
+    }
+};
+
+#endif  // STRING_VIEW_HPP
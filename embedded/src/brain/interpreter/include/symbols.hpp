@@ -0,0 +1,54 @@
+// Interns identifiers so the rest of the interpreter compares small integers instead of strings
+// The tokenizer interns every identifier it reads; the name is only looked up again for messages and toString()
+
+#ifndef SYMBOLS_HPP
+#define SYMBOLS_HPP
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "stringView.hpp"
+
+typedef int Symbol;
+
+// Symbol of tokens and nodes that carry no name, Ex. a Token that is not an IDENTIFIER
+#define NO_SYMBOL 0
+
+/**
+ * @brief Maps each distinct identifier to a small integer and back
+ *
+ * Every name is stored once. Symbols stay valid until clear(), which should only be called once no
+ * tokens or AST nodes from the previous program are left.
+ *
+ */
+class SymbolTable {
+   public:
+    SymbolTable();
+    ~SymbolTable();
+
+    // Returns the symbol for name, adding it if it is new
+    // Only a new name is copied, so interning a lexeme that was seen before allocates nothing
+    Symbol intern(StringView name);
+
+    // Returns the symbol for name, or NO_SYMBOL if it was never interned
+    Symbol find(StringView name) const;
+
+    const std::string& name(Symbol symbol) const;
+
+    // Number of symbols, including NO_SYMBOL
+    std::size_t size() const;
+
+    // Forgets every symbol, Ex. before a new program is uploaded
+    void clear();
+
+   private:
+    std::deque<std::string> names;  // Indexed by symbol, a deque so the map's views stay valid
+    std::unordered_map<StringView, Symbol, StringViewHash> symbols;  // Keys view into names
+};
+
+// The table shared by the tokenizer, parser and engines
+extern SymbolTable symbolTable;
+
+#endif  // SYMBOLS_HPP
@@ -1,10 +1,14 @@
 #ifndef TOKENIZER_HPP
 #define TOKENIZER_HPP
 
+#include <cstddef>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
+#include "sourceLocation.hpp"
+#include "stringView.hpp"
+#include "symbols.hpp"
+
 /**
  * @brief Enum for token types
  *
@@ -32,37 +36,67 @@ enum class TokenType {
  * Contains the type of the token and the lexeme (the actual string that the token represents)
  *
  * @param type The type of the token
- * @param lexeme The lexeme of the token
+ * @param lexeme The lexeme of the token, a view into the source the Tokenizer read
+ * @param symbol The interned lexeme of an IDENTIFIER, NO_SYMBOL for every other type
+ * @param offset Where the lexeme starts in the source
+ * @param location The line and column the lexeme starts at, for error messages
  *
  */
 struct Token {
     TokenType type;
-    std::string lexeme;
+    StringView lexeme;
+    Symbol symbol;
+    std::size_t offset;
+    SourceLocation location;
 };
 
 /**
  * @brief Tokenizer object to convert source code into tokens
  *
- * The tokenizer takes in a string of source code and tokenizes it into a vector of tokens
+ * The tokenizer takes in a string of source code and tokenizes it into a vector of tokens.
+ * Lexemes are views into the source, so the only allocation is the token vector (and the name of an
+ * identifier the first time the symbol table sees it).
+ *
+ * A Tokenizer made with no source streams instead: feed() appends a chunk, Ex. one BLE write, and
+ * tokenizes everything the chunk completed, finish() tokenizes the rest once the last chunk is in.
  *
  * @param sourceCode The source code to tokenize
  *
  */
 class Tokenizer {
    public:
+    // Copies sourceCode, the tokens are valid for as long as the Tokenizer is
     Tokenizer(const std::string& sourceCode);
+
+    // Borrows source without copying it, it has to stay alive and unchanged for as long as the tokens are used
+    Tokenizer(const char* source, std::size_t length);
+
+    // Streams the source through feed() and finish()
+    Tokenizer();
+
     Tokenizer(const Tokenizer&) = delete;
     Tokenizer& operator=(const Tokenizer&) = delete;
     std::vector<Token> tokenize();
 
+    // Streaming only, the tokens so far are in getTokens()
+    // A token that the next chunk could still extend, Ex. "whi" or "1.", is held back until then
+    void feed(const char* chunk, std::size_t length);
+    void finish();
+    const std::vector<Token>& getTokens() const;
+    const std::string& getSource() const;  // Every chunk fed so far
+
     static std::string tokenTypeToString(TokenType tokenType);
-    static const std::unordered_set<std::string> keywords;
-    static const std::unordered_set<std::string> doubleCharOperators;
-    static const std::unordered_set<char> singleCharOperators;
+
+    // Classification by switch rather than hashed sets, nothing is built to look a lexeme up
+    static bool isKeyword(StringView word);
+    static std::size_t operatorLength(char first, char second);  // 2 for Ex. >=, 1 for Ex. +, 0 if first starts no operator
 
    private:
-    std::string sourceCode;
+    std::string ownedSource;  // Only used by the copying and streaming constructors
+    const char* source;
+    std::size_t sourceLength;
     std::size_t currentPosition;
+    std::vector<Token> streamedTokens;  // Views into ownedSource, moved along when it reallocates
 
     char peek() const;            // Peek at the current character
     char peek(int offset) const;  // Peek at the character at the given offset (default: 1)
@@ -72,11 +106,24 @@ class Tokenizer {
     void skipWhitespace();
     void skipComment();
 
+    // The token from start up to the current position
+    Token makeToken(TokenType type, std::size_t start) const;
+
+    // Tokens are kept in order, so only the characters since the last one are scanned for newlines
+    SourceLocation locate(std::size_t position);
+    std::size_t locatedPosition;
+    std::size_t locatedLine;
+    std::size_t locatedLineStart;
+
     Token parseToken();
     Token parseKeywordOrIdentifier();
-    Token parseNumber(bool isNegative);
+    Token parseNumber(std::size_t start);  // start is before the '-' of a negative literal
     Token parseOperator();
     Token parseUnknown();
+
+    // Appends every token that ends at least margin characters before the end of the source
+    // Lookahead decides where a token ends, so one closer to the end is read again with the next chunk
+    void tokenizeInto(std::vector<Token>& tokens, std::size_t margin);
 };
 
 #endif  // TOKENIZER_HPP
@@ -0,0 +1,39 @@
+// Debug tracing that compiles away when disabled
+// Ex. TRACE(TRACE_DEBUG, TRACE_PARSER, "Parsed %u statements\n", count);
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdio>
+
+// Levels, a trace is printed if its level is at most TRACE_LEVEL
+#define TRACE_OFF 0
+#define TRACE_INFO 1   // Once per upload, Ex. progress through parsing
+#define TRACE_DEBUG 2  // Per token or per evaluation, far too slow to leave on the ESP32
+
+// Categories, OR them into TRACE_CATEGORIES to pick what is traced
+#define TRACE_UPLOAD 0x1       // Receiving, parsing and starting scripts in main.cpp
+#define TRACE_PARSER 0x2       // ast.cpp
+#define TRACE_INTERPRETER 0x4  // interpreter.cpp
+
+// Set with -DTRACE_LEVEL=2 and -DTRACE_CATEGORIES=0x4, or here
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_OFF
+#endif
+
+#ifndef TRACE_CATEGORIES
+#define TRACE_CATEGORIES (TRACE_UPLOAD | TRACE_PARSER | TRACE_INTERPRETER)
+#endif
+
+// A constant, so a disabled trace is dropped by the compiler along with its arguments
+#define TRACE_ENABLED(level, category) ((level) <= TRACE_LEVEL && ((category) & TRACE_CATEGORIES) != 0)
+
+// The arguments are still type checked when disabled, so traces cannot rot
+#define TRACE(level, category, ...)            \
+    do {                                       \
+        if (TRACE_ENABLED(level, category)) {  \
+            printf(__VA_ARGS__);               \
+        }                                      \
+    } while (0)
+
+#endif  // TRACE_HPP
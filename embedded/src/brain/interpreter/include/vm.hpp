@@ -0,0 +1,82 @@
+#ifndef VM_HPP
+#define VM_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "error.hpp"
+#include "executor.hpp"
+#include "interpreter.hpp"
+#include "outputStream.hpp"
+#include "radioFormatter.hpp"
+
+// Number of 32 bit slots shared by every frame's variables and operands
+#define VM_STACK_SIZE 2048
+
+// Deepest chain of user function calls before a stack overflow is reported
+#define VM_MAX_CALL_DEPTH 256
+
+/**
+ * @brief Runs a program as bytecode instead of walking the AST
+ *
+ * The AST is compiled once on construction; interpret() can then be called any number of times.
+ * Output, errors and builtins behave like the tree-walking Interpreter.
+ *
+ */
+class VirtualMachine : public Executor {
+   public:
+    VirtualMachine(BlockNode& ast, OutputStream& outputStream, ErrorHandler& errorHandler);
+    VirtualMachine(BlockNode& ast, OutputStream& outputStream, ErrorHandler& errorHandler, RadioFormatter& radioFormatter);
+
+    // Runs a program compiled earlier, Ex. loaded from the ProgramCache, and takes ownership of it
+    VirtualMachine(Program* program, OutputStream& outputStream, ErrorHandler& errorHandler);
+    VirtualMachine(Program* program, OutputStream& outputStream, ErrorHandler& errorHandler, RadioFormatter& radioFormatter);
+
+    void interpret() override;
+    ~VirtualMachine();
+
+    // The compiled program, nullptr if compilation failed
+    const Program* getProgram() const;
+
+   private:
+    // Stack slots carry no type, the compiler already knows which one it is
+    union Slot {
+        int32_t i;
+        float f;
+    };
+
+    struct CallFrame {
+        size_t returnAddress;
+        Slot* framePointer;
+        int function;
+        Slot* savedDisplay;  // The display entry this call replaced
+    };
+
+    Program* program;
+    OutputStream& outputStream;
+    ErrorHandler& errorHandler;
+    RadioFormatter* radioFormatter;
+
+    std::vector<Slot> stack;
+    std::vector<CallFrame> frames;
+
+    // display[level] is the frame of the latest active function at that nesting level
+    std::vector<Slot*> display;
+
+    void compile(BlockNode& ast);
+
+    // Sizes the stacks for the program
+    void prepare();
+
+    // Reported at where the instruction was compiled from
+    void runtimeError(size_t instruction, const std::string& message) const;
+    SourceLocation locationOf(size_t instruction) const;
+
+    // Pops the builtin's arguments and pushes its result, returns false on a runtime error
+    bool callBuiltin(Builtin builtin, Slot*& stackPointer, size_t instruction);
+};
+
+#endif  // VM_HPP
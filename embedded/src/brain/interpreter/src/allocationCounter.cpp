@@ -0,0 +1,135 @@
+#include "allocationCounter.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+AllocationCounter allocationCounter;
+
+// What the current thread is doing, set by the scopes
+// Plain ints so they need no constructor either
+static thread_local int currentPhase = (int)AllocationPhase::OTHER;
+static thread_local int currentNodeType = -1;  // No node
+
+AllocationCounts AllocationCounter::load(const Counts& counts) {
+    AllocationCounts result;
+    result.allocations = counts.allocations.load(std::memory_order_relaxed);
+    result.bytes = counts.bytes.load(std::memory_order_relaxed);
+    return result;
+}
+
+AllocationCounts AllocationCounter::getTotal() const {
+    AllocationCounts total = {0, 0};
+    for (const Counts& phase : phases) {
+        AllocationCounts counts = load(phase);
+        total.allocations += counts.allocations;
+        total.bytes += counts.bytes;
+    }
+    return total;
+}
+
+AllocationCounts AllocationCounter::getPhase(AllocationPhase phase) const { return load(phases[(std::size_t)phase]); }
+
+AllocationCounts AllocationCounter::getNodeType(ASTNodeType type) const { return load(nodeTypes[(std::size_t)type]); }
+
+std::size_t AllocationCounter::getLiveBytes() const { return liveBytes.load(std::memory_order_relaxed); }
+
+std::size_t AllocationCounter::getPeakLiveBytes() const { return peakLiveBytes.load(std::memory_order_relaxed); }
+
+void AllocationCounter::resetPeak() { peakLiveBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+void AllocationCounter::reset() {
+    for (Counts& counts : phases) {
+        counts.allocations.store(0, std::memory_order_relaxed);
+        counts.bytes.store(0, std::memory_order_relaxed);
+    }
+    for (Counts& counts : nodeTypes) {
+        counts.allocations.store(0, std::memory_order_relaxed);
+        counts.bytes.store(0, std::memory_order_relaxed);
+    }
+    resetPeak();
+}
+
+void AllocationCounter::recordAllocation(std::size_t size) {
+    Counts& phase = phases[currentPhase];
+    phase.allocations.fetch_add(1, std::memory_order_relaxed);
+    phase.bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (currentNodeType >= 0) {
+        Counts& nodeType = nodeTypes[currentNodeType];
+        nodeType.allocations.fetch_add(1, std::memory_order_relaxed);
+        nodeType.bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    std::size_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::size_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void AllocationCounter::recordFree(std::size_t size) { liveBytes.fetch_sub(size, std::memory_order_relaxed); }
+
+AllocationPhaseScope::AllocationPhaseScope(AllocationPhase phase) : previous((AllocationPhase)currentPhase) { currentPhase = (int)phase; }
+
+AllocationPhaseScope::~AllocationPhaseScope() { currentPhase = (int)previous; }
+
+AllocationNodeScope::AllocationNodeScope(const ASTNode* node) : previous(currentNodeType) { currentNodeType = (int)node->getNodeType(); }
+
+AllocationNodeScope::~AllocationNodeScope() { currentNodeType = previous; }
+
+#if ALLOCATION_TRACKING
+
+// The size is kept in front of each block so delete knows how much is freed
+// On the ESP32 this catches every C++ allocation; malloc calls from C, Ex. in the BLE stack, are not counted
+static const std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+static void* countedAllocate(std::size_t size) {
+    char* block = (char*)std::malloc(HEADER_SIZE + size);
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    std::memcpy(block, &size, sizeof(size));
+    allocationCounter.recordAllocation(size);
+    return block + HEADER_SIZE;
+}
+
+static void countedFree(void* pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+
+    char* block = (char*)pointer - HEADER_SIZE;
+    std::size_t size;
+    std::memcpy(&size, block, sizeof(size));
+    allocationCounter.recordFree(size);
+    std::free(block);
+}
+
+void* operator new(std::size_t size) {
+    void* pointer = countedAllocate(size);
+    if (pointer == nullptr) {
+        // The ESP-IDF component may be built with -fno-exceptions, out of memory is fatal there
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return pointer;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+// Every form that can be paired with the replaced delete has to go through the same header
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size); }
+
+void operator delete(void* pointer) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { countedFree(pointer); }
+
+#endif  // ALLOCATION_TRACKING
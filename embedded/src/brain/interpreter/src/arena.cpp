@@ -0,0 +1,106 @@
+#include "arena.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+Arena astArena;
+
+// Chunk headers are padded so the first allocation is aligned for anything
+static const std::size_t CHUNK_HEADER_SIZE = (sizeof(void*) * 3 + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+Arena::Arena() : Arena(ARENA_CHUNK_SIZE) {}
+
+Arena::Arena(std::size_t chunkSize)
+    : chunkSize(chunkSize), chunks(nullptr), bytesUsed(0), bytesReserved(0), peakBytesUsed(0), chunkCount(0), allocationCount(0) {}
+
+Arena::~Arena() {
+    while (chunks != nullptr) {
+        Chunk* next = chunks->next;
+        std::free(chunks);
+        chunks = next;
+    }
+}
+
+Arena::Chunk* Arena::newChunk(std::size_t minimumSize) {
+    std::size_t size = std::max(chunkSize, minimumSize);
+    Chunk* chunk = (Chunk*)std::malloc(CHUNK_HEADER_SIZE + size);
+
+    if (chunk == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    chunk->size = size;
+    chunk->used = 0;
+    bytesReserved += CHUNK_HEADER_SIZE + size;
+    chunkCount++;
+    return chunk;
+}
+
+void* Arena::allocate(std::size_t size, std::size_t alignment) {
+    std::size_t padding = 0;
+
+    if (chunks != nullptr) {
+        std::uintptr_t next = (std::uintptr_t)chunks + CHUNK_HEADER_SIZE + chunks->used;
+        padding = (alignment - next % alignment) % alignment;
+    }
+
+    // Start a new chunk when the current one is full, big requests get one sized for them
+    if (chunks == nullptr || chunks->used + padding + size > chunks->size) {
+        Chunk* chunk = newChunk(size);
+        chunk->next = chunks;
+        chunks = chunk;
+        padding = 0;
+    }
+
+    void* memory = (char*)chunks + CHUNK_HEADER_SIZE + chunks->used + padding;
+    chunks->used += padding + size;
+
+    bytesUsed += padding + size;
+    peakBytesUsed = std::max(peakBytesUsed, bytesUsed);
+    allocationCount++;
+
+    return memory;
+}
+
+const char* Arena::copyString(const std::string& value) { return copyString(value.data(), value.size()); }
+
+const char* Arena::copyString(const char* characters, std::size_t length) {
+    char* copy = (char*)allocate(length + 1, 1);
+    std::memcpy(copy, characters, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+void Arena::reset() {
+    if (chunks == nullptr) {
+        return;
+    }
+
+    // Keep the oldest chunk, it is the usual size and the next program will need it anyway
+    Chunk* kept = chunks;
+    while (kept->next != nullptr) {
+        Chunk* next = kept->next;
+        bytesReserved -= CHUNK_HEADER_SIZE + kept->size;
+        chunkCount--;
+        std::free(kept);
+        kept = next;
+    }
+
+    kept->used = 0;
+    chunks = kept;
+
+    bytesUsed = 0;
+    allocationCount = 0;
+}
+
+std::size_t Arena::getBytesUsed() const { return bytesUsed; }
+
+std::size_t Arena::getBytesReserved() const { return bytesReserved; }
+
+std::size_t Arena::getPeakBytesUsed() const { return peakBytesUsed; }
+
+std::size_t Arena::getChunkCount() const { return chunkCount; }
+
+std::size_t Arena::getAllocationCount() const { return allocationCount; }
@@ -1,7 +1,13 @@
 #include "ast.hpp"
+#include "allocationCounter.hpp"
+#include "builtins.hpp"
 #include "tokenizer.hpp"
+#include "trace.hpp"
 
 #include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
 
 
 // Upon error, return nullptr
@@ -10,20 +16,110 @@
 
 // In general, call the syntaxError function at the source and pass the error
 // Therefore, we'll be checking the errorHandler a lot (or equivalently, seeing if we were returned ERROR_NODE)
-// Also since we are not calling new, we will only have to delete the nodes that we create when error handling
+// Nodes come from the Parser's Arena, so nodes dropped while error handling are freed when it is reset
 #define ERROR_NODE nullptr
-#define ERROR_VECTOR \
-    {}
 
-Parser::Parser(const std::vector<Token>& tokens, OutputStream& outputStream, ErrorHandler& errorHandler) : tokens(tokens), outputStream(outputStream), errorHandler(errorHandler) {
+Operator operatorFromLexeme(StringView lexeme) {
+    // Only called while parsing, evaluation switches on the result
+    if (lexeme == "+") return Operator::ADD;
+    if (lexeme == "-") return Operator::SUBTRACT;
+    if (lexeme == "*") return Operator::MULTIPLY;
+    if (lexeme == "/") return Operator::DIVIDE;
+    if (lexeme == "%") return Operator::MODULO;
+    if (lexeme == ">") return Operator::GREATER;
+    if (lexeme == "<") return Operator::LESS;
+    if (lexeme == ">=") return Operator::GREATER_EQUAL;
+    if (lexeme == "<=") return Operator::LESS_EQUAL;
+    if (lexeme == "==") return Operator::EQUAL;
+    if (lexeme == "!=") return Operator::NOT_EQUAL;
+    if (lexeme == "&&") return Operator::AND;
+    if (lexeme == "||") return Operator::OR;
+    if (lexeme == "!") return Operator::NOT;
+    return Operator::UNKNOWN;
+}
+
+const char* nodeTypeToString(ASTNodeType type) {
+    switch (type) {
+        case ASTNodeType::BLOCK_NODE:
+            return "BLOCK_NODE";
+        case ASTNodeType::VARIABLE_DECLARATION_NODE:
+            return "VARIABLE_DECLARATION_NODE";
+        case ASTNodeType::ASSIGNMENT_NODE:
+            return "ASSIGNMENT_NODE";
+        case ASTNodeType::VARIABLE_ACCESS_NODE:
+            return "VARIABLE_ACCESS_NODE";
+        case ASTNodeType::NUMBER_NODE:
+            return "NUMBER_NODE";
+        case ASTNodeType::BINARY_OPERATION_NODE:
+            return "BINARY_OPERATION_NODE";
+        case ASTNodeType::MONO_OPERATION_NODE:
+            return "MONO_OPERATION_NODE";
+        case ASTNodeType::IF_NODE:
+            return "IF_NODE";
+        case ASTNodeType::WHILE_NODE:
+            return "WHILE_NODE";
+        case ASTNodeType::FOR_NODE:
+            return "FOR_NODE";
+        case ASTNodeType::BREAK_NODE:
+            return "BREAK_NODE";
+        case ASTNodeType::CONTINUE_NODE:
+            return "CONTINUE_NODE";
+        case ASTNodeType::FUNCTION_DECLARATION_NODE:
+            return "FUNCTION_DECLARATION_NODE";
+        case ASTNodeType::FUNCTION_CALL_NODE:
+            return "FUNCTION_CALL_NODE";
+        case ASTNodeType::RETURN_NODE:
+            return "RETURN_NODE";
+        case ASTNodeType::EMPTY_EXPRESSION_NODE:
+            return "EMPTY_EXPRESSION_NODE";
+        case ASTNodeType::CONVERSION_NODE:
+            return "CONVERSION_NODE";
+    }
+    return "UNKNOWN";
+}
+
+std::string operatorToString(Operator op) {
+    switch (op) {
+        case Operator::ADD:
+            return "+";
+        case Operator::SUBTRACT:
+            return "-";
+        case Operator::MULTIPLY:
+            return "*";
+        case Operator::DIVIDE:
+            return "/";
+        case Operator::MODULO:
+            return "%";
+        case Operator::GREATER:
+            return ">";
+        case Operator::LESS:
+            return "<";
+        case Operator::GREATER_EQUAL:
+            return ">=";
+        case Operator::LESS_EQUAL:
+            return "<=";
+        case Operator::EQUAL:
+            return "==";
+        case Operator::NOT_EQUAL:
+            return "!=";
+        case Operator::AND:
+            return "&&";
+        case Operator::OR:
+            return "||";
+        case Operator::NOT:
+            return "!";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+Parser::Parser(const std::vector<Token>& tokens, OutputStream& outputStream, ErrorHandler& errorHandler, Arena& arena) : tokens(tokens), outputStream(outputStream), errorHandler(errorHandler), arena(arena) {
     currentTokenIndex = 0;
+    generatedIdentifiers = 0;
+    streamFailed = false;
+    bracketErrorIndex = NO_MATCHING_BRACKET;
 
-    // Fill out the user identifiers
-    for (const Token& token : tokens) {
-        if (token.type == TokenType::IDENTIFIER) {
-            userIdentifiers.push_back(token.lexeme);
-        }
-    }
+    matchBrackets();
 
     // Set the seed for the random number generator
     srand(12345);
@@ -33,537 +129,428 @@ Parser::~Parser() {
 }
 
 void Parser::syntaxError(const std::string& message) const {
-    if (currentTokenIndex < tokens.size()) {
-        errorHandler.handleError("Syntax Error at token " + std::to_string(currentTokenIndex + 1) + ": " + tokens[currentTokenIndex].lexeme + ": " + message);
+    syntaxError(currentTokenIndex, message);
+}
+
+void Parser::syntaxError(size_t tokenIndex, const std::string& message) const {
+    if (tokenIndex < tokens.size()) {
+        errorHandler.handleError("Syntax Error: " + tokens[tokenIndex].lexeme + ": " + message, tokens[tokenIndex].location);
+
+    } else if (!tokens.empty()) {
+        // Ran out of tokens, the last one is as close as it gets
+        errorHandler.handleError("Syntax Error: " + message, tokens.back().location);
 
     } else {
-        errorHandler.handleError("Syntax Error at token " + std::to_string(tokens.size()) + ": " + message);
+        errorHandler.handleError("Syntax Error: " + message);
     }
 }
 
-std::string Parser::genNewIdentifier() {
+void Parser::matchBrackets() {
+    // One pass over the tokens with a stack of the brackets still open
+    // Ex. for { ( ) { } } token 0 matches 5, 1 matches 2 and 3 matches 4
+    // Only the first mismatch is kept, it is reported by parseProgram before anything is parsed
+    // A streamed program calls this again for every chunk, so it picks up where it left off
+    size_t first = matchingBrackets.size();
+    matchingBrackets.resize(tokens.size(), NO_MATCHING_BRACKET);
+
+    for (size_t i = first; i < tokens.size(); i++) {
+        TokenType type = tokens[i].type;
+
+        if (type == TokenType::LEFT_BRACE || type == TokenType::LEFT_PARENTHESIS) {
+            openBrackets.push_back(i);
+        } else if (type == TokenType::RIGHT_BRACE || type == TokenType::RIGHT_PARENTHESIS) {
+            if (openBrackets.empty()) {
+                if (bracketErrorIndex == NO_MATCHING_BRACKET) {
+                    bracketErrorIndex = i;
+                    bracketError = "Unexpected brace or parenthesis " + tokens[i].lexeme;
+                }
+                continue;
+            }
+
+            size_t opening = openBrackets.back();
+            openBrackets.pop_back();
+
+            TokenType expected = tokens[opening].type == TokenType::LEFT_BRACE ? TokenType::RIGHT_BRACE : TokenType::RIGHT_PARENTHESIS;
+
+            if (type == expected) {
+                matchingBrackets[opening] = i;
+                matchingBrackets[i] = opening;
+            } else if (bracketErrorIndex == NO_MATCHING_BRACKET) {
+                // Ex. {(})
+                bracketErrorIndex = i;
+                bracketError = "Unexpected brace or parenthesis " + tokens[i].lexeme + ", expected " + Tokenizer::tokenTypeToString(expected) + " to close the " + tokens[opening].lexeme + " on line " +
+                               std::to_string(tokens[opening].location.line) + ", column " + std::to_string(tokens[opening].location.column);
+            }
+        }
+    }
+}
+
+void Parser::checkUnclosedBrackets() {
+    // Only known once every token is in
+    if (!openBrackets.empty() && bracketErrorIndex == NO_MATCHING_BRACKET) {
+        bracketErrorIndex = openBrackets.back();
+        bracketError = "Unclosed brace or parenthesis " + tokens[bracketErrorIndex].lexeme;
+    }
+}
+
+size_t Parser::getMatchingBracket(size_t tokenIndex) const {
+    return tokenIndex < matchingBrackets.size() ? matchingBrackets[tokenIndex] : NO_MATCHING_BRACKET;
+}
+
+Symbol Parser::genNewIdentifier() {
     // Generate a new identifier for use in obfuscation or optimization
-    // This identifier should not be in the list of user identifiers
-    std::string newIdentifier;
-    do {
-        newIdentifier = "obfuscated_" + std::to_string(rand());
-    // We don't have to worry about builtins, because they do not start with obfuscated_
-    } while (std::find(userIdentifiers.begin(), userIdentifiers.end(), newIdentifier) != userIdentifiers.end());
-    userIdentifiers.push_back(newIdentifier);
-    return newIdentifier;
+    // No script name contains the prefix's #, so numbering from 0 in every parse is enough to keep them apart
+    // Each parse reuses the names the previous one interned, the symbol table only grows with the most parameters a program had
+    return symbolTable.intern(GENERATED_IDENTIFIER_PREFIX + std::to_string(generatedIdentifiers++));
 }
 
 BlockNode* Parser::parseProgram() {
     // The entry point for parsing a program into an AST.
     // Example: Parse a block of code (e.g., the main program)
+    ALLOCATION_PHASE(AllocationPhase::PARSE);
+
+    // A statement parsed from an earlier chunk already reported its error
+    if (streamFailed) {
+        return ERROR_NODE;
+    }
+
+    // Tokens streamed in since the last parseAvailableStatements
+    matchBrackets();
+    checkUnclosedBrackets();
 
     // If the program is empty, return an empty block
     if (tokens.size() == 0) {
-        return new BlockNode(std::vector<ASTNode*>());
+        return new (arena) BlockNode(ArenaArray<ASTNode*>());
+    }
+
+    // Unbalanced braces and parentheses are reported where they are, before parsing anything
+    if (bracketErrorIndex != NO_MATCHING_BRACKET) {
+        syntaxError(bracketErrorIndex, bracketError);
+        return ERROR_NODE;
     }
 
     // If the first and last tokens are not braces, we have an error
     if (tokens[0].type != TokenType::LEFT_BRACE || tokens[tokens.size() - 1].type != TokenType::RIGHT_BRACE) {
-        printf("Program must be enclosed in braces.\n");
+        TRACE(TRACE_INFO, TRACE_PARSER, "Program must be enclosed in braces.\n");
         syntaxError("Program must be enclosed in braces.");
         return ERROR_NODE;
     }
 
-    BlockNode* programBlock = parseBlock();
+    // A streamed program has its brace and leading statements parsed already
+    BlockNode* programBlock = currentTokenIndex == 0 ? parseBlock() : finishBlock(matchingBrackets[0], programStatements, 0);
 
     // Check if there are any remaining tokens; if yes, report an error
     // Avoid this error if we already have an error
     if (currentTokenIndex < tokens.size() && programBlock != ERROR_NODE) {
-        printf("Unexpected tokens after the program.\n");
+        TRACE(TRACE_INFO, TRACE_PARSER, "Unexpected tokens after the program.\n");
         syntaxError("Unexpected tokens after the program.");
-        delete programBlock;
         return ERROR_NODE;
     }
 
-    printf("Program parsed successfully.\n");
+    TRACE(TRACE_INFO, TRACE_PARSER, "Program parsed successfully.\n");
 
     // If parseBlock failed, it would be forwarded to here, which is good because we want to return nullptr (ERROR_NODE)
     return programBlock;
 }
 
-void Parser::eatToken(TokenType expectedTokenType) {
-    // Eat the next token if it matches the expected token type
-    // POSTCONDITION Can throw a syntax error if the token types do not match, so checking for errors following is necessary
-    if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == expectedTokenType) {
-        currentTokenIndex++;
-    } else {
-        if(currentTokenIndex < tokens.size()) {
-            syntaxError("Unexpected token type, expected " + Tokenizer::tokenTypeToString(expectedTokenType) + ", got " + Tokenizer::tokenTypeToString(tokens[currentTokenIndex].type));
-        } else {
-            syntaxError("Unexpected end of file, expected " + Tokenizer::tokenTypeToString(expectedTokenType));
-        }
+size_t Parser::parseAvailableStatements() {
+    // Parses the statements of the program block whose tokens have all arrived, parseProgram does the rest
+    // Anything wrong with the program as a whole, Ex. a missing brace, is left for parseProgram to report
+    ALLOCATION_PHASE(AllocationPhase::PARSE);
+
+    matchBrackets();
+
+    if (streamFailed || bracketErrorIndex != NO_MATCHING_BRACKET || tokens.empty() || tokens[0].type != TokenType::LEFT_BRACE) {
+        return programStatements.size();
     }
-}
 
-std::vector<const Token*> Parser::gatherTokensUntil(TokenType endTokenType) {
-    // Gather tokens until the end token type is reached
-    // Precondition: for wrapping syntax, the currentTokenIndex will be
-    // immediately after the opening version Ex. If we are looking for } we should
-    // be right after the { (which should have been eaten prior to this call)
+    // Eat the program's leading brace
+    if (currentTokenIndex == 0) {
+        currentTokenIndex = 1;
+    }
 
-    // In the case of an error, return an empty vector
-    // Therefore, calls to this function should check if the error handler has been tripped
+    while (findStatementEnd(currentTokenIndex) != NO_MATCHING_BRACKET) {
+        ASTNode* statement = parseStatement();
 
-    // If we want a closing parenthesis or brace, we need to keep a counter
-    // This counter will go up with every left brace/parenthesis and down with
-    // every right brace/parenthesis When the counter reaches 0, we know we have
-    // reached the end of the block A syntax error will be thrown if the counter
-    // goes below 0 A syntax error will also be thrown if we reach the end of the
-    // file without the counter reaching 0 The last case for a syntax error is
-    // that of {(})
+        if (errorHandler.shouldStopExecution()) {
+            streamFailed = true;
+            break;
+        }
 
-    int braceParenthesisCounter = 0;
+        programStatements.push_back(statement);
+    }
 
-    // This is just a placeholder, it will be overwritten. It also indicates if we
-    // are looking for a brace or parenthesis It just keeps track of the opened
-    // ones: ( or {
-    TokenType lastBraceParenthesis = TokenType::UNKNOWN;
+    return programStatements.size();
+}
 
-    if (endTokenType == TokenType::RIGHT_BRACE || endTokenType == TokenType::RIGHT_PARENTHESIS) {
-        // We want to match, so assume we already ate an opening brace/parenthesis
-        braceParenthesisCounter++;
-        if (endTokenType == TokenType::RIGHT_BRACE) {
-            lastBraceParenthesis = TokenType::LEFT_BRACE;
-        } else {
-            lastBraceParenthesis = TokenType::LEFT_PARENTHESIS;
+size_t Parser::findStatementEnd(size_t start) const {
+    // Index of the last token of the statement at start, NO_MATCHING_BRACKET while it could still go on
+    // Ex. int x = 1; ends at its semicolon, while (x) { } at its brace unless an else follows
+    size_t i = start;
+
+    while (i < tokens.size()) {
+        TokenType type = tokens[i].type;
+
+        if (type == TokenType::SEMICOLON) {
+            return i;
         }
-    }
 
-    std::vector<const Token*> gatheredTokens;
-    // while we can keep going and (we still should go)
-    // we should go if (we are not looking for a brace or parenthesis and the
-    // current token is not the end token type) OR (we are looking for a brace or
-    // parenthesis and the counter is not 0)
-    while (currentTokenIndex < tokens.size() && ((lastBraceParenthesis == TokenType::UNKNOWN && tokens[currentTokenIndex].type != endTokenType) || (lastBraceParenthesis != TokenType::UNKNOWN && braceParenthesisCounter != 0))) {
-        // If we are looking for a brace or parenthesis, check if the current token
-        // is one
-        if (lastBraceParenthesis != TokenType::UNKNOWN) {
-            TokenType currentTokenType = tokens[currentTokenIndex].type;
-            // Increment or decrement the counter
-            if (currentTokenType == TokenType::LEFT_BRACE || currentTokenType == TokenType::LEFT_PARENTHESIS) {
-                braceParenthesisCounter++;
-            } else if (currentTokenType == TokenType::RIGHT_BRACE || currentTokenType == TokenType::RIGHT_PARENTHESIS) {
-                braceParenthesisCounter--;
-
-                // If we decremented the counter to 0 and the current token is not the
-                // end token type, we have an error
-                if (braceParenthesisCounter == 0 && currentTokenType != endTokenType) {
-                    syntaxError("Unexpected brace or parenthesis " + tokens[currentTokenIndex].lexeme);
-                    return ERROR_VECTOR;
-                }
+        if (type == TokenType::RIGHT_BRACE || type == TokenType::RIGHT_PARENTHESIS) {
+            // Closes the program block, Ex. the statement is missing its semicolon
+            return NO_MATCHING_BRACKET;
+        }
 
-                // If we decremented the counter to -1, we have an error
-                if (braceParenthesisCounter < 0) {
-                    syntaxError("Unexpected brace or parenthesis " + tokens[currentTokenIndex].lexeme);
-                    return ERROR_VECTOR;
-                }
+        if (type == TokenType::LEFT_BRACE || type == TokenType::LEFT_PARENTHESIS) {
+            size_t closing = matchingBrackets[i];
 
-                // If we decremented the counter to 0 and the current token is the end
-                // token type, we are done
-                if (braceParenthesisCounter == 0 && currentTokenType == endTokenType) {
-                    break;
-                }
+            if (closing == NO_MATCHING_BRACKET) {
+                return NO_MATCHING_BRACKET;
             }
 
-            // Check for the condition where we have something like {(})
-            if ((currentTokenType == TokenType::RIGHT_BRACE && lastBraceParenthesis == TokenType::LEFT_PARENTHESIS) || (currentTokenType == TokenType::RIGHT_PARENTHESIS && lastBraceParenthesis == TokenType::LEFT_BRACE)) {
-                syntaxError("Unexpected brace or parenthesis " + tokens[currentTokenIndex].lexeme);
-                return ERROR_VECTOR;
-            }
+            // The token after a body tells whether an else continues the statement
+            if (type == TokenType::LEFT_BRACE) {
+                if (closing + 1 >= tokens.size()) {
+                    return NO_MATCHING_BRACKET;
+                }
 
-            // If it is an opening brace or parenthesis, update the last
-            // brace/parenthesis
-            if (currentTokenType == TokenType::LEFT_BRACE || currentTokenType == TokenType::LEFT_PARENTHESIS) {
-                lastBraceParenthesis = currentTokenType;
+                if (tokens[closing + 1].type != TokenType::KEYWORD || tokens[closing + 1].lexeme != "else") {
+                    return closing;
+                }
             }
+
+            i = closing;
         }
 
-        // Parse a statement
-        gatheredTokens.push_back(&tokens[currentTokenIndex]);
-        // Only advance the token index if we expect to find the end token type
-        currentTokenIndex++;
+        i++;
     }
 
-    // Check if we reached the end token type
-    if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == endTokenType) {
-        // Add the end token to the gathered tokens as to include it in the vector
-        gatheredTokens.push_back(&tokens[currentTokenIndex]);
-        // Advance to the next token
+    return NO_MATCHING_BRACKET;
+}
+
+void Parser::eatToken(TokenType expectedTokenType) {
+    // Eat the next token if it matches the expected token type
+    // POSTCONDITION Can throw a syntax error if the token types do not match, so checking for errors following is necessary
+    if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == expectedTokenType) {
         currentTokenIndex++;
     } else {
-        // Expected means we expect to find the token
-        syntaxError("Unexpected end of file, expected " + Tokenizer::tokenTypeToString(endTokenType));
-        return ERROR_VECTOR;
+        if(currentTokenIndex < tokens.size()) {
+            syntaxError("Unexpected token type, expected " + Tokenizer::tokenTypeToString(expectedTokenType) + ", got " + Tokenizer::tokenTypeToString(tokens[currentTokenIndex].type));
+        } else {
+            syntaxError("Unexpected end of file, expected " + Tokenizer::tokenTypeToString(expectedTokenType));
+        }
     }
-
-    return gatheredTokens;
 }
 
-int Parser::getPrecedence(const std::string& lexeme) {
-    // Returns the precedence of the given token type
+int Parser::getPrecedence(Operator op) {
+    // Returns the precedence of the given operator
     // Higher number is higher precedence, specific numbers are arbitrary
     // Based on https://en.cppreference.com/w/cpp/language/operator_precedence
 
-    if (lexeme == "!") {
-        return 10;
-    } else if (lexeme == "*" || lexeme == "/" || lexeme == "%") {
-        return 8;
-    } else if (lexeme == "+" || lexeme == "-") {
-        return 6;
-    } else if (lexeme == ">" || lexeme == "<" || lexeme == "<=" || lexeme == ">=") {
-        return 4;
-    } else if (lexeme == "==" || lexeme == "!=") {
-        return 3;
-    } else if (lexeme == "&&") {
-        return 2;
-    } else if (lexeme == "||") {
-        return 1;
-    } else {
-        syntaxError("Unexpected operator " + lexeme);
-        return -1;
+    switch (op) {
+        case Operator::NOT:
+            return 10;
+        case Operator::MULTIPLY:
+        case Operator::DIVIDE:
+        case Operator::MODULO:
+            return 8;
+        case Operator::ADD:
+        case Operator::SUBTRACT:
+            return 6;
+        case Operator::GREATER:
+        case Operator::LESS:
+        case Operator::GREATER_EQUAL:
+        case Operator::LESS_EQUAL:
+            return 4;
+        case Operator::EQUAL:
+        case Operator::NOT_EQUAL:
+            return 3;
+        case Operator::AND:
+            return 2;
+        case Operator::OR:
+            return 1;
+        default:
+            syntaxError("Unexpected operator " + operatorToString(op));
+            return -1;
     }
 }
 
-// Used for below function
-#define NUKE_HIGH_LEVEL_NODES          \
-    for (auto node : highLevelNodes) { \
-        delete node;                   \
-    }
-
-ASTNode* Parser::parseExpression(const std::vector<const Token*>& expressionTokens, bool canBeEmpty) {
-    // Parses expressions, potentially with parentheses and nested function calls
+ASTNode* Parser::parseExpression(TokenType terminator) {
+    // Parses the expression starting at the current token, then eats the terminator
     // Ex. 5, x, 3.14, 5 + 8, 5 * 8 + x * (4 + 13) * foo(5, 8 - foo(5, 8))
 
-    // Handle the case where there are no tokens
-    if (expressionTokens.size() == 0 && !canBeEmpty) {
-        syntaxError("Empty (sub)expression");
-        return ERROR_NODE;
-    }
+    // Operators below OR's precedence end an expression, so 1 admits every operator
+    ASTNode* expression = parseBinaryOperation(1);
 
-    // Handle the base case when there is one token
-    if (expressionTokens.size() == 1) {
-        // Check if the token is a constant or variable access
-        if (expressionTokens[0]->type == TokenType::INTEGER || expressionTokens[0]->type == TokenType::FLOAT) {
-            // Parse the constant
-            return new NumberNode(expressionTokens[0]->lexeme, expressionTokens[0]->type);
-        } else if (expressionTokens[0]->type == TokenType::IDENTIFIER) {
-            // Parse the variable access
-            return new VariableAccessNode(expressionTokens[0]->lexeme);
-        } else {
-            syntaxError("Unexpected token " + expressionTokens[0]->lexeme);
-            return ERROR_NODE;
-        }
+    if (expression == ERROR_NODE) {
+        return ERROR_NODE;
     }
 
-    // Look at all high-level operations, treating parentheses as a single token
-    // Generate a vector of these high-level operations
-    // Ex. 5 * 8 + x * (4 + 13) -> {*, +, *}
-
-    // Also maintain a vector of the nodes that correspond to the tokens
-    // Ex. 5 * 8 + x * (4 + 13) -> {5, 8, x, (4 + 13)}
-
-    // First, we need to find the highest-level operation
-    // We will do this by keeping track of the parentheses
+    eatToken(terminator);
 
-    std::vector<std::string> highLevelOperators;
-    std::vector<ASTNode*> highLevelNodes;
-
-    // Keep track of the parentheses
-    int parenthesesCounter = 0;
+    if (errorHandler.shouldStopExecution()) {
+        return ERROR_NODE;
+    }
 
-    // Keep track of potential sub-expressions, i.e. stuff in parentheses
-    std::vector<const Token*> subExpressionTokens;
+    return expression;
+}
 
-    size_t i = 0;
-    while (i < expressionTokens.size()) {
-        // Get the current token
-        const Token* token = expressionTokens[i];
+ASTNode* Parser::parseBinaryOperation(int minimumPrecedence) {
+    // Precedence climbing, each token is looked at once
+    // An operator binds the operand on its left if its precedence is at least minimumPrecedence, otherwise the caller
+    // gets the operand and the operator is left for a caller with a lower minimum
+    // Ex. for 1 + 2 * 3 - 4, the * is parsed by the recursive call for the right side of +, the - by the outermost loop
+    ASTNode* left = parseOperand();
 
-        // If we find a left parenthesis, increment the counter
-        if (token->type == TokenType::LEFT_PARENTHESIS) {
-            // If we already are a parenthesis in, add the parenthesis to the
-            // sub-expression tokens
-            if (parenthesesCounter != 0) {
-                subExpressionTokens.push_back(token);
-            }
+    if (left == ERROR_NODE) {
+        return ERROR_NODE;
+    }
 
-            parenthesesCounter++;
-        }
-        // If we find a right parenthesis, decrement the counter
-        else if (token->type == TokenType::RIGHT_PARENTHESIS) {
-            // If we already are a parenthesis in, add the parenthesis to the
-            // sub-expression tokens
-            if (parenthesesCounter != 0) {
-                subExpressionTokens.push_back(token);
-            }
+    while (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == TokenType::OPERATOR) {
+        Operator op = operatorFromLexeme(tokens[currentTokenIndex].lexeme);
 
-            parenthesesCounter--;
+        if (op == Operator::UNKNOWN) {
+            syntaxError("Unexpected operator " + tokens[currentTokenIndex].lexeme);
+            return ERROR_NODE;
         }
 
-        // If we find a function call as a high-level node, we need to parse it
-        // Functions are indicated by a function header, i.e. a function name and a (
-        // Only take this case when it is going to be a high-level node, i.e. when the parentheses counter is 0
-        else if (parenthesesCounter == 0 && token->type == TokenType::IDENTIFIER &&
-                 i + 1 < expressionTokens.size() && expressionTokens[i + 1]->type == TokenType::LEFT_PARENTHESIS) {
-            // Get the function name
-            std::string functionName = token->lexeme;
-
-            // Gather function arguments until the proper right parenthesis
-            // Keeping track of the index i
-
-            // Eat the name
-            i++;
-
-            // Eat the left parenthesis
-            i++;
-
-            // Gather the current function argument
-            std::vector<const Token*> currentFunctionArgumentTokens;
-
-            // The collected function arguments
-            std::vector<ASTNode*> functionArguments;
-
-            // Keep track of the parentheses
-            // Initialized to 1 because we already ate the left parenthesis
-            int functionParenthesesCounter = 1;
-
-            while (i < expressionTokens.size()) {
-                // Get the current token
-                const Token* functionToken = expressionTokens[i];
-
-                // If we find a left parenthesis, increment the counter
-                if (functionToken->type == TokenType::LEFT_PARENTHESIS) {
-                    // If we already are a parenthesis in, add the parenthesis to the
-                    // sub-expression tokens
-
-                    if (functionParenthesesCounter != 0) {
-                        currentFunctionArgumentTokens.push_back(functionToken);
-                    }
-
-                    functionParenthesesCounter++;
-
-                }
-                // If we find a right parenthesis, decrement the counter
-                else if (functionToken->type == TokenType::RIGHT_PARENTHESIS) {
-                    // If we already are a parenthesis in, add the parenthesis to the
-                    // sub-expression tokens
-
-                    functionParenthesesCounter--;
+        int precedence = getPrecedence(op);
 
-                    if (functionParenthesesCounter != 0) {
-                        currentFunctionArgumentTokens.push_back(functionToken);
-                    }
-
-                }
-                // If we find a comma, we have reached the end of the current function
-                // argument
-                // Of course, we only do this if we are not in a sub-expression
-                else if (functionToken->type == TokenType::COMMA && functionParenthesesCounter == 1) {
-                    // If we are not back to 1 parentheses (the opening left), throw an error
-                    if (functionParenthesesCounter != 1) {
-                        syntaxError("Unexpected comma " + functionToken->lexeme);
-                        NUKE_HIGH_LEVEL_NODES
-                        // Nuke function arguments
-                        for (auto arg : functionArguments) {
-                            delete arg;
-                        }
-                        return ERROR_NODE;
-                    }
-
-                    // Parse the current function argument
-                    ASTNode* currentFunctionArgument = parseExpression(currentFunctionArgumentTokens, false);
+        if (precedence < minimumPrecedence) {
+            break;
+        }
 
-                    if (currentFunctionArgument == ERROR_NODE) {
-                        NUKE_HIGH_LEVEL_NODES
-                        // Nuke function arguments
-                        for (auto arg : functionArguments) {
-                            delete arg;
-                        }
-                        return ERROR_NODE;
-                    }
+        // Eat the operator, which is where an error in the operation is reported
+        const Token& operatorToken = tokens[currentTokenIndex];
+        currentTokenIndex++;
 
-                    // Add the current function argument to the vector
-                    functionArguments.push_back(currentFunctionArgument);
+        // Only operators that bind tighter join the right side, which makes equal precedence left associative
+        // Ex. 8 - 4 - 2 is (8 - 4) - 2
+        ASTNode* right = parseBinaryOperation(precedence + 1);
 
-                    // Clear the current function argument tokens
-                    currentFunctionArgumentTokens.clear();
-                }
-                // Add everything else to the current function argument tokens
-                else {
-                    currentFunctionArgumentTokens.push_back(functionToken);
-                }
-
-                // If we get back to 0 parentheses, we have reached the end of the
-                // function call
-                if (functionParenthesesCounter == 0) {
-                    // Parse the current function argument
+        if (right == ERROR_NODE) {
+            return ERROR_NODE;
+        }
 
-                    ASTNode* currentFunctionArgument = parseExpression(currentFunctionArgumentTokens, true); // true because we can have an empty function argument
+        left = locate(new (arena) BinaryOperationNode(left, op, right), operatorToken);
+    }
 
-                    if (currentFunctionArgument == ERROR_NODE) {
-                        NUKE_HIGH_LEVEL_NODES
-                        // Nuke function arguments
-                        for (auto arg : functionArguments) {
-                            delete arg;
-                        }
-                        return ERROR_NODE;
-                    }
+    return left;
+}
 
-                    // Add the current function argument to the vector
-                    functionArguments.push_back(currentFunctionArgument);
+ASTNode* Parser::parseOperand() {
+    // An operand is a constant, a variable access, a function call or a parenthesized expression
+    if (currentTokenIndex >= tokens.size()) {
+        syntaxError("Unexpected end of file, expected an expression");
+        return ERROR_NODE;
+    }
 
-                    // Clear the current function argument tokens
-                    currentFunctionArgumentTokens.clear();
+    const Token& token = tokens[currentTokenIndex];
 
-                    // Create the function call node
-                    FunctionCallNode* functionCallNode = new FunctionCallNode(functionName, functionArguments);
+    switch (token.type) {
+        case TokenType::INTEGER:
+        case TokenType::FLOAT:
+            currentTokenIndex++;
+            return parseNumber(token);
 
-                    if (functionCallNode == ERROR_NODE) {
-                        NUKE_HIGH_LEVEL_NODES
-                        // Nuke function arguments
-                        for (auto arg : functionArguments) {
-                            delete arg;
-                        }
-                        return ERROR_NODE;
-                    }
-
-                    // Add the function call node to the high-level nodes
-                    highLevelNodes.push_back(functionCallNode);
+        case TokenType::IDENTIFIER:
+            // Functions are indicated by a function name and a (
+            if (currentTokenIndex + 1 < tokens.size() && tokens[currentTokenIndex + 1].type == TokenType::LEFT_PARENTHESIS) {
+                return parseCall();
+            }
 
-                    // Clear the function arguments
-                    functionArguments.clear();
+            currentTokenIndex++;
+            return locate(new (arena) VariableAccessNode(token.symbol), token);
 
-                    // Also add the high-level operator (the rest of the logic build up Tokens rather than an ASTNode)
-                    if (i + 1 < expressionTokens.size() && expressionTokens[i + 1]->type == TokenType::OPERATOR) {
-                        highLevelOperators.push_back(expressionTokens[i + 1]->lexeme);
-                        i++;
-                    }
+        case TokenType::LEFT_PARENTHESIS: {
+            currentTokenIndex++;
 
-                    // Break out of the while loop
-                    break;
-                }
+            ASTNode* expression = parseBinaryOperation(1);
 
-                // Increment the index
-                i++;
+            if (expression == ERROR_NODE) {
+                return ERROR_NODE;
             }
-        }
-
-        // If we find an operator, check if the parentheses counter is 0
-        // If it is, we have found a high-level operator
-        else if (token->type == TokenType::OPERATOR && parenthesesCounter == 0) {
-            // Add the operator to the vector
-            highLevelOperators.push_back(token->lexeme);
 
-            // Parse the sub-expression
-            ASTNode* subExpression = parseExpression(subExpressionTokens, false);
+            eatToken(TokenType::RIGHT_PARENTHESIS);
 
-            if (subExpression == ERROR_NODE) {
-                NUKE_HIGH_LEVEL_NODES
+            if (errorHandler.shouldStopExecution()) {
                 return ERROR_NODE;
             }
 
-            // Add the sub-expression to the vector
-            highLevelNodes.push_back(subExpression);
-
-            // Clear the sub-expression tokens
-            subExpressionTokens.clear();
-        }
-        // Add to the sub-expression tokens
-        else {
-            subExpressionTokens.push_back(token);
+            return expression;
         }
 
-        // Increment the index
-        i++;
-    }
-
-    // Edge case: if we have a sub-expression at the end, we need to parse it
-    // Should have at least one high-level operator
-    if (subExpressionTokens.size() > 0) {
-        // If the subExpressionTokens is just all of the original tokens, we have an error
-        // As in, whatever junk that was passed in was not parsed properly by the above logic
-        if (subExpressionTokens.size() == expressionTokens.size()) {
-            syntaxError("Unexpected token " + subExpressionTokens[0]->lexeme);
-            NUKE_HIGH_LEVEL_NODES
+        default:
+            syntaxError("Unexpected token " + token.lexeme);
             return ERROR_NODE;
-        }
+    }
+}
 
-        // Parse the sub-expression
-        ASTNode* subExpression = parseExpression(subExpressionTokens, false);
+FunctionCallNode* Parser::parseCall() {
+    size_t start = currentTokenIndex;
 
-        if (subExpression == ERROR_NODE) {
-            NUKE_HIGH_LEVEL_NODES
-            return ERROR_NODE;
-        }
+    // Parses name(argument, ...) without a trailing semicolon, so calls can be used within expressions
+    Symbol name = tokens[currentTokenIndex].symbol;
+    eatToken(TokenType::IDENTIFIER);
 
-        // Add the sub-expression to the vector
-        highLevelNodes.push_back(subExpression);
+    if (errorHandler.shouldStopExecution()) {
+        return ERROR_NODE;
     }
 
-    // Now, construct the AST using the high-level operators and nodes
-    // Using getPrecedence, we can find the highest-level operator
-
-    // If we canBeEmpty, we can have an empty expression
-    if (highLevelNodes.size() == 0 && highLevelOperators.size() == 0 && canBeEmpty) {
-        return new EmptyExpressionNode();
-    }
+    eatToken(TokenType::LEFT_PARENTHESIS);
 
-    // First check that we have the right number of operators for the number of nodes
-    if (highLevelOperators.size() != highLevelNodes.size() - 1) {
-        syntaxError("Unexpected number of operators");
-        NUKE_HIGH_LEVEL_NODES
+    if (errorHandler.shouldStopExecution()) {
         return ERROR_NODE;
     }
 
-    // Loop until there are no more high-level operators
-    while (highLevelOperators.size() > 0) {
-        // Find the highest-level operator
-        int highestPrecedence = 0;
-        size_t highestPrecedenceIndex = 0;
-        for (size_t i = 0; i < highLevelOperators.size(); i++) {
-            size_t precedence = getPrecedence(highLevelOperators[i]);
-            if (precedence > highestPrecedence) {
-                highestPrecedence = precedence;
-                highestPrecedenceIndex = i;
-            }
-        }
+    // The arguments go on top of pendingNodes, like a block's statements
+    size_t first = pendingNodes.size();
 
-        // Get the highest-level operator
-        std::string highestLevelOperator = highLevelOperators[highestPrecedenceIndex];
+    if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == TokenType::RIGHT_PARENTHESIS) {
+        // A call without arguments has a single empty argument, which is what the engines check for
+        pendingNodes.push_back(new (arena) EmptyExpressionNode());
+    } else {
+        while (true) {
+            ASTNode* argument = parseBinaryOperation(1);
+
+            if (argument == ERROR_NODE) {
+                pendingNodes.resize(first);
+                return ERROR_NODE;
+            }
 
-        // Get the left and right nodes
-        ASTNode* leftNode = highLevelNodes[highestPrecedenceIndex];
-        ASTNode* rightNode = highLevelNodes[highestPrecedenceIndex + 1];
+            pendingNodes.push_back(argument);
 
-        // Create a binary operation node based on the operator
-        BinaryOperationNode* binaryNode = new BinaryOperationNode(leftNode, highestLevelOperator, rightNode);
+            if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == TokenType::COMMA) {
+                currentTokenIndex++;
+            } else {
+                break;
+            }
+        }
+    }
 
-        // Replace the left and right nodes with the binary node
-        highLevelNodes[highestPrecedenceIndex] = binaryNode;
-        highLevelNodes.erase(highLevelNodes.begin() + highestPrecedenceIndex + 1);
+    eatToken(TokenType::RIGHT_PARENTHESIS);
 
-        // Remove the operator
-        highLevelOperators.erase(highLevelOperators.begin() + highestPrecedenceIndex);
+    FunctionCallNode* call = ERROR_NODE;
+    if (!errorHandler.shouldStopExecution()) {
+        call = locate(new (arena) FunctionCallNode(name, ArenaArray<ASTNode*>(arena, pendingNodes, first), findBuiltin(tokens[start].lexeme)), tokens[start]);
     }
 
-    // Return the last node
-    return highLevelNodes[0];
+    pendingNodes.resize(first);
+    return call;
 }
 
 NumberNode* Parser::parseConstant() {
     // Check if the current token is an integer or float
     if (tokens[currentTokenIndex].type == TokenType::INTEGER || tokens[currentTokenIndex].type == TokenType::FLOAT) {
         // Parse the constant
-        NumberNode* constant = new NumberNode(tokens[currentTokenIndex].lexeme, tokens[currentTokenIndex].type);
+        NumberNode* constant = parseNumber(tokens[currentTokenIndex]);
+
+        if (constant == ERROR_NODE) {
+            return ERROR_NODE;
+        }
+
         eatToken(tokens[currentTokenIndex].type);
 
         if (errorHandler.shouldStopExecution()) {
-            delete constant;
             return ERROR_NODE;
         }
 
@@ -574,18 +561,40 @@ NumberNode* Parser::parseConstant() {
     }
 }
 
+NumberNode* Parser::parseNumber(const Token& token) {
+    // The lexeme is a view into the source, the node keeps a null terminated copy that strtof and strtoll can read
+    const char* literal = arena.copyString(token.lexeme.data(), token.lexeme.size());
+
+    if (token.type == TokenType::FLOAT) {
+        return locate(new (arena) NumberNode(literal, std::strtof(literal, nullptr)), token);
+    }
+
+    // Integers are decoded exactly rather than through a float, and must fit in 32 bits
+    errno = 0;
+    long long value = std::strtoll(literal, nullptr, 10);
+
+    if (errno == ERANGE || value < INT32_MIN || value > INT32_MAX) {
+        syntaxError("Integer " + token.lexeme + " is out of range");
+        return ERROR_NODE;
+    }
+
+    return locate(new (arena) NumberNode(literal, (int)value), token);
+}
+
 VariableAccessNode* Parser::parseVariableAccess() {
+    size_t start = currentTokenIndex;
+
     // Check if the current token is an identifier
     if (tokens[currentTokenIndex].type == TokenType::IDENTIFIER) {
         // Parse the identifier
-        std::string identifier = tokens[currentTokenIndex].lexeme;
+        Symbol identifier = tokens[currentTokenIndex].symbol;
         eatToken(TokenType::IDENTIFIER);
 
         if (errorHandler.shouldStopExecution()) {
             return ERROR_NODE;
         }
 
-        return new VariableAccessNode(identifier);
+        return locate(new (arena) VariableAccessNode(identifier), tokens[start]);
     } else {
         syntaxError("Unexpected token " + tokens[currentTokenIndex].lexeme);
         return ERROR_NODE;
@@ -593,10 +602,12 @@ VariableAccessNode* Parser::parseVariableAccess() {
 }
 
 AssignmentNode* Parser::parseAssignment(TokenType terminator) {
+    size_t start = currentTokenIndex;
+
     // Check if the current token is an identifier
     if (tokens[currentTokenIndex].type == TokenType::IDENTIFIER) {
         // Parse the identifier
-        std::string identifier = tokens[currentTokenIndex].lexeme;
+        Symbol identifier = tokens[currentTokenIndex].symbol;
         eatToken(TokenType::IDENTIFIER);
 
         if (errorHandler.shouldStopExecution()) {
@@ -612,23 +623,13 @@ AssignmentNode* Parser::parseAssignment(TokenType terminator) {
                 return ERROR_NODE;
             }
 
-            std::vector<const Token*> expressionTokens = gatherTokensUntil(terminator);
+            ASTNode* expression = parseExpression(terminator);
 
             if (errorHandler.shouldStopExecution()) {
                 return ERROR_NODE;
             }
 
-            // Parse the initializer, minus the semicolon
-            expressionTokens.pop_back();
-
-            // Parse the expression
-            ASTNode* expression = parseExpression(expressionTokens, false);
-
-            if (errorHandler.shouldStopExecution()) {
-                return ERROR_NODE;
-            }
-
-            return new AssignmentNode(identifier, expression);
+            return locate(new (arena) AssignmentNode(identifier, expression), tokens[start]);
         } else {
             syntaxError("AssignmentNode1: Unexpected token " + tokens[currentTokenIndex].lexeme);
             return ERROR_NODE;
@@ -640,6 +641,8 @@ AssignmentNode* Parser::parseAssignment(TokenType terminator) {
 }
 
 IfNode* Parser::parseIfStatement() {
+    size_t start = currentTokenIndex;
+
     // Construct an if node
     // Can be a simple if or an if-else, or an if-else-if-else, etc.
 
@@ -666,14 +669,7 @@ IfNode* Parser::parseIfStatement() {
                 return ERROR_NODE;
             }
 
-            std::vector<const Token*> expressionTokens = gatherTokensUntil(TokenType::RIGHT_PARENTHESIS);
-
-            if (errorHandler.shouldStopExecution()) {
-                return ERROR_NODE;
-            }
-
-            // Parse the expression
-            ASTNode* expression = parseExpression(expressionTokens, false);
+            ASTNode* expression = parseExpression(TokenType::RIGHT_PARENTHESIS);
 
             if (errorHandler.shouldStopExecution()) {
                 return ERROR_NODE;
@@ -685,7 +681,6 @@ IfNode* Parser::parseIfStatement() {
             BlockNode* block = parseBlock();
 
             if (errorHandler.shouldStopExecution()) {
-                delete expression;
                 return ERROR_NODE;
             }
 
@@ -701,12 +696,6 @@ IfNode* Parser::parseIfStatement() {
                     eatToken(TokenType::KEYWORD);
 
                     if (errorHandler.shouldStopExecution()) {
-                        for (auto expression : expressions) {
-                            delete expression;
-                        }
-                        for (auto block : blocks) {
-                            delete block;
-                        }
                         return ERROR_NODE;
                     }
 
@@ -714,12 +703,6 @@ IfNode* Parser::parseIfStatement() {
                     eatToken(TokenType::KEYWORD);
 
                     if (errorHandler.shouldStopExecution()) {
-                        for (auto expression : expressions) {
-                            delete expression;
-                        }
-                        for (auto block : blocks) {
-                            delete block;
-                        }
                         return ERROR_NODE;
                     }
 
@@ -727,37 +710,12 @@ IfNode* Parser::parseIfStatement() {
                     eatToken(TokenType::LEFT_PARENTHESIS);
 
                     if (errorHandler.shouldStopExecution()) {
-                        for (auto expression : expressions) {
-                            delete expression;
-                        }
-                        for (auto block : blocks) {
-                            delete block;
-                        }
-                        return ERROR_NODE;
-                    }
-
-                    std::vector<const Token*> expressionTokens = gatherTokensUntil(TokenType::RIGHT_PARENTHESIS);
-
-                    if (errorHandler.shouldStopExecution()) {
-                        for (auto expression : expressions) {
-                            delete expression;
-                        }
-                        for (auto block : blocks) {
-                            delete block;
-                        }
                         return ERROR_NODE;
                     }
 
-                    // Parse the expression
-                    ASTNode* expression = parseExpression(expressionTokens, false);
+                    ASTNode* expression = parseExpression(TokenType::RIGHT_PARENTHESIS);
 
                     if (errorHandler.shouldStopExecution()) {
-                        for (auto expression : expressions) {
-                            delete expression;
-                        }
-                        for (auto block : blocks) {
-                            delete block;
-                        }
                         return ERROR_NODE;
                     }
 
@@ -767,13 +725,6 @@ IfNode* Parser::parseIfStatement() {
                     BlockNode* block = parseBlock();
 
                     if (errorHandler.shouldStopExecution()) {
-                        for (auto expression : expressions) {
-                            delete expression;
-                        }
-                        for (auto block : blocks) {
-                            delete block;
-                        }
-                        delete expression;
                         return ERROR_NODE;
                     }
 
@@ -783,12 +734,6 @@ IfNode* Parser::parseIfStatement() {
                     eatToken(TokenType::KEYWORD);
 
                     if (errorHandler.shouldStopExecution()) {
-                        for (auto expression : expressions) {
-                            delete expression;
-                        }
-                        for (auto block : blocks) {
-                            delete block;
-                        }
                         return ERROR_NODE;
                     }
 
@@ -796,12 +741,6 @@ IfNode* Parser::parseIfStatement() {
                     BlockNode* block = parseBlock();
 
                     if (errorHandler.shouldStopExecution()) {
-                        for (auto expression : expressions) {
-                            delete expression;
-                        }
-                        for (auto block : blocks) {
-                            delete block;
-                        }
                         return ERROR_NODE;
                     }
 
@@ -812,7 +751,7 @@ IfNode* Parser::parseIfStatement() {
                 }
             }
 
-            return new IfNode(expressions, blocks);
+            return locate(new (arena) IfNode(ArenaArray<ASTNode*>(arena, expressions), ArenaArray<BlockNode*>(arena, blocks)), tokens[start]);
 
         } else {
             syntaxError("IfNode: Unexpected keyword " + tokens[currentTokenIndex].lexeme);
@@ -828,6 +767,7 @@ IfNode* Parser::parseIfStatement() {
 
 BlockNode* Parser::parseBlock() {
     // Parse a block of code (ex the main program or a loop body)
+    size_t blockStart = currentTokenIndex;
 
     // Eat the leading brace
     eatToken(TokenType::LEFT_BRACE);
@@ -836,109 +776,103 @@ BlockNode* Parser::parseBlock() {
         return ERROR_NODE;
     }
 
-    // The resulting vector of tokens should be parsed into a vector of ASTNodes
-    std::vector<ASTNode*> statements;
+    // The closing brace is known from the match table, so the block's statements end there
+    size_t blockEnd = matchingBrackets[blockStart];
 
-    // This is where we need to differentiate between assignment, declaration, if,
-    // while, ...
-    while (currentTokenIndex < tokens.size()) {
-        // Get the next token
-        const Token* token = &tokens[currentTokenIndex];
+    if (blockEnd == NO_MATCHING_BRACKET) {
+        syntaxError(blockStart, "Unclosed brace or parenthesis {");
+        return ERROR_NODE;
+    }
 
-        // If we find a right brace, we are done
-        if (token->type == TokenType::RIGHT_BRACE) {
-            break;
-        }
+    // The statements go on top of the enclosing blocks' in pendingNodes
+    return finishBlock(blockEnd, pendingNodes, pendingNodes.size());
+}
 
-        // Check if the token is a keyword
-        if (token->type == TokenType::KEYWORD) {
-            // Check which keyword it is
-            if (token->lexeme == "int" || token->lexeme == "float" || token->lexeme == "void") {
-                // Either a variable or function declaration
-                // Functions are indicated by a function header, i.e. a type, a function name, and a (
-                if (currentTokenIndex + 1 < tokens.size() && tokens[currentTokenIndex + 1].type == TokenType::IDENTIFIER && currentTokenIndex + 2 < tokens.size() && tokens[currentTokenIndex + 2].type == TokenType::LEFT_PARENTHESIS) {
-                    // Parse the function declaration
-                    statements.push_back(parseFunctionDeclaration());
-                } else if (currentTokenIndex + 1 < tokens.size() && tokens[currentTokenIndex + 1].type == TokenType::IDENTIFIER) {
-                    // Parse the variable declaration
-                    statements.push_back(parseVariableDeclaration());
-                } else {
-                    syntaxError("BlockNode: Unexpected keyword " + token->lexeme);
-                    // Nuke statements
-                    for (auto statement : statements) {
-                        delete statement;
-                    }
-                    return ERROR_NODE;
-                }
-            } else if (token->lexeme == "if") {
-                // Parse the if statement
-                statements.push_back(parseIfStatement());
-            } else if (token->lexeme == "while") {
-                // Parse the while loop
-                statements.push_back(parseWhile());
-            } else if (token->lexeme == "break") {
-                // Parse the break statement
-                statements.push_back(parseBreak());
-            } else if (token->lexeme == "continue") {
-                // Parse the continue statement
-                statements.push_back(parseContinue());
-            } else if (token->lexeme == "return") {
-                // Parse the return statement
-                statements.push_back(parseReturn());
-            } else if (token->lexeme == "for") {
-                // Parse the for loop
-                statements.push_back(parseFor());
-            } else {
-                syntaxError("BlockNode1: Unexpected keyword " + token->lexeme);
-                // Nuke statements
-                for (auto statement : statements) {
-                    delete statement;
-                }
-                return ERROR_NODE;
-            }
-        } else if (token->type == TokenType::IDENTIFIER) {
-            if (currentTokenIndex + 1 < tokens.size() && tokens[currentTokenIndex + 1].type == TokenType::LEFT_PARENTHESIS) {
-                // Function calls with no assignment in current scope
-                statements.push_back(parseFunctionCall());
-
-            } else {
-                // Parse the assignment
-                statements.push_back(parseAssignment(TokenType::SEMICOLON));
-            }
-        } else {
-            syntaxError("BlockNode3: Unexpected token " + tokens[currentTokenIndex].lexeme);
-            // Nuke statements
-            for (auto statement : statements) {
-                delete statement;
-            }
-            return ERROR_NODE;
-        }
+BlockNode* Parser::finishBlock(size_t blockEnd, std::vector<ASTNode*>& statements, size_t first) {
+    while (currentTokenIndex < blockEnd) {
+        ASTNode* statement = parseStatement();
 
         // Check from the error handler after any statement
         if (errorHandler.shouldStopExecution()) {
-            // Nuke statements
-            for (auto statement : statements) {
-                delete statement;
-            }
+            statements.resize(first);
             return ERROR_NODE;
         }
+
+        statements.push_back(statement);
     }
 
     // Eat the trailing brace
     eatToken(TokenType::RIGHT_BRACE);
 
-    if (errorHandler.shouldStopExecution()) {
-        // Nuke statements
-        for (auto statement : statements) {
-            delete statement;
+    BlockNode* block = ERROR_NODE;
+    if (!errorHandler.shouldStopExecution()) {
+        block = locate(new (arena) BlockNode(ArenaArray<ASTNode*>(arena, statements, first)), tokens[matchingBrackets[blockEnd]]);
+    }
+
+    statements.resize(first);
+    return block;
+}
+
+ASTNode* Parser::parseStatement() {
+    // This is where we need to differentiate between assignment, declaration, if,
+    // while, ...
+    const Token* token = &tokens[currentTokenIndex];
+
+    // Check if the token is a keyword
+    if (token->type == TokenType::KEYWORD) {
+        // Check which keyword it is
+        if (token->lexeme == "int" || token->lexeme == "float" || token->lexeme == "void") {
+            // Either a variable or function declaration
+            // Functions are indicated by a function header, i.e. a type, a function name, and a (
+            if (currentTokenIndex + 1 < tokens.size() && tokens[currentTokenIndex + 1].type == TokenType::IDENTIFIER && currentTokenIndex + 2 < tokens.size() && tokens[currentTokenIndex + 2].type == TokenType::LEFT_PARENTHESIS) {
+                // Parse the function declaration
+                return parseFunctionDeclaration();
+            } else if (currentTokenIndex + 1 < tokens.size() && tokens[currentTokenIndex + 1].type == TokenType::IDENTIFIER) {
+                // Parse the variable declaration
+                return parseVariableDeclaration();
+            } else {
+                syntaxError("BlockNode: Unexpected keyword " + token->lexeme);
+                return ERROR_NODE;
+            }
+        } else if (token->lexeme == "if") {
+            // Parse the if statement
+            return parseIfStatement();
+        } else if (token->lexeme == "while") {
+            // Parse the while loop
+            return parseWhile();
+        } else if (token->lexeme == "break") {
+            // Parse the break statement
+            return parseBreak();
+        } else if (token->lexeme == "continue") {
+            // Parse the continue statement
+            return parseContinue();
+        } else if (token->lexeme == "return") {
+            // Parse the return statement
+            return parseReturn();
+        } else if (token->lexeme == "for") {
+            // Parse the for loop
+            return parseFor();
+        } else {
+            syntaxError("BlockNode1: Unexpected keyword " + token->lexeme);
+            return ERROR_NODE;
+        }
+    } else if (token->type == TokenType::IDENTIFIER) {
+        if (currentTokenIndex + 1 < tokens.size() && tokens[currentTokenIndex + 1].type == TokenType::LEFT_PARENTHESIS) {
+            // Function calls with no assignment in current scope
+            return parseFunctionCall();
+        } else {
+            // Parse the assignment
+            return parseAssignment(TokenType::SEMICOLON);
         }
-        return ERROR_NODE;
     }
 
-    return new BlockNode(statements);
+    syntaxError("BlockNode3: Unexpected token " + tokens[currentTokenIndex].lexeme);
+    return ERROR_NODE;
 }
 
 VariableDeclarationNode* Parser::parseVariableDeclaration() {
+    size_t start = currentTokenIndex;
+
     // Parse a variable declaration
     // Ex: int x = 5;
     // Ex: float y = x * 5.4;
@@ -948,7 +882,7 @@ VariableDeclarationNode* Parser::parseVariableDeclaration() {
         // Check which keyword it is
         if (tokens[currentTokenIndex].lexeme == "int" || tokens[currentTokenIndex].lexeme == "float") {
             // Parse the type
-            std::string type = tokens[currentTokenIndex].lexeme;
+            Symbol type = symbolTable.intern(tokens[currentTokenIndex].lexeme);
             eatToken(TokenType::KEYWORD);
 
             if (errorHandler.shouldStopExecution()) {
@@ -956,7 +890,7 @@ VariableDeclarationNode* Parser::parseVariableDeclaration() {
             }
 
             // Parse the identifier
-            std::string identifier = tokens[currentTokenIndex].lexeme;
+            Symbol identifier = tokens[currentTokenIndex].symbol;
             eatToken(TokenType::IDENTIFIER);
 
             if (errorHandler.shouldStopExecution()) {
@@ -973,15 +907,7 @@ VariableDeclarationNode* Parser::parseVariableDeclaration() {
                     return ERROR_NODE;
                 }
 
-                std::vector<const Token*> expressionTokens = gatherTokensUntil(TokenType::SEMICOLON);
-
-                if (errorHandler.shouldStopExecution()) {
-                    return ERROR_NODE;
-                }
-
-                // Parse the initializer, minus the semicolon
-                expressionTokens.pop_back();
-                initializer = parseExpression(expressionTokens, false);
+                initializer = parseExpression(TokenType::SEMICOLON);
 
                 if (errorHandler.shouldStopExecution()) {
                     return ERROR_NODE;
@@ -991,9 +917,8 @@ VariableDeclarationNode* Parser::parseVariableDeclaration() {
                 return ERROR_NODE;
             }
 
-            // Semicolon is already eaten by gatherTokensUntil and we popped it off
-            // the expressionTokens vector
-            return new VariableDeclarationNode(identifier, type, initializer);
+            // Semicolon is already eaten by parseExpression
+            return locate(new (arena) VariableDeclarationNode(identifier, type, initializer), tokens[start]);
 
         } else {
             syntaxError("VariableDeclarationNode: Unexpected keyword " + tokens[currentTokenIndex].lexeme);
@@ -1006,6 +931,8 @@ VariableDeclarationNode* Parser::parseVariableDeclaration() {
 }
 
 WhileNode* Parser::parseWhile() {
+    size_t start = currentTokenIndex;
+
     // Check if the current token is a keyword
     if (tokens[currentTokenIndex].type == TokenType::KEYWORD && tokens[currentTokenIndex].lexeme == "while") {
         // Eat the while keyword
@@ -1024,17 +951,7 @@ WhileNode* Parser::parseWhile() {
                 return ERROR_NODE;
             }
 
-            std::vector<const Token*> expressionTokens = gatherTokensUntil(TokenType::RIGHT_PARENTHESIS);
-
-            if (errorHandler.shouldStopExecution()) {
-                return ERROR_NODE;
-            }
-
-            // Pop off the right parenthesis
-            expressionTokens.pop_back();
-
-            // Parse the expression
-            ASTNode* expression = parseExpression(expressionTokens, false);
+            ASTNode* expression = parseExpression(TokenType::RIGHT_PARENTHESIS);
 
             if (errorHandler.shouldStopExecution()) {
                 return ERROR_NODE;
@@ -1044,11 +961,10 @@ WhileNode* Parser::parseWhile() {
             BlockNode* block = parseBlock();
 
             if (errorHandler.shouldStopExecution()) {
-                delete expression;
                 return ERROR_NODE;
             }
 
-            return new WhileNode(expression, block);
+            return locate(new (arena) WhileNode(expression, block), tokens[start]);
         } else {
             syntaxError("WhileNode1: Unexpected token " + tokens[currentTokenIndex].lexeme);
             return ERROR_NODE;
@@ -1060,6 +976,8 @@ WhileNode* Parser::parseWhile() {
 }
 
 BreakNode* Parser::parseBreak() {
+    size_t start = currentTokenIndex;
+
     // Check if the current token is a keyword
     if (tokens[currentTokenIndex].type == TokenType::KEYWORD && tokens[currentTokenIndex].lexeme == "break") {
         // Eat the break keyword
@@ -1076,7 +994,7 @@ BreakNode* Parser::parseBreak() {
             return ERROR_NODE;
         }
 
-        return new BreakNode();
+        return locate(new (arena) BreakNode(), tokens[start]);
     } else {
         syntaxError("BreakNode: Unexpected token " + tokens[currentTokenIndex].lexeme);
         return ERROR_NODE;
@@ -1084,6 +1002,8 @@ BreakNode* Parser::parseBreak() {
 }
 
 ContinueNode* Parser::parseContinue() {
+    size_t start = currentTokenIndex;
+
     // Check if the current token is a keyword
     if (tokens[currentTokenIndex].type == TokenType::KEYWORD && tokens[currentTokenIndex].lexeme == "continue") {
         // Eat the continue keyword
@@ -1100,7 +1020,7 @@ ContinueNode* Parser::parseContinue() {
             return ERROR_NODE;
         }
 
-        return new ContinueNode();
+        return locate(new (arena) ContinueNode(), tokens[start]);
     } else {
         syntaxError("ContinueNode: Unexpected token " + tokens[currentTokenIndex].lexeme);
         return ERROR_NODE;
@@ -1110,52 +1030,9 @@ ContinueNode* Parser::parseContinue() {
 FunctionCallNode* Parser::parseFunctionCall() {
     // Check if the current token is an identifier
     if (tokens[currentTokenIndex].type == TokenType::IDENTIFIER) {
-        // We can just leverage parseExpression to parse the function call
-
-        // Note the identifier token
-        const Token* identifierToken = &tokens[currentTokenIndex];
-
-        // Eat the identifier
-        eatToken(TokenType::IDENTIFIER);
-
-        if (errorHandler.shouldStopExecution()) {
-            return ERROR_NODE;
-        }
-
-        // Note the left parenthesis token
-        const Token* leftParenthesisToken = &tokens[currentTokenIndex];
-
-        // Eat the left parenthesis
-        eatToken(TokenType::LEFT_PARENTHESIS);
-
-        if (errorHandler.shouldStopExecution()) {
-            return ERROR_NODE;
-        }
-
-        // Gather the tokens until the right parenthesis
-        std::vector<const Token*> expressionTokens = gatherTokensUntil(TokenType::RIGHT_PARENTHESIS);
+        FunctionCallNode* functionCall = parseCall();
 
-        if (errorHandler.shouldStopExecution()) {
-            return ERROR_NODE;
-        }
-
-        // Prepend the identifier token and a left parenthesis token to prepare for parseExpression
-        expressionTokens.insert(expressionTokens.begin(), identifierToken);
-        expressionTokens.insert(expressionTokens.begin() + 1, leftParenthesisToken);
-
-        // Will also need to append the right parenthesis token to complete the addition of the function call
-        Token* rightParenthesisToken = new Token();
-        rightParenthesisToken->type = TokenType::RIGHT_PARENTHESIS;
-        rightParenthesisToken->lexeme = ")";
-        expressionTokens.push_back(rightParenthesisToken);
-
-        // Note how we had to do this workaround in order to have the safely keep track of the token index
-        // This makes sure that the token index is at the right place and that these tokens actually exist
-
-        ASTNode* expression = parseExpression(expressionTokens, false);
-
-        if (errorHandler.shouldStopExecution()) {
-            delete rightParenthesisToken;
+        if (functionCall == ERROR_NODE) {
             return ERROR_NODE;
         }
 
@@ -1163,21 +1040,10 @@ FunctionCallNode* Parser::parseFunctionCall() {
         eatToken(TokenType::SEMICOLON);
 
         if (errorHandler.shouldStopExecution()) {
-            delete rightParenthesisToken;
-            delete expression;
             return ERROR_NODE;
         }
 
-        // The expression should be a function call node
-        if (expression->getNodeType() == ASTNodeType::FUNCTION_CALL_NODE) {
-            delete rightParenthesisToken;
-            return (FunctionCallNode*)expression;
-        } else {
-            syntaxError("FunctionCallNode: Unexpected token " + tokens[currentTokenIndex].lexeme);
-            delete rightParenthesisToken;
-            delete expression;
-            return ERROR_NODE;
-        }
+        return functionCall;
     } else {
         syntaxError("FunctionCallNode: Unexpected token " + tokens[currentTokenIndex].lexeme);
         return ERROR_NODE;
@@ -1185,15 +1051,17 @@ FunctionCallNode* Parser::parseFunctionCall() {
 }
 
 FunctionDeclarationNode* Parser::parseFunctionDeclaration() {
+    size_t start = currentTokenIndex;
+
     // A function declaration is a keyword followed by an identifier followed by a left parenthesis
-    std::string type = tokens[currentTokenIndex].lexeme;
+    Symbol type = symbolTable.intern(tokens[currentTokenIndex].lexeme);
     eatToken(TokenType::KEYWORD);
 
     if (errorHandler.shouldStopExecution()) {
         return ERROR_NODE;
     }
 
-    std::string identifier = tokens[currentTokenIndex].lexeme;
+    Symbol identifier = tokens[currentTokenIndex].symbol;
     eatToken(TokenType::IDENTIFIER);
 
     if (errorHandler.shouldStopExecution()) {
@@ -1207,8 +1075,9 @@ FunctionDeclarationNode* Parser::parseFunctionDeclaration() {
     }
 
     // Gather the tokens until the right parenthesis
-    std::vector<std::string> parameterTypes;
-    std::vector<std::string> parameterIdentifiers;
+    std::vector<Symbol> parameterTypes;
+    std::vector<ValueType> parameterValueTypes;
+    std::vector<Symbol> parameterIdentifiers;
 
     while (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type != TokenType::RIGHT_PARENTHESIS) {
         // Check if the current token is a keyword
@@ -1216,7 +1085,7 @@ FunctionDeclarationNode* Parser::parseFunctionDeclaration() {
             // Check which keyword it is
             if (tokens[currentTokenIndex].lexeme == "int" || tokens[currentTokenIndex].lexeme == "float") {
                 // Parse the type
-                std::string type = tokens[currentTokenIndex].lexeme;
+                Symbol type = symbolTable.intern(tokens[currentTokenIndex].lexeme);
                 eatToken(TokenType::KEYWORD);
 
                 if (errorHandler.shouldStopExecution()) {
@@ -1225,6 +1094,7 @@ FunctionDeclarationNode* Parser::parseFunctionDeclaration() {
 
                 // Add the type to the vector
                 parameterTypes.push_back(type);
+                parameterValueTypes.push_back(tokens[currentTokenIndex - 1].lexeme == "int" ? ValueType::INTEGER : ValueType::FLOAT);
             }
         } else {
             syntaxError("FunctionDeclarationNode: Unexpected token " + tokens[currentTokenIndex].lexeme);
@@ -1234,7 +1104,7 @@ FunctionDeclarationNode* Parser::parseFunctionDeclaration() {
         // Check if the current token is an identifier
         if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type == TokenType::IDENTIFIER) {
             // Parse the identifier
-            std::string identifier = tokens[currentTokenIndex].lexeme;
+            Symbol identifier = tokens[currentTokenIndex].symbol;
             eatToken(TokenType::IDENTIFIER);
 
             if (errorHandler.shouldStopExecution()) {
@@ -1279,18 +1149,22 @@ FunctionDeclarationNode* Parser::parseFunctionDeclaration() {
 
     // Go through the pararameter identifiers and obfuscate them
     for (size_t i = 0; i < parameterIdentifiers.size(); i++) {
-        std::string oldIdentifier = parameterIdentifiers[i];
-        std::string newIdentifier = genNewIdentifier();
+        Symbol oldIdentifier = parameterIdentifiers[i];
+        Symbol newIdentifier = genNewIdentifier();
 
         // Replace the old identifier with the new identifier
         parameterIdentifiers[i] = newIdentifier;
         block->replaceIdentifier(oldIdentifier, newIdentifier);
     }
 
-    return new FunctionDeclarationNode(type, identifier, parameterIdentifiers, parameterTypes, block);
+    return locate(new (arena) FunctionDeclarationNode(type, identifier, ArenaArray<Symbol>(arena, parameterIdentifiers), ArenaArray<Symbol>(arena, parameterTypes),
+                                                      ArenaArray<ValueType>(arena, parameterValueTypes), block),
+                  tokens[start]);
 }
 
 ReturnNode* Parser::parseReturn() {
+    size_t start = currentTokenIndex;
+
     // Check if the current token is a keyword
     if (tokens[currentTokenIndex].type == TokenType::KEYWORD && tokens[currentTokenIndex].lexeme == "return") {
         // Eat the return keyword
@@ -1302,21 +1176,13 @@ ReturnNode* Parser::parseReturn() {
 
         // Check if there is an expression
         if (currentTokenIndex < tokens.size() && tokens[currentTokenIndex].type != TokenType::SEMICOLON) {
-            std::vector<const Token*> expressionTokens = gatherTokensUntil(TokenType::SEMICOLON);
-
-            if (errorHandler.shouldStopExecution()) {
-                return ERROR_NODE;
-            }
-
-            // Parse the expression, minus the semicolon
-            expressionTokens.pop_back();
-            ASTNode* expression = parseExpression(expressionTokens, false);
+            ASTNode* expression = parseExpression(TokenType::SEMICOLON);
 
             if (errorHandler.shouldStopExecution()) {
                 return ERROR_NODE;
             }
 
-            return new ReturnNode(expression);
+            return locate(new (arena) ReturnNode(expression), tokens[start]);
         } else {
             // Eat the semicolon
             eatToken(TokenType::SEMICOLON);
@@ -1325,7 +1191,7 @@ ReturnNode* Parser::parseReturn() {
                 return ERROR_NODE;
             }
 
-            return new ReturnNode();
+            return locate(new (arena) ReturnNode(), tokens[start]);
         }
     } else {
         syntaxError("ReturnNode: Unexpected token " + tokens[currentTokenIndex].lexeme);
@@ -1334,6 +1200,8 @@ ReturnNode* Parser::parseReturn() {
 }
 
 ForNode* Parser::parseFor() {
+    size_t start = currentTokenIndex;
+
     // Check if the current token is a keyword
     if (tokens[currentTokenIndex].type == TokenType::KEYWORD && tokens[currentTokenIndex].lexeme == "for") {
         // Eat the for keyword
@@ -1360,19 +1228,9 @@ ForNode* Parser::parseFor() {
             }
 
             // Parse the condition
-            std::vector<const Token*> expressionTokens = gatherTokensUntil(TokenType::SEMICOLON);
-
-            if (errorHandler.shouldStopExecution()) {
-                delete initializer;
-                return ERROR_NODE;
-            }
-
-            // Parse the expression, minus the semicolon
-            expressionTokens.pop_back();
-            ASTNode* condition = parseExpression(expressionTokens, false);
+            ASTNode* condition = parseExpression(TokenType::SEMICOLON);
 
             if (errorHandler.shouldStopExecution()) {
-                delete initializer;
                 return ERROR_NODE;
             }
 
@@ -1380,8 +1238,6 @@ ForNode* Parser::parseFor() {
             ASTNode* increment = parseAssignment(TokenType::RIGHT_PARENTHESIS);
 
             if (errorHandler.shouldStopExecution()) {
-                delete initializer;
-                delete condition;
                 return ERROR_NODE;
             }
 
@@ -1389,13 +1245,10 @@ ForNode* Parser::parseFor() {
             BlockNode* block = parseBlock();
 
             if (errorHandler.shouldStopExecution()) {
-                delete initializer;
-                delete condition;
-                delete increment;
                 return ERROR_NODE;
             }
 
-            return new ForNode(initializer, condition, increment, block);
+            return locate(new (arena) ForNode(initializer, condition, increment, block), tokens[start]);
         } else {
             syntaxError("ForNode1: Unexpected token " + tokens[currentTokenIndex].lexeme);
             return ERROR_NODE;
@@ -1411,17 +1264,10 @@ ForNode* Parser::parseFor() {
 // ASTNode Implementations
 //================================================================================================
 
-BlockNode::BlockNode(const std::vector<ASTNode*>& statements)
-    : statements(statements) {
+BlockNode::BlockNode(const ArenaArray<ASTNode*>& statements)
+    : statements(statements), frameSize(0) {
 }
 
-BlockNode::~BlockNode() {
-    while (!statements.empty()) {
-        ASTNode* statement = statements.back();
-        statements.pop_back();
-        delete statement;
-    }
-}
 
 std::string BlockNode::toString() const {
     std::string result = "BLOCK NODE {\n";
@@ -1434,10 +1280,14 @@ std::string BlockNode::toString() const {
 
 ASTNodeType BlockNode::getNodeType() const { return ASTNodeType::BLOCK_NODE; }
 
-std::vector<ASTNode*> BlockNode::getStatements() const { return statements; }
+const ArenaArray<ASTNode*>& BlockNode::getStatements() const { return statements; }
 
+int BlockNode::getFrameSize() const { return frameSize; }
 
-void BlockNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void BlockNode::setFrameSize(int frameSize) { this->frameSize = frameSize; }
+
+
+void BlockNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     for (ASTNode* statement : statements) {
         statement->replaceIdentifier(oldIdentifier, newIdentifier);
     }
@@ -1446,29 +1296,36 @@ void BlockNode::replaceIdentifier(const std::string& oldIdentifier, const std::s
 
 
 VariableDeclarationNode::VariableDeclarationNode(
-    const std::string& identifier, const std::string& type, ASTNode* initializer)
-    : identifier(identifier), type(type), initializer(initializer) {
+    Symbol identifier, Symbol type, ASTNode* initializer)
+    : identifier(identifier), type(type), initializer(initializer), location({-1, -1, ValueType::INTEGER}) {
 }
 
-VariableDeclarationNode::~VariableDeclarationNode() { delete initializer; }
 
 std::string VariableDeclarationNode::toString() const {
-    std::string result = "VARIABLE DECLARATION " + type + " " + identifier;
+    std::string result = "VARIABLE DECLARATION " + symbolTable.name(type) + " " + symbolTable.name(identifier);
     if (initializer != nullptr) {
         result += " = " + initializer->toString();
     }
     return result;
 }
 
-std::string VariableDeclarationNode::getIdentifier() const { return identifier; }
+const std::string& VariableDeclarationNode::getIdentifier() const { return symbolTable.name(identifier); }
+
+Symbol VariableDeclarationNode::getSymbol() const { return identifier; }
 
-std::string VariableDeclarationNode::getType() const { return type; }
+const std::string& VariableDeclarationNode::getType() const { return symbolTable.name(type); }
 
 ASTNode* VariableDeclarationNode::getInitializer() const { return initializer; }
 
+void VariableDeclarationNode::setInitializer(ASTNode* initializer) { this->initializer = initializer; }
+
+const VariableLocation& VariableDeclarationNode::getLocation() const { return location; }
+
+void VariableDeclarationNode::setLocation(const VariableLocation& location) { this->location = location; }
+
 ASTNodeType VariableDeclarationNode::getNodeType() const { return ASTNodeType::VARIABLE_DECLARATION_NODE; }
 
-void VariableDeclarationNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void VariableDeclarationNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     if (initializer != nullptr) {
         initializer->replaceIdentifier(oldIdentifier, newIdentifier);
     }
@@ -1478,13 +1335,12 @@ void VariableDeclarationNode::replaceIdentifier(const std::string& oldIdentifier
     }
 }
 
-AssignmentNode::AssignmentNode(const std::string& identifier, ASTNode* expression)
-    : identifier(identifier), expression(expression) {
+AssignmentNode::AssignmentNode(Symbol identifier, ASTNode* expression)
+    : identifier(identifier), expression(expression), location({-1, -1, ValueType::INTEGER}) {
 }
 
-AssignmentNode::~AssignmentNode() { delete expression; }
 
-void AssignmentNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void AssignmentNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     expression->replaceIdentifier(oldIdentifier, newIdentifier);
 
     if (identifier == oldIdentifier) {
@@ -1492,51 +1348,71 @@ void AssignmentNode::replaceIdentifier(const std::string& oldIdentifier, const s
     }
 }
 
-std::string AssignmentNode::getIdentifier() const { return identifier; }
+const std::string& AssignmentNode::getIdentifier() const { return symbolTable.name(identifier); }
 
-std::string AssignmentNode::toString() const { return "ASSIGNMENT " + identifier + " = " + expression->toString(); }
+Symbol AssignmentNode::getSymbol() const { return identifier; }
+
+std::string AssignmentNode::toString() const { return "ASSIGNMENT " + symbolTable.name(identifier) + " = " + expression->toString(); }
 
 ASTNode* AssignmentNode::getExpression() const { return expression; }
 
+void AssignmentNode::setExpression(ASTNode* expression) { this->expression = expression; }
+
+const VariableLocation& AssignmentNode::getLocation() const { return location; }
+
+void AssignmentNode::setLocation(const VariableLocation& location) { this->location = location; }
+
 ASTNodeType AssignmentNode::getNodeType() const { return ASTNodeType::ASSIGNMENT_NODE; }
 
-NumberNode::NumberNode(std::string val, TokenType type)
-    : value(val), type(type) {
+NumberNode::NumberNode(const char* val, int intValue)
+    : value(val), type(TokenType::INTEGER), intValue(intValue) {
 }
 
-NumberNode::~NumberNode() {}
+NumberNode::NumberNode(const char* val, float floatValue)
+    : value(val), type(TokenType::FLOAT), floatValue(floatValue) {
+}
 
-std::string NumberNode::toString() const { return "NUMBER " + value; }
+
+std::string NumberNode::toString() const { return std::string("NUMBER ") + value; }
 
 TokenType NumberNode::getType() const { return type; }
 
+int NumberNode::getIntValue() const { return intValue; }
+
+float NumberNode::getFloatValue() const { return floatValue; }
+
 std::string NumberNode::getValue() const { return value; }
 
 ASTNodeType NumberNode::getNodeType() const { return ASTNodeType::NUMBER_NODE; }
 
-void NumberNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void NumberNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     // Do nothing
 }
 
-VariableAccessNode::VariableAccessNode(const std::string& identifier)
-    : identifier(identifier) {
+VariableAccessNode::VariableAccessNode(Symbol identifier)
+    : identifier(identifier), location({-1, -1, ValueType::INTEGER}) {
 }
 
-std::string VariableAccessNode::toString() const { return "VARIABLE ACCESS " + identifier; }
+std::string VariableAccessNode::toString() const { return "VARIABLE ACCESS " + symbolTable.name(identifier); }
+
+const std::string& VariableAccessNode::getIdentifier() const { return symbolTable.name(identifier); }
+
+Symbol VariableAccessNode::getSymbol() const { return identifier; }
+
+const VariableLocation& VariableAccessNode::getLocation() const { return location; }
 
-std::string VariableAccessNode::getIdentifier() const { return identifier; }
+void VariableAccessNode::setLocation(const VariableLocation& location) { this->location = location; }
 
 ASTNodeType VariableAccessNode::getNodeType() const { return ASTNodeType::VARIABLE_ACCESS_NODE; }
 
-VariableAccessNode::~VariableAccessNode() {}
 
-void VariableAccessNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void VariableAccessNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     if (identifier == oldIdentifier) {
         identifier = newIdentifier;
     }
 }
 
-IfNode::IfNode(std::vector<ASTNode*> expressions, std::vector<BlockNode*> bodies)
+IfNode::IfNode(const ArenaArray<ASTNode*>& expressions, const ArenaArray<BlockNode*>& bodies)
     : expressions(expressions), bodies(bodies) {
 }
 
@@ -1551,26 +1427,16 @@ std::string IfNode::toString() const {
     return result;
 }
 
-std::vector<ASTNode*> IfNode::getExpressions() const { return expressions; }
+const ArenaArray<ASTNode*>& IfNode::getExpressions() const { return expressions; }
 
-std::vector<BlockNode*> IfNode::getBodies() const { return bodies; }
+void IfNode::setExpression(size_t index, ASTNode* expression) { expressions[index] = expression; }
+
+const ArenaArray<BlockNode*>& IfNode::getBodies() const { return bodies; }
 
 ASTNodeType IfNode::getNodeType() const { return ASTNodeType::IF_NODE; }
 
-IfNode::~IfNode() {
-    while (!expressions.empty()) {
-        ASTNode* expression = expressions.back();
-        expressions.pop_back();
-        delete expression;
-    }
-    while (!bodies.empty()) {
-        BlockNode* body = bodies.back();
-        bodies.pop_back();
-        delete body;
-    }
-}
 
-void IfNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void IfNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     for (ASTNode* expression : expressions) {
         expression->replaceIdentifier(oldIdentifier, newIdentifier);
     }
@@ -1580,47 +1446,48 @@ void IfNode::replaceIdentifier(const std::string& oldIdentifier, const std::stri
     }
 }
 
-BinaryOperationNode::BinaryOperationNode(ASTNode* left, std::string op, ASTNode* right)
+BinaryOperationNode::BinaryOperationNode(ASTNode* left, Operator op, ASTNode* right)
     : left(left), op(op), right(right) {
 }
 
 std::string BinaryOperationNode::toString() const {
-    return "BINARY OPERATION (" + left->toString() + " " + op + " " + right->toString() + ")";
+    return "BINARY OPERATION (" + left->toString() + " " + operatorToString(op) + " " + right->toString() + ")";
 }
 
-BinaryOperationNode::~BinaryOperationNode() {
-    delete left;
-    delete right;
-}
 
 ASTNode* BinaryOperationNode::getLeftExpression() const { return left; }
 
 ASTNode* BinaryOperationNode::getRightExpression() const { return right; }
 
-std::string BinaryOperationNode::getOperator() const { return op; }
+void BinaryOperationNode::setLeftExpression(ASTNode* left) { this->left = left; }
+
+void BinaryOperationNode::setRightExpression(ASTNode* right) { this->right = right; }
+
+Operator BinaryOperationNode::getOperator() const { return op; }
 
 ASTNodeType BinaryOperationNode::getNodeType() const { return ASTNodeType::BINARY_OPERATION_NODE; }
 
-void BinaryOperationNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void BinaryOperationNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     left->replaceIdentifier(oldIdentifier, newIdentifier);
     right->replaceIdentifier(oldIdentifier, newIdentifier);
 }
 
-MonoOperationNode::MonoOperationNode(std::string op, ASTNode* expression)
+MonoOperationNode::MonoOperationNode(Operator op, ASTNode* expression)
     : op(op), expression(expression) {
 }
 
-std::string MonoOperationNode::toString() const { return "MONO OPERATION (" + op + " " + expression->toString() + ")"; }
+std::string MonoOperationNode::toString() const { return "MONO OPERATION (" + operatorToString(op) + " " + expression->toString() + ")"; }
 
-MonoOperationNode::~MonoOperationNode() { delete expression; }
 
-std::string MonoOperationNode::getOperator() const { return op; }
+Operator MonoOperationNode::getOperator() const { return op; }
 
 ASTNode* MonoOperationNode::getExpression() const { return expression; }
 
+void MonoOperationNode::setExpression(ASTNode* expression) { this->expression = expression; }
+
 ASTNodeType MonoOperationNode::getNodeType() const { return ASTNodeType::MONO_OPERATION_NODE; }
 
-void MonoOperationNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void MonoOperationNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     expression->replaceIdentifier(oldIdentifier, newIdentifier);
 }
 
@@ -1632,16 +1499,14 @@ std::string WhileNode::toString() const { return "WHILE LOOP ( " + expression->t
 
 ASTNode* WhileNode::getExpression() const { return expression; }
 
+void WhileNode::setExpression(ASTNode* expression) { this->expression = expression; }
+
 BlockNode* WhileNode::getBody() const { return body; }
 
 ASTNodeType WhileNode::getNodeType() const { return ASTNodeType::WHILE_NODE; }
 
-WhileNode::~WhileNode() {
-    delete expression;
-    delete body;
-}
 
-void WhileNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void WhileNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     expression->replaceIdentifier(oldIdentifier, newIdentifier);
     body->replaceIdentifier(oldIdentifier, newIdentifier);
 }
@@ -1652,9 +1517,8 @@ std::string BreakNode::toString() const { return "BREAK STATEMENT"; }
 
 ASTNodeType BreakNode::getNodeType() const { return ASTNodeType::BREAK_NODE; }
 
-BreakNode::~BreakNode() {}
 
-void BreakNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void BreakNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     // Do nothing
 }
 
@@ -1664,42 +1528,43 @@ std::string ContinueNode::toString() const { return "CONTINUE STATEMENT"; }
 
 ASTNodeType ContinueNode::getNodeType() const { return ASTNodeType::CONTINUE_NODE; }
 
-ContinueNode::~ContinueNode() {}
 
-void ContinueNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void ContinueNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     // Do nothing
 }
 
-FunctionDeclarationNode::FunctionDeclarationNode(const std::string& type, const std::string& name, const std::vector<std::string>& parameters, const std::vector<std::string>& parameterTypes, BlockNode* body)
-    : type(type), name(name), parameters(parameters), parameterTypes(parameterTypes), body(body) {
+FunctionDeclarationNode::FunctionDeclarationNode(Symbol type, Symbol name, const ArenaArray<Symbol>& parameters, const ArenaArray<Symbol>& parameterTypes,
+                                                 const ArenaArray<ValueType>& parameterValueTypes, BlockNode* body)
+    : type(type), name(name), parameters(parameters), parameterTypes(parameterTypes), parameterValueTypes(parameterValueTypes), body(body) {
 }
 
 std::string FunctionDeclarationNode::toString() const {
-    std::string result = "FUNCTION DECLARATION (" + type + ") " + name + " ( ";
+    std::string result = "FUNCTION DECLARATION (" + symbolTable.name(type) + ") " + symbolTable.name(name) + " ( ";
     for (size_t i = 0; i < parameters.size(); i++) {
-        result += parameterTypes[i] + " " + parameters[i] + ", ";
+        result += symbolTable.name(parameterTypes[i]) + " " + symbolTable.name(parameters[i]) + ", ";
     }
     result += ") " + body->toString();
     return result;
 }
 
-std::string FunctionDeclarationNode::getType() const { return type; }
+const std::string& FunctionDeclarationNode::getType() const { return symbolTable.name(type); }
+
+const std::string& FunctionDeclarationNode::getName() const { return symbolTable.name(name); }
+
+Symbol FunctionDeclarationNode::getSymbol() const { return name; }
 
-std::string FunctionDeclarationNode::getName() const { return name; }
+const ArenaArray<Symbol>& FunctionDeclarationNode::getParameters() const { return parameters; }
 
-std::vector<std::string> FunctionDeclarationNode::getParameters() const { return parameters; }
+const ArenaArray<Symbol>& FunctionDeclarationNode::getParameterTypes() const { return parameterTypes; }
 
-std::vector<std::string> FunctionDeclarationNode::getParameterTypes() const { return parameterTypes; }
+const ArenaArray<ValueType>& FunctionDeclarationNode::getParameterValueTypes() const { return parameterValueTypes; }
 
 BlockNode* FunctionDeclarationNode::getBody() const { return body; }
 
 ASTNodeType FunctionDeclarationNode::getNodeType() const { return ASTNodeType::FUNCTION_DECLARATION_NODE; }
 
-FunctionDeclarationNode::~FunctionDeclarationNode() {
-    delete body;
-}
 
-void FunctionDeclarationNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void FunctionDeclarationNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     body->replaceIdentifier(oldIdentifier, newIdentifier);
 
     for (size_t i = 0; i < parameters.size(); i++) {
@@ -1709,12 +1574,12 @@ void FunctionDeclarationNode::replaceIdentifier(const std::string& oldIdentifier
     }
 }
 
-FunctionCallNode::FunctionCallNode(const std::string& name, const std::vector<ASTNode*>& arguments)
-    : name(name), arguments(arguments) {
+FunctionCallNode::FunctionCallNode(Symbol name, const ArenaArray<ASTNode*>& arguments, const BuiltinSignature* builtin)
+    : name(name), arguments(arguments), builtin(builtin), target(nullptr), targetDepth(0) {
 }
 
 std::string FunctionCallNode::toString() const {
-    std::string result = "FUNCTION CALL " + name + " ( ";
+    std::string result = "FUNCTION CALL " + symbolTable.name(name) + " ( ";
     for (ASTNode* argument : arguments) {
         result += argument->toString() + ", ";
     }
@@ -1722,21 +1587,29 @@ std::string FunctionCallNode::toString() const {
     return result;
 }
 
-std::string FunctionCallNode::getName() const { return name; }
+const std::string& FunctionCallNode::getName() const { return symbolTable.name(name); }
 
-std::vector<ASTNode*> FunctionCallNode::getArguments() const { return arguments; }
+Symbol FunctionCallNode::getSymbol() const { return name; }
 
-ASTNodeType FunctionCallNode::getNodeType() const { return ASTNodeType::FUNCTION_CALL_NODE; }
+const ArenaArray<ASTNode*>& FunctionCallNode::getArguments() const { return arguments; }
 
-FunctionCallNode::~FunctionCallNode() {
-    while (!arguments.empty()) {
-        ASTNode* argument = arguments.back();
-        arguments.pop_back();
-        delete argument;
-    }
+void FunctionCallNode::setArgument(size_t index, ASTNode* argument) { arguments[index] = argument; }
+
+const BuiltinSignature* FunctionCallNode::getBuiltin() const { return builtin; }
+
+FunctionDeclarationNode* FunctionCallNode::getTarget() const { return target; }
+
+int FunctionCallNode::getTargetDepth() const { return targetDepth; }
+
+void FunctionCallNode::setTarget(FunctionDeclarationNode* target, int depth) {
+    this->target = target;
+    targetDepth = depth;
 }
 
-void FunctionCallNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+ASTNodeType FunctionCallNode::getNodeType() const { return ASTNodeType::FUNCTION_CALL_NODE; }
+
+
+void FunctionCallNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     for (ASTNode* argument : arguments) {
         argument->replaceIdentifier(oldIdentifier, newIdentifier);
     }
@@ -1760,15 +1633,12 @@ std::string ReturnNode::toString() const {
 
 ASTNode* ReturnNode::getExpression() const { return expression; }
 
+void ReturnNode::setExpression(ASTNode* expression) { this->expression = expression; }
+
 ASTNodeType ReturnNode::getNodeType() const { return ASTNodeType::RETURN_NODE; }
 
-ReturnNode::~ReturnNode() {
-    if (expression != nullptr) {
-        delete expression;
-    }
-}
 
-void ReturnNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void ReturnNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     if (expression != nullptr) {
         expression->replaceIdentifier(oldIdentifier, newIdentifier);
     }
@@ -1786,20 +1656,16 @@ ASTNode* ForNode::getInitializer() const { return initializer; }
 
 ASTNode* ForNode::getCondition() const { return condition; }
 
+void ForNode::setCondition(ASTNode* condition) { this->condition = condition; }
+
 ASTNode* ForNode::getIncrement() const { return increment; }
 
 BlockNode* ForNode::getBody() const { return body; }
 
 ASTNodeType ForNode::getNodeType() const { return ASTNodeType::FOR_NODE; }
 
-ForNode::~ForNode() {
-    delete initializer;
-    delete condition;
-    delete increment;
-    delete body;
-}
 
-void ForNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void ForNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     initializer->replaceIdentifier(oldIdentifier, newIdentifier);
     condition->replaceIdentifier(oldIdentifier, newIdentifier);
     increment->replaceIdentifier(oldIdentifier, newIdentifier);
@@ -1812,8 +1678,33 @@ std::string EmptyExpressionNode::toString() const { return "EMPTY EXPRESSION"; }
 
 ASTNodeType EmptyExpressionNode::getNodeType() const { return ASTNodeType::EMPTY_EXPRESSION_NODE; }
 
-EmptyExpressionNode::~EmptyExpressionNode() {}
 
-void EmptyExpressionNode::replaceIdentifier(const std::string& oldIdentifier, const std::string& newIdentifier) {
+void EmptyExpressionNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
     // Do nothing
 }
+
+ConversionNode::ConversionNode(Conversion conversion, ASTNode* expression)
+    : conversion(conversion), expression(expression) {
+    setValueType(conversion == Conversion::INT_TO_FLOAT ? ValueType::FLOAT : ValueType::INTEGER);
+}
+
+std::string ConversionNode::toString() const {
+    switch (conversion) {
+        case Conversion::INT_TO_FLOAT:
+            return "CONVERSION (float " + expression->toString() + ")";
+        case Conversion::FLOAT_TO_INT:
+            return "CONVERSION (int " + expression->toString() + ")";
+        default:
+            return "CONVERSION (truth " + expression->toString() + ")";
+    }
+}
+
+Conversion ConversionNode::getConversion() const { return conversion; }
+
+ASTNode* ConversionNode::getExpression() const { return expression; }
+
+ASTNodeType ConversionNode::getNodeType() const { return ASTNodeType::CONVERSION_NODE; }
+
+void ConversionNode::replaceIdentifier(Symbol oldIdentifier, Symbol newIdentifier) {
+    expression->replaceIdentifier(oldIdentifier, newIdentifier);
+}
@@ -0,0 +1,667 @@
+#include "astSerializer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "builtins.hpp"
+#include "symbols.hpp"
+
+#define AST_FORMAT_MAGIC "BAST"
+
+//================================================================================================
+// Encoding
+//================================================================================================
+
+static void appendVarint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+// Small magnitudes of either sign take one byte, Ex. -1 is 1 and 1 is 2
+static void appendSignedVarint(std::string& out, int32_t value) { appendVarint(out, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31)); }
+
+static bool isGeneratedName(const std::string& name) { return name.compare(0, strlen(GENERATED_IDENTIFIER_PREFIX), GENERATED_IDENTIFIER_PREFIX) == 0; }
+
+// The nodes errors can be reported at, the others take their parent's location
+static bool hasLocation(ASTNodeType type) {
+    switch (type) {
+        case ASTNodeType::NUMBER_NODE:
+        case ASTNodeType::VARIABLE_ACCESS_NODE:
+        case ASTNodeType::CONVERSION_NODE:
+        case ASTNodeType::EMPTY_EXPRESSION_NODE:
+        case ASTNodeType::BLOCK_NODE:
+        case ASTNodeType::BREAK_NODE:
+        case ASTNodeType::CONTINUE_NODE:
+            return false;
+        default:
+            return true;
+    }
+}
+
+ASTSerializer::ASTSerializer(ErrorHandler& errorHandler) : errorHandler(errorHandler), previousLine(0), depth(0), failed(false) {}
+
+std::string ASTSerializer::serialize(const BlockNode& program) {
+    nodes.clear();
+    symbols.clear();
+    symbolIds.clear();
+    previousLine = 0;
+    depth = 0;
+    failed = false;
+
+    writeNode(&program);
+
+    if (failed) {
+        return "";
+    }
+
+    std::string payload = AST_FORMAT_MAGIC;
+    appendVarint(payload, AST_FORMAT_VERSION);
+
+    appendVarint(payload, (uint32_t)symbols.size());
+    for (Symbol symbol : symbols) {
+        const std::string& name = symbolTable.name(symbol);
+        if (isGeneratedName(name)) {
+            appendVarint(payload, 0);
+            continue;
+        }
+        appendVarint(payload, (uint32_t)name.size());
+        payload += name;
+    }
+
+    payload += nodes;
+    return payload;
+}
+
+void ASTSerializer::writeSymbol(Symbol symbol) {
+    auto found = symbolIds.find(symbol);
+    if (found != symbolIds.end()) {
+        appendVarint(nodes, found->second);
+        return;
+    }
+
+    symbols.push_back(symbol);
+    uint32_t id = (uint32_t)symbols.size();
+    symbolIds[symbol] = id;
+    appendVarint(nodes, id);
+}
+
+void ASTSerializer::writeNode(const ASTNode* node) {
+    if (failed) {
+        return;
+    }
+
+    if (node == nullptr) {
+        nodes.push_back((char)NULL_NODE_TAG);
+        return;
+    }
+
+    // Counted like the loader counts, which would reject the payload
+    if (depth + 1 > AST_MAX_DEPTH) {
+        errorHandler.handleError("Serialize Error: Program nested more than " + std::to_string(AST_MAX_DEPTH) + " deep", node->getSourceLocation());
+        failed = true;
+        return;
+    }
+    depth++;
+
+    // Scripts run top to bottom, so the line mostly stays put or moves down by one
+    uint8_t tag = (uint8_t)node->getNodeType();
+    if (!hasLocation(node->getNodeType())) {
+        nodes.push_back((char)tag);
+    } else {
+        SourceLocation location = node->getSourceLocation();
+        if (location.line == previousLine) {
+            nodes.push_back((char)tag);
+        } else {
+            nodes.push_back((char)(tag | LINE_CHANGED_FLAG));
+            appendSignedVarint(nodes, (int32_t)location.line - (int32_t)previousLine);
+            previousLine = location.line;
+        }
+        appendVarint(nodes, location.column);
+    }
+
+    switch (node->getNodeType()) {
+        case ASTNodeType::BLOCK_NODE: {
+            const ArenaArray<ASTNode*>& statements = ((const BlockNode*)node)->getStatements();
+            appendVarint(nodes, (uint32_t)statements.size());
+            for (const ASTNode* statement : statements) {
+                writeNode(statement);
+            }
+            break;
+        }
+
+        case ASTNodeType::VARIABLE_DECLARATION_NODE: {
+            const VariableDeclarationNode* declaration = (const VariableDeclarationNode*)node;
+            writeSymbol(declaration->getSymbol());
+            writeSymbol(symbolTable.find(declaration->getType()));
+            writeNode(declaration->getInitializer());
+            break;
+        }
+
+        case ASTNodeType::ASSIGNMENT_NODE: {
+            const AssignmentNode* assignment = (const AssignmentNode*)node;
+            writeSymbol(assignment->getSymbol());
+            writeNode(assignment->getExpression());
+            break;
+        }
+
+        case ASTNodeType::VARIABLE_ACCESS_NODE:
+            writeSymbol(((const VariableAccessNode*)node)->getSymbol());
+            break;
+
+        case ASTNodeType::NUMBER_NODE: {
+            const NumberNode* number = (const NumberNode*)node;
+            if (number->getType() == TokenType::INTEGER) {
+                nodes.push_back(0);
+                appendSignedVarint(nodes, number->getIntValue());
+            } else {
+                // As written, so the loader decodes it exactly like the Parser did
+                // The Optimizer spells the values it folds with enough digits to decode to the same float
+                std::string literal = number->getValue();
+                nodes.push_back(1);
+                appendVarint(nodes, (uint32_t)literal.size());
+                nodes += literal;
+            }
+            break;
+        }
+
+        case ASTNodeType::BINARY_OPERATION_NODE: {
+            const BinaryOperationNode* operation = (const BinaryOperationNode*)node;
+            nodes.push_back((char)operation->getOperator());
+            writeNode(operation->getLeftExpression());
+            writeNode(operation->getRightExpression());
+            break;
+        }
+
+        case ASTNodeType::MONO_OPERATION_NODE: {
+            const MonoOperationNode* operation = (const MonoOperationNode*)node;
+            nodes.push_back((char)operation->getOperator());
+            writeNode(operation->getExpression());
+            break;
+        }
+
+        case ASTNodeType::IF_NODE: {
+            const IfNode* ifStatement = (const IfNode*)node;
+            appendVarint(nodes, (uint32_t)ifStatement->getExpressions().size());
+            appendVarint(nodes, (uint32_t)ifStatement->getBodies().size());
+            for (const ASTNode* expression : ifStatement->getExpressions()) {
+                writeNode(expression);
+            }
+            for (const BlockNode* body : ifStatement->getBodies()) {
+                writeNode(body);
+            }
+            break;
+        }
+
+        case ASTNodeType::WHILE_NODE: {
+            const WhileNode* whileStatement = (const WhileNode*)node;
+            writeNode(whileStatement->getExpression());
+            writeNode(whileStatement->getBody());
+            break;
+        }
+
+        case ASTNodeType::FOR_NODE: {
+            const ForNode* forStatement = (const ForNode*)node;
+            writeNode(forStatement->getInitializer());
+            writeNode(forStatement->getCondition());
+            writeNode(forStatement->getIncrement());
+            writeNode(forStatement->getBody());
+            break;
+        }
+
+        case ASTNodeType::FUNCTION_DECLARATION_NODE: {
+            const FunctionDeclarationNode* declaration = (const FunctionDeclarationNode*)node;
+            writeSymbol(symbolTable.find(declaration->getType()));
+            writeSymbol(declaration->getSymbol());
+            appendVarint(nodes, (uint32_t)declaration->getParameters().size());
+            for (size_t i = 0; i < declaration->getParameters().size(); i++) {
+                writeSymbol(declaration->getParameters()[i]);
+                writeSymbol(declaration->getParameterTypes()[i]);
+            }
+            writeNode(declaration->getBody());
+            break;
+        }
+
+        case ASTNodeType::FUNCTION_CALL_NODE: {
+            const FunctionCallNode* call = (const FunctionCallNode*)node;
+            writeSymbol(call->getSymbol());
+            appendVarint(nodes, (uint32_t)call->getArguments().size());
+            for (const ASTNode* argument : call->getArguments()) {
+                writeNode(argument);
+            }
+            break;
+        }
+
+        case ASTNodeType::RETURN_NODE:
+            writeNode(((const ReturnNode*)node)->getExpression());
+            break;
+
+        case ASTNodeType::CONVERSION_NODE: {
+            const ConversionNode* conversion = (const ConversionNode*)node;
+            nodes.push_back((char)conversion->getConversion());
+            writeNode(conversion->getExpression());
+            break;
+        }
+
+        case ASTNodeType::BREAK_NODE:
+        case ASTNodeType::CONTINUE_NODE:
+        case ASTNodeType::EMPTY_EXPRESSION_NODE:
+            break;
+    }
+
+    depth--;
+}
+
+//================================================================================================
+// Decoding
+//================================================================================================
+
+ASTLoader::ASTLoader(ErrorHandler& errorHandler, Arena& arena)
+    : errorHandler(errorHandler), arena(arena), position(nullptr), end(nullptr), previousLine(0), parentLocation{0, 0}, depth(0), failed(false) {}
+
+void ASTLoader::loadError(const std::string& message) {
+    // Only the first problem is reported, the rest follow from it
+    if (!failed) {
+        errorHandler.handleError("Load Error: " + message);
+    }
+    failed = true;
+}
+
+BlockNode* ASTLoader::load(const char* data, size_t size) {
+    position = (const uint8_t*)data;
+    end = position + size;
+    symbols.clear();
+    previousLine = 0;
+    parentLocation = SourceLocation{0, 0};
+    depth = 0;
+    failed = false;
+
+    if (size < 4 || std::memcmp(data, AST_FORMAT_MAGIC, 4) != 0) {
+        loadError("Not a compiled program");
+        return nullptr;
+    }
+    position += 4;
+
+    uint32_t version = readVarint();
+    if (!failed && version != AST_FORMAT_VERSION) {
+        loadError("Compiled for format " + std::to_string(version) + ", expected " + std::to_string(AST_FORMAT_VERSION));
+        return nullptr;
+    }
+
+    uint32_t symbolCount = readVarint();
+    if (!failed && symbolCount > (uint32_t)(end - position)) {
+        loadError("Truncated program");
+    }
+
+    // Names are interned once, nodes refer to them by index
+    symbols.push_back(NO_SYMBOL);
+    for (uint32_t i = 0; i < symbolCount && !failed; i++) {
+        uint32_t length = readVarint();
+        if (failed) {
+            break;
+        }
+        if (length > (uint32_t)(end - position)) {
+            loadError("Truncated program");
+            break;
+        }
+        symbols.push_back(length == 0 ? NO_SYMBOL : symbolTable.intern(StringView((const char*)position, length)));
+        position += length;
+    }
+
+    // Generated names are numbered from 0 like the Parser numbers them
+    // Only a payload that was not written by ASTSerializer can list one of them by name, those are skipped
+    uint32_t generated = 0;
+    for (size_t i = 1; i < symbols.size(); i++) {
+        if (symbols[i] != NO_SYMBOL) {
+            continue;
+        }
+        Symbol symbol;
+        do {
+            symbol = symbolTable.intern(GENERATED_IDENTIFIER_PREFIX + std::to_string(generated++));
+        } while (std::find(symbols.begin(), symbols.end(), symbol) != symbols.end());
+        symbols[i] = symbol;
+    }
+
+    BlockNode* program = failed ? nullptr : readBlock();
+
+    if (!failed && position != end) {
+        loadError("Unexpected data after the program");
+    }
+
+    return failed ? nullptr : program;
+}
+
+uint8_t ASTLoader::readByte() {
+    if (position >= end) {
+        loadError("Truncated program");
+        return 0;
+    }
+    return *position++;
+}
+
+uint32_t ASTLoader::readVarint() {
+    // Cut off mid number, readByte's 0 would end it with whatever was read so far
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35 && !failed; shift += 7) {
+        uint8_t byte = readByte();
+        if (failed) {
+            return 0;
+        }
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+
+    if (!failed) {
+        loadError("Malformed number");
+    }
+    return 0;
+}
+
+int32_t ASTLoader::readSignedVarint() {
+    uint32_t value = readVarint();
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+const char* ASTLoader::readLiteral() {
+    uint32_t length = readVarint();
+    if (failed) {
+        return nullptr;
+    }
+
+    if (length == 0 || length > (uint32_t)(end - position)) {
+        loadError("Truncated program");
+        return nullptr;
+    }
+
+    const char* literal = arena.copyString((const char*)position, length);
+    position += length;
+    return literal;
+}
+
+Symbol ASTLoader::readSymbol() {
+    uint32_t id = readVarint();
+    if (failed) {
+        return NO_SYMBOL;
+    }
+
+    if (id == 0 || id >= symbols.size()) {
+        loadError("Unknown name " + std::to_string(id));
+        return NO_SYMBOL;
+    }
+    return symbols[id];
+}
+
+static bool isStatement(ASTNodeType type) {
+    switch (type) {
+        case ASTNodeType::VARIABLE_DECLARATION_NODE:
+        case ASTNodeType::ASSIGNMENT_NODE:
+        case ASTNodeType::FUNCTION_DECLARATION_NODE:
+        case ASTNodeType::IF_NODE:
+        case ASTNodeType::WHILE_NODE:
+        case ASTNodeType::FOR_NODE:
+        case ASTNodeType::BREAK_NODE:
+        case ASTNodeType::CONTINUE_NODE:
+        case ASTNodeType::RETURN_NODE:
+        case ASTNodeType::FUNCTION_CALL_NODE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool isExpression(ASTNodeType type) {
+    switch (type) {
+        case ASTNodeType::VARIABLE_ACCESS_NODE:
+        case ASTNodeType::NUMBER_NODE:
+        case ASTNodeType::BINARY_OPERATION_NODE:
+        case ASTNodeType::MONO_OPERATION_NODE:
+        case ASTNodeType::FUNCTION_CALL_NODE:
+        case ASTNodeType::EMPTY_EXPRESSION_NODE:
+        case ASTNodeType::CONVERSION_NODE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+ASTNode* ASTLoader::readNode(Position where) {
+    uint8_t tag = readByte();
+    if (failed) {
+        return nullptr;
+    }
+
+    if (tag == NULL_NODE_TAG) {
+        if (where != Position::RETURN_VALUE) {
+            loadError("Missing node");
+        }
+        return nullptr;
+    }
+
+    bool lineChanged = (tag & LINE_CHANGED_FLAG) != 0;
+    tag &= ~LINE_CHANGED_FLAG;
+    if (tag >= AST_NODE_TYPE_COUNT) {
+        loadError("Unknown node type " + std::to_string(tag));
+        return nullptr;
+    }
+
+    ASTNodeType type = (ASTNodeType)tag;
+    bool allowed;
+    switch (where) {
+        case Position::STATEMENT:
+            allowed = isStatement(type);
+            break;
+        case Position::BLOCK:
+            allowed = type == ASTNodeType::BLOCK_NODE;
+            break;
+        case Position::DECLARATION:
+            allowed = type == ASTNodeType::VARIABLE_DECLARATION_NODE;
+            break;
+        case Position::ASSIGNMENT:
+            allowed = type == ASTNodeType::ASSIGNMENT_NODE;
+            break;
+        default:
+            allowed = isExpression(type);
+            break;
+    }
+
+    if (!allowed) {
+        loadError(std::string("Unexpected ") + nodeTypeToString(type));
+        return nullptr;
+    }
+
+    SourceLocation enclosing = parentLocation;
+    SourceLocation location = parentLocation;
+    if (hasLocation(type)) {
+        if (lineChanged) {
+            previousLine += readSignedVarint();
+        }
+        location.line = (uint16_t)previousLine;
+        location.column = (uint16_t)readVarint();
+    } else if (lineChanged) {
+        loadError(std::string("Unexpected line for ") + nodeTypeToString(type));
+        return nullptr;
+    }
+
+    if (++depth > AST_MAX_DEPTH) {
+        loadError("Program nested too deeply");
+        return nullptr;
+    }
+
+    parentLocation = location;
+    ASTNode* node = readFields(type);
+    parentLocation = enclosing;
+    depth--;
+
+    if (failed) {
+        return nullptr;
+    }
+
+    node->setSourceLocation(location);
+    return node;
+}
+
+BlockNode* ASTLoader::readBlock() { return (BlockNode*)readNode(Position::BLOCK); }
+
+ASTNode* ASTLoader::readFields(ASTNodeType type) {
+    switch (type) {
+        case ASTNodeType::BLOCK_NODE: {
+            uint32_t count = readVarint();
+            std::vector<ASTNode*> statements;
+            for (uint32_t i = 0; i < count && !failed; i++) {
+                statements.push_back(readNode(Position::STATEMENT));
+            }
+            return failed ? nullptr : new (arena) BlockNode(ArenaArray<ASTNode*>(arena, statements));
+        }
+
+        case ASTNodeType::VARIABLE_DECLARATION_NODE: {
+            Symbol identifier = readSymbol();
+            Symbol valueType = readSymbol();
+            ASTNode* initializer = readNode(Position::EXPRESSION);
+            return failed ? nullptr : new (arena) VariableDeclarationNode(identifier, valueType, initializer);
+        }
+
+        case ASTNodeType::ASSIGNMENT_NODE: {
+            Symbol identifier = readSymbol();
+            ASTNode* expression = readNode(Position::EXPRESSION);
+            return failed ? nullptr : new (arena) AssignmentNode(identifier, expression);
+        }
+
+        case ASTNodeType::VARIABLE_ACCESS_NODE: {
+            Symbol identifier = readSymbol();
+            return failed ? nullptr : new (arena) VariableAccessNode(identifier);
+        }
+
+        // An int is spelled like the Optimizer spells the constants it folds
+        case ASTNodeType::NUMBER_NODE: {
+            uint8_t kind = readByte();
+            if (kind == 0) {
+                int value = readSignedVarint();
+                return failed ? nullptr : new (arena) NumberNode(arena.copyString(std::to_string(value)), value);
+            }
+            if (kind == 1) {
+                const char* literal = readLiteral();
+                return failed ? nullptr : new (arena) NumberNode(literal, std::strtof(literal, nullptr));
+            }
+            loadError("Unknown number type");
+            return nullptr;
+        }
+
+        case ASTNodeType::BINARY_OPERATION_NODE:
+        case ASTNodeType::MONO_OPERATION_NODE: {
+            uint8_t op = readByte();
+            if (!failed && op >= (uint8_t)Operator::UNKNOWN) {
+                loadError("Unknown operator " + std::to_string(op));
+            }
+
+            if (type == ASTNodeType::MONO_OPERATION_NODE) {
+                ASTNode* expression = readNode(Position::EXPRESSION);
+                return failed ? nullptr : new (arena) MonoOperationNode((Operator)op, expression);
+            }
+
+            ASTNode* left = readNode(Position::EXPRESSION);
+            ASTNode* right = readNode(Position::EXPRESSION);
+            return failed ? nullptr : new (arena) BinaryOperationNode(left, (Operator)op, right);
+        }
+
+        case ASTNodeType::IF_NODE: {
+            uint32_t expressionCount = readVarint();
+            uint32_t bodyCount = readVarint();
+            if (!failed && (expressionCount == 0 || (bodyCount != expressionCount && bodyCount != expressionCount + 1))) {
+                loadError("Malformed if statement");
+            }
+
+            std::vector<ASTNode*> expressions;
+            for (uint32_t i = 0; i < expressionCount && !failed; i++) {
+                expressions.push_back(readNode(Position::EXPRESSION));
+            }
+            std::vector<BlockNode*> bodies;
+            for (uint32_t i = 0; i < bodyCount && !failed; i++) {
+                bodies.push_back(readBlock());
+            }
+
+            return failed ? nullptr : new (arena) IfNode(ArenaArray<ASTNode*>(arena, expressions), ArenaArray<BlockNode*>(arena, bodies));
+        }
+
+        case ASTNodeType::WHILE_NODE: {
+            ASTNode* expression = readNode(Position::EXPRESSION);
+            BlockNode* body = readBlock();
+            return failed ? nullptr : new (arena) WhileNode(expression, body);
+        }
+
+        case ASTNodeType::FOR_NODE: {
+            ASTNode* initializer = readNode(Position::DECLARATION);
+            ASTNode* condition = readNode(Position::EXPRESSION);
+            ASTNode* increment = readNode(Position::ASSIGNMENT);
+            BlockNode* body = readBlock();
+            return failed ? nullptr : new (arena) ForNode(initializer, condition, increment, body);
+        }
+
+        case ASTNodeType::BREAK_NODE:
+            return new (arena) BreakNode();
+
+        case ASTNodeType::CONTINUE_NODE:
+            return new (arena) ContinueNode();
+
+        // Parameter types are decoded from their names like the Parser does
+        case ASTNodeType::FUNCTION_DECLARATION_NODE: {
+            Symbol returnType = readSymbol();
+            Symbol name = readSymbol();
+            uint32_t count = readVarint();
+
+            std::vector<Symbol> parameters;
+            std::vector<Symbol> parameterTypes;
+            std::vector<ValueType> parameterValueTypes;
+            for (uint32_t i = 0; i < count && !failed; i++) {
+                parameters.push_back(readSymbol());
+                parameterTypes.push_back(readSymbol());
+                parameterValueTypes.push_back(!failed && symbolTable.name(parameterTypes.back()) == "int" ? ValueType::INTEGER : ValueType::FLOAT);
+            }
+
+            BlockNode* body = readBlock();
+            return failed ? nullptr
+                          : new (arena) FunctionDeclarationNode(returnType, name, ArenaArray<Symbol>(arena, parameters), ArenaArray<Symbol>(arena, parameterTypes),
+                                                                ArenaArray<ValueType>(arena, parameterValueTypes), body);
+        }
+
+        case ASTNodeType::FUNCTION_CALL_NODE: {
+            Symbol name = readSymbol();
+            uint32_t count = readVarint();
+
+            std::vector<ASTNode*> arguments;
+            for (uint32_t i = 0; i < count && !failed; i++) {
+                arguments.push_back(readNode(Position::EXPRESSION));
+            }
+
+            return failed ? nullptr : new (arena) FunctionCallNode(name, ArenaArray<ASTNode*>(arena, arguments), findBuiltin(symbolTable.name(name)));
+        }
+
+        case ASTNodeType::RETURN_NODE: {
+            ASTNode* expression = readNode(Position::RETURN_VALUE);
+            if (failed) {
+                return nullptr;
+            }
+            return expression == nullptr ? new (arena) ReturnNode() : new (arena) ReturnNode(expression);
+        }
+
+        case ASTNodeType::EMPTY_EXPRESSION_NODE:
+            return new (arena) EmptyExpressionNode();
+
+        case ASTNodeType::CONVERSION_NODE: {
+            uint8_t conversion = readByte();
+            if (!failed && conversion > (uint8_t)Conversion::FLOAT_TO_TRUTH) {
+                loadError("Unknown conversion " + std::to_string(conversion));
+            }
+
+            ASTNode* expression = readNode(Position::EXPRESSION);
+            return failed ? nullptr : new (arena) ConversionNode((Conversion)conversion, expression);
+        }
+    }
+
+    loadError("Unknown node type");
+    return nullptr;
+}
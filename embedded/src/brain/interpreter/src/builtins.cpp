@@ -0,0 +1,42 @@
+#include "builtins.hpp"
+
+constexpr BuiltinSignature builtinSignatures[] = {
+    {"print", Builtin::PRINT_INT, 1, {ArgumentKind::ANY}, ValueType::INTEGER, false},
+    {"wait", Builtin::WAIT, 1, {ArgumentKind::INTEGER}, ValueType::INTEGER, false},
+    {"rand", Builtin::RAND, 0, {}, ValueType::FLOAT, false},
+    {"float_to_int", Builtin::FLOAT_TO_INT, 1, {ArgumentKind::FLOAT}, ValueType::INTEGER, true},
+    {"int_to_float", Builtin::INT_TO_FLOAT, 1, {ArgumentKind::INTEGER}, ValueType::FLOAT, true},
+    {"runtime", Builtin::RUNTIME, 0, {}, ValueType::INTEGER, false},
+    {"pow", Builtin::POW, 2, {ArgumentKind::NUMBER, ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"pi", Builtin::PI_VALUE, 0, {}, ValueType::FLOAT, true},
+    {"exp", Builtin::EXP, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"sin", Builtin::SIN, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"cos", Builtin::COS, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"tan", Builtin::TAN, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"asin", Builtin::ASIN, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"acos", Builtin::ACOS, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"atan", Builtin::ATAN, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"atan2", Builtin::ATAN2, 2, {ArgumentKind::NUMBER, ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"sqrt", Builtin::SQRT, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"abs", Builtin::ABS, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"floor", Builtin::FLOOR, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"ceil", Builtin::CEIL, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"min", Builtin::MIN, 2, {ArgumentKind::NUMBER, ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"max", Builtin::MAX, 2, {ArgumentKind::NUMBER, ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"log", Builtin::LOG, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"log10", Builtin::LOG10, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"log2", Builtin::LOG2, 1, {ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"round", Builtin::ROUND, 2, {ArgumentKind::NUMBER, ArgumentKind::NUMBER}, ValueType::FLOAT, true},
+    {"send_bool", Builtin::SEND_BOOL, 2, {ArgumentKind::INTEGER, ArgumentKind::TRUTHY}, ValueType::INTEGER, false},
+};
+
+const std::size_t builtinCount = sizeof(builtinSignatures) / sizeof(builtinSignatures[0]);
+
+const BuiltinSignature* findBuiltin(StringView name) {
+    for (std::size_t i = 0; i < builtinCount; i++) {
+        if (name == builtinSignatures[i].name) {
+            return &builtinSignatures[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,695 @@
+#include "compiler.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "builtins.hpp"
+#include "resolver.hpp"
+
+// Return null pointer if there is an error
+// Signified by this macro
+#define ERROR_PROGRAM nullptr
+
+// How many values an opcode leaves on the stack relative to before it ran
+// Calls depend on their argument count and are given explicitly
+static int stackEffectOf(OpCode op) {
+    switch (op) {
+        case OpCode::PUSH_INT:
+        case OpCode::PUSH_FLOAT:
+        case OpCode::LOAD_LOCAL:
+        case OpCode::LOAD_OUTER:
+            return 1;
+        case OpCode::INT_TO_FLOAT:
+        case OpCode::FLOAT_TO_INT:
+        case OpCode::FLOAT_TRUTHY:
+        case OpCode::JUMP:
+        case OpCode::LOOP:
+        case OpCode::HALT:
+            return 0;
+        default:
+            // Binary operations, stores, pops, conditional jumps and returns all consume one value
+            return -1;
+    }
+}
+
+Compiler::Compiler(OutputStream& outputStream, ErrorHandler& errorHandler)
+    : outputStream(outputStream), errorHandler(errorHandler), program(nullptr), hadError(false), currentLocation{0, 0} {}
+
+Compiler::~Compiler() {}
+
+void Compiler::compileError(const std::string& message) {
+    // Only report the first error, the rest are usually fallout from it
+    if (!hadError) {
+        errorHandler.handleError("Compile Error: " + message, currentLocation);
+    }
+    hadError = true;
+}
+
+Program* Compiler::compile(BlockNode& ast) {
+    // Checks the program and leaves slots, types, conversions and call targets on the AST
+    Resolver resolver(outputStream, errorHandler);
+    if (!resolver.resolve(ast)) {
+        return ERROR_PROGRAM;
+    }
+
+    program = new Program();
+    program->maxLevel = 0;
+    hadError = false;
+    frames.clear();
+    functions.clear();
+    declarations.clear();
+    functionIndices.clear();
+    functionCode.clear();
+    functionLocations.clear();
+    currentLocation = {0, 0};
+
+    // Function 0 is the top level program
+    program->functions.push_back({"main", 0, 0, -1, 0, 0, 0});
+    declarations.push_back(nullptr);
+    functionCode.emplace_back();
+    functionLocations.emplace_back();
+
+    beginFunction(0, 0, ValueType::INTEGER);
+    compileBlock(&ast);
+    emit(OpCode::HALT);
+    endFunction();
+
+    if (hadError) {
+        delete program;
+        program = nullptr;
+        return ERROR_PROGRAM;
+    }
+
+    link();
+
+    Program* result = program;
+    program = nullptr;
+    return result;
+}
+
+//================================================================================================
+// Emitting
+//================================================================================================
+
+size_t Compiler::emit(OpCode op, int32_t operand) {
+    return emit(op, operand, stackEffectOf(op));
+}
+
+size_t Compiler::emit(OpCode op, int32_t operand, int stackEffect) {
+    FunctionState& function = functions.back();
+
+    // A new span only starts where the location changes, Ex. at the next statement
+    if (function.locations.empty() || function.locations.back().location.line != currentLocation.line ||
+        function.locations.back().location.column != currentLocation.column) {
+        function.locations.push_back({function.code.size(), currentLocation});
+    }
+
+    function.code.push_back({op, operand});
+
+    function.stackDepth += stackEffect;
+    if (function.stackDepth > function.maxStackDepth) {
+        function.maxStackDepth = function.stackDepth;
+    }
+
+    return function.code.size() - 1;
+}
+
+size_t Compiler::emitJump(OpCode op) {
+    // The target is filled in by patchJump once it is known
+    return emit(op, -1);
+}
+
+void Compiler::patchJump(size_t jump) {
+    functions.back().code[jump].operand = (int32_t)currentOffset();
+}
+
+void Compiler::emitLoop(size_t target) {
+    emit(OpCode::LOOP, (int32_t)target);
+}
+
+size_t Compiler::currentOffset() const {
+    return functions.back().code.size();
+}
+
+void Compiler::emitVariable(OpCode localOp, OpCode outerOp, const VariableLocation& location) {
+    // The Resolver counts blocks out, each of which is laid out in the frame of the function owning it
+    const Frame& frame = frames[frames.size() - 1 - location.depth];
+    int slot = frame.firstSlot + location.slot;
+
+    if (frame.level == functions.back().level) {
+        emit(localOp, slot);
+    } else {
+        emit(outerOp, (frame.level << 16) | slot);
+    }
+}
+
+void Compiler::link() {
+    // Lay the functions out one after the other and turn jump targets into absolute indices
+    for (size_t i = 0; i < functionCode.size(); i++) {
+        size_t entry = program->code.size();
+        program->functions[i].entry = entry;
+
+        for (Instruction instruction : functionCode[i]) {
+            if (instruction.op == OpCode::JUMP || instruction.op == OpCode::JUMP_IF_FALSE || instruction.op == OpCode::LOOP) {
+                instruction.operand += (int32_t)entry;
+            }
+            program->code.push_back(instruction);
+        }
+
+        for (SourceSpan span : functionLocations[i]) {
+            span.firstInstruction += entry;
+            program->locations.push_back(span);
+        }
+    }
+
+    functionCode.clear();
+    functionLocations.clear();
+}
+
+
+//================================================================================================
+// Frames
+//================================================================================================
+
+void Compiler::pushFrame(int frameSize) {
+    // A block's frame goes after those of the blocks enclosing it in the same function
+    FunctionState& function = functions.back();
+
+    Frame frame;
+    frame.level = function.level;
+    frame.firstSlot = function.nextSlot;
+    frames.push_back(frame);
+
+    function.nextSlot += frameSize;
+    if (function.nextSlot > function.numSlots) {
+        function.numSlots = function.nextSlot;
+    }
+}
+
+void Compiler::popFrame() {
+    // Compile the bodies of the functions declared in this block while its frame is still laid out
+    std::vector<int> pending = frames.back().pendingFunctions;
+    frames.back().pendingFunctions.clear();
+
+    // The bodies move the location along, the code after them belongs where this block ends
+    SourceLocation location = currentLocation;
+
+    for (int index : pending) {
+        if (hadError) {
+            break;
+        }
+        compileFunctionBody(index);
+    }
+
+    currentLocation = location;
+
+    functions.back().nextSlot = frames.back().firstSlot;
+    frames.pop_back();
+}
+
+//================================================================================================
+// Functions
+//================================================================================================
+
+void Compiler::beginFunction(int index, int level, ValueType returnType) {
+    FunctionState function;
+    function.index = index;
+    function.level = level;
+    function.returnType = returnType;
+    function.nextSlot = 0;
+    function.numSlots = 0;
+    function.stackDepth = 0;
+    function.maxStackDepth = 0;
+    functions.push_back(function);
+
+    if (level > program->maxLevel) {
+        program->maxLevel = level;
+    }
+}
+
+void Compiler::endFunction() {
+    FunctionState& function = functions.back();
+    FunctionInfo& info = program->functions[function.index];
+
+    info.numSlots = function.numSlots;
+    info.maxStackDepth = function.maxStackDepth;
+    functionCode[function.index] = std::move(function.code);
+    functionLocations[function.index] = std::move(function.locations);
+
+    functions.pop_back();
+}
+
+void Compiler::compileFunctionBody(int index) {
+    FunctionDeclarationNode* declaration = declarations[index];
+    currentLocation = declaration->getSourceLocation();
+
+    // void functions hand back 0 like the tree-walking interpreter
+    ValueType returnType = declaration->getType() == "float" ? ValueType::FLOAT : ValueType::INTEGER;
+
+    beginFunction(index, program->functions[index].level, returnType);
+
+    // The Resolver gave the parameters the first slots of the body's frame, which is where the call leaves the arguments
+    compileBlock(declaration->getBody());
+
+    // Falling off the end of the body returns 0
+    emit(returnType == ValueType::FLOAT ? OpCode::PUSH_FLOAT : OpCode::PUSH_INT, 0);
+    emit(OpCode::RETURN);
+
+    endFunction();
+}
+
+//================================================================================================
+// Statements
+//================================================================================================
+
+void Compiler::compileBlock(BlockNode* block) {
+    pushFrame(block->getFrameSize());
+
+    for (ASTNode* statement : block->getStatements()) {
+        compileStatement(statement);
+
+        if (hadError) {
+            break;
+        }
+    }
+
+    popFrame();
+}
+
+void Compiler::compileStatement(ASTNode* statement) {
+    currentLocation = statement->getSourceLocation();
+
+    switch (statement->getNodeType()) {
+        case ASTNodeType::VARIABLE_DECLARATION_NODE:
+            compileVariableDeclaration((VariableDeclarationNode*)statement);
+            break;
+
+        case ASTNodeType::ASSIGNMENT_NODE:
+            compileAssignment((AssignmentNode*)statement);
+            break;
+
+        case ASTNodeType::FUNCTION_DECLARATION_NODE:
+            compileFunctionDeclaration((FunctionDeclarationNode*)statement);
+            break;
+
+        case ASTNodeType::IF_NODE:
+            compileIf((IfNode*)statement);
+            break;
+
+        case ASTNodeType::WHILE_NODE:
+            compileWhile((WhileNode*)statement);
+            break;
+
+        case ASTNodeType::FOR_NODE:
+            compileFor((ForNode*)statement);
+            break;
+
+        case ASTNodeType::BREAK_NODE:
+            compileBreakOrContinue(true);
+            break;
+
+        case ASTNodeType::CONTINUE_NODE:
+            compileBreakOrContinue(false);
+            break;
+
+        case ASTNodeType::RETURN_NODE:
+            compileReturn((ReturnNode*)statement);
+            break;
+
+        case ASTNodeType::FUNCTION_CALL_NODE:
+            // The result of a call used as a statement is thrown away
+            compileFunctionCall((FunctionCallNode*)statement);
+            emit(OpCode::POP);
+            break;
+
+        default:
+            compileError("Unknown statement type");
+    }
+}
+
+void Compiler::compileVariableDeclaration(VariableDeclarationNode* variableDeclaration) {
+    // The Resolver converted the initializer to the variable's type
+    compileExpression(variableDeclaration->getInitializer());
+
+    // Back from the initializer
+    currentLocation = variableDeclaration->getSourceLocation();
+
+    emitVariable(OpCode::STORE_LOCAL, OpCode::STORE_OUTER, variableDeclaration->getLocation());
+}
+
+void Compiler::compileAssignment(AssignmentNode* assignment) {
+    // The Resolver converted the value to the variable's type
+    compileExpression(assignment->getExpression());
+
+    // Back from the expression
+    currentLocation = assignment->getSourceLocation();
+
+    emitVariable(OpCode::STORE_LOCAL, OpCode::STORE_OUTER, assignment->getLocation());
+}
+
+void Compiler::compileFunctionDeclaration(FunctionDeclarationNode* functionDeclaration) {
+    int index = (int)program->functions.size();
+    int level = functions.back().level + 1;
+    int numParameters = (int)functionDeclaration->getParameters().size();
+
+    program->functions.push_back({functionDeclaration->getName(), 0, level, functions.back().index, numParameters, 0, 0});
+    declarations.push_back(functionDeclaration);
+    functionIndices[functionDeclaration] = index;
+    functionCode.emplace_back();
+    functionLocations.emplace_back();
+
+    // The body waits for the block to close, like the Resolver resolved it
+    frames.back().pendingFunctions.push_back(index);
+}
+
+void Compiler::compileIf(IfNode* ifStatement) {
+    const ArenaArray<ASTNode*>& expressions = ifStatement->getExpressions();
+    const ArenaArray<BlockNode*>& bodies = ifStatement->getBodies();
+
+    // Every taken branch jumps past the rest of the chain
+    std::vector<size_t> endJumps;
+
+    for (size_t i = 0; i < expressions.size(); i++) {
+        // The Resolver made the condition an int
+        compileExpression(expressions[i]);
+
+        if (hadError) {
+            return;
+        }
+
+        size_t skipBody = emitJump(OpCode::JUMP_IF_FALSE);
+
+        compileBlock(bodies[i]);
+
+        // The last branch without an else can simply fall through
+        if (i + 1 < bodies.size()) {
+            endJumps.push_back(emitJump(OpCode::JUMP));
+        }
+
+        patchJump(skipBody);
+    }
+
+    // Else body
+    if (bodies.size() > expressions.size()) {
+        compileBlock(bodies.back());
+    }
+
+    for (size_t jump : endJumps) {
+        patchJump(jump);
+    }
+}
+
+void Compiler::compileWhile(WhileNode* whileStatement) {
+    size_t loopStart = currentOffset();
+
+    compileExpression(whileStatement->getExpression());
+
+    if (hadError) {
+        return;
+    }
+
+    size_t exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+
+    functions.back().loops.emplace_back();
+    compileBlock(whileStatement->getBody());
+    Loop loop = functions.back().loops.back();
+    functions.back().loops.pop_back();
+
+    // continue goes straight back to the condition
+    for (size_t jump : loop.continueJumps) {
+        functions.back().code[jump] = {OpCode::LOOP, (int32_t)loopStart};
+    }
+
+    emitLoop(loopStart);
+
+    patchJump(exitJump);
+    for (size_t jump : loop.breakJumps) {
+        patchJump(jump);
+    }
+}
+
+void Compiler::compileFor(ForNode* forStatement) {
+    // The Resolver stored the loop variable in the enclosing block's frame and checked the loop's shape
+    compileVariableDeclaration((VariableDeclarationNode*)forStatement->getInitializer());
+
+    size_t loopStart = currentOffset();
+
+    compileExpression(forStatement->getCondition());
+
+    if (hadError) {
+        return;
+    }
+
+    size_t exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+
+    functions.back().loops.emplace_back();
+    compileBlock(forStatement->getBody());
+    Loop loop = functions.back().loops.back();
+    functions.back().loops.pop_back();
+
+    // continue still runs the increment
+    for (size_t jump : loop.continueJumps) {
+        patchJump(jump);
+    }
+
+    compileAssignment((AssignmentNode*)forStatement->getIncrement());
+    emitLoop(loopStart);
+
+    patchJump(exitJump);
+    for (size_t jump : loop.breakJumps) {
+        patchJump(jump);
+    }
+}
+
+void Compiler::compileReturn(ReturnNode* returnStatement) {
+    FunctionState& function = functions.back();
+
+    // A return in the top level program ends it, after evaluating the value for its side effects
+    if (function.index == 0) {
+        if (returnStatement->getExpression() != nullptr) {
+            compileExpression(returnStatement->getExpression());
+            emit(OpCode::POP);
+        }
+        emit(OpCode::HALT);
+        return;
+    }
+
+    // The Resolver converted the value to the function's return type
+    if (returnStatement->getExpression() != nullptr) {
+        compileExpression(returnStatement->getExpression());
+    } else {
+        emit(function.returnType == ValueType::FLOAT ? OpCode::PUSH_FLOAT : OpCode::PUSH_INT, 0);
+    }
+
+    emit(OpCode::RETURN);
+}
+
+void Compiler::compileBreakOrContinue(bool isBreak) {
+    FunctionState& function = functions.back();
+
+    // Outside of a loop, break and continue unwind like a bare return
+    if (function.loops.empty()) {
+        if (function.index == 0) {
+            emit(OpCode::HALT);
+        } else {
+            emit(function.returnType == ValueType::FLOAT ? OpCode::PUSH_FLOAT : OpCode::PUSH_INT, 0);
+            emit(OpCode::RETURN);
+        }
+        return;
+    }
+
+    size_t jump = emitJump(OpCode::JUMP);
+
+    if (isBreak) {
+        function.loops.back().breakJumps.push_back(jump);
+    } else {
+        function.loops.back().continueJumps.push_back(jump);
+    }
+}
+
+//================================================================================================
+// Expressions
+//================================================================================================
+
+void Compiler::compileExpression(ASTNode* expression) {
+    if (hadError) {
+        return;
+    }
+
+    switch (expression->getNodeType()) {
+        case ASTNodeType::VARIABLE_ACCESS_NODE: {
+            VariableAccessNode* variableAccess = (VariableAccessNode*)expression;
+            currentLocation = variableAccess->getSourceLocation();
+            emitVariable(OpCode::LOAD_LOCAL, OpCode::LOAD_OUTER, variableAccess->getLocation());
+            break;
+        }
+
+        case ASTNodeType::BINARY_OPERATION_NODE:
+            compileBinaryOperation((BinaryOperationNode*)expression);
+            break;
+
+        case ASTNodeType::NUMBER_NODE:
+            compileNumber((NumberNode*)expression);
+            break;
+
+        case ASTNodeType::FUNCTION_CALL_NODE:
+            compileFunctionCall((FunctionCallNode*)expression);
+            break;
+
+        case ASTNodeType::CONVERSION_NODE:
+            compileConversion((ConversionNode*)expression);
+            break;
+
+        default:
+            compileError("Unknown expression type");
+    }
+}
+
+void Compiler::compileNumber(NumberNode* number) {
+    if (number->getType() == TokenType::INTEGER) {
+        emit(OpCode::PUSH_INT, number->getIntValue());
+        return;
+    }
+
+    // Floats travel in the operand bit for bit
+    float floatValue = number->getFloatValue();
+    int32_t bits;
+    std::memcpy(&bits, &floatValue, sizeof(bits));
+    emit(OpCode::PUSH_FLOAT, bits);
+}
+
+void Compiler::compileConversion(ConversionNode* conversion) {
+    compileExpression(conversion->getExpression());
+
+    switch (conversion->getConversion()) {
+        case Conversion::INT_TO_FLOAT:
+            emit(OpCode::INT_TO_FLOAT);
+            break;
+        case Conversion::FLOAT_TO_INT:
+            emit(OpCode::FLOAT_TO_INT);
+            break;
+        case Conversion::FLOAT_TO_TRUTH:
+            // Conditions are tested as ints, floats need to be compared against 0 rather than truncated
+            emit(OpCode::FLOAT_TRUTHY);
+            break;
+    }
+}
+
+void Compiler::compileBinaryOperation(BinaryOperationNode* binaryExpression) {
+    Operator op = binaryExpression->getOperator();
+
+    // The Resolver reduced the operands of logical operators to ints and promoted mixed operands to float
+    compileExpression(binaryExpression->getLeftExpression());
+    compileExpression(binaryExpression->getRightExpression());
+
+    if (hadError) {
+        return;
+    }
+
+    // Where a division by zero is reported
+    currentLocation = binaryExpression->getSourceLocation();
+
+    bool isFloat = binaryExpression->getLeftExpression()->getValueType() == ValueType::FLOAT;
+    OpCode opCode;
+
+    switch (op) {
+        case Operator::AND:
+            opCode = OpCode::AND;
+            break;
+        case Operator::OR:
+            opCode = OpCode::OR;
+            break;
+        case Operator::ADD:
+            opCode = isFloat ? OpCode::ADD_FLOAT : OpCode::ADD_INT;
+            break;
+        case Operator::SUBTRACT:
+            opCode = isFloat ? OpCode::SUB_FLOAT : OpCode::SUB_INT;
+            break;
+        case Operator::MULTIPLY:
+            opCode = isFloat ? OpCode::MUL_FLOAT : OpCode::MUL_INT;
+            break;
+        case Operator::DIVIDE:
+            opCode = isFloat ? OpCode::DIV_FLOAT : OpCode::DIV_INT;
+            break;
+        case Operator::MODULO:
+            opCode = isFloat ? OpCode::MOD_FLOAT : OpCode::MOD_INT;
+            break;
+        case Operator::GREATER:
+            opCode = isFloat ? OpCode::GREATER_FLOAT : OpCode::GREATER_INT;
+            break;
+        case Operator::LESS:
+            opCode = isFloat ? OpCode::LESS_FLOAT : OpCode::LESS_INT;
+            break;
+        case Operator::GREATER_EQUAL:
+            opCode = isFloat ? OpCode::GREATER_EQUAL_FLOAT : OpCode::GREATER_EQUAL_INT;
+            break;
+        case Operator::LESS_EQUAL:
+            opCode = isFloat ? OpCode::LESS_EQUAL_FLOAT : OpCode::LESS_EQUAL_INT;
+            break;
+        case Operator::EQUAL:
+            opCode = isFloat ? OpCode::EQUAL_FLOAT : OpCode::EQUAL_INT;
+            break;
+        case Operator::NOT_EQUAL:
+            opCode = isFloat ? OpCode::NOT_EQUAL_FLOAT : OpCode::NOT_EQUAL_INT;
+            break;
+        default:
+            compileError("Unknown operator " + operatorToString(op));
+            return;
+    }
+
+    emit(opCode);
+}
+
+void Compiler::compileFunctionCall(FunctionCallNode* functionCall) {
+    currentLocation = functionCall->getSourceLocation();
+
+    if (functionCall->getBuiltin() != nullptr) {
+        compileBuiltinCall(functionCall);
+        return;
+    }
+
+    // The Resolver tied the call to its declaration and checked the arguments against its parameters
+    FunctionDeclarationNode* target = functionCall->getTarget();
+    const ArenaArray<ASTNode*>& arguments = functionCall->getArguments();
+    size_t argumentCount = target->getParameters().size();
+
+    // Arguments are left on the stack in order and become the first slots of the callee's frame
+    for (size_t i = 0; i < argumentCount; i++) {
+        compileExpression(arguments[i]);
+    }
+
+    // Back from the arguments, a stack overflow is reported at the call
+    currentLocation = functionCall->getSourceLocation();
+    emit(OpCode::CALL, functionIndices[target], 1 - (int)argumentCount);
+}
+
+void Compiler::compileBuiltinCall(FunctionCallNode* functionCall) {
+    const BuiltinSignature* signature = functionCall->getBuiltin();
+    const ArenaArray<ASTNode*>& arguments = functionCall->getArguments();
+
+    // The Resolver checked the arguments against the signature and converted them
+    // Calls without arguments are parsed as a single empty expression, which is not compiled
+    size_t argumentCount = (size_t)signature->numArguments;
+
+    for (size_t i = 0; i < argumentCount; i++) {
+        compileExpression(arguments[i]);
+    }
+
+    currentLocation = functionCall->getSourceLocation();
+
+    Builtin id = signature->id;
+
+    // print picks its formatting from the static type
+    if (id == Builtin::PRINT_INT && arguments[0]->getValueType() == ValueType::FLOAT) {
+        id = Builtin::PRINT_FLOAT;
+    }
+
+    // The conversions are single instructions
+    if (id == Builtin::FLOAT_TO_INT) {
+        emit(OpCode::FLOAT_TO_INT);
+    } else if (id == Builtin::INT_TO_FLOAT) {
+        emit(OpCode::INT_TO_FLOAT);
+    } else {
+        emit(OpCode::CALL_BUILTIN, (int32_t)id, 1 - (int)argumentCount);
+    }
+}
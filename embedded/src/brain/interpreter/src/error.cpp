@@ -1,38 +1,34 @@
-#include <mutex>
-
 #include "error.hpp"
 #include "flags.h"
 
-// Initialize stopExecution flag to false
-// Only set back to true when reuploading code TODO
-bool stopExecution = false;
-std::mutex stopExecutionMutex;
-
-
-ErrorHandler::ErrorHandler(OutputStream& outputStream) : outputStream(outputStream) {}
+ErrorHandler::ErrorHandler(OutputStream& outputStream) : outputStream(outputStream), stopExecution(false) {}
 
 ErrorHandler::~ErrorHandler() {}
 
 void ErrorHandler::handleError(const std::string& errorMessage) {
     // Raise stopExecution flag
-    std::lock_guard<std::mutex> lock(stopExecutionMutex);
-    stopExecution = true;
+    triggerStopExecution();
     // Print error message
     printf("Error: %s\n", errorMessage.c_str());
     outputStream.write(ERROR_FLAG + errorMessage + "\n" + ERROR_FLAG);
 }
 
-bool ErrorHandler::shouldStopExecution() {
-    std::lock_guard<std::mutex> lock(stopExecutionMutex);
-    return stopExecution;
+void ErrorHandler::handleError(const std::string& errorMessage, SourceLocation location) {
+    handleError(errorMessage + locationToString(location));
+}
+
+std::string locationToString(SourceLocation location) {
+    if (location.line == 0) {
+        return "";
+    }
+
+    return " at line " + std::to_string(location.line) + ", column " + std::to_string(location.column);
 }
 
 void ErrorHandler::triggerStopExecution() {
-    std::lock_guard<std::mutex> lock(stopExecutionMutex);
-    stopExecution = true;
+    stopExecution.store(true, std::memory_order_release);
 }
 
 void ErrorHandler::resetStopExecution() {
-    std::lock_guard<std::mutex> lock(stopExecutionMutex);
-    stopExecution = false;
+    stopExecution.store(false, std::memory_order_release);
 }
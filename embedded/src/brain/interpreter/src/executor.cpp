@@ -0,0 +1,81 @@
+#include "executor.hpp"
+
+#include <chrono>
+
+#include "outputStream.hpp"
+
+#if __EMBEDDED__
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+Executor::Executor()
+    : yieldPolicy(DEFAULT_YIELD_POLICY), yieldSlice(DEFAULT_YIELD_SLICE), budget(1), sliceStart(0), yieldCount(0) {
+#if __EMBEDDED__
+    // A single tick is enough for the idle task to feed the watchdog and for BLE to be serviced
+    yieldHook = []() { vTaskDelay(1); };
+#endif
+    resetBudget();
+}
+
+void Executor::setYieldSlice(YieldPolicy policy, uint32_t slice) {
+    yieldPolicy = policy;
+    yieldSlice = slice > 0 ? slice : 1;
+    resetBudget();
+}
+
+YieldPolicy Executor::getYieldPolicy() const {
+    return yieldPolicy;
+}
+
+uint32_t Executor::getYieldSlice() const {
+    return yieldSlice;
+}
+
+void Executor::setYieldHook(const std::function<void()>& hook) {
+    yieldHook = hook;
+}
+
+uint32_t Executor::getYieldCount() const {
+    return yieldCount;
+}
+
+void Executor::resetBudget() {
+    if (yieldPolicy == YieldPolicy::INSTRUCTIONS) {
+        budget = yieldSlice;
+    } else {
+        budget = YIELD_CLOCK_INTERVAL;
+        sliceStart = nowMicroseconds();
+    }
+}
+
+void Executor::budgetExpired() {
+    if (yieldPolicy == YieldPolicy::INSTRUCTIONS) {
+        yield();
+        budget = yieldSlice;
+        return;
+    }
+
+    // Time has to be checked, but the slice may not be over yet
+    budget = YIELD_CLOCK_INTERVAL;
+    if (nowMicroseconds() - sliceStart >= yieldSlice) {
+        yield();
+        sliceStart = nowMicroseconds();
+    }
+}
+
+void Executor::yield() {
+    yieldCount++;
+    if (yieldHook) {
+        yieldHook();
+    }
+}
+
+int64_t Executor::nowMicroseconds() {
+#if __EMBEDDED__
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
@@ -2,196 +2,126 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <thread>
 
+#include "allocationCounter.hpp"
+#include "builtins.hpp"
 #include "error.hpp"
 #include "flags.h"
 #include "tokenizer.hpp"
+#include "trace.hpp"
 
 #if __EMBEDDED__
 #include "freertos/FreeRTOS.h"
 #endif
 
-// Return null pointer if there is an error
-// Signified by this macro
-#define ERROR_EXIT nullptr
+// Returned when there is an error
+// The error has already been reported and the stop flag raised, callers only need to unwind
+#define ERROR_EXIT Exiting::of(ExitingType::ERROR)
+#define ERROR_VALUE Returnable::none()
 
-#define BIND_FUNCTION(func) std::bind(&Interpreter::func, this, std::placeholders::_1, std::placeholders::_2)
-
-// Yield to other tasks in FreeRTOS
-#if __EMBEDDED__
-#define YIELD vTaskDelay(15 / portTICK_PERIOD_MS)
-#else
-#define YIELD
-#endif
-
-StackFrame::StackFrame(StackFrame *parent, OutputStream &outputStream, ErrorHandler &errorHandler)
-    : parent(parent), outputStream(outputStream), errorHandler(errorHandler) {}
+StackFrame::StackFrame(StackFrame *parent, Slot *slots) : parent(parent), slots(slots) {}
 
 StackFrame::~StackFrame() {
-    // Functions should not be deleted here because they are stored in the AST
-}
-
-void StackFrame::allocateFloatVariable(std::string &name, float value) {
-    if (isAllocated(name)) {
-        errorHandler.handleError("Runtime Error: Identifier " + name + " already exists in this scope");
-    } else {
-        float_variables[name] = value;
-    }
-}
-
-void StackFrame::allocateIntVariable(std::string &name, int value) {
-    if (isAllocated(name)) {
-        errorHandler.handleError("Runtime Error: Identifier " + name + " already exists in this scope");
-    } else {
-        int_variables[name] = value;
-    }
-}
-
-void StackFrame::allocateFunction(std::string &name, FunctionDeclarationNode *function) {
-    if (isAllocated(name)) {
-        errorHandler.handleError("Runtime Error: Identifier " + name + " already exists in this scope");
-    } else {
-        functions[name] = function;
+    // The slots belong to the Interpreter
+}
+
+StackFrame *StackFrame::getAncestor(int depth) {
+    StackFrame *frame = this;
+    while (depth-- > 0) {
+        frame = frame->parent;
+    }
+    return frame;
+}
+
+Slot &StackFrame::getSlot(int slot) {
+    return slots[slot];
+}
+
+// In the order of the Builtin enum
+const Interpreter::BuiltinFunction Interpreter::builtinFunctions[] = {
+    &Interpreter::_print,         // PRINT_INT
+    &Interpreter::_print,         // PRINT_FLOAT, only the VM tells the two apart
+    &Interpreter::_wait,          // WAIT
+    &Interpreter::_rand,          // RAND
+    &Interpreter::_float_to_int,  // FLOAT_TO_INT
+    &Interpreter::_int_to_float,  // INT_TO_FLOAT
+    &Interpreter::_runtime,       // RUNTIME
+    &Interpreter::_pow,           // POW
+    &Interpreter::_pi,            // PI_VALUE
+    &Interpreter::_exp,           // EXP
+    &Interpreter::_sin,           // SIN
+    &Interpreter::_cos,           // COS
+    &Interpreter::_tan,           // TAN
+    &Interpreter::_asin,          // ASIN
+    &Interpreter::_acos,          // ACOS
+    &Interpreter::_atan,          // ATAN
+    &Interpreter::_atan2,         // ATAN2
+    &Interpreter::_sqrt,          // SQRT
+    &Interpreter::_abs,           // ABS
+    &Interpreter::_floor,         // FLOOR
+    &Interpreter::_ceil,          // CEIL
+    &Interpreter::_min,           // MIN
+    &Interpreter::_max,           // MAX
+    &Interpreter::_log,           // LOG
+    &Interpreter::_log10,         // LOG10
+    &Interpreter::_log2,          // LOG2
+    &Interpreter::_round,         // ROUND
+    &Interpreter::_sendBool,      // SEND_BOOL
+};
+
+Interpreter::Interpreter(BlockNode &ast, OutputStream &outputStream, ErrorHandler &errorHandler) : ast(ast), outputStream(outputStream), errorHandler(errorHandler), radioFormatter(nullptr), profiler(nullptr), slotsUsed(0), currentLocation{0, 0} {
+    resolve();
+}
+
+Interpreter::Interpreter(BlockNode &ast, OutputStream &outputStream, ErrorHandler &errorHandler, RadioFormatter &radioFormatter) : ast(ast), outputStream(outputStream), errorHandler(errorHandler), radioFormatter(&radioFormatter), profiler(nullptr), slotsUsed(0), currentLocation{0, 0} {
+    resolve();
+}
+
+void Interpreter::resolve() {
+    if (errorHandler.shouldStopExecution()) {
+        return;
     }
-}
 
-void StackFrame::setFloatVariable(std::string &name, float value) {
-    // Check if the variable exists in the float map
-    if (float_variables.find(name) != float_variables.end()) {
-        float_variables[name] = value;
-    } else if (parent != nullptr) {
-        parent->setFloatVariable(name, value);
-    } else {
-        errorHandler.handleError("Runtime Error: Variable " + name + " does not exist in this scope");
-    }
-}
+    ALLOCATION_PHASE(AllocationPhase::COMPILE);
 
-void StackFrame::setIntVariable(std::string &name, int value) {
-    // Check if the variable exists in the int map
-    if (int_variables.find(name) != int_variables.end()) {
-        int_variables[name] = value;
-    } else if (parent != nullptr) {
-        parent->setIntVariable(name, value);
-    } else {
-        errorHandler.handleError("Runtime Error: Variable " + name + " does not exist in this scope");
-    }
-}
+    Resolver resolver(outputStream, errorHandler);
+    resolver.resolve(ast);
 
-float StackFrame::getFloatVariable(std::string &name) {
-    // Check if the variable exists in the float map
-    if (float_variables.find(name) != float_variables.end()) {
-        return float_variables[name];
-    } else if (parent != nullptr) {
-        return parent->getFloatVariable(name);
-    } else {
-        errorHandler.handleError("Runtime Error: Variable " + name + " does not exist in this scope");
-        return 0.0;
-    }
+    slots.resize(INTERPRETER_STACK_SIZE);
 }
 
-int StackFrame::getIntVariable(std::string &name) {
-    // Check if the variable exists in the int map
-    if (int_variables.find(name) != int_variables.end()) {
-        return int_variables[name];
-    } else if (parent != nullptr) {
-        return parent->getIntVariable(name);
-    } else {
-        errorHandler.handleError("Runtime Error: Variable " + name + " does not exist in this scope");
-        return 0;
-    }
-}
-
-FunctionDeclarationNode *StackFrame::getFunction(std::string &name) {
-    // Check if the variable exists in the function map
-    if (functions.find(name) != functions.end()) {
-        return functions[name];
-    } else if (parent != nullptr) {
-        return parent->getFunction(name);
-    } else {
-        errorHandler.handleError("Runtime Error: Function " + name + " does not exist in this scope");
+Slot *Interpreter::pushSlots(int count) {
+    if (slotsUsed + count > slots.size()) {
+        runtimeError("Stack overflow");
         return nullptr;
     }
-}
 
-ValueType StackFrame::getType(std::string &name) {
-    // Check if the variable exists in the float map
-    if (float_variables.find(name) != float_variables.end()) {
-        return ValueType::FLOAT;
-    } else if (int_variables.find(name) != int_variables.end()) {
-        return ValueType::INTEGER;
-    } else if (functions.find(name) != functions.end()) {
-        return ValueType::FUNCTION;
-    } else if (parent != nullptr) {
-        return parent->getType(name);
-    } else {
-        errorHandler.handleError("Runtime Error: Variable " + name + " does not exist in this scope");
-        return ValueType::INTEGER;  // Bogus value does not matter because the error handler will stop execution
-    }
-}
+    Slot *frameSlots = slots.data() + slotsUsed;
+    slotsUsed += count;
 
-bool StackFrame::isAllocated(std::string &name) {
-    if (float_variables.find(name) != float_variables.end()) {
-        return true;
-    } else if (int_variables.find(name) != int_variables.end()) {
-        return true;
-    } else if (functions.find(name) != functions.end()) {
-        return true;
-    } else if (parent != nullptr) {
-        return parent->isAllocated(name);
-    } else {
-        return false;
-    }
-}
+    // Variables read before their declaration has run (Ex. from a function declared earlier) read as 0
+    std::fill(frameSlots, frameSlots + count, Slot{0});
 
-std::map<std::string, FunctionDeclarationNode *> &StackFrame::getFunctions() {
-    return functions;
+    return frameSlots;
 }
 
-void Interpreter::initBuiltInFunctions() {
-    // Fill out the function map
-    functionMap["print"] = BIND_FUNCTION(_print);
-    functionMap["wait"] = BIND_FUNCTION(_wait);
-    functionMap["rand"] = BIND_FUNCTION(_rand);
-    functionMap["float_to_int"] = BIND_FUNCTION(_float_to_int);
-    functionMap["int_to_float"] = BIND_FUNCTION(_int_to_float);
-    functionMap["runtime"] = BIND_FUNCTION(_runtime);
-    functionMap["pow"] = BIND_FUNCTION(_pow);
-    functionMap["pi"] = BIND_FUNCTION(_pi);
-    functionMap["exp"] = BIND_FUNCTION(_exp);
-    functionMap["sin"] = BIND_FUNCTION(_sin);
-    functionMap["cos"] = BIND_FUNCTION(_cos);
-    functionMap["tan"] = BIND_FUNCTION(_tan);
-    functionMap["asin"] = BIND_FUNCTION(_asin);
-    functionMap["acos"] = BIND_FUNCTION(_acos);
-    functionMap["atan"] = BIND_FUNCTION(_atan);
-    functionMap["atan2"] = BIND_FUNCTION(_atan2);
-    functionMap["sqrt"] = BIND_FUNCTION(_sqrt);
-    functionMap["abs"] = BIND_FUNCTION(_abs);
-    functionMap["floor"] = BIND_FUNCTION(_floor);
-    functionMap["ceil"] = BIND_FUNCTION(_ceil);
-    functionMap["min"] = BIND_FUNCTION(_min);
-    functionMap["max"] = BIND_FUNCTION(_max);
-    functionMap["log"] = BIND_FUNCTION(_log);
-    functionMap["log10"] = BIND_FUNCTION(_log10);
-    functionMap["log2"] = BIND_FUNCTION(_log2);
-    functionMap["round"] = BIND_FUNCTION(_round);
-    functionMap["send_bool"] = BIND_FUNCTION(_sendBool);
+void Interpreter::popSlots(int count) {
+    slotsUsed -= count;
 }
 
-Interpreter::Interpreter(BlockNode &ast, OutputStream &outputStream, ErrorHandler &errorHandler) : ast(ast), outputStream(outputStream), errorHandler(errorHandler), radioFormatter(nullptr) {
-    initBuiltInFunctions();
+Interpreter::~Interpreter() {
 }
 
-Interpreter::Interpreter(BlockNode &ast, OutputStream &outputStream, ErrorHandler &errorHandler, RadioFormatter &radioFormatter) : ast(ast), outputStream(outputStream), errorHandler(errorHandler), radioFormatter(&radioFormatter) {
-    initBuiltInFunctions();
-}
+void Interpreter::setProfiler(Profiler *profiler) { this->profiler = profiler; }
 
-Interpreter::~Interpreter() {
+void Interpreter::runtimeError(const std::string &message) const {
+    errorHandler.handleError("Runtime Error: " + message, currentLocation);
 }
 
-void Interpreter::runtimeError(const std::string &message) const {
-    errorHandler.handleError("Runtime Error: " + message);
+void Interpreter::runtimeError(const ASTNode *node, const std::string &message) const {
+    errorHandler.handleError("Runtime Error: " + message, node->getSourceLocation());
 }
 
 void Interpreter::interpret() {
@@ -199,40 +129,45 @@ void Interpreter::interpret() {
         return;
     }
 
-    // Create a stack frame for the global scope
-    StackFrame *globalScope = new StackFrame(nullptr, outputStream, errorHandler);
-
-    // Add the built-in functions to the global scope for the sake of throwing errors if they are redefined by the user
-    // The functions themselves are not stored in the AST
-    for (const auto &function : functionMap) {
-        std::string name = function.first;  // Do it in two steps to create references
-        globalScope->allocateFunction(name, nullptr);
-    }
+    ALLOCATION_PHASE(AllocationPhase::INTERPRET);
 
     // Create a vector of stack frames
     std::vector<StackFrame *> stack;
-    stack.push_back(globalScope);
+    slotsUsed = 0;
+
+    resetBudget();
 
     // Interpret the block
-    ExitingObject *ret = interpretBlock(&ast, stack);
+    interpretBlock(&ast, stack);
+}
 
-    if (ret != ERROR_EXIT)
-        delete ret;
+Exiting Interpreter::interpretBlock(BlockNode *block, std::vector<StackFrame *> &stack) {
+    int frameSize = block->getFrameSize();
+    Slot *frameSlots = pushSlots(frameSize);
 
-    delete globalScope;
+    if (frameSlots == nullptr) {
+        return ERROR_EXIT;
+    }
+
+    // Create a new stack frame, enclosed by the current one
+    StackFrame frame(stack.empty() ? nullptr : stack.back(), frameSlots);
+
+    Exiting ret = interpretBlock(block, &frame, stack);
+
+    popSlots(frameSize);
+
+    return ret;
 }
 
-ExitingObject *Interpreter::interpretBlock(BlockNode *block, std::vector<StackFrame *> &stack) {
+Exiting Interpreter::interpretBlock(BlockNode *block, StackFrame *frame, std::vector<StackFrame *> &stack) {
 
-    YIELD;
+    // Let other tasks run if this slice is used up
+    checkBudget();
 
     if (errorHandler.shouldStopExecution()) {
         return ERROR_EXIT;
     }
 
-    // Create a new stack frame
-    StackFrame *frame = new StackFrame(stack.back(), outputStream, errorHandler);
-
     // Push the new stack frame onto the stack
     stack.push_back(frame);
 
@@ -243,66 +178,62 @@ ExitingObject *Interpreter::interpretBlock(BlockNode *block, std::vector<StackFr
         // TODO
 #endif
 
-        ExitingObject *ret = interpretStatement(statement, stack);
+        Exiting ret = interpretStatement(statement, stack);
 
         // Check if we should stop execution
         if (errorHandler.shouldStopExecution()) {
-            delete ret;
             stack.pop_back();
-            delete frame;
             return ERROR_EXIT;
         }
 
-        switch (ret->getType()) {
-            case ExitingType::BREAK:
-                delete ret;
-                stack.pop_back();
-                delete frame;
-                return new ExitingBreak();
-            case ExitingType::CONTINUE:
-                delete ret;
-                stack.pop_back();
-                delete frame;
-                return new ExitingContinue();
-            case ExitingType::RETURN:
-                stack.pop_back();
-                delete frame;
-                return ret;
-            case ExitingType::NONE:
-                delete ret;
-                // Do nothing
+        // Break, continue and return all leave the block early
+        if (ret.type != ExitingType::NONE) {
+            stack.pop_back();
+            return ret;
         }
     }
 
     // Pop the stack frame off the stack
     stack.pop_back();
 
-    // Delete the stack frame
-    delete frame;
-
-    return new ExitingNone();
+    return Exiting::of(ExitingType::NONE);
 }
 
-ExitingObject *Interpreter::interpretStatement(ASTNode *statement, std::vector<StackFrame *> &stack) {
+Exiting Interpreter::interpretStatement(ASTNode *statement, std::vector<StackFrame *> &stack) {
     // These are the statements that represent "start points"
     // In other words, statements that do not return a ValueType
 
-    YIELD;
+    checkBudget();
 
+    currentLocation = statement->getSourceLocation();
+    ALLOCATION_NODE(statement);
+
+    // While profiling is off, this branch is all it costs
+    if (profiler != nullptr) {
+        profiler->enter(statement);
+        Exiting ret = dispatchStatement(statement, stack);
+        profiler->exit();
+        return ret;
+    }
+
+    return dispatchStatement(statement, stack);
+}
+
+Exiting Interpreter::dispatchStatement(ASTNode *statement, std::vector<StackFrame *> &stack) {
     // Avoids RTTI by using virtual function to getNodeType
 
     switch (statement->getNodeType()) {
         case ASTNodeType::VARIABLE_DECLARATION_NODE:
             interpretVariableDeclaration((VariableDeclarationNode *)statement, stack);
-            return new ExitingNone();
+            return Exiting::of(ExitingType::NONE);
 
         case ASTNodeType::ASSIGNMENT_NODE:
             interpretAssignment((AssignmentNode *)statement, stack);
-            return new ExitingNone();
+            return Exiting::of(ExitingType::NONE);
 
         case ASTNodeType::FUNCTION_DECLARATION_NODE:
             interpretFunctionDeclaration((FunctionDeclarationNode *)statement, stack);
-            return new ExitingNone();
+            return Exiting::of(ExitingType::NONE);
 
         case ASTNodeType::IF_NODE:
             return interpretIf((IfNode *)statement, stack);
@@ -314,30 +245,32 @@ ExitingObject *Interpreter::interpretStatement(ASTNode *statement, std::vector<S
             return interpretFor((ForNode *)statement, stack);
 
         case ASTNodeType::BREAK_NODE:
-            return new ExitingBreak();
+            return Exiting::of(ExitingType::BREAK);
 
         case ASTNodeType::CONTINUE_NODE:
-            return new ExitingContinue();
+            return Exiting::of(ExitingType::CONTINUE);
 
         case ASTNodeType::RETURN_NODE:
             return interpretReturn((ReturnNode *)statement, stack);
 
         case ASTNodeType::FUNCTION_CALL_NODE:
-            delete interpretFunctionCall((FunctionCallNode *)statement, stack);
-            return new ExitingNone();
+            interpretFunctionCall((FunctionCallNode *)statement, stack);
+            return Exiting::of(ExitingType::NONE);
 
         default:
-            runtimeError("Unknown statement type " + statement->toString());
+            runtimeError(statement, "Unknown statement type");
             return ERROR_EXIT;
     }
 }
 
-ReturnableObject *Interpreter::interpretExpression(ASTNode *expression, std::vector<StackFrame *> &stack) {
+Returnable Interpreter::interpretExpression(ASTNode *expression, std::vector<StackFrame *> &stack) {
     // Check if we should stop execution
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
+    ALLOCATION_NODE(expression);
+
     // These are the expressions that return a value, such as a variable access or a binary operation
     switch (expression->getNodeType()) {
         case ASTNodeType::VARIABLE_ACCESS_NODE:
@@ -352,345 +285,295 @@ ReturnableObject *Interpreter::interpretExpression(ASTNode *expression, std::vec
         case ASTNodeType::FUNCTION_CALL_NODE:
             return interpretFunctionCall((FunctionCallNode *)expression, stack);
 
+        case ASTNodeType::CONVERSION_NODE:
+            return interpretConversion((ConversionNode *)expression, stack);
+
         default:
-            runtimeError("Unknown expression type " + expression->toString());
-            return ERROR_EXIT;
+            runtimeError(expression, "Unknown expression type");
+            return ERROR_VALUE;
     }
 }
 
-ReturnableObject *Interpreter::interpretNumber(NumberNode *number, std::vector<StackFrame *> &stack) {
-    // Get the type of the number
-    std::string type = number->getType() == TokenType::INTEGER ? "int" : "float";
-
-    // Get the value of the number, cast from string to either int or float
-    float value = std::stof(number->getValue());
-
-    if (type == "int") {
-        return new ReturnableInt((int)value);
-    } else if (type == "float") {
-        // Create a new returnable float
-        return new ReturnableFloat(value);
-    } else {
-        runtimeError("Unknown number type " + type);
-        return ERROR_EXIT;
+Returnable Interpreter::interpretNumber(NumberNode *number, std::vector<StackFrame *> &stack) {
+    // The Parser already decoded the literal
+    if (number->getType() == TokenType::INTEGER) {
+        return Returnable::fromInt(number->getIntValue());
     }
-}
 
-ReturnableObject *Interpreter::interpretVariableAccess(VariableAccessNode *variableAccess, std::vector<StackFrame *> &stack) {
-    // Get the identifier
-    std::string identifier = variableAccess->getIdentifier();
-
-    // Get the type of the variable
-    ValueType type = stack.back()->getType(identifier);
-
-    // Check if the variable exists -- if not then throw an error
-    if (type == ValueType::INTEGER) {
-        // Get the int variable
-        int value = stack.back()->getIntVariable(identifier);
-
-        return new ReturnableInt(value);
+    return Returnable::fromFloat(number->getFloatValue());
+}
 
-    } else if (type == ValueType::FLOAT) {
-        // Get the float variable
-        float value = stack.back()->getFloatVariable(identifier);
+Returnable Interpreter::interpretVariableAccess(VariableAccessNode *variableAccess, std::vector<StackFrame *> &stack) {
+    const VariableLocation &location = variableAccess->getLocation();
 
-        return new ReturnableFloat(value);
+    // The Resolver already knows where the variable lives and what it holds
+    Slot &slot = stack.back()->getAncestor(location.depth)->getSlot(location.slot);
 
+    if (location.type == ValueType::INTEGER) {
+        return Returnable::fromInt(slot.intValue);
     } else {
-        runtimeError("Unknown variable type " + identifier);
-        return ERROR_EXIT;
+        return Returnable::fromFloat(slot.floatValue);
     }
 }
 
-ReturnableObject *Interpreter::interpretBinaryOperation(BinaryOperationNode *binaryExpression, std::vector<StackFrame *> &stack) {
+Returnable Interpreter::interpretBinaryOperation(BinaryOperationNode *binaryExpression, std::vector<StackFrame *> &stack) {
     ASTNode *leftExpression = binaryExpression->getLeftExpression();
     ASTNode *rightExpression = binaryExpression->getRightExpression();
 
-    ReturnableObject *left = interpretExpression(leftExpression, stack);
+    Returnable left = interpretExpression(leftExpression, stack);
 
     if (errorHandler.shouldStopExecution()) {
-        delete left;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    ReturnableObject *right = interpretExpression(rightExpression, stack);
+    Returnable right = interpretExpression(rightExpression, stack);
 
     if (errorHandler.shouldStopExecution()) {
-        delete left;
-        delete right;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    ValueType leftType = left->getType();
-    ValueType rightType = right->getType();
-
-    if (leftType == ValueType::FLOAT || rightType == ValueType::FLOAT) {
-        float leftFloat = (leftType == ValueType::INTEGER) ? ((ReturnableInt *)left)->getValue() : ((ReturnableFloat *)left)->getValue();
-        float rightFloat = (rightType == ValueType::INTEGER) ? ((ReturnableInt *)right)->getValue() : ((ReturnableFloat *)right)->getValue();
-        std::string op = binaryExpression->getOperator();
+    // The Resolver converted both operands to the same type
+    if (leftExpression->getValueType() == ValueType::FLOAT) {
+        return interpretFloatOperation(binaryExpression, left.floatValue, right.floatValue);
+    }
 
-        if ((op == "/" && rightFloat == 0) || (op == "%" && rightFloat == 0)) {
-            runtimeError("Division by zero");
-            delete left;
-            delete right;
-            return ERROR_EXIT;
-        }
+    return interpretIntOperation(binaryExpression, left.intValue, right.intValue);
+}
 
-        if (op == "+" || op == "-" || op == "*" || op == "/") {
-            delete left;
-            delete right;
-            return new ReturnableFloat(
-                (op == "+")   ? leftFloat + rightFloat
-                : (op == "-") ? leftFloat - rightFloat
-                : (op == "*") ? leftFloat * rightFloat
-                              : leftFloat / rightFloat);
-        } else {
-            delete left;
-            delete right;
-            return new ReturnableInt(
-                (op == ">")    ? leftFloat > rightFloat
-                : (op == "<")  ? leftFloat < rightFloat
-                : (op == "%")  ? (int)leftFloat % (int)rightFloat
-                : (op == ">=") ? leftFloat >= rightFloat
-                : (op == "<=") ? leftFloat <= rightFloat
-                : (op == "==") ? leftFloat == rightFloat
-                : (op == "!=") ? leftFloat != rightFloat
-                : (op == "&&") ? leftFloat && rightFloat
-                               : leftFloat || rightFloat);
-        }
-    } else {
-        int leftInt = (leftType == ValueType::INTEGER) ? ((ReturnableInt *)left)->getValue() : ((ReturnableFloat *)left)->getValue();
-        int rightInt = (rightType == ValueType::INTEGER) ? ((ReturnableInt *)right)->getValue() : ((ReturnableFloat *)right)->getValue();
-        std::string op = binaryExpression->getOperator();
-
-        if ((op == "/" && rightInt == 0) || (op == "%" && rightInt == 0)) {
-            runtimeError("Division by zero");
-            delete left;
-            delete right;
-            return ERROR_EXIT;
-        }
+Returnable Interpreter::interpretIntOperation(BinaryOperationNode *binaryExpression, int left, int right) {
+    Operator op = binaryExpression->getOperator();
 
-        delete left;
-        delete right;
-
-        return new ReturnableInt(
-            (op == "+")    ? leftInt + rightInt
-            : (op == "-")  ? leftInt - rightInt
-            : (op == "*")  ? leftInt * rightInt
-            : (op == "/")  ? leftInt / rightInt
-            : (op == ">")  ? leftInt > rightInt
-            : (op == "<")  ? leftInt < rightInt
-            : (op == "%")  ? leftInt % rightInt
-            : (op == ">=") ? leftInt >= rightInt
-            : (op == "<=") ? leftInt <= rightInt
-            : (op == "==") ? leftInt == rightInt
-            : (op == "!=") ? leftInt != rightInt
-            : (op == "&&") ? leftInt && rightInt
-                           : leftInt || rightInt);
+    // Arithmetic wraps instead of overflowing, like the VM's
+    switch (op) {
+        case Operator::ADD:
+            return Returnable::fromInt((int)((uint32_t)left + (uint32_t)right));
+        case Operator::SUBTRACT:
+            return Returnable::fromInt((int)((uint32_t)left - (uint32_t)right));
+        case Operator::MULTIPLY:
+            return Returnable::fromInt((int)((uint32_t)left * (uint32_t)right));
+        case Operator::DIVIDE:
+            if (right == 0) {
+                runtimeError(binaryExpression, "Division by zero");
+                return ERROR_VALUE;
+            }
+            // INT_MIN / -1 would trap
+            return Returnable::fromInt(right == -1 ? (int)(0u - (uint32_t)left) : left / right);
+        case Operator::MODULO:
+            if (right == 0) {
+                runtimeError(binaryExpression, "Division by zero");
+                return ERROR_VALUE;
+            }
+            return Returnable::fromInt(right == -1 ? 0 : left % right);
+        case Operator::GREATER:
+            return Returnable::fromInt(left > right);
+        case Operator::LESS:
+            return Returnable::fromInt(left < right);
+        case Operator::GREATER_EQUAL:
+            return Returnable::fromInt(left >= right);
+        case Operator::LESS_EQUAL:
+            return Returnable::fromInt(left <= right);
+        case Operator::EQUAL:
+            return Returnable::fromInt(left == right);
+        case Operator::NOT_EQUAL:
+            return Returnable::fromInt(left != right);
+        case Operator::AND:
+            return Returnable::fromInt(left && right);
+        case Operator::OR:
+            return Returnable::fromInt(left || right);
+        default:
+            break;
     }
-}
 
-ReturnableObject *Interpreter::interpretFunctionCall(FunctionCallNode *functionCall, std::vector<StackFrame *> &stack) {
-    // Get the identifier
-    std::string identifier = functionCall->getName();
+    // The parser only builds binary nodes from known operators, so this is a malformed AST
+    runtimeError(binaryExpression, "Unknown operator " + operatorToString(op));
+    return ERROR_VALUE;
+}
 
-    // Get the arguments
-    std::vector<ASTNode *> arguments = functionCall->getArguments();
+Returnable Interpreter::interpretFloatOperation(BinaryOperationNode *binaryExpression, float left, float right) {
+    Operator op = binaryExpression->getOperator();
 
-    // Check if the function exists as a built-in function
-    // If so, use the map to call the function
-    if (functionMap.find(identifier) != functionMap.end()) {
-        return functionMap[identifier](arguments, stack);
+    // AND and OR never get here, the Resolver reduces their operands to ints
+    switch (op) {
+        case Operator::ADD:
+            return Returnable::fromFloat(left + right);
+        case Operator::SUBTRACT:
+            return Returnable::fromFloat(left - right);
+        case Operator::MULTIPLY:
+            return Returnable::fromFloat(left * right);
+        case Operator::DIVIDE:
+            if (right == 0) {
+                runtimeError(binaryExpression, "Division by zero");
+                return ERROR_VALUE;
+            }
+            return Returnable::fromFloat(left / right);
+        case Operator::MODULO:
+            // The operands are truncated, so anything in (-1, 1) is a zero divisor as well
+            if ((int)right == 0) {
+                runtimeError(binaryExpression, "Division by zero");
+                return ERROR_VALUE;
+            }
+            return Returnable::fromInt((int)left % (int)right);
+        case Operator::GREATER:
+            return Returnable::fromInt(left > right);
+        case Operator::LESS:
+            return Returnable::fromInt(left < right);
+        case Operator::GREATER_EQUAL:
+            return Returnable::fromInt(left >= right);
+        case Operator::LESS_EQUAL:
+            return Returnable::fromInt(left <= right);
+        case Operator::EQUAL:
+            return Returnable::fromInt(left == right);
+        case Operator::NOT_EQUAL:
+            return Returnable::fromInt(left != right);
+        default:
+            break;
     }
 
-    // Get the function from the stack
-    FunctionDeclarationNode *function = stack.back()->getFunction(identifier);
+    runtimeError(binaryExpression, "Unknown operator " + operatorToString(op));
+    return ERROR_VALUE;
+}
 
-    if (function == nullptr) {
-        return ERROR_EXIT;
+Returnable Interpreter::interpretConversion(ConversionNode *conversion, std::vector<StackFrame *> &stack) {
+    Returnable value = interpretExpression(conversion->getExpression(), stack);
+
+    if (errorHandler.shouldStopExecution()) {
+        return ERROR_VALUE;
     }
 
-    // Get the parameters
-    std::vector<std::string> parameters = function->getParameters();
+    switch (conversion->getConversion()) {
+        case Conversion::INT_TO_FLOAT:
+            return Returnable::fromFloat((float)value.intValue);
+        case Conversion::FLOAT_TO_INT:
+            return Returnable::fromInt((int)value.floatValue);
+        case Conversion::FLOAT_TO_TRUTH:
+            return Returnable::fromInt(value.floatValue != 0);
+    }
 
-    // Get the parameter types
-    std::vector<std::string> parameterTypes = function->getParameterTypes();
+    return ERROR_VALUE;
+}
 
-    // Check if the number of arguments matches the number of parameters
-    // Or if there are 0 arguments in the function and 1 is given and it is an EmptyExpressionNode
-    if (arguments.size() != parameters.size() && !(arguments.size() == 1 && arguments[0]->getNodeType() == ASTNodeType::EMPTY_EXPRESSION_NODE)) {
-        runtimeError("Function " + identifier + " takes " + std::to_string(parameters.size()) + " arguments, but " + std::to_string(arguments.size()) + " were given");
-        return ERROR_EXIT;
-    }
+Returnable Interpreter::interpretFunctionCall(FunctionCallNode *functionCall, std::vector<StackFrame *> &stack) {
+    // Get the arguments
+    const ArenaArray<ASTNode *>& arguments = functionCall->getArguments();
 
-    // Create a new stack frame to house the parameters
-    StackFrame *newFrame = new StackFrame(stack.back(), outputStream, errorHandler);
+    // Get the function the Resolver tied this call to
+    FunctionDeclarationNode *function = functionCall->getTarget();
 
-    // Push the new stack frame onto the stack
-    stack.push_back(newFrame);
+    static_assert(sizeof(builtinFunctions) / sizeof(builtinFunctions[0]) == (size_t)Builtin::SEND_BOOL + 1, "Every Builtin needs an entry in builtinFunctions");
+
+    // Builtins are not tied to a declaration, the Parser found their entry in the builtin table
+    // They report their errors at the call
+    if (function == nullptr) {
+        currentLocation = functionCall->getSourceLocation();
+        return (this->*builtinFunctions[(size_t)functionCall->getBuiltin()->id])(arguments, stack);
+    }
 
-    // Interpret each argument
-    for (int i = 0; i < parameters.size(); i++) {
-        // Get the argument
-        ASTNode *argument = arguments[i];
+    // The Resolver has already checked there is an argument of the right type for each of these
+    const ArenaArray<ValueType>& parameterTypes = function->getParameterValueTypes();
 
-        // Get the parameter
-        std::string parameter = parameters[i];
+    // Claim the body's frame, the parameters are its first slots
+    // A stack overflow is reported at the call
+    BlockNode *body = function->getBody();
+    int frameSize = body->getFrameSize();
+    currentLocation = functionCall->getSourceLocation();
+    Slot *frameSlots = pushSlots(frameSize);
 
-        // Get the parameter type
-        std::string parameterType = parameterTypes[i];
+    if (frameSlots == nullptr) {
+        return ERROR_VALUE;
+    }
 
-        // Interpret the argument
-        ReturnableObject *value = interpretExpression(argument, stack);
+    // Interpret each argument in the caller's frame
+    for (int i = 0; i < parameterTypes.size(); i++) {
+        Returnable value = interpretExpression(arguments[i], stack);
 
         if (errorHandler.shouldStopExecution()) {
-            delete value;
-            stack.pop_back();
-            delete newFrame;
-            return ERROR_EXIT;
+            popSlots(frameSize);
+            return ERROR_VALUE;
         }
 
-        // Allocate the parameter
-        if (parameterType == "int") {
-            if (value->getType() == ValueType::INTEGER) {
-                newFrame->allocateIntVariable(parameter, ((ReturnableInt *)value)->getValue());
-            } else {
-                newFrame->allocateIntVariable(parameter, (int)((ReturnableFloat *)value)->getValue());
-            }
-        } else if (parameterType == "float") {  // TODO optimize this
-            if (value->getType() == ValueType::INTEGER) {
-                newFrame->allocateFloatVariable(parameter, (float)((ReturnableInt *)value)->getValue());
-            } else {
-                newFrame->allocateFloatVariable(parameter, ((ReturnableFloat *)value)->getValue());
-            }
+        if (parameterTypes[i] == ValueType::INTEGER) {
+            frameSlots[i].intValue = value.intValue;
         } else {
-            runtimeError("Unknown parameter type " + parameterType);
-            delete value;
-            stack.pop_back();
-            delete newFrame;
-            return ERROR_EXIT;
+            frameSlots[i].floatValue = value.floatValue;
         }
-
-        delete value;
     }
 
+    // The body sees the variables around the function's declaration, not around the call
+    StackFrame frame(stack.back()->getAncestor(functionCall->getTargetDepth()), frameSlots);
+
     // Interpret the function body
-    ExitingObject *ret = interpretBlock(function->getBody(), stack);
+    Exiting ret = interpretBlock(body, &frame, stack);
 
-    // Delete the new stack frame
-    stack.pop_back();
-    delete newFrame;
+    popSlots(frameSize);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    // If ret is a return, return the value, otherwise return 0
-    if (ret->getType() == ExitingType::RETURN) {
-        ReturnableObject *value = ((ExitingReturn *)ret)->getValue();
-        delete ret;
-        return value;
+    // If ret is a return with a value, return the value, already of the function's type, otherwise return 0
+    if (ret.type == ExitingType::RETURN && ret.value.type != ValueType::VOID) {
+        return ret.value;
+    } else if (functionCall->getValueType() == ValueType::FLOAT) {
+        return Returnable::fromFloat(0);
     } else {
-        delete ret;
-        return new ReturnableInt(0);
+        return Returnable::fromInt(0);
     }
 }
 
 void Interpreter::interpretVariableDeclaration(VariableDeclarationNode *variableDeclaration, std::vector<StackFrame *> &stack) {
-    ReturnableObject *val = interpretExpression(variableDeclaration->getInitializer(), stack);
+    Returnable val = interpretExpression(variableDeclaration->getInitializer(), stack);
 
     if (errorHandler.shouldStopExecution()) {
         return;
     }
 
-    std::string type = variableDeclaration->getType();
-
-    // Handle both types as a float and cast to the appropriate type later
-    float value = val->getType() == ValueType::INTEGER ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
+    // Declarations always land in the current frame
+    const VariableLocation &location = variableDeclaration->getLocation();
+    Slot &slot = stack.back()->getSlot(location.slot);
 
-    delete val;
-
-    std::string identifier = variableDeclaration->getIdentifier();
-
-    if (type == "int") {
-        // Allocate the int variable
-        stack.back()->allocateIntVariable(identifier, (int)value);
-    } else if (type == "float") {
-        // Allocate the float variable
-        stack.back()->allocateFloatVariable(identifier, (float)value);
+    // The Resolver converted the value to the variable's type
+    if (location.type == ValueType::INTEGER) {
+        slot.intValue = val.intValue;
     } else {
-        runtimeError("Unknown variable type " + type);
+        slot.floatValue = val.floatValue;
     }
 }
 
 void Interpreter::interpretAssignment(AssignmentNode *assignment, std::vector<StackFrame *> &stack) {
-    ReturnableObject *val = interpretExpression(assignment->getExpression(), stack);
+    Returnable val = interpretExpression(assignment->getExpression(), stack);
 
     if (errorHandler.shouldStopExecution()) {
         return;
     }
 
-    std::string identifier = assignment->getIdentifier();
-
-    ValueType type = stack.back()->getType(identifier);
-
-    if (errorHandler.shouldStopExecution()) {
-        delete val;
-        return;
-    }
+    const VariableLocation &location = assignment->getLocation();
+    Slot &slot = stack.back()->getAncestor(location.depth)->getSlot(location.slot);
 
-    // Handle both types as a float and cast to the appropriate type later
-    float value = val->getType() == ValueType::INTEGER ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    if (type == ValueType::INTEGER) {
-        // Set the int variable
-        stack.back()->setIntVariable(identifier, (int)value);
-    } else if (type == ValueType::FLOAT) {
-        // Set the float variable
-        stack.back()->setFloatVariable(identifier, (float)value);
+    // The Resolver converted the value to the variable's type
+    if (location.type == ValueType::INTEGER) {
+        slot.intValue = val.intValue;
     } else {
-        delete val;
-        runtimeError("Unknown variable type for " + identifier);
+        slot.floatValue = val.floatValue;
     }
-
-    delete val;
 }
 
 void Interpreter::interpretFunctionDeclaration(FunctionDeclarationNode *functionDeclaration, std::vector<StackFrame *> &stack) {
-    // Get the identifier
-    std::string identifier = functionDeclaration->getName();
-
-    // Allocate the function
-    stack.back()->allocateFunction(identifier, functionDeclaration);
+    // Nothing to do at runtime, the Resolver has already tied every call to its declaration
 }
 
-bool Interpreter::interpretTruthiness(ReturnableObject *condition, std::vector<StackFrame *> &stack) {
-    float conditionVal = 0;  // Default to false
-
-    if (condition->getType() == ValueType::INTEGER) {
-        conditionVal = ((ReturnableInt *)condition)->getValue();
-    } else if (condition->getType() == ValueType::FLOAT) {
-        conditionVal = ((ReturnableFloat *)condition)->getValue();
-    } else {
-        runtimeError("Unknown condition type for interpret truthiness");
-    }
-
-    // Check if the condition is true
-    // Truthy is value != 0
-    if (conditionVal != 0) {
-        return true;
-    } else {
-        return false;
-    }
+bool Interpreter::interpretTruthiness(const Returnable &condition, std::vector<StackFrame *> &stack) {
+    // Float conditions were already compared against 0 by a conversion the Resolver inserted
+    return condition.intValue != 0;
 }
 
-ExitingObject *Interpreter::interpretIf(IfNode *ifStatement, std::vector<StackFrame *> &stack) {
-    std::vector<ASTNode *> expressions = ifStatement->getExpressions();
-    std::vector<BlockNode *> bodies = ifStatement->getBodies();
+Exiting Interpreter::interpretIf(IfNode *ifStatement, std::vector<StackFrame *> &stack) {
+    const ArenaArray<ASTNode *>& expressions = ifStatement->getExpressions();
+    const ArenaArray<BlockNode *>& bodies = ifStatement->getBodies();
 
-    //print the expressions
-    for (auto &expression : expressions) {
-        std::cout << expression->toString() << std::endl;
+    if (TRACE_ENABLED(TRACE_DEBUG, TRACE_INTERPRETER)) {
+        for (auto &expression : expressions) {
+            TRACE(TRACE_DEBUG, TRACE_INTERPRETER, "If condition: %s\n", expression->toString().c_str());
+        }
     }
 
     // Interpret each expression and once one is true, interpret the corresponding body
@@ -700,7 +583,7 @@ ExitingObject *Interpreter::interpretIf(IfNode *ifStatement, std::vector<StackFr
 
     for (int i = 0; i < expressions.size(); i++) {
         // Evaluate the condition
-        ReturnableObject *condition = interpretExpression(expressions[i], stack);
+        Returnable condition = interpretExpression(expressions[i], stack);
 
         if (errorHandler.shouldStopExecution()) {
             return ERROR_EXIT;
@@ -709,11 +592,8 @@ ExitingObject *Interpreter::interpretIf(IfNode *ifStatement, std::vector<StackFr
         // Check if the condition is true
         if (interpretTruthiness(condition, stack)) {
             blockNum = i;
-            delete condition;
             break;
         }
-
-        delete condition;
     }
 
     // Interpret the else block
@@ -721,7 +601,7 @@ ExitingObject *Interpreter::interpretIf(IfNode *ifStatement, std::vector<StackFr
 
     // If no conditions evaluated to true and there is no else body, then do nothing
     if (blockNum == -1 && expressions.size() == bodies.size()) {
-        return new ExitingNone();
+        return Exiting::of(ExitingType::NONE);
     }
 
     // If no conditions evaluated to true and there is an else body, then interpret the else body
@@ -733,9 +613,9 @@ ExitingObject *Interpreter::interpretIf(IfNode *ifStatement, std::vector<StackFr
     return interpretBlock(bodies[blockNum], stack);
 }
 
-ExitingObject *Interpreter::interpretWhile(WhileNode *whileStatement, std::vector<StackFrame *> &stack) {
+Exiting Interpreter::interpretWhile(WhileNode *whileStatement, std::vector<StackFrame *> &stack) {
     // Evaluate the condition
-    ReturnableObject *condition = interpretExpression(whileStatement->getExpression(), stack);
+    Returnable condition = interpretExpression(whileStatement->getExpression(), stack);
 
     if (errorHandler.shouldStopExecution()) {
         return ERROR_EXIT;
@@ -745,38 +625,36 @@ ExitingObject *Interpreter::interpretWhile(WhileNode *whileStatement, std::vecto
     while (interpretTruthiness(condition, stack)) {
         // Interpret the while block
         // Gather the return type to check for break or continue
-        ExitingObject *returnType = interpretBlock(whileStatement->getBody(), stack);
+        Exiting returnType = interpretBlock(whileStatement->getBody(), stack);
 
         if (errorHandler.shouldStopExecution()) {
-            delete condition;
             return ERROR_EXIT;
         }
 
-        switch (returnType->getType()) {
+        switch (returnType.type) {
             case ExitingType::BREAK:
-                delete condition;
-                delete returnType;
-                return new ExitingNone();
+                return Exiting::of(ExitingType::NONE);
             case ExitingType::RETURN:
-                delete condition;
                 return returnType;
             case ExitingType::CONTINUE:
             case ExitingType::NONE:
-                delete returnType;
+            case ExitingType::ERROR:
                 // Do nothing
                 break;
         }
 
         // Re-evaluate the condition
-        delete condition;
         condition = interpretExpression(whileStatement->getExpression(), stack);
+
+        if (errorHandler.shouldStopExecution()) {
+            return ERROR_EXIT;
+        }
     }
 
-    delete condition;
-    return new ExitingNone();
+    return Exiting::of(ExitingType::NONE);
 }
 
-ExitingObject *Interpreter::interpretFor(ForNode *forStatement, std::vector<StackFrame *> &stack) {
+Exiting Interpreter::interpretFor(ForNode *forStatement, std::vector<StackFrame *> &stack) {
     // Evaluate the initializer
     interpretVariableDeclaration((VariableDeclarationNode *)forStatement->getInitializer(), stack);
 
@@ -785,7 +663,7 @@ ExitingObject *Interpreter::interpretFor(ForNode *forStatement, std::vector<Stac
     }
 
     // Evaluate the condition
-    ReturnableObject *condition = interpretExpression(forStatement->getCondition(), stack);
+    Returnable condition = interpretExpression(forStatement->getCondition(), stack);
 
     if (errorHandler.shouldStopExecution()) {
         return ERROR_EXIT;
@@ -795,120 +673,90 @@ ExitingObject *Interpreter::interpretFor(ForNode *forStatement, std::vector<Stac
     while (interpretTruthiness(condition, stack)) {
         // Interpret the for block
         // Gather the return type to check for break or continue
-        ExitingObject *returnType = interpretBlock(forStatement->getBody(), stack);
+        Exiting returnType = interpretBlock(forStatement->getBody(), stack);
 
         if (errorHandler.shouldStopExecution()) {
-            delete condition;
             return ERROR_EXIT;
         }
 
-        switch (returnType->getType()) {
+        switch (returnType.type) {
             case ExitingType::BREAK:
-                delete condition;
-                delete returnType;
-                return new ExitingNone();
+                return Exiting::of(ExitingType::NONE);
             case ExitingType::CONTINUE:
             case ExitingType::NONE:
+            case ExitingType::ERROR:
                 // Continue to the next iteration
                 break;
             case ExitingType::RETURN:
-                delete condition;
                 return returnType;
         }
 
-        delete returnType;
-
         // Evaluate the increment
         interpretAssignment((AssignmentNode *)forStatement->getIncrement(), stack);
 
         if (errorHandler.shouldStopExecution()) {
-            delete condition;
             return ERROR_EXIT;
         }
 
         // Re-evaluate the condition
-        delete condition;
         condition = interpretExpression(forStatement->getCondition(), stack);
 
         if (errorHandler.shouldStopExecution()) {
-            delete condition;
             return ERROR_EXIT;
         }
     }
 
-    delete condition;
-    return new ExitingNone();
+    return Exiting::of(ExitingType::NONE);
 }
 
-ExitingObject *Interpreter::interpretReturn(ReturnNode *returnStatement, std::vector<StackFrame *> &stack) {
+Exiting Interpreter::interpretReturn(ReturnNode *returnStatement, std::vector<StackFrame *> &stack) {
     // Check if it is a return statement with no expression
     if (returnStatement->getExpression() == nullptr) {
-        return new ExitingReturn();
+        return Exiting::returning(Returnable::none());
     }
 
-    ReturnableObject *value = interpretExpression(returnStatement->getExpression(), stack);
+    Returnable value = interpretExpression(returnStatement->getExpression(), stack);
 
     if (errorHandler.shouldStopExecution()) {
-        delete value;
         return ERROR_EXIT;
     }
 
-    return new ExitingReturn(value);
+    return Exiting::returning(value);
 }
 
 // Builtin functions
+// The Resolver has already checked the number of arguments and converted them to the types in the
+// builtin's signature, so only the values themselves are checked here
 
-ReturnableObject *Interpreter::_print(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("print() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_print(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() == ValueType::INTEGER)
-        outputStream.write(PRINT_FLAG + std::to_string(((ReturnableInt *)val)->getValue()) + "\n" + PRINT_FLAG);
+    if (arguments[0]->getValueType() == ValueType::INTEGER)
+        outputStream.write(PRINT_FLAG + std::to_string(val.intValue) + "\n" + PRINT_FLAG);
     else
-        outputStream.write(PRINT_FLAG + std::to_string(((ReturnableFloat *)val)->getValue()) + "\n" + PRINT_FLAG);
+        outputStream.write(PRINT_FLAG + std::to_string(val.floatValue) + "\n" + PRINT_FLAG);
 
-    delete val;
-
-    return new ReturnableInt(0);
+    return Returnable::fromInt(0);
 }
 
-ReturnableObject *Interpreter::_wait(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("wait() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_wait(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::INTEGER) {
-        runtimeError("wait() takes an integer argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    int value = ((ReturnableInt *)val)->getValue();
-
-    delete val;
+    int value = val.intValue;
 
     if (value < 0) {
         runtimeError("wait() takes a non-negative integer argument");
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
 #if __EMBEDDED__
@@ -919,844 +767,367 @@ ReturnableObject *Interpreter::_wait(std::vector<ASTNode *> &arguments, std::vec
     std::this_thread::sleep_for(std::chrono::milliseconds(value));
 #endif
 
-    return new ReturnableInt(0);
-}
+    // Waiting already let other tasks run, so the slice starts over
+    resetBudget();
 
-ReturnableObject *Interpreter::_rand(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument -- that being an EmptyExpressionNode
-    if (arguments.size() != 1 || arguments[0]->getNodeType() != ASTNodeType::EMPTY_EXPRESSION_NODE) {
-        runtimeError("rand() takes exactly 0 arguments");
-        return ERROR_EXIT;
-    }
+    return Returnable::fromInt(0);
+}
 
+Returnable Interpreter::_rand(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Generate a random number between 0 and 1
     float value = (float)rand() / RAND_MAX;
 
-    return new ReturnableFloat(value);
+    return Returnable::fromFloat(value);
 }
 
-ReturnableObject *Interpreter::_float_to_int(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("int() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_float_to_int(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::FLOAT) {
-        runtimeError("int() takes a float argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    float value = ((ReturnableFloat *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableInt((int)value);
+    return Returnable::fromInt((int)val.floatValue);
 }
 
-ReturnableObject *Interpreter::_int_to_float(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("float() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_int_to_float(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::INTEGER) {
-        runtimeError("float() takes an integer argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    int value = ((ReturnableInt *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableFloat((float)value);
+    return Returnable::fromFloat((float)val.intValue);
 }
 
-ReturnableObject *Interpreter::_runtime(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument -- that being an EmptyExpressionNode
-    if (arguments.size() != 1 || arguments[0]->getNodeType() != ASTNodeType::EMPTY_EXPRESSION_NODE) {
-        runtimeError("runtime() takes exactly 0 arguments");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_runtime(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
 #if __EMBEDDED__
-    // return new ReturnableInt((int)round(millis())); //TODO ensure this is good
-    return new ReturnableInt((int)round((double)clock() / CLOCKS_PER_SEC * 1000));
+    // return Returnable::fromInt((int)round(millis())); //TODO ensure this is good
+    return Returnable::fromInt((int)round((double)clock() / CLOCKS_PER_SEC * 1000));
 #else
-    return new ReturnableInt((int)round((double)clock() / CLOCKS_PER_SEC * 1000));
+    return Returnable::fromInt((int)round((double)clock() / CLOCKS_PER_SEC * 1000));
 #endif
 }
 
-ReturnableObject *Interpreter::_pow(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there are exactly two arguments
-    if (arguments.size() != 2) {
-        runtimeError("pow() takes exactly two arguments");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_pow(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val1 = interpretExpression(arguments[0], stack);
+    Returnable val1 = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
     // Get the second argument
-    ReturnableObject *val2 = interpretExpression(arguments[1], stack);
+    Returnable val2 = interpretExpression(arguments[1], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val1->getType() != ValueType::INTEGER && val1->getType() != ValueType::FLOAT) {
-        runtimeError("pow() takes a float or integer argument");
-        delete val1;
-        delete val2;
-        return ERROR_EXIT;
-    }
-
-    if (val2->getType() != ValueType::INTEGER && val2->getType() != ValueType::FLOAT) {
-        runtimeError("pow() takes a float or integer argument");
-        delete val1;
-        delete val2;
-        return ERROR_EXIT;
-    }
-
-    float value1 = (val1->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val1)->getValue() : ((ReturnableFloat *)val1)->getValue();
-    float value2 = (val2->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val2)->getValue() : ((ReturnableFloat *)val2)->getValue();
-
-    delete val1;
-    delete val2;
-
-    return new ReturnableFloat(pow(value1, value2));
+    return Returnable::fromFloat(pow(val1.floatValue, val2.floatValue));
 }
 
-ReturnableObject *Interpreter::_pi(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument -- that being an EmptyExpressionNode
-    if (arguments.size() != 1 || arguments[0]->getNodeType() != ASTNodeType::EMPTY_EXPRESSION_NODE) {
-        runtimeError("pi() takes exactly 0 arguments");
-        return ERROR_EXIT;
-    }
-
-    return new ReturnableFloat(PI);
+Returnable Interpreter::_pi(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
+    return Returnable::fromFloat(PI);
 }
 
-ReturnableObject *Interpreter::_exp(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("exp() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_exp(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val->getType() != ValueType::INTEGER && val->getType() != ValueType::FLOAT) {
-        runtimeError("exp() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableFloat(exp(value));
+    return Returnable::fromFloat(exp(val.floatValue));
 }
 
-ReturnableObject *Interpreter::_sin(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("sin() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_sin(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val->getType() != ValueType::INTEGER && val->getType() != ValueType::FLOAT) {
-        runtimeError("sin() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableFloat(sin(value));
+    return Returnable::fromFloat(sin(val.floatValue));
 }
 
-ReturnableObject *Interpreter::_cos(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("cos() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_cos(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val->getType() != ValueType::INTEGER && val->getType() != ValueType::FLOAT) {
-        runtimeError("cos() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableFloat(cos(value));
+    return Returnable::fromFloat(cos(val.floatValue));
 }
 
-ReturnableObject *Interpreter::_tan(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("tan() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_tan(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val->getType() != ValueType::INTEGER && val->getType() != ValueType::FLOAT) {
-        runtimeError("tan() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableFloat(tan(value));
+    return Returnable::fromFloat(tan(val.floatValue));
 }
 
-ReturnableObject *Interpreter::_asin(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("asin() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_asin(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::FLOAT && val->getType() != ValueType::INTEGER) {
-        runtimeError("asin() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
+    float value = val.floatValue;
 
     if (value < -1 || value > 1) {
         runtimeError("asin() takes an argument between -1 and 1");
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    return new ReturnableFloat(asin(value));
+    return Returnable::fromFloat(asin(value));
 }
 
-ReturnableObject *Interpreter::_acos(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("acos() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_acos(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::FLOAT && val->getType() != ValueType::INTEGER) {
-        runtimeError("acos() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
+    float value = val.floatValue;
 
     if (value < -1 || value > 1) {
         runtimeError("acos() takes an argument between -1 and 1");
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    return new ReturnableFloat(acos(value));
+    return Returnable::fromFloat(acos(value));
 }
 
-ReturnableObject *Interpreter::_atan(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("atan() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_atan(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::FLOAT && val->getType() != ValueType::INTEGER) {
-        runtimeError("atan() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableFloat(atan(value));
+    return Returnable::fromFloat(atan(val.floatValue));
 }
 
-ReturnableObject *Interpreter::_atan2(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there are exactly two arguments
-    if (arguments.size() != 2) {
-        runtimeError("atan2() takes exactly two arguments");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_atan2(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val1 = interpretExpression(arguments[0], stack);
+    Returnable val1 = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val1->getType() != ValueType::FLOAT && val1->getType() != ValueType::INTEGER) {
-        runtimeError("atan2() takes a float or integer argument");
-        delete val1;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
     // Get the second argument
-    ReturnableObject *val2 = interpretExpression(arguments[1], stack);
+    Returnable val2 = interpretExpression(arguments[1], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val2->getType() != ValueType::FLOAT && val2->getType() != ValueType::INTEGER) {
-        runtimeError("atan2() takes a float or integer argument");
-        delete val1;
-        delete val2;
-        return ERROR_EXIT;
-    }
-
-    float value1 = (val1->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val1)->getValue() : ((ReturnableFloat *)val1)->getValue();
-    float value2 = (val2->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val2)->getValue() : ((ReturnableFloat *)val2)->getValue();
-
-    delete val1;
-    delete val2;
-
-    return new ReturnableFloat(atan2(value1, value2));
+    return Returnable::fromFloat(atan2(val1.floatValue, val2.floatValue));
 }
 
-ReturnableObject *Interpreter::_sqrt(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("sqrt() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_sqrt(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::FLOAT && val->getType() != ValueType::INTEGER) {
-        runtimeError("sqrt() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
+    float value = val.floatValue;
 
     if (value < 0) {
         runtimeError("sqrt() takes a positive argument");
-        delete val;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    delete val;
-
-    return new ReturnableFloat(sqrt(value));
+    return Returnable::fromFloat(sqrt(value));
 }
 
-ReturnableObject *Interpreter::_abs(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("abs() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_abs(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val->getType() != ValueType::FLOAT && val->getType() != ValueType::INTEGER) {
-        runtimeError("abs() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableFloat(abs(value));
+    return Returnable::fromFloat(fabs(val.floatValue));
 }
 
-ReturnableObject *Interpreter::_floor(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("floor() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_floor(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::FLOAT && val->getType() != ValueType::INTEGER) {
-        runtimeError("floor() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableFloat(floor(value));
+    return Returnable::fromFloat(floor(val.floatValue));
 }
 
-ReturnableObject *Interpreter::_ceil(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("ceil() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_ceil(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::FLOAT && val->getType() != ValueType::INTEGER) {
-        runtimeError("ceil() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
-
-    return new ReturnableFloat(ceil(value));
+    return Returnable::fromFloat(ceil(val.floatValue));
 }
 
-ReturnableObject *Interpreter::_min(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there are exactly two arguments
-    if (arguments.size() != 2) {
-        runtimeError("min() takes exactly two arguments");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_min(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val1 = interpretExpression(arguments[0], stack);
+    Returnable val1 = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val1->getType() != ValueType::FLOAT && val1->getType() != ValueType::INTEGER) {
-        runtimeError("min() takes a float or integer argument");
-        delete val1;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
     // Get the second argument
-    ReturnableObject *val2 = interpretExpression(arguments[1], stack);
+    Returnable val2 = interpretExpression(arguments[1], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val2->getType() != ValueType::FLOAT && val2->getType() != ValueType::INTEGER) {
-        runtimeError("min() takes a float or integer argument");
-        delete val1;
-        delete val2;
-        return ERROR_EXIT;
-    }
-
-    float value1 = (val1->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val1)->getValue() : ((ReturnableFloat *)val1)->getValue();
-    float value2 = (val2->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val2)->getValue() : ((ReturnableFloat *)val2)->getValue();
-
-    delete val1;
-    delete val2;
-
-    return new ReturnableFloat(std::min(value1, value2));
+    return Returnable::fromFloat(std::min(val1.floatValue, val2.floatValue));
 }
 
-ReturnableObject *Interpreter::_max(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there are exactly two arguments
-    if (arguments.size() != 2) {
-        runtimeError("max() takes exactly two arguments");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_max(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val1 = interpretExpression(arguments[0], stack);
+    Returnable val1 = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val1->getType() != ValueType::FLOAT && val1->getType() != ValueType::INTEGER) {
-        runtimeError("max() takes a float or integer argument");
-        delete val1;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
     // Get the second argument
-    ReturnableObject *val2 = interpretExpression(arguments[1], stack);
+    Returnable val2 = interpretExpression(arguments[1], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val2->getType() != ValueType::FLOAT && val2->getType() != ValueType::INTEGER) {
-        runtimeError("max() takes a float or integer argument");
-        delete val1;
-        delete val2;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    float value1 = (val1->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val1)->getValue() : ((ReturnableFloat *)val1)->getValue();
-    float value2 = (val2->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val2)->getValue() : ((ReturnableFloat *)val2)->getValue();
-
-    delete val1;
-    delete val2;
-
-    return new ReturnableFloat(std::max(value1, value2));
+    return Returnable::fromFloat(std::max(val1.floatValue, val2.floatValue));
 }
 
-ReturnableObject *Interpreter::_log(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("log() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_log(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val->getType() != ValueType::FLOAT && val->getType() != ValueType::INTEGER) {
-        runtimeError("log() takes a float or integer argument");
-        delete val;
-        return ERROR_EXIT;
-    }
-
-    float value = (val->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val)->getValue() : ((ReturnableFloat *)val)->getValue();
-
-    delete val;
+    float value = val.floatValue;
 
     if (value < 0) {
         runtimeError("log() takes a positive argument");
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    return new ReturnableFloat(log(value));
+    return Returnable::fromFloat(log(value));
 }
 
-ReturnableObject *Interpreter::_log10(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("log10() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_log10(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val1 = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val1->getType() != ValueType::FLOAT && val1->getType() != ValueType::INTEGER) {
-        runtimeError("log10() takes a float or integer argument");
-        delete val1;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    float value1 = (val1->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val1)->getValue() : ((ReturnableFloat *)val1)->getValue();
-
-    delete val1;
+    float value = val.floatValue;
 
-    if (value1 < 0) {
+    if (value < 0) {
         runtimeError("log10() takes a positive argument");
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    return new ReturnableFloat(log10(value1));
+    return Returnable::fromFloat(log10(value));
 }
 
-ReturnableObject *Interpreter::_log2(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 1) {
-        runtimeError("log2() takes exactly one argument");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_log2(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val1 = interpretExpression(arguments[0], stack);
+    Returnable val = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val1->getType() != ValueType::FLOAT && val1->getType() != ValueType::INTEGER) {
-        runtimeError("log2() takes a float or integer argument");
-        delete val1;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    float value1 = (val1->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val1)->getValue() : ((ReturnableFloat *)val1)->getValue();
+    float value = val.floatValue;
 
-    delete val1;
-
-    if (value1 < 0) {
+    if (value < 0) {
         runtimeError("log2() takes a positive argument");
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    return new ReturnableFloat(log2(value1));
+    return Returnable::fromFloat(log2(value));
 }
 
-ReturnableObject *Interpreter::_round(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there is exactly one argument
-    if (arguments.size() != 2) {
-        runtimeError("round() takes exactly two arguments");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_round(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument
-    ReturnableObject *val1 = interpretExpression(arguments[0], stack);
+    Returnable val1 = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val1->getType() != ValueType::FLOAT && val1->getType() != ValueType::INTEGER) {
-        runtimeError("round() takes a float or integer argument");
-        delete val1;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
     // Get the second argument
-    ReturnableObject *val2 = interpretExpression(arguments[1], stack);
+    Returnable val2 = interpretExpression(arguments[1], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    if (val2->getType() != ValueType::FLOAT && val2->getType() != ValueType::INTEGER) {
-        runtimeError("round() takes a float or integer argument");
-        delete val1;
-        delete val2;
-        return ERROR_EXIT;
-    }
-
-    float value1 = (val1->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val1)->getValue() : ((ReturnableFloat *)val1)->getValue();
-    float value2 = (val2->getType() == ValueType::INTEGER) ? ((ReturnableInt *)val2)->getValue() : ((ReturnableFloat *)val2)->getValue();
-
-    delete val1;
-    delete val2;
-
-    float factor = pow(10, value2);
+    float factor = pow(10, val2.floatValue);
 
-    return new ReturnableFloat(round(value1 * factor) / factor);
+    return Returnable::fromFloat(round(val1.floatValue * factor) / factor);
 }
 
-ReturnableObject *Interpreter::_sendBool(std::vector<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
-    // Check if there are exactly two arguments
-    if (arguments.size() != 2) {
-        runtimeError("send_bool() takes exactly two arguments");
-        return ERROR_EXIT;
-    }
-
+Returnable Interpreter::_sendBool(const ArenaArray<ASTNode *> &arguments, std::vector<StackFrame *> &stack) {
     // Get the first argument -- the pin
-    ReturnableObject *val1 = interpretExpression(arguments[0], stack);
+    Returnable val1 = interpretExpression(arguments[0], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        return ERROR_EXIT;
-    }
-
-    if (val1->getType() != ValueType::INTEGER) {
-        runtimeError("send_bool()'s first argument must be an integer");
-        delete val1;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
-    // Get the second argument -- the value
-    ReturnableObject *val2 = interpretExpression(arguments[1], stack);
+    // Get the second argument -- the value, already reduced to an int
+    Returnable val2 = interpretExpression(arguments[1], stack);
 
     if (errorHandler.shouldStopExecution()) {
-        delete val1;
-        return ERROR_EXIT;
+        return ERROR_VALUE;
     }
 
     bool value = interpretTruthiness(val2, stack);
-
-    if (errorHandler.shouldStopExecution()) {
-        delete val1;
-        delete val2;
-        return ERROR_EXIT;
-    }
-
-    int tileIdx = ((ReturnableInt *)val1)->getValue();
+    int tileIdx = val1.intValue;
 
 // Send the data command over radio
 #if __EMBEDDED__
     radioFormatter->send_bool(tileIdx, value);
 #else
-    delete val1;
-    delete val2;
     runtimeError("send_bool() is only available in embedded mode");
-    return ERROR_EXIT;
+    return ERROR_VALUE;
 #endif
 
-    delete val1;
-    delete val2;
-
-    return new ReturnableInt(0);
-}
-
-//===================================================
-
-ReturnableFloat::ReturnableFloat(float value) : value(value) {}
-
-ValueType ReturnableFloat::getType() {
-    return ValueType::FLOAT;
-}
-
-float ReturnableFloat::getValue() {
-    return value;
+    return Returnable::fromInt(0);
 }
-
-ReturnableFloat::~ReturnableFloat() {}
-
-ReturnableInt::ReturnableInt(int value) : value(value) {}
-
-ValueType ReturnableInt::getType() {
-    return ValueType::INTEGER;
-}
-
-int ReturnableInt::getValue() {
-    return value;
-}
-
-ReturnableInt::~ReturnableInt() {}
-
-ExitingBreak::ExitingBreak() {}
-
-ExitingType ExitingBreak::getType() {
-    return ExitingType::BREAK;
-}
-
-ExitingBreak::~ExitingBreak() {}
-
-ExitingContinue::ExitingContinue() {}
-
-ExitingType ExitingContinue::getType() {
-    return ExitingType::CONTINUE;
-}
-
-ExitingContinue::~ExitingContinue() {}
-
-ExitingReturn::ExitingReturn(ReturnableObject *value) : value(value) {}
-
-ExitingReturn::ExitingReturn() : value(nullptr) {}
-
-ExitingType ExitingReturn::getType() {
-    return ExitingType::RETURN;
-}
-
-ReturnableObject *ExitingReturn::getValue() {
-    return value;
-}
-
-ExitingReturn::~ExitingReturn() {
-    // Do not delete value because it is needed elsewhere
-}
-
-ExitingNone::ExitingNone() {}
-
-ExitingType ExitingNone::getType() {
-    return ExitingType::NONE;
-}
-
-ExitingNone::~ExitingNone() {}
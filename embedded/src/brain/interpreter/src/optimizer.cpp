@@ -0,0 +1,356 @@
+#include "optimizer.hpp"
+
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "allocationCounter.hpp"
+#include "interpreter.hpp"
+
+Optimizer::Optimizer(Arena& arena) : arena(arena), foldCount(0) {}
+
+Optimizer::~Optimizer() {}
+
+void Optimizer::optimize(BlockNode& ast) {
+    ALLOCATION_PHASE(AllocationPhase::COMPILE);
+
+    foldCount = 0;
+    optimizeBlock(&ast);
+}
+
+int Optimizer::getFoldCount() const { return foldCount; }
+
+//================================================================================================
+// Statements
+//================================================================================================
+
+void Optimizer::optimizeBlock(BlockNode* block) {
+    for (ASTNode* statement : block->getStatements()) {
+        optimizeStatement(statement);
+    }
+}
+
+void Optimizer::optimizeStatement(ASTNode* statement) {
+    switch (statement->getNodeType()) {
+        case ASTNodeType::VARIABLE_DECLARATION_NODE: {
+            VariableDeclarationNode* declaration = (VariableDeclarationNode*)statement;
+            declaration->setInitializer(optimizeExpression(declaration->getInitializer()));
+            break;
+        }
+        case ASTNodeType::ASSIGNMENT_NODE: {
+            AssignmentNode* assignment = (AssignmentNode*)statement;
+            assignment->setExpression(optimizeExpression(assignment->getExpression()));
+            break;
+        }
+        case ASTNodeType::FUNCTION_DECLARATION_NODE:
+            optimizeBlock(((FunctionDeclarationNode*)statement)->getBody());
+            break;
+        case ASTNodeType::IF_NODE: {
+            IfNode* ifStatement = (IfNode*)statement;
+            const ArenaArray<ASTNode*>& expressions = ifStatement->getExpressions();
+            for (size_t i = 0; i < expressions.size(); i++) {
+                ifStatement->setExpression(i, optimizeExpression(expressions[i]));
+            }
+            for (BlockNode* body : ifStatement->getBodies()) {
+                optimizeBlock(body);
+            }
+            break;
+        }
+        case ASTNodeType::WHILE_NODE: {
+            WhileNode* whileStatement = (WhileNode*)statement;
+            whileStatement->setExpression(optimizeExpression(whileStatement->getExpression()));
+            optimizeBlock(whileStatement->getBody());
+            break;
+        }
+        case ASTNodeType::FOR_NODE: {
+            ForNode* forStatement = (ForNode*)statement;
+            optimizeStatement(forStatement->getInitializer());
+            forStatement->setCondition(optimizeExpression(forStatement->getCondition()));
+            optimizeStatement(forStatement->getIncrement());
+            optimizeBlock(forStatement->getBody());
+            break;
+        }
+        case ASTNodeType::RETURN_NODE: {
+            ReturnNode* returnStatement = (ReturnNode*)statement;
+            if (returnStatement->getExpression() != nullptr) {
+                returnStatement->setExpression(optimizeExpression(returnStatement->getExpression()));
+            }
+            break;
+        }
+        case ASTNodeType::FUNCTION_CALL_NODE: {
+            // Called for its effect, so only the arguments are simplified
+            FunctionCallNode* functionCall = (FunctionCallNode*)statement;
+            const ArenaArray<ASTNode*>& arguments = functionCall->getArguments();
+            for (size_t i = 0; i < arguments.size(); i++) {
+                functionCall->setArgument(i, optimizeExpression(arguments[i]));
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+//================================================================================================
+// Expressions
+//================================================================================================
+
+ASTNode* Optimizer::optimizeExpression(ASTNode* expression) {
+    switch (expression->getNodeType()) {
+        case ASTNodeType::BINARY_OPERATION_NODE:
+            return optimizeBinaryOperation((BinaryOperationNode*)expression);
+        case ASTNodeType::MONO_OPERATION_NODE:
+            return optimizeMonoOperation((MonoOperationNode*)expression);
+        case ASTNodeType::FUNCTION_CALL_NODE:
+            return optimizeFunctionCall((FunctionCallNode*)expression);
+        default:
+            return expression;
+    }
+}
+
+// True if node is the integer constant value
+static bool isIntConstant(ASTNode* node, int value) {
+    return node->getNodeType() == ASTNodeType::NUMBER_NODE && ((NumberNode*)node)->getType() == TokenType::INTEGER &&
+           ((NumberNode*)node)->getIntValue() == value;
+}
+
+ASTNode* Optimizer::optimizeBinaryOperation(BinaryOperationNode* binaryExpression) {
+    binaryExpression->setLeftExpression(optimizeExpression(binaryExpression->getLeftExpression()));
+    binaryExpression->setRightExpression(optimizeExpression(binaryExpression->getRightExpression()));
+
+    ASTNode* left = binaryExpression->getLeftExpression();
+    ASTNode* right = binaryExpression->getRightExpression();
+    Operator op = binaryExpression->getOperator();
+
+    if (left->getNodeType() == ASTNodeType::NUMBER_NODE && right->getNodeType() == ASTNodeType::NUMBER_NODE) {
+        NumberNode* folded = foldBinaryOperation(op, (NumberNode*)left, (NumberNode*)right);
+
+        if (folded != nullptr) {
+            foldCount++;
+            return folded;
+        }
+        return binaryExpression;
+    }
+
+    // Identities only use an integer constant, so the other side keeps its type
+    // Ex. x * 1 is x whether x is an int or a float, but x * 1.0 would turn an int x into a float
+    ASTNode* kept = nullptr;
+
+    if ((op == Operator::ADD && isIntConstant(right, 0)) || (op == Operator::SUBTRACT && isIntConstant(right, 0)) ||
+        (op == Operator::MULTIPLY && isIntConstant(right, 1)) || (op == Operator::DIVIDE && isIntConstant(right, 1))) {
+        kept = left;
+    } else if ((op == Operator::ADD && isIntConstant(left, 0)) || (op == Operator::MULTIPLY && isIntConstant(left, 1))) {
+        kept = right;
+    }
+
+    if (kept != nullptr) {
+        foldCount++;
+        return kept;
+    }
+
+    return binaryExpression;
+}
+
+ASTNode* Optimizer::optimizeMonoOperation(MonoOperationNode* monoExpression) {
+    monoExpression->setExpression(optimizeExpression(monoExpression->getExpression()));
+
+    if (monoExpression->getExpression()->getNodeType() != ASTNodeType::NUMBER_NODE) {
+        return monoExpression;
+    }
+
+    NumberNode* operand = (NumberNode*)monoExpression->getExpression();
+    bool isFloat = operand->getType() == TokenType::FLOAT;
+    NumberNode* folded = nullptr;
+
+    if (monoExpression->getOperator() == Operator::NOT) {
+        folded = makeInt(isFloat ? !operand->getFloatValue() : !operand->getIntValue());
+    } else if (monoExpression->getOperator() == Operator::SUBTRACT) {
+        folded = isFloat ? makeFloat(-operand->getFloatValue()) : makeInt((int)(0u - (uint32_t)operand->getIntValue()));
+    }
+
+    if (folded == nullptr) {
+        return monoExpression;
+    }
+
+    foldCount++;
+    return folded;
+}
+
+ASTNode* Optimizer::optimizeFunctionCall(FunctionCallNode* functionCall) {
+    const ArenaArray<ASTNode*>& arguments = functionCall->getArguments();
+    std::vector<NumberNode*> constants;
+    bool allConstant = true;
+
+    for (size_t i = 0; i < arguments.size(); i++) {
+        ASTNode* argument = optimizeExpression(arguments[i]);
+        functionCall->setArgument(i, argument);
+
+        if (argument->getNodeType() == ASTNodeType::NUMBER_NODE) {
+            constants.push_back((NumberNode*)argument);
+        } else if (argument->getNodeType() != ASTNodeType::EMPTY_EXPRESSION_NODE) {
+            allConstant = false;
+        }
+    }
+
+    // Only builtins without side effects are folded, never rand(), runtime() or the I/O ones
+    const BuiltinSignature* builtin = functionCall->getBuiltin();
+
+    if (!allConstant || builtin == nullptr || !builtin->pure) {
+        return functionCall;
+    }
+
+    NumberNode* folded = foldBuiltin(builtin->id, constants);
+
+    if (folded == nullptr) {
+        return functionCall;
+    }
+
+    foldCount++;
+    return folded;
+}
+
+//================================================================================================
+// Folding, mirrors what the engines compute at runtime
+//================================================================================================
+
+NumberNode* Optimizer::foldBinaryOperation(Operator op, NumberNode* left, NumberNode* right) const {
+    if (left->getType() == TokenType::FLOAT || right->getType() == TokenType::FLOAT) {
+        float leftFloat = left->getType() == TokenType::FLOAT ? left->getFloatValue() : (float)left->getIntValue();
+        float rightFloat = right->getType() == TokenType::FLOAT ? right->getFloatValue() : (float)right->getIntValue();
+
+        switch (op) {
+            case Operator::ADD:
+                return makeFloat(leftFloat + rightFloat);
+            case Operator::SUBTRACT:
+                return makeFloat(leftFloat - rightFloat);
+            case Operator::MULTIPLY:
+                return makeFloat(leftFloat * rightFloat);
+            case Operator::DIVIDE:
+                // Left for the engine to report
+                return rightFloat == 0 ? nullptr : makeFloat(leftFloat / rightFloat);
+            case Operator::MODULO:
+                return (int)rightFloat == 0 ? nullptr : makeInt((int)leftFloat % (int)rightFloat);
+            case Operator::GREATER:
+                return makeInt(leftFloat > rightFloat);
+            case Operator::LESS:
+                return makeInt(leftFloat < rightFloat);
+            case Operator::GREATER_EQUAL:
+                return makeInt(leftFloat >= rightFloat);
+            case Operator::LESS_EQUAL:
+                return makeInt(leftFloat <= rightFloat);
+            case Operator::EQUAL:
+                return makeInt(leftFloat == rightFloat);
+            case Operator::NOT_EQUAL:
+                return makeInt(leftFloat != rightFloat);
+            case Operator::AND:
+                return makeInt(leftFloat && rightFloat);
+            case Operator::OR:
+                return makeInt(leftFloat || rightFloat);
+            default:
+                return nullptr;
+        }
+    }
+
+    int leftInt = left->getIntValue();
+    int rightInt = right->getIntValue();
+
+    // Arithmetic wraps the way the engines' does instead of overflowing at compile time
+    switch (op) {
+        case Operator::ADD:
+            return makeInt((int)((uint32_t)leftInt + (uint32_t)rightInt));
+        case Operator::SUBTRACT:
+            return makeInt((int)((uint32_t)leftInt - (uint32_t)rightInt));
+        case Operator::MULTIPLY:
+            return makeInt((int)((uint32_t)leftInt * (uint32_t)rightInt));
+        case Operator::DIVIDE:
+            return (rightInt == 0 || (leftInt == INT_MIN && rightInt == -1)) ? nullptr : makeInt(leftInt / rightInt);
+        case Operator::MODULO:
+            return (rightInt == 0 || (leftInt == INT_MIN && rightInt == -1)) ? nullptr : makeInt(leftInt % rightInt);
+        case Operator::GREATER:
+            return makeInt(leftInt > rightInt);
+        case Operator::LESS:
+            return makeInt(leftInt < rightInt);
+        case Operator::GREATER_EQUAL:
+            return makeInt(leftInt >= rightInt);
+        case Operator::LESS_EQUAL:
+            return makeInt(leftInt <= rightInt);
+        case Operator::EQUAL:
+            return makeInt(leftInt == rightInt);
+        case Operator::NOT_EQUAL:
+            return makeInt(leftInt != rightInt);
+        case Operator::AND:
+            return makeInt(leftInt && rightInt);
+        case Operator::OR:
+            return makeInt(leftInt || rightInt);
+        default:
+            return nullptr;
+    }
+}
+
+NumberNode* Optimizer::foldBuiltin(Builtin builtin, const std::vector<NumberNode*>& arguments) const {
+    if (arguments.empty()) {
+        return builtin == Builtin::PI_VALUE ? makeFloat(PI) : nullptr;
+    }
+
+    if (arguments.size() == 1) {
+        NumberNode* argument = arguments[0];
+        bool isFloat = argument->getType() == TokenType::FLOAT;
+
+        if (builtin == Builtin::INT_TO_FLOAT) {
+            return isFloat ? nullptr : makeFloat((float)argument->getIntValue());
+        }
+        if (builtin == Builtin::FLOAT_TO_INT) {
+            return isFloat ? makeInt((int)argument->getFloatValue()) : nullptr;
+        }
+
+        float value = isFloat ? argument->getFloatValue() : (float)argument->getIntValue();
+
+        switch (builtin) {
+            case Builtin::EXP:
+                return makeFloat(exp(value));
+            case Builtin::SIN:
+                return makeFloat(sin(value));
+            case Builtin::COS:
+                return makeFloat(cos(value));
+            case Builtin::TAN:
+                return makeFloat(tan(value));
+            case Builtin::ATAN:
+                return makeFloat(atan(value));
+            case Builtin::FLOOR:
+                return makeFloat(floor(value));
+            case Builtin::CEIL:
+                return makeFloat(ceil(value));
+            case Builtin::SQRT:
+                return value < 0 ? nullptr : makeFloat(sqrt(value));
+            default:
+                return nullptr;
+        }
+    }
+
+    if (arguments.size() == 2) {
+        float first = arguments[0]->getType() == TokenType::FLOAT ? arguments[0]->getFloatValue() : (float)arguments[0]->getIntValue();
+        float second = arguments[1]->getType() == TokenType::FLOAT ? arguments[1]->getFloatValue() : (float)arguments[1]->getIntValue();
+
+        switch (builtin) {
+            case Builtin::POW:
+                return makeFloat(pow(first, second));
+            case Builtin::ATAN2:
+                return makeFloat(atan2(first, second));
+            default:
+                return nullptr;
+        }
+    }
+
+    return nullptr;
+}
+
+NumberNode* Optimizer::makeInt(int value) const { return new (arena) NumberNode(arena.copyString(std::to_string(value)), value); }
+
+NumberNode* Optimizer::makeFloat(float value) const {
+    // Nine significant digits read back as the same float, which the ASTSerializer relies on as it writes floats as text
+    // std::to_string would spell 1e-7 as 0.000000
+    char literal[32];
+    int length = std::snprintf(literal, sizeof(literal), "%.9g", value);
+    return new (arena) NumberNode(arena.copyString(literal, (size_t)length), value);
+}
@@ -0,0 +1,99 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "flags.h"
+#include "outputStream.hpp"
+
+#if __EMBEDDED__
+#include "esp_timer.h"
+#endif
+
+// Deep enough for the nesting of most programs, so entering a statement does not allocate
+#define PROFILER_INITIAL_DEPTH 64
+
+Profiler::Profiler() { running.reserve(PROFILER_INITIAL_DEPTH); }
+
+void Profiler::enter(const ASTNode* statement) {
+    ProfileEntry& entry = entries[statement];
+    entry.statement = statement;
+    entry.count++;
+
+    Running started = {&entry, nowNanoseconds(), 0};
+    running.push_back(started);
+}
+
+void Profiler::exit() {
+    if (running.empty()) {
+        return;
+    }
+
+    Running finished = running.back();
+    running.pop_back();
+
+    int64_t elapsed = nowNanoseconds() - finished.start;
+    finished.entry->totalNanoseconds += elapsed;
+    finished.entry->selfNanoseconds += elapsed - finished.childNanoseconds;
+
+    if (!running.empty()) {
+        running.back().childNanoseconds += elapsed;
+    }
+}
+
+void Profiler::reset() {
+    entries.clear();
+    running.clear();
+}
+
+std::vector<ProfileEntry> Profiler::getEntries() const {
+    std::vector<ProfileEntry> sorted;
+    sorted.reserve(entries.size());
+    for (const auto& entry : entries) {
+        sorted.push_back(entry.second);
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const ProfileEntry& left, const ProfileEntry& right) {
+        if (left.selfNanoseconds != right.selfNanoseconds) {
+            return left.selfNanoseconds > right.selfNanoseconds;
+        }
+        return left.count > right.count;
+    });
+
+    return sorted;
+}
+
+std::string Profiler::toString(size_t limit) const {
+    std::vector<ProfileEntry> sorted = getEntries();
+
+    std::string result;
+    for (size_t i = 0; i < sorted.size() && i < limit; i++) {
+        const ProfileEntry& entry = sorted[i];
+        SourceLocation location = entry.statement->getSourceLocation();
+
+        char line[128];
+        snprintf(line, sizeof(line), "%u:%u %s ran %u times, %lld us (self %lld us)\n", (unsigned)location.line, (unsigned)location.column,
+                 nodeTypeToString(entry.statement->getNodeType()), (unsigned)entry.count, (long long)(entry.totalNanoseconds / 1000),
+                 (long long)(entry.selfNanoseconds / 1000));
+        result += line;
+    }
+
+    return result;
+}
+
+void Profiler::report(OutputStream& outputStream, size_t limit) const {
+    if (entries.empty()) {
+        return;
+    }
+
+    outputStream.write(PROFILE_FLAG + toString(limit) + PROFILE_FLAG);
+}
+
+int64_t Profiler::nowNanoseconds() {
+#if __EMBEDDED__
+    return esp_timer_get_time() * 1000;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
@@ -0,0 +1,508 @@
+#include "programCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include "builtins.hpp"
+
+#define PROGRAM_CACHE_MAGIC "BRPC"
+#define PROGRAM_CACHE_HEADER_SIZE 24
+
+//================================================================================================
+// Encoding
+//================================================================================================
+
+// Appends little endian integers, whatever the byte order of the host
+class EntryWriter {
+   public:
+    explicit EntryWriter(std::string& out) : out(out) {}
+
+    void u8(uint8_t value) { out.push_back((char)value); }
+    void u16(uint16_t value) { integer(value, 2); }
+    void u32(uint32_t value) { integer(value, 4); }
+    void u64(uint64_t value) { integer(value, 8); }
+    void i32(int32_t value) { u32((uint32_t)value); }
+    void bytes(const std::string& value) { out.append(value); }
+
+   private:
+    std::string& out;
+
+    void integer(uint64_t value, int size) {
+        for (int i = 0; i < size; i++) {
+            out.push_back((char)(value >> (8 * i)));
+        }
+    }
+};
+
+// Reads what EntryWriter wrote, failing rather than reading past the end
+class EntryReader {
+   public:
+    EntryReader(const std::string& in, size_t position) : in(in), position(position), failed(false) {}
+
+    uint8_t u8() { return (uint8_t)integer(1); }
+    uint16_t u16() { return (uint16_t)integer(2); }
+    uint32_t u32() { return (uint32_t)integer(4); }
+    uint64_t u64() { return integer(8); }
+    int32_t i32() { return (int32_t)u32(); }
+
+    std::string bytes(uint32_t size) {
+        if (!has(size)) {
+            return std::string();
+        }
+        std::string value = in.substr(position, size);
+        position += size;
+        return value;
+    }
+
+    // Whether count items of at least itemSize bytes can still follow, checked before reserving for them
+    bool has(uint64_t count, uint64_t itemSize = 1) {
+        if (count * itemSize > in.size() - position) {
+            failed = true;
+        }
+        return !failed;
+    }
+
+    bool ok() const { return !failed; }
+    bool atEnd() const { return position == in.size(); }
+
+   private:
+    const std::string& in;
+    size_t position;
+    bool failed;
+
+    uint64_t integer(int size) {
+        if (!has(size)) {
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < size; i++) {
+            value |= (uint64_t)(uint8_t)in[position + i] << (8 * i);
+        }
+        position += size;
+        return value;
+    }
+};
+
+// CRC-32 as used by zip, bit by bit so there is no table to keep in RAM
+static uint32_t crc32(const char* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint8_t)data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// The function enclosing function at level, function itself at its own level
+// Levels drop by one from a function to its parent, isRunnable checks that first
+static int enclosingAt(const Program& program, int function, int level) {
+    while (program.functions[function].level > level) {
+        function = program.functions[function].parent;
+    }
+    return function;
+}
+
+// How many values a builtin takes off the stack, -1 for an unknown one
+static int builtinArity(Builtin builtin) {
+    // print compiles to PRINT_FLOAT for a float, which has no entry of its own
+    if (builtin == Builtin::PRINT_FLOAT) {
+        builtin = Builtin::PRINT_INT;
+    }
+
+    for (size_t i = 0; i < builtinCount; i++) {
+        if (builtinSignatures[i].id == builtin) {
+            return builtinSignatures[i].numArguments;
+        }
+    }
+    return -1;
+}
+
+// Follows every path through function's code with the number of values on the operand stack
+// Each path has to end in a RETURN or HALT without leaving the function, never take more values than
+// there are, reach every instruction with the same depth and stay within the maxStackDepth the VM reserves
+static bool hasBalancedStack(const Program& program, size_t function) {
+    const FunctionInfo& info = program.functions[function];
+    size_t begin = info.entry;
+    size_t end = function + 1 < program.functions.size() ? program.functions[function + 1].entry : program.code.size();
+
+    std::vector<int> depths(end - begin, -1);  // Before each instruction, -1 until a path reaches it
+    std::vector<size_t> pending;
+
+    depths[0] = 0;
+    pending.push_back(begin);
+
+    while (!pending.empty()) {
+        size_t pc = pending.back();
+        pending.pop_back();
+
+        const Instruction& instruction = program.code[pc];
+        int depth = depths[pc - begin];
+        int taken = 0;
+        int pushed = 0;
+        size_t successors[2];
+        int successorCount = 1;
+        successors[0] = pc + 1;
+
+        switch (instruction.op) {
+            case OpCode::PUSH_INT:
+            case OpCode::PUSH_FLOAT:
+            case OpCode::LOAD_LOCAL:
+            case OpCode::LOAD_OUTER:
+                pushed = 1;
+                break;
+
+            case OpCode::POP:
+            case OpCode::STORE_LOCAL:
+            case OpCode::STORE_OUTER:
+                taken = 1;
+                break;
+
+            case OpCode::INT_TO_FLOAT:
+            case OpCode::FLOAT_TO_INT:
+            case OpCode::FLOAT_TRUTHY:
+                taken = 1;
+                pushed = 1;
+                break;
+
+            case OpCode::JUMP:
+            case OpCode::LOOP:
+                successors[0] = (size_t)instruction.operand;
+                break;
+
+            case OpCode::JUMP_IF_FALSE:
+                taken = 1;
+                successors[1] = (size_t)instruction.operand;
+                successorCount = 2;
+                break;
+
+            case OpCode::CALL:
+                taken = program.functions[instruction.operand].numParameters;
+                pushed = 1;
+                break;
+
+            case OpCode::CALL_BUILTIN:
+                taken = builtinArity((Builtin)instruction.operand);
+                pushed = 1;
+                break;
+
+            // Only the VM's own call frames can be returned from, the top level program halts instead
+            case OpCode::RETURN:
+                if (function == 0) {
+                    return false;
+                }
+                taken = 1;
+                successorCount = 0;
+                break;
+
+            case OpCode::HALT:
+                successorCount = 0;
+                break;
+
+            // Binary operations
+            default:
+                taken = 2;
+                pushed = 1;
+                break;
+        }
+
+        if (taken < 0 || depth < taken || depth - taken + pushed > info.maxStackDepth) {
+            return false;
+        }
+        depth += pushed - taken;
+
+        for (int i = 0; i < successorCount; i++) {
+            size_t next = successors[i];
+            if (next < begin || next >= end) {
+                return false;
+            }
+
+            if (depths[next - begin] == -1) {
+                depths[next - begin] = depth;
+                pending.push_back(next);
+            } else if (depths[next - begin] != depth) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Operands that index into the program have to stay inside it, or the VM would run off its tables
+// The operand stack has to stay inside what the VM reserves for each call, see hasBalancedStack
+static bool isRunnable(const Program& program) {
+    if (program.functions.empty() || program.code.empty() || program.maxLevel < 0) {
+        return false;
+    }
+
+    // The Compiler lays functions out in order, each one's code runs up to the next one's entry
+    for (size_t i = 0; i < program.functions.size(); i++) {
+        const FunctionInfo& function = program.functions[i];
+        if (function.entry >= program.code.size() || function.level < 0 || function.level > program.maxLevel || function.numParameters < 0 ||
+            function.numSlots < function.numParameters || function.maxStackDepth < 0) {
+            return false;
+        }
+
+        if (i == 0 ? function.entry != 0 || function.level != 0 || function.parent != -1
+                   : function.entry <= program.functions[i - 1].entry || function.parent < 0 || (size_t)function.parent >= program.functions.size() ||
+                         program.functions[function.parent].level != function.level - 1) {
+            return false;
+        }
+    }
+
+    int current = 0;  // The function the instruction belongs to
+    for (size_t pc = 0; pc < program.code.size(); pc++) {
+        const Instruction& instruction = program.code[pc];
+
+        while ((size_t)current + 1 < program.functions.size() && program.functions[current + 1].entry <= pc) {
+            current++;
+        }
+        const FunctionInfo& function = program.functions[current];
+
+        if (instruction.op > OpCode::HALT) {
+            return false;
+        }
+
+        switch (instruction.op) {
+            case OpCode::JUMP:
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::LOOP:
+                if (instruction.operand < 0 || (size_t)instruction.operand >= program.code.size()) {
+                    return false;
+                }
+                break;
+
+            case OpCode::LOAD_LOCAL:
+            case OpCode::STORE_LOCAL:
+                if (instruction.operand < 0 || instruction.operand >= function.numSlots) {
+                    return false;
+                }
+                break;
+
+            // Outer variables live in the frame of an enclosing function, the display holds it at that level
+            case OpCode::LOAD_OUTER:
+            case OpCode::STORE_OUTER: {
+                int level = instruction.operand >> 16;
+                if (instruction.operand < 0 || level >= function.level ||
+                    (instruction.operand & 0xFFFF) >= program.functions[enclosingAt(program, current, level)].numSlots) {
+                    return false;
+                }
+                break;
+            }
+
+            // Only functions declared here or in an enclosing function can be called, the display is only right for those
+            case OpCode::CALL: {
+                if (instruction.operand <= 0 || (size_t)instruction.operand >= program.functions.size()) {
+                    return false;
+                }
+                const FunctionInfo& callee = program.functions[instruction.operand];
+                if (callee.level > function.level + 1 || enclosingAt(program, current, callee.level - 1) != callee.parent) {
+                    return false;
+                }
+                break;
+            }
+
+            case OpCode::CALL_BUILTIN:
+                if (instruction.operand < 0 || instruction.operand > (int32_t)Builtin::SEND_BOOL) {
+                    return false;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    for (size_t i = 1; i < program.locations.size(); i++) {
+        if (program.locations[i].firstInstruction < program.locations[i - 1].firstInstruction) {
+            return false;
+        }
+    }
+
+    // Only once every operand is known to be in range, the paths are followed through them
+    for (size_t i = 0; i < program.functions.size(); i++) {
+        if (!hasBalancedStack(program, i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string ProgramCache::serialize(uint64_t sourceHash, const Program& program) {
+    std::string payload;
+    EntryWriter writer(payload);
+
+    writer.i32(program.maxLevel);
+
+    writer.u32((uint32_t)program.code.size());
+    for (const Instruction& instruction : program.code) {
+        writer.u8((uint8_t)instruction.op);
+        writer.i32(instruction.operand);
+    }
+
+    writer.u32((uint32_t)program.functions.size());
+    for (const FunctionInfo& function : program.functions) {
+        writer.u32((uint32_t)function.name.size());
+        writer.bytes(function.name);
+        writer.u32((uint32_t)function.entry);
+        writer.i32(function.level);
+        writer.i32(function.parent);
+        writer.i32(function.numParameters);
+        writer.i32(function.numSlots);
+        writer.i32(function.maxStackDepth);
+    }
+
+    writer.u32((uint32_t)program.locations.size());
+    for (const SourceSpan& span : program.locations) {
+        writer.u32((uint32_t)span.firstInstruction);
+        writer.u16(span.location.line);
+        writer.u16(span.location.column);
+    }
+
+    std::string entry;
+    entry.reserve(PROGRAM_CACHE_HEADER_SIZE + payload.size());
+    EntryWriter header(entry);
+
+    entry.append(PROGRAM_CACHE_MAGIC, 4);
+    header.u16(PROGRAM_CACHE_VERSION);
+    header.u16(0);
+    header.u64(sourceHash);
+    header.u32((uint32_t)payload.size());
+    header.u32(crc32(payload.data(), payload.size()));
+    entry.append(payload);
+
+    return entry;
+}
+
+Program* ProgramCache::deserialize(uint64_t sourceHash, const std::string& entry) {
+    if (entry.size() < PROGRAM_CACHE_HEADER_SIZE || entry.compare(0, 4, PROGRAM_CACHE_MAGIC) != 0) {
+        return nullptr;
+    }
+
+    EntryReader header(entry, 4);
+    uint16_t version = header.u16();
+    header.u16();
+    uint64_t entryHash = header.u64();
+    uint32_t payloadSize = header.u32();
+    uint32_t checksum = header.u32();
+
+    if (version != PROGRAM_CACHE_VERSION || entryHash != sourceHash || payloadSize != entry.size() - PROGRAM_CACHE_HEADER_SIZE ||
+        checksum != crc32(entry.data() + PROGRAM_CACHE_HEADER_SIZE, payloadSize)) {
+        return nullptr;
+    }
+
+    EntryReader reader(entry, PROGRAM_CACHE_HEADER_SIZE);
+    Program* program = new Program();
+
+    program->maxLevel = reader.i32();
+
+    uint32_t codeSize = reader.u32();
+    if (reader.has(codeSize, 5)) {
+        program->code.resize(codeSize);
+        for (Instruction& instruction : program->code) {
+            instruction.op = (OpCode)reader.u8();
+            instruction.operand = reader.i32();
+        }
+    }
+
+    uint32_t functionCount = reader.u32();
+    if (reader.has(functionCount, 28)) {
+        program->functions.resize(functionCount);
+        for (FunctionInfo& function : program->functions) {
+            function.name = reader.bytes(reader.u32());
+            function.entry = reader.u32();
+            function.level = reader.i32();
+            function.parent = reader.i32();
+            function.numParameters = reader.i32();
+            function.numSlots = reader.i32();
+            function.maxStackDepth = reader.i32();
+        }
+    }
+
+    uint32_t locationCount = reader.u32();
+    if (reader.has(locationCount, 8)) {
+        program->locations.resize(locationCount);
+        for (SourceSpan& span : program->locations) {
+            span.firstInstruction = reader.u32();
+            span.location.line = reader.u16();
+            span.location.column = reader.u16();
+        }
+    }
+
+    if (!reader.ok() || !reader.atEnd() || !isRunnable(*program)) {
+        delete program;
+        return nullptr;
+    }
+
+    return program;
+}
+
+//================================================================================================
+// Cache
+//================================================================================================
+
+ProgramCache::ProgramCache(ProgramCacheStorage& storage) : storage(storage) {}
+
+uint64_t ProgramCache::hashSource(const char* source, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)source[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint32_t ProgramCache::slotOf(uint64_t sourceHash) { return (uint32_t)(sourceHash % PROGRAM_CACHE_SLOTS); }
+
+Program* ProgramCache::load(const char* source, size_t size) { return loadByHash(hashSource(source, size)); }
+
+Program* ProgramCache::loadByHash(uint64_t sourceHash) {
+    std::string entry;
+    if (!storage.read(slotOf(sourceHash), entry)) {
+        return nullptr;
+    }
+
+    return deserialize(sourceHash, entry);
+}
+
+bool ProgramCache::store(const char* source, size_t size, const Program& program) { return storeByHash(hashSource(source, size), program); }
+
+bool ProgramCache::storeByHash(uint64_t sourceHash, const Program& program) { return storage.write(slotOf(sourceHash), serialize(sourceHash, program)); }
+
+//================================================================================================
+// Files
+//================================================================================================
+
+FileProgramCacheStorage::FileProgramCacheStorage(const std::string& directory) : directory(directory) {}
+
+std::string FileProgramCacheStorage::pathOf(uint32_t slot) const { return directory + "/program" + std::to_string(slot) + ".bin"; }
+
+bool FileProgramCacheStorage::read(uint32_t slot, std::string& entry) {
+    FILE* file = fopen(pathOf(slot).c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    entry.clear();
+    char buffer[512];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        entry.append(buffer, read);
+    }
+
+    bool failed = ferror(file) != 0;
+    fclose(file);
+    return !failed;
+}
+
+bool FileProgramCacheStorage::write(uint32_t slot, const std::string& entry) {
+    FILE* file = fopen(pathOf(slot).c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool written = fwrite(entry.data(), 1, entry.size(), file) == entry.size();
+    return fclose(file) == 0 && written;
+}
@@ -0,0 +1,553 @@
+#include "resolver.hpp"
+
+#include "builtins.hpp"
+#include "error.hpp"
+
+Resolver::Resolver(OutputStream& outputStream, ErrorHandler& errorHandler, Arena& arena)
+    : outputStream(outputStream), errorHandler(errorHandler), arena(arena), hadError(false), returnType(ValueType::VOID), currentLocation{0, 0} {}
+
+Resolver::~Resolver() {}
+
+void Resolver::resolveError(const std::string& message) {
+    // Only report the first error, the rest are usually fallout from it
+    if (!hadError) {
+        errorHandler.handleError("Compile Error: " + message, currentLocation);
+    }
+    hadError = true;
+}
+
+bool Resolver::resolve(BlockNode& ast) {
+    scopes.clear();
+    visibleDeclarations.clear();
+    hadError = false;
+    returnType = ValueType::VOID;
+
+    resolveBlock(&ast, nullptr);
+
+    return !hadError;
+}
+
+//================================================================================================
+// Scopes
+//================================================================================================
+
+void Resolver::pushScope(bool ownsFrame) {
+    Scope scope;
+    scope.ownsFrame = ownsFrame;
+    scope.frameSize = 0;
+    scopes.push_back(scope);
+}
+
+void Resolver::popScope() {
+    // Resolve the bodies of the functions declared here now that everything they can see is declared
+    // The scope stays on the stack while doing so, so the bodies find it one frame out
+    std::vector<int> enclosingVisible = visibleDeclarations;
+
+    for (size_t i = 0; i < scopes.back().pendingFunctions.size() && !hadError; i++) {
+        PendingFunction function = scopes.back().pendingFunctions[i];
+        visibleDeclarations = function.visible;
+        resolveBlock(function.declaration->getBody(), function.declaration);
+    }
+
+    visibleDeclarations = enclosingVisible;
+    scopes.pop_back();
+}
+
+Resolver::Scope& Resolver::frameScope() {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        if (scope->ownsFrame) {
+            return *scope;
+        }
+    }
+    return scopes.front();
+}
+
+bool Resolver::isDeclared(Symbol name) const {
+    // Builtins are reserved names, they cannot be redeclared by the user
+    if (findBuiltin(symbolTable.name(name)) != nullptr) {
+        return true;
+    }
+
+    for (size_t i = 0; i < scopes.size(); i++) {
+        auto declaration = scopes[i].declarationOrder.find(name);
+        if (declaration != scopes[i].declarationOrder.end() && (i >= visibleDeclarations.size() || declaration->second < visibleDeclarations[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Resolver::recordDeclaration(Symbol name) {
+    int order = (int)scopes.back().declarationOrder.size();
+    scopes.back().declarationOrder[name] = order;
+}
+
+bool Resolver::declareVariable(Symbol name, const std::string& type, VariableLocation& location) {
+    if (isDeclared(name)) {
+        resolveError("Identifier " + symbolTable.name(name) + " already exists in this scope");
+        return false;
+    }
+
+    ValueType valueType;
+    if (type == "int") {
+        valueType = ValueType::INTEGER;
+    } else if (type == "float") {
+        valueType = ValueType::FLOAT;
+    } else {
+        resolveError("Unknown variable type " + type);
+        return false;
+    }
+
+    Scope& frame = frameScope();
+    Variable variable = {frame.frameSize++, valueType};
+    scopes.back().variables[name] = variable;
+    recordDeclaration(name);
+
+    location = {0, variable.slot, valueType};
+    return true;
+}
+
+bool Resolver::findVariable(Symbol name, VariableLocation& location) const {
+    int depth = 0;
+
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        auto variable = scope->variables.find(name);
+        if (variable != scope->variables.end()) {
+            location = {depth, variable->second.slot, variable->second.type};
+            return true;
+        }
+
+        // Leaving a block means going one frame out
+        if (scope->ownsFrame) {
+            depth++;
+        }
+    }
+    return false;
+}
+
+//================================================================================================
+// Types
+//================================================================================================
+
+ASTNode* Resolver::convert(ASTNode* expression, ValueType type) {
+    ValueType from = expression->getValueType();
+    Conversion conversion;
+
+    if (from == ValueType::INTEGER && type == ValueType::FLOAT) {
+        conversion = Conversion::INT_TO_FLOAT;
+    } else if (from == ValueType::FLOAT && type == ValueType::INTEGER) {
+        conversion = Conversion::FLOAT_TO_INT;
+    } else {
+        return expression;
+    }
+
+    ConversionNode* conversionNode = new (arena) ConversionNode(conversion, expression);
+    conversionNode->setSourceLocation(expression->getSourceLocation());
+    return conversionNode;
+}
+
+ASTNode* Resolver::truthy(ASTNode* expression) {
+    // Floats need to be compared against 0 rather than truncated
+    if (expression->getValueType() != ValueType::FLOAT) {
+        return expression;
+    }
+
+    ConversionNode* conversionNode = new (arena) ConversionNode(Conversion::FLOAT_TO_TRUTH, expression);
+    conversionNode->setSourceLocation(expression->getSourceLocation());
+    return conversionNode;
+}
+
+ValueType Resolver::returnTypeOf(const FunctionDeclarationNode* function) {
+    return function->getType() == "float" ? ValueType::FLOAT : ValueType::INTEGER;
+}
+
+//================================================================================================
+// Statements
+//================================================================================================
+
+void Resolver::resolveBlock(BlockNode* block, FunctionDeclarationNode* function) {
+    pushScope(true);
+
+    ValueType enclosingReturnType = returnType;
+
+    // Parameters take the first slots of the body's frame, in order
+    if (function != nullptr) {
+        currentLocation = function->getSourceLocation();
+        returnType = returnTypeOf(function);
+
+        const ArenaArray<Symbol>& parameters = function->getParameters();
+        const ArenaArray<Symbol>& parameterTypes = function->getParameterTypes();
+
+        for (size_t i = 0; i < parameters.size() && !hadError; i++) {
+            VariableLocation location;
+            declareVariable(parameters[i], symbolTable.name(parameterTypes[i]), location);
+        }
+    }
+
+    for (ASTNode* statement : block->getStatements()) {
+        if (hadError) {
+            break;
+        }
+        resolveStatement(statement);
+    }
+
+    // Function bodies declared in this block may not add to its frame, so its size is known here
+    block->setFrameSize(scopes.back().frameSize);
+
+    // Nested function bodies are resolved by popScope and set their own return type
+    popScope();
+
+    returnType = enclosingReturnType;
+}
+
+void Resolver::resolveStatement(ASTNode* statement) {
+    currentLocation = statement->getSourceLocation();
+
+    switch (statement->getNodeType()) {
+        case ASTNodeType::VARIABLE_DECLARATION_NODE:
+            resolveVariableDeclaration((VariableDeclarationNode*)statement);
+            break;
+
+        case ASTNodeType::ASSIGNMENT_NODE:
+            resolveAssignment((AssignmentNode*)statement);
+            break;
+
+        case ASTNodeType::FUNCTION_DECLARATION_NODE:
+            resolveFunctionDeclaration((FunctionDeclarationNode*)statement);
+            break;
+
+        case ASTNodeType::IF_NODE: {
+            IfNode* ifStatement = (IfNode*)statement;
+            const ArenaArray<ASTNode*>& expressions = ifStatement->getExpressions();
+            for (size_t i = 0; i < expressions.size(); i++) {
+                resolveExpression(expressions[i]);
+                ifStatement->setExpression(i, truthy(expressions[i]));
+            }
+            for (BlockNode* body : ifStatement->getBodies()) {
+                resolveBlock(body, nullptr);
+            }
+            break;
+        }
+
+        case ASTNodeType::WHILE_NODE: {
+            WhileNode* whileStatement = (WhileNode*)statement;
+            resolveExpression(whileStatement->getExpression());
+            whileStatement->setExpression(truthy(whileStatement->getExpression()));
+            resolveBlock(whileStatement->getBody(), nullptr);
+            break;
+        }
+
+        case ASTNodeType::FOR_NODE:
+            resolveFor((ForNode*)statement);
+            break;
+
+        case ASTNodeType::BREAK_NODE:
+        case ASTNodeType::CONTINUE_NODE:
+            break;
+
+        case ASTNodeType::RETURN_NODE: {
+            ReturnNode* returnStatement = (ReturnNode*)statement;
+            ASTNode* expression = returnStatement->getExpression();
+            if (expression != nullptr) {
+                resolveExpression(expression);
+
+                // A return from the program block just stops it, there is nothing to convert to
+                if (returnType != ValueType::VOID) {
+                    returnStatement->setExpression(convert(expression, returnType));
+                }
+            }
+            break;
+        }
+
+        case ASTNodeType::FUNCTION_CALL_NODE:
+            resolveFunctionCall((FunctionCallNode*)statement);
+            break;
+
+        default:
+            resolveError("Unknown statement type");
+    }
+}
+
+void Resolver::resolveVariableDeclaration(VariableDeclarationNode* variableDeclaration) {
+    // The initializer is resolved first so it cannot refer to the variable being declared
+    resolveExpression(variableDeclaration->getInitializer());
+
+    if (hadError) {
+        return;
+    }
+
+    // Back from the initializer
+    currentLocation = variableDeclaration->getSourceLocation();
+
+    VariableLocation location;
+    if (declareVariable(variableDeclaration->getSymbol(), variableDeclaration->getType(), location)) {
+        variableDeclaration->setLocation(location);
+        variableDeclaration->setInitializer(convert(variableDeclaration->getInitializer(), location.type));
+    }
+}
+
+void Resolver::resolveAssignment(AssignmentNode* assignment) {
+    resolveExpression(assignment->getExpression());
+
+    if (hadError) {
+        return;
+    }
+
+    // Back from the expression
+    currentLocation = assignment->getSourceLocation();
+
+    VariableLocation location;
+    if (!findVariable(assignment->getSymbol(), location)) {
+        resolveError("Variable " + assignment->getIdentifier() + " does not exist in this scope");
+        return;
+    }
+
+    assignment->setLocation(location);
+    assignment->setExpression(convert(assignment->getExpression(), location.type));
+}
+
+void Resolver::resolveFunctionDeclaration(FunctionDeclarationNode* functionDeclaration) {
+    Symbol name = functionDeclaration->getSymbol();
+
+    if (isDeclared(name)) {
+        resolveError("Identifier " + functionDeclaration->getName() + " already exists in this scope");
+        return;
+    }
+
+    // Declared before the body is resolved so the function can call itself
+    scopes.back().functions[name] = functionDeclaration;
+    recordDeclaration(name);
+
+    // The body only clashes with what is declared up to here, not with what the scope declares later
+    PendingFunction pending;
+    pending.declaration = functionDeclaration;
+    for (size_t i = 0; i < scopes.size(); i++) {
+        int declared = (int)scopes[i].declarationOrder.size();
+        pending.visible.push_back(i < visibleDeclarations.size() && visibleDeclarations[i] < declared ? visibleDeclarations[i] : declared);
+    }
+    scopes.back().pendingFunctions.push_back(pending);
+}
+
+void Resolver::resolveFor(ForNode* forStatement) {
+    if (forStatement->getInitializer()->getNodeType() != ASTNodeType::VARIABLE_DECLARATION_NODE || forStatement->getIncrement()->getNodeType() != ASTNodeType::ASSIGNMENT_NODE) {
+        resolveError("Malformed for loop");
+        return;
+    }
+
+    // The loop variable is scoped to the loop but stored in the enclosing block's frame
+    pushScope(false);
+
+    resolveVariableDeclaration((VariableDeclarationNode*)forStatement->getInitializer());
+    resolveExpression(forStatement->getCondition());
+    forStatement->setCondition(truthy(forStatement->getCondition()));
+    resolveAssignment((AssignmentNode*)forStatement->getIncrement());
+    resolveBlock(forStatement->getBody(), nullptr);
+
+    popScope();
+}
+
+//================================================================================================
+// Expressions
+//================================================================================================
+
+ValueType Resolver::resolveExpression(ASTNode* expression) {
+    if (hadError) {
+        return ValueType::INTEGER;
+    }
+
+    ValueType type;
+
+    switch (expression->getNodeType()) {
+        case ASTNodeType::VARIABLE_ACCESS_NODE: {
+            VariableAccessNode* variableAccess = (VariableAccessNode*)expression;
+            VariableLocation location;
+            currentLocation = variableAccess->getSourceLocation();
+
+            if (!findVariable(variableAccess->getSymbol(), location)) {
+                resolveError("Variable " + variableAccess->getIdentifier() + " does not exist in this scope");
+                return ValueType::INTEGER;
+            }
+
+            variableAccess->setLocation(location);
+            type = location.type;
+            break;
+        }
+
+        case ASTNodeType::BINARY_OPERATION_NODE:
+            type = resolveBinaryOperation((BinaryOperationNode*)expression);
+            break;
+
+        case ASTNodeType::FUNCTION_CALL_NODE:
+            type = resolveFunctionCall((FunctionCallNode*)expression);
+            break;
+
+        case ASTNodeType::NUMBER_NODE:
+            type = ((NumberNode*)expression)->getType() == TokenType::INTEGER ? ValueType::INTEGER : ValueType::FLOAT;
+            break;
+
+        case ASTNodeType::CONVERSION_NODE:
+            // Already inserted by an earlier pass, its type is fixed by the conversion
+            resolveExpression(((ConversionNode*)expression)->getExpression());
+            return expression->getValueType();
+
+        case ASTNodeType::EMPTY_EXPRESSION_NODE:
+            type = ValueType::VOID;
+            break;
+
+        default:
+            resolveError("Unknown expression type");
+            return ValueType::INTEGER;
+    }
+
+    expression->setValueType(type);
+    return type;
+}
+
+ValueType Resolver::resolveBinaryOperation(BinaryOperationNode* binaryExpression) {
+    Operator op = binaryExpression->getOperator();
+    ASTNode* left = binaryExpression->getLeftExpression();
+    ASTNode* right = binaryExpression->getRightExpression();
+
+    ValueType leftType = resolveExpression(left);
+    ValueType rightType = resolveExpression(right);
+
+    if (hadError) {
+        return ValueType::INTEGER;
+    }
+
+    // Logical operators work on truthiness
+    if (op == Operator::AND || op == Operator::OR) {
+        binaryExpression->setLeftExpression(truthy(left));
+        binaryExpression->setRightExpression(truthy(right));
+        return ValueType::INTEGER;
+    }
+
+    // Mixed operands are promoted to float
+    ValueType operandType = leftType == ValueType::FLOAT || rightType == ValueType::FLOAT ? ValueType::FLOAT : ValueType::INTEGER;
+    binaryExpression->setLeftExpression(convert(left, operandType));
+    binaryExpression->setRightExpression(convert(right, operandType));
+
+    // Arithmetic keeps the operand type, everything else produces an int
+    switch (op) {
+        case Operator::ADD:
+        case Operator::SUBTRACT:
+        case Operator::MULTIPLY:
+        case Operator::DIVIDE:
+            return operandType;
+        default:
+            return ValueType::INTEGER;
+    }
+}
+
+ValueType Resolver::resolveFunctionCall(FunctionCallNode* functionCall) {
+    // The Parser has already tied builtin calls to their entry in the builtin table
+    if (functionCall->getBuiltin() != nullptr) {
+        return resolveBuiltinCall(functionCall);
+    }
+
+    const ArenaArray<ASTNode*>& arguments = functionCall->getArguments();
+
+    for (ASTNode* argument : arguments) {
+        resolveExpression(argument);
+    }
+
+    currentLocation = functionCall->getSourceLocation();
+
+    Symbol name = functionCall->getSymbol();
+
+    int depth = 0;
+
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        auto function = scope->functions.find(name);
+        if (function != scope->functions.end()) {
+            // Checked once here, so the engines can bind the arguments without counting them on every call
+            const ArenaArray<ValueType>& parameterTypes = function->second->getParameterValueTypes();
+            size_t parameterCount = parameterTypes.size();
+
+            // A call with no arguments is parsed as a single empty expression
+            bool noArguments = arguments.size() == 1 && arguments[0]->getNodeType() == ASTNodeType::EMPTY_EXPRESSION_NODE;
+            size_t argumentCount = noArguments ? 0 : arguments.size();
+
+            if (argumentCount != parameterCount) {
+                resolveError("Function " + functionCall->getName() + " takes " + std::to_string(parameterCount) + " arguments, but " + std::to_string(argumentCount) + " were given");
+                return ValueType::INTEGER;
+            }
+
+            // Each argument arrives already of its parameter's type
+            for (size_t i = 0; i < argumentCount; i++) {
+                functionCall->setArgument(i, convert(arguments[i], parameterTypes[i]));
+            }
+
+            functionCall->setTarget(function->second, depth);
+            return returnTypeOf(function->second);
+        }
+
+        if (scope->ownsFrame) {
+            depth++;
+        }
+    }
+
+    resolveError("Function " + functionCall->getName() + " does not exist in this scope");
+    return ValueType::INTEGER;
+}
+
+ValueType Resolver::resolveBuiltinCall(FunctionCallNode* functionCall) {
+    const std::string& name = functionCall->getName();
+    const BuiltinSignature* signature = functionCall->getBuiltin();
+    const ArenaArray<ASTNode*>& arguments = functionCall->getArguments();
+    size_t argumentCount = arguments.size();
+
+    currentLocation = functionCall->getSourceLocation();
+
+    if (signature->numArguments == 0) {
+        // Calls without arguments are parsed as a single empty expression
+        if (arguments.size() != 1 || arguments[0]->getNodeType() != ASTNodeType::EMPTY_EXPRESSION_NODE) {
+            resolveError(name + "() takes exactly 0 arguments");
+            return signature->returnType;
+        }
+        argumentCount = 0;
+    } else if ((int)arguments.size() != signature->numArguments) {
+        resolveError(name + "() takes exactly " + (signature->numArguments == 1 ? "one argument" : "two arguments"));
+        return signature->returnType;
+    }
+
+    for (size_t i = 0; i < argumentCount; i++) {
+        ValueType type = resolveExpression(arguments[i]);
+        currentLocation = functionCall->getSourceLocation();
+
+        if (hadError) {
+            return signature->returnType;
+        }
+
+        if (type == ValueType::VOID) {
+            resolveError(name + "() is missing an argument");
+            return signature->returnType;
+        }
+
+        switch (signature->arguments[i]) {
+            case ArgumentKind::ANY:
+                // print picks its formatting from the static type
+                break;
+            case ArgumentKind::NUMBER:
+                functionCall->setArgument(i, convert(arguments[i], ValueType::FLOAT));
+                break;
+            case ArgumentKind::INTEGER:
+                if (type != ValueType::INTEGER) {
+                    resolveError(name + "() takes an integer argument");
+                    return signature->returnType;
+                }
+                break;
+            case ArgumentKind::FLOAT:
+                if (type != ValueType::FLOAT) {
+                    resolveError(name + "() takes a float argument");
+                    return signature->returnType;
+                }
+                break;
+            case ArgumentKind::TRUTHY:
+                functionCall->setArgument(i, truthy(arguments[i]));
+                break;
+        }
+    }
+
+    return signature->returnType;
+}
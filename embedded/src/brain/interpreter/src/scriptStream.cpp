@@ -0,0 +1,26 @@
+#include "scriptStream.hpp"
+
+ScriptStream::ScriptStream(OutputStream& outputStream, ErrorHandler& errorHandler, Arena& arena)
+    : parser(tokenizer.getTokens(), outputStream, errorHandler, arena), statementCount(0) {}
+
+void ScriptStream::feed(const char* chunk, std::size_t length) {
+    tokenizer.feed(chunk, length);
+    statementCount = parser.parseAvailableStatements();
+}
+
+BlockNode* ScriptStream::finish() {
+    tokenizer.finish();
+    return parser.parseProgram();
+}
+
+const std::string& ScriptStream::getSource() const {
+    return tokenizer.getSource();
+}
+
+std::size_t ScriptStream::getTokenCount() const {
+    return tokenizer.getTokens().size();
+}
+
+std::size_t ScriptStream::getStatementCount() const {
+    return statementCount;
+}
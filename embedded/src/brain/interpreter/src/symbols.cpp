@@ -0,0 +1,36 @@
+#include "symbols.hpp"
+
+SymbolTable symbolTable;
+
+SymbolTable::SymbolTable() { clear(); }
+
+SymbolTable::~SymbolTable() {}
+
+Symbol SymbolTable::intern(StringView name) {
+    auto found = symbols.find(name);
+    if (found != symbols.end()) {
+        return found->second;
+    }
+
+    Symbol symbol = (Symbol)names.size();
+    names.push_back(name.str());
+    symbols[StringView(names.back())] = symbol;
+    return symbol;
+}
+
+Symbol SymbolTable::find(StringView name) const {
+    auto found = symbols.find(name);
+    return found == symbols.end() ? NO_SYMBOL : found->second;
+}
+
+const std::string& SymbolTable::name(Symbol symbol) const { return names[symbol]; }
+
+std::size_t SymbolTable::size() const { return names.size(); }
+
+void SymbolTable::clear() {
+    symbols.clear();
+    names.clear();
+
+    // NO_SYMBOL names nothing, it is not in the map so it is never handed out
+    names.push_back("");
+}
@@ -2,55 +2,96 @@
 
 #include <cctype>
 
-
-const std::unordered_set<std::string> Tokenizer::keywords = {
-    "int", "float", "string", "if",
-    "while", "for", "break", "continue",
-    "else", "return", "void"};
-
-const std::unordered_set<std::string> Tokenizer::doubleCharOperators = {
-    ">=", "<=", "==", "!=", "&&", "||"};
-
-const std::unordered_set<char> Tokenizer::singleCharOperators = {
-    '+', '-', '*', '/', '=', '>', '<', '%', '!'};
+#include "allocationCounter.hpp"
 
 Tokenizer::Tokenizer(const std::string& sourceCode)
-    : sourceCode(sourceCode), currentPosition(0) {}
+    : ownedSource(sourceCode), source(ownedSource.data()), sourceLength(ownedSource.size()), currentPosition(0), locatedPosition(0), locatedLine(1), locatedLineStart(0) {}
+
+Tokenizer::Tokenizer(const char* source, std::size_t length)
+    : source(source), sourceLength(length), currentPosition(0), locatedPosition(0), locatedLine(1), locatedLineStart(0) {}
+
+Tokenizer::Tokenizer()
+    : source(ownedSource.data()), sourceLength(0), currentPosition(0), locatedPosition(0), locatedLine(1), locatedLineStart(0) {}
+
+bool Tokenizer::isKeyword(StringView word) {
+    // Keywords: int, float, string, if, while, for, break, continue, else, return, void
+    // Switching on the length leaves at most three to compare
+    switch (word.size()) {
+        case 2:
+            return word == "if";
+        case 3:
+            return word == "int" || word == "for";
+        case 4:
+            return word == "else" || word == "void";
+        case 5:
+            return word == "float" || word == "while" || word == "break";
+        case 6:
+            return word == "string" || word == "return";
+        case 8:
+            return word == "continue";
+        default:
+            return false;
+    }
+}
+
+std::size_t Tokenizer::operatorLength(char first, char second) {
+    // Double character operators: >=, <=, ==, !=, &&, ||
+    // Single character operators: +, -, *, /, =, >, <, %, !
+    switch (first) {
+        case '>':
+        case '<':
+        case '=':
+        case '!':
+            return second == '=' ? 2 : 1;
+        case '&':
+            return second == '&' ? 2 : 0;
+        case '|':
+            return second == '|' ? 2 : 0;
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case '%':
+            return 1;
+        default:
+            return 0;
+    }
+}
 
 char Tokenizer::peek() const {
     if (isAtEnd())
         return '\0';
-    return sourceCode[currentPosition];
+    return source[currentPosition];
 }
 
 char Tokenizer::peek(int offset) const {
     if (offset < 0) {
         for (int i = currentPosition + offset; i >= 0; --i) {
-            if (sourceCode[i] != ' ') 
-                return sourceCode[i];
+            if (source[i] != ' ') 
+                return source[i];
         }
         return '\0';
     }
-    if (currentPosition + offset >= sourceCode.length())
+    if (currentPosition + offset >= sourceLength)
         return '\0';
-    return sourceCode[currentPosition + offset];
+    return source[currentPosition + offset];
 }
 
 
 char Tokenizer::advance() {
     if (!isAtEnd())
         currentPosition++;
-    return sourceCode[currentPosition - 1];
+    return source[currentPosition - 1];
 }
 
 bool Tokenizer::isAtEnd() const {
-    return currentPosition >= sourceCode.length();
+    return currentPosition >= sourceLength;
 }
 
 bool Tokenizer::match(char expected) {
     if (isAtEnd())
         return false;
-    if (sourceCode[currentPosition] != expected)
+    if (source[currentPosition] != expected)
         return false;
     currentPosition++;
     return true;
@@ -69,12 +110,35 @@ void Tokenizer::skipComment() {
     }
 }
 
+Token Tokenizer::makeToken(TokenType type, std::size_t start) const {
+    Token token;
+    token.type = type;
+    token.lexeme = StringView(source + start, currentPosition - start);
+    token.symbol = NO_SYMBOL;
+    token.offset = start;
+    return token;
+}
+
+SourceLocation Tokenizer::locate(std::size_t position) {
+    for (; locatedPosition < position; locatedPosition++) {
+        if (source[locatedPosition] == '\n') {
+            locatedLine++;
+            locatedLineStart = locatedPosition + 1;
+        }
+    }
+
+    SourceLocation location;
+    location.line = (uint16_t)locatedLine;
+    location.column = (uint16_t)(position - locatedLineStart + 1);
+    return location;
+}
+
 Token Tokenizer::parseToken() {
     skipWhitespace();
     skipComment();
 
     if (isAtEnd())
-        return {TokenType::UNKNOWN, ""};
+        return makeToken(TokenType::UNKNOWN, currentPosition);
 
     char currentChar = peek();
     if (std::isalpha(currentChar))
@@ -84,144 +148,161 @@ Token Tokenizer::parseToken() {
     // Except when the previous token is a number or decimal point or variable or closing parenthesis
     char previousChar = peek(-1);
     if (currentChar == '-' && (std::isdigit(peek(1)) || (peek(1) == '.' && std::isdigit(peek(2)))) && !std::isdigit(previousChar) && previousChar != '.' && !std::isalpha(previousChar) && previousChar != ')') {
+        std::size_t start = currentPosition;
         advance();  // Consume '-'
-        return parseNumber(true);
+        return parseNumber(start);
     }
 
     if (std::isdigit(currentChar) || (currentChar == '.' && std::isdigit(peek(1))))
-        return parseNumber(false);
+        return parseNumber(currentPosition);
 
     // Check for operators
-
-    // Handle dual character operators
-
-    if (doubleCharOperators.find(std::string(1, currentChar) + peek(1)) != doubleCharOperators.end())
-        return parseOperator();
-    if (singleCharOperators.find(currentChar) != singleCharOperators.end())
+    if (operatorLength(currentChar, peek(1)) != 0)
         return parseOperator();
 
-    if (currentChar == ';') {
-        advance();
-        return {TokenType::SEMICOLON, ";"};
-    }
-
-    if (currentChar == '(') {
-        advance();
-        return {TokenType::LEFT_PARENTHESIS, "("};
-    }
-
-    if (currentChar == ')') {
-        advance();
-        return {TokenType::RIGHT_PARENTHESIS, ")"};
-    }
-
-    if (currentChar == '{') {
-        advance();
-        return {TokenType::LEFT_BRACE, "{"};
-    }
-
-    if (currentChar == '}') {
-        advance();
-        return {TokenType::RIGHT_BRACE, "}"};
-    }
-
-    if (currentChar == ',') {
-        advance();
-        return {TokenType::COMMA, ","};
+    std::size_t start = currentPosition;
+    advance();
+
+    switch (currentChar) {
+        case ';':
+            return makeToken(TokenType::SEMICOLON, start);
+        case '(':
+            return makeToken(TokenType::LEFT_PARENTHESIS, start);
+        case ')':
+            return makeToken(TokenType::RIGHT_PARENTHESIS, start);
+        case '{':
+            return makeToken(TokenType::LEFT_BRACE, start);
+        case '}':
+            return makeToken(TokenType::RIGHT_BRACE, start);
+        case ',':
+            return makeToken(TokenType::COMMA, start);
+        default:
+            // Unrecognized character, already consumed
+            return makeToken(TokenType::UNKNOWN, start);
     }
-
-    advance();  // Consume unrecognized character
-    return {TokenType::UNKNOWN, std::string(1, currentChar)};
 }
 
 Token Tokenizer::parseKeywordOrIdentifier() {
-    std::string lexeme;
+    std::size_t start = currentPosition;
     while (std::isalnum(peek()) || peek() == '_') {
-        lexeme += advance();
+        advance();
     }
 
+    Token token = makeToken(TokenType::IDENTIFIER, start);
+
     // Check if lexeme is a keyword
-    if (keywords.find(lexeme) != keywords.end()) {
-        return {TokenType::KEYWORD, lexeme};
+    // Identifiers are interned by tokenizeInto, once it is sure the lexeme is whole
+    if (isKeyword(token.lexeme)) {
+        token.type = TokenType::KEYWORD;
     }
 
-    return {TokenType::IDENTIFIER, lexeme};
+    return token;
 }
 
-Token Tokenizer::parseNumber(bool isNegative) {
-    std::string lexeme;
+Token Tokenizer::parseNumber(std::size_t start) {
     while (std::isdigit(peek())) {
-        lexeme += advance();
+        advance();
     }
 
     if (peek() == '.' && std::isdigit(peek(1))) {
-        lexeme += advance();  // Consume '.'
+        advance();  // Consume '.'
         while (std::isdigit(peek())) {
-            lexeme += advance();
-        }
-        if (isNegative) {
-            return {TokenType::FLOAT, "-" + lexeme};
+            advance();
         }
-        return {TokenType::FLOAT, lexeme};
-    }
-
-    if (isNegative) {
-        return {TokenType::INTEGER, "-" + lexeme};
+        return makeToken(TokenType::FLOAT, start);
     }
 
-    return {TokenType::INTEGER, lexeme};
+    return makeToken(TokenType::INTEGER, start);
 }
 
 Token Tokenizer::parseOperator() {
-    std::string lexeme;
+    std::size_t start = currentPosition;
+    std::size_t length = operatorLength(peek(), peek(1));
 
-    if (doubleCharOperators.find(std::string(1, peek()) + peek(1)) != doubleCharOperators.end()) {
-        lexeme += advance();
-        lexeme += advance();
+    // If nothing is an operator, return unknown
+    if (length == 0) {
+        return makeToken(TokenType::UNKNOWN, start);
     }
 
-    else if (singleCharOperators.find(peek()) != singleCharOperators.end()) {
-        lexeme += advance();
-    }
+    currentPosition += length;
+    return makeToken(TokenType::OPERATOR, start);
+}
 
-    else if (peek() == '(' || peek() == ')') {
-        lexeme += advance();
-        return {TokenType::OPERATOR, lexeme};
-    }
+Token Tokenizer::parseUnknown() {
+    // Consume and return the unknown character
+    std::size_t start = currentPosition;
+    advance();
+    return makeToken(TokenType::UNKNOWN, start);
+}
 
-    else if (peek() == '{' || peek() == '}') {
-        lexeme += advance();
-        return {TokenType::OPERATOR, lexeme};
-    }
+void Tokenizer::tokenizeInto(std::vector<Token>& tokens, std::size_t margin) {
+    while (!isAtEnd()) {
+        std::size_t start = currentPosition;
+        Token token = parseToken();
 
-    // If nothing is in lexeme, return unknown
-    if (lexeme == "") {
-        return {TokenType::UNKNOWN, lexeme};
-    }
+        // Ex. "1" could be "1.5" and "/" could be a comment, so wait for what follows
+        if (currentPosition + margin > sourceLength) {
+            currentPosition = start;
+            return;
+        }
 
-    return {TokenType::OPERATOR, lexeme};
-}
+        if (token.type == TokenType::UNKNOWN) {
+            continue;
+        }
 
-Token Tokenizer::parseUnknown() {
-    // Consume and return the unknown character
-    return {TokenType::UNKNOWN, std::string(1, advance())};
+        // Identifiers are interned here so everything after the tokenizer compares symbols
+        if (token.type == TokenType::IDENTIFIER) {
+            token.symbol = symbolTable.intern(token.lexeme);
+        }
+
+        token.location = locate(token.offset);
+        tokens.push_back(token);
+    }
 }
 
 std::vector<Token> Tokenizer::tokenize() {
-    if (sourceCode == "") {
+    ALLOCATION_PHASE(AllocationPhase::TOKENIZE);
+
+    if (sourceLength == 0) {
         return {};
     }
 
     std::vector<Token> tokens;
+    tokenizeInto(tokens, 0);
 
-    while (!isAtEnd()) {
-        Token token = parseToken();
-        if (token.type != TokenType::UNKNOWN) {
-            tokens.push_back(token);
+    return tokens;
+}
+
+void Tokenizer::feed(const char* chunk, std::size_t length) {
+    ALLOCATION_PHASE(AllocationPhase::TOKENIZE);
+
+    ownedSource.append(chunk, length);
+
+    // Appending may have moved the source, the lexemes read so far have to follow it
+    if (ownedSource.data() != source) {
+        source = ownedSource.data();
+        for (Token& token : streamedTokens) {
+            token.lexeme = StringView(source + token.offset, token.lexeme.size());
         }
     }
+    sourceLength = ownedSource.size();
 
-    return tokens;
+    // Two characters is the most lookahead past the end of a token, Ex. "5." needs the digit after the '.'
+    tokenizeInto(streamedTokens, 2);
+}
+
+void Tokenizer::finish() {
+    ALLOCATION_PHASE(AllocationPhase::TOKENIZE);
+
+    tokenizeInto(streamedTokens, 0);
+}
+
+const std::vector<Token>& Tokenizer::getTokens() const {
+    return streamedTokens;
+}
+
+const std::string& Tokenizer::getSource() const {
+    return ownedSource;
 }
 
 std::string Tokenizer::tokenTypeToString(TokenType tokenType) {
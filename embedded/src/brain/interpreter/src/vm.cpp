@@ -0,0 +1,543 @@
+#include "vm.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "allocationCounter.hpp"
+#include "compiler.hpp"
+#include "error.hpp"
+#include "flags.h"
+
+#if __EMBEDDED__
+#include "freertos/FreeRTOS.h"
+#endif
+
+// Binary operations replace the two operands on top of the stack with the result
+#define BINARY_INT(expression)     \
+    {                              \
+        int32_t right = (--sp)->i; \
+        int32_t left = sp[-1].i;   \
+        sp[-1].i = (expression);   \
+        break;                     \
+    }
+
+#define BINARY_FLOAT(expression)   \
+    {                              \
+        float right = (--sp)->f;   \
+        float left = sp[-1].f;     \
+        sp[-1].f = (expression);   \
+        break;                     \
+    }
+
+#define COMPARE_FLOAT(expression)  \
+    {                              \
+        float right = (--sp)->f;   \
+        float left = sp[-1].f;     \
+        sp[-1].i = (expression);   \
+        break;                     \
+    }
+
+VirtualMachine::VirtualMachine(BlockNode& ast, OutputStream& outputStream, ErrorHandler& errorHandler)
+    : program(nullptr), outputStream(outputStream), errorHandler(errorHandler), radioFormatter(nullptr) {
+    compile(ast);
+}
+
+VirtualMachine::VirtualMachine(BlockNode& ast, OutputStream& outputStream, ErrorHandler& errorHandler, RadioFormatter& radioFormatter)
+    : program(nullptr), outputStream(outputStream), errorHandler(errorHandler), radioFormatter(&radioFormatter) {
+    compile(ast);
+}
+
+VirtualMachine::VirtualMachine(Program* program, OutputStream& outputStream, ErrorHandler& errorHandler)
+    : program(program), outputStream(outputStream), errorHandler(errorHandler), radioFormatter(nullptr) {
+    prepare();
+}
+
+VirtualMachine::VirtualMachine(Program* program, OutputStream& outputStream, ErrorHandler& errorHandler, RadioFormatter& radioFormatter)
+    : program(program), outputStream(outputStream), errorHandler(errorHandler), radioFormatter(&radioFormatter) {
+    prepare();
+}
+
+VirtualMachine::~VirtualMachine() {
+    delete program;
+}
+
+const Program* VirtualMachine::getProgram() const {
+    return program;
+}
+
+void VirtualMachine::compile(BlockNode& ast) {
+    if (errorHandler.shouldStopExecution()) {
+        return;
+    }
+
+    ALLOCATION_PHASE(AllocationPhase::COMPILE);
+
+    Compiler compiler(outputStream, errorHandler);
+    program = compiler.compile(ast);
+
+    prepare();
+}
+
+void VirtualMachine::prepare() {
+    if (program == nullptr) {
+        return;
+    }
+
+    // Everything the VM needs is allocated once up front
+    stack.resize(VM_STACK_SIZE);
+    frames.reserve(VM_MAX_CALL_DEPTH);
+    display.resize(program->maxLevel + 1);
+}
+
+void VirtualMachine::runtimeError(size_t instruction, const std::string& message) const {
+    errorHandler.handleError("Runtime Error: " + message, locationOf(instruction));
+}
+
+SourceLocation VirtualMachine::locationOf(size_t instruction) const {
+    // The last span starting at or before the instruction, only looked up once something has gone wrong
+    const std::vector<SourceSpan>& locations = program->locations;
+    auto span = std::upper_bound(locations.begin(), locations.end(), instruction,
+                                 [](size_t index, const SourceSpan& span) { return index < span.firstInstruction; });
+
+    if (span == locations.begin()) {
+        SourceLocation unknown = {0, 0};
+        return unknown;
+    }
+
+    return (span - 1)->location;
+}
+
+void VirtualMachine::interpret() {
+    if (program == nullptr || errorHandler.shouldStopExecution()) {
+        return;
+    }
+
+    ALLOCATION_PHASE(AllocationPhase::INTERPRET);
+
+    const Instruction* code = program->code.data();
+    const FunctionInfo* functions = program->functions.data();
+
+    const FunctionInfo& main = functions[0];
+    if (main.numSlots + main.maxStackDepth > VM_STACK_SIZE) {
+        runtimeError(main.entry, "Stack overflow");
+        return;
+    }
+
+    Slot* stackBottom = stack.data();
+    Slot* stackTop = stackBottom + VM_STACK_SIZE;
+
+    // The top level program's variables are the bottom of the stack
+    Slot* fp = stackBottom;
+    Slot* sp = fp + main.numSlots;
+    std::fill(fp, sp, Slot{0});
+
+    frames.clear();
+    std::fill(display.begin(), display.end(), nullptr);
+    display[0] = fp;
+
+    int currentFunction = 0;
+    size_t pc = main.entry;
+
+    resetBudget();
+
+    while (true) {
+        const Instruction& instruction = code[pc++];
+
+        switch (instruction.op) {
+            case OpCode::PUSH_INT:
+                (sp++)->i = instruction.operand;
+                break;
+
+            case OpCode::PUSH_FLOAT:
+                // The operand holds the float's bits
+                (sp++)->i = instruction.operand;
+                break;
+
+            case OpCode::POP:
+                sp--;
+                break;
+
+            case OpCode::LOAD_LOCAL:
+                *(sp++) = fp[instruction.operand];
+                break;
+
+            case OpCode::STORE_LOCAL:
+                fp[instruction.operand] = *(--sp);
+                break;
+
+            case OpCode::LOAD_OUTER:
+                *(sp++) = display[instruction.operand >> 16][instruction.operand & 0xFFFF];
+                break;
+
+            case OpCode::STORE_OUTER:
+                display[instruction.operand >> 16][instruction.operand & 0xFFFF] = *(--sp);
+                break;
+
+            case OpCode::INT_TO_FLOAT:
+                sp[-1].f = (float)sp[-1].i;
+                break;
+
+            case OpCode::FLOAT_TO_INT:
+                sp[-1].i = (int32_t)sp[-1].f;
+                break;
+
+            case OpCode::FLOAT_TRUTHY:
+                sp[-1].i = sp[-1].f != 0;
+                break;
+
+            // Integer arithmetic wraps instead of overflowing
+            case OpCode::ADD_INT:
+                BINARY_INT((int32_t)((uint32_t)left + (uint32_t)right))
+            case OpCode::SUB_INT:
+                BINARY_INT((int32_t)((uint32_t)left - (uint32_t)right))
+            case OpCode::MUL_INT:
+                BINARY_INT((int32_t)((uint32_t)left * (uint32_t)right))
+
+            case OpCode::DIV_INT:
+            case OpCode::MOD_INT: {
+                int32_t right = (--sp)->i;
+                int32_t left = sp[-1].i;
+
+                if (right == 0) {
+                    runtimeError(pc - 1, "Division by zero");
+                    return;
+                }
+
+                // INT_MIN / -1 would trap
+                if (right == -1) {
+                    sp[-1].i = instruction.op == OpCode::DIV_INT ? (int32_t)(0u - (uint32_t)left) : 0;
+                } else {
+                    sp[-1].i = instruction.op == OpCode::DIV_INT ? left / right : left % right;
+                }
+                break;
+            }
+
+            case OpCode::GREATER_INT:
+                BINARY_INT(left > right)
+            case OpCode::LESS_INT:
+                BINARY_INT(left < right)
+            case OpCode::GREATER_EQUAL_INT:
+                BINARY_INT(left >= right)
+            case OpCode::LESS_EQUAL_INT:
+                BINARY_INT(left <= right)
+            case OpCode::EQUAL_INT:
+                BINARY_INT(left == right)
+            case OpCode::NOT_EQUAL_INT:
+                BINARY_INT(left != right)
+
+            case OpCode::ADD_FLOAT:
+                BINARY_FLOAT(left + right)
+            case OpCode::SUB_FLOAT:
+                BINARY_FLOAT(left - right)
+            case OpCode::MUL_FLOAT:
+                BINARY_FLOAT(left * right)
+
+            case OpCode::DIV_FLOAT: {
+                float right = (--sp)->f;
+                float left = sp[-1].f;
+
+                if (right == 0) {
+                    runtimeError(pc - 1, "Division by zero");
+                    return;
+                }
+
+                sp[-1].f = left / right;
+                break;
+            }
+
+            case OpCode::MOD_FLOAT: {
+                float right = (--sp)->f;
+                float left = sp[-1].f;
+
+                // The operands are truncated, so anything in (-1, 1) is a zero divisor as well
+                if ((int32_t)right == 0) {
+                    runtimeError(pc - 1, "Division by zero");
+                    return;
+                }
+
+                sp[-1].i = (int32_t)left % (int32_t)right;
+                break;
+            }
+
+            case OpCode::GREATER_FLOAT:
+                COMPARE_FLOAT(left > right)
+            case OpCode::LESS_FLOAT:
+                COMPARE_FLOAT(left < right)
+            case OpCode::GREATER_EQUAL_FLOAT:
+                COMPARE_FLOAT(left >= right)
+            case OpCode::LESS_EQUAL_FLOAT:
+                COMPARE_FLOAT(left <= right)
+            case OpCode::EQUAL_FLOAT:
+                COMPARE_FLOAT(left == right)
+            case OpCode::NOT_EQUAL_FLOAT:
+                COMPARE_FLOAT(left != right)
+
+            case OpCode::AND:
+                BINARY_INT(left && right)
+            case OpCode::OR:
+                BINARY_INT(left || right)
+
+            case OpCode::JUMP:
+                pc = instruction.operand;
+                break;
+
+            case OpCode::JUMP_IF_FALSE:
+                if ((--sp)->i == 0) {
+                    pc = instruction.operand;
+                }
+                break;
+
+            case OpCode::LOOP:
+                pc = instruction.operand;
+
+                // Every loop iteration passes through here, so this is where uploads and errors stop us
+                checkBudget();
+
+                if (errorHandler.shouldStopExecution()) {
+                    return;
+                }
+                break;
+
+            case OpCode::CALL: {
+                const FunctionInfo& function = functions[instruction.operand];
+
+                // The arguments already on the stack become the first slots of the new frame
+                Slot* newFramePointer = sp - function.numParameters;
+
+                if (frames.size() >= VM_MAX_CALL_DEPTH || newFramePointer + function.numSlots + function.maxStackDepth > stackTop) {
+                    runtimeError(pc - 1, "Stack overflow in call to " + function.name);
+                    return;
+                }
+
+                // Recursion can run for long without looping, so calls count against the budget too
+                checkBudget();
+
+                if (errorHandler.shouldStopExecution()) {
+                    return;
+                }
+
+                frames.push_back({pc, fp, currentFunction, display[function.level]});
+
+                sp = newFramePointer + function.numSlots;
+                std::fill(newFramePointer + function.numParameters, sp, Slot{0});
+
+                fp = newFramePointer;
+                display[function.level] = fp;
+                currentFunction = instruction.operand;
+                pc = function.entry;
+                break;
+            }
+
+            case OpCode::CALL_BUILTIN:
+                if (!callBuiltin((Builtin)instruction.operand, sp, pc - 1)) {
+                    return;
+                }
+                break;
+
+            case OpCode::RETURN: {
+                Slot result = *(--sp);
+                CallFrame frame = frames.back();
+                frames.pop_back();
+
+                display[functions[currentFunction].level] = frame.savedDisplay;
+
+                // Drop the callee's frame and hand the result to the caller in place of the arguments
+                sp = fp;
+                *(sp++) = result;
+
+                fp = frame.framePointer;
+                currentFunction = frame.function;
+                pc = frame.returnAddress;
+                break;
+            }
+
+            case OpCode::HALT:
+                return;
+        }
+    }
+}
+
+bool VirtualMachine::callBuiltin(Builtin builtin, Slot*& sp, size_t instruction) {
+    switch (builtin) {
+        case Builtin::PRINT_INT:
+            outputStream.write(PRINT_FLAG + std::to_string(sp[-1].i) + "\n" + PRINT_FLAG);
+            sp[-1].i = 0;
+            return true;
+
+        case Builtin::PRINT_FLOAT:
+            outputStream.write(PRINT_FLAG + std::to_string(sp[-1].f) + "\n" + PRINT_FLAG);
+            sp[-1].i = 0;
+            return true;
+
+        case Builtin::WAIT: {
+            int value = sp[-1].i;
+
+            if (value < 0) {
+                runtimeError(instruction, "wait() takes a non-negative integer argument");
+                return false;
+            }
+
+#if __EMBEDDED__
+            vTaskDelay(value / portTICK_PERIOD_MS);
+#else
+            std::this_thread::sleep_for(std::chrono::milliseconds(value));
+#endif
+
+            // Waiting already let other tasks run, so the slice starts over
+            resetBudget();
+
+            sp[-1].i = 0;
+            return true;
+        }
+
+        case Builtin::RAND:
+            (sp++)->f = (float)rand() / RAND_MAX;
+            return true;
+
+        case Builtin::FLOAT_TO_INT:
+            sp[-1].i = (int32_t)sp[-1].f;
+            return true;
+
+        case Builtin::INT_TO_FLOAT:
+            sp[-1].f = (float)sp[-1].i;
+            return true;
+
+        case Builtin::RUNTIME:
+            (sp++)->i = (int)round((double)clock() / CLOCKS_PER_SEC * 1000);
+            return true;
+
+        case Builtin::POW:
+            sp--;
+            sp[-1].f = pow(sp[-1].f, sp[0].f);
+            return true;
+
+        case Builtin::PI_VALUE:
+            (sp++)->f = PI;
+            return true;
+
+        case Builtin::EXP:
+            sp[-1].f = exp(sp[-1].f);
+            return true;
+
+        case Builtin::SIN:
+            sp[-1].f = sin(sp[-1].f);
+            return true;
+
+        case Builtin::COS:
+            sp[-1].f = cos(sp[-1].f);
+            return true;
+
+        case Builtin::TAN:
+            sp[-1].f = tan(sp[-1].f);
+            return true;
+
+        case Builtin::ASIN:
+            if (sp[-1].f < -1 || sp[-1].f > 1) {
+                runtimeError(instruction, "asin() takes an argument between -1 and 1");
+                return false;
+            }
+            sp[-1].f = asin(sp[-1].f);
+            return true;
+
+        case Builtin::ACOS:
+            if (sp[-1].f < -1 || sp[-1].f > 1) {
+                runtimeError(instruction, "acos() takes an argument between -1 and 1");
+                return false;
+            }
+            sp[-1].f = acos(sp[-1].f);
+            return true;
+
+        case Builtin::ATAN:
+            sp[-1].f = atan(sp[-1].f);
+            return true;
+
+        case Builtin::ATAN2:
+            sp--;
+            sp[-1].f = atan2(sp[-1].f, sp[0].f);
+            return true;
+
+        case Builtin::SQRT:
+            if (sp[-1].f < 0) {
+                runtimeError(instruction, "sqrt() takes a positive argument");
+                return false;
+            }
+            sp[-1].f = sqrt(sp[-1].f);
+            return true;
+
+        case Builtin::ABS:
+            sp[-1].f = fabs(sp[-1].f);
+            return true;
+
+        case Builtin::FLOOR:
+            sp[-1].f = floor(sp[-1].f);
+            return true;
+
+        case Builtin::CEIL:
+            sp[-1].f = ceil(sp[-1].f);
+            return true;
+
+        case Builtin::MIN:
+            sp--;
+            sp[-1].f = std::min(sp[-1].f, sp[0].f);
+            return true;
+
+        case Builtin::MAX:
+            sp--;
+            sp[-1].f = std::max(sp[-1].f, sp[0].f);
+            return true;
+
+        case Builtin::LOG:
+            if (sp[-1].f < 0) {
+                runtimeError(instruction, "log() takes a positive argument");
+                return false;
+            }
+            sp[-1].f = log(sp[-1].f);
+            return true;
+
+        case Builtin::LOG10:
+            if (sp[-1].f < 0) {
+                runtimeError(instruction, "log10() takes a positive argument");
+                return false;
+            }
+            sp[-1].f = log10(sp[-1].f);
+            return true;
+
+        case Builtin::LOG2:
+            if (sp[-1].f < 0) {
+                runtimeError(instruction, "log2() takes a positive argument");
+                return false;
+            }
+            sp[-1].f = log2(sp[-1].f);
+            return true;
+
+        case Builtin::ROUND: {
+            sp--;
+            float factor = pow(10, sp[0].f);
+            sp[-1].f = round(sp[-1].f * factor) / factor;
+            return true;
+        }
+
+        case Builtin::SEND_BOOL: {
+            sp--;
+            bool value = sp[0].i != 0;
+            int tileIdx = sp[-1].i;
+
+// Send the data command over radio
+#if __EMBEDDED__
+            radioFormatter->send_bool(tileIdx, value);
+            sp[-1].i = 0;
+            return true;
+#else
+            (void)value;
+            (void)tileIdx;
+            runtimeError(instruction, "send_bool() is only available in embedded mode");
+            return false;
+#endif
+        }
+    }
+
+    runtimeError(instruction, "Unknown builtin function");
+    return false;
+}
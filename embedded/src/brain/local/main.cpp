@@ -5,6 +5,7 @@
 #include "ast.hpp"
 #include "error.hpp"
 #include "interpreter.hpp"
+#include "optimizer.hpp"
 #include "outputStream.hpp"
 #include "tokenizer.hpp"
 
@@ -22,7 +23,7 @@ int main() {
     // Create a Tokenizer object
     // No error handling is done here as the tokenizer is not supposed to fail
     // Therefore, we do not need to pass the ErrorHandler object to the Tokenizer constructor
-    Tokenizer tokenizer(sourceCode);
+    Tokenizer tokenizer(sourceCode.data(), sourceCode.size());
 
     // Tokenize the source code
     const std::vector<Token> tokens = tokenizer.tokenize();
@@ -43,6 +44,9 @@ int main() {
 
     // Create an Interpreter object
     if (block != nullptr) {
+        Optimizer optimizer;
+        optimizer.optimize(*block);
+
         std::cout << block->toString() << std::endl;
 
          Interpreter interpreter(*block, outputStream, errorHandler);
@@ -50,8 +54,11 @@ int main() {
         // Interpret the AST
         interpreter.interpret();
 
-        delete block;
+        std::cout << "AST arena: " << astArena.getBytesUsed() << " bytes in " << astArena.getAllocationCount() << " allocations" << std::endl;
     }
+
+    // Free the whole program at once
+    astArena.reset();
    
 
     std::cout << std::endl;
@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <mutex>
 
+#include "allocationCounter.hpp"
 #include "ast.hpp"
 #include "ble.h"
 #include "error.hpp"
@@ -11,13 +13,30 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_timer.h"
+#include "nvs.h"
 
 #include "interpreter.hpp"
+#include "optimizer.hpp"
 #include "outputStream.hpp"
+#include "profiler.hpp"
+#include "programCache.hpp"
 #include "radio.h"
 #include "radioFormatter.hpp"
+#include "scriptStream.hpp"
 #include "tile_types.h"
 #include "tokenizer.hpp"
+#include "trace.hpp"
+#include "vm.hpp"
+
+// 1 to run scripts on the bytecode VM, 0 to walk the AST with the Interpreter
+#define USE_BYTECODE_VM 1
+
+// 1 to time every statement and send the hot spots to the web app after each run
+#define PROFILE_SCRIPTS 0
+
+#if PROFILE_SCRIPTS && USE_BYTECODE_VM
+#error "PROFILE_SCRIPTS needs the tree-walking Interpreter, set USE_BYTECODE_VM to 0"
+#endif
 
 std::mutex script_mutex;
 std::mutex tile_mutex;
@@ -70,24 +89,54 @@ class BLEOutputStream : public OutputStream {
 
 BLEOutputStream outputStream;
 ErrorHandler errorHandler(outputStream);
-Interpreter* interpreter = nullptr;
+Executor* interpreter = nullptr;
+
+// Kept across runs of the same program, so each report covers every run since the upload
+Profiler profiler;
 BlockNode* block = nullptr;
 RadioFormatter radioFormatter;
 
-void generate_ast() {
+// Keeps cache slot i in the NVS blob "program<i>", NVS is set up by ble_init
+class NvsProgramCacheStorage : public ProgramCacheStorage {
+   public:
+    bool read(uint32_t slot, std::string& entry) override {
+        nvs_handle_t handle;
+        if (nvs_open("brain", NVS_READONLY, &handle) != ESP_OK) {
+            return false;
+        }
 
-    // Yield to other tasks and let the interpreter stop
-    vTaskDelay(50 / portTICK_PERIOD_MS);
+        std::string key = "program" + std::to_string(slot);
+        size_t length = 0;
+        bool found = nvs_get_blob(handle, key.c_str(), nullptr, &length) == ESP_OK;
+        if (found) {
+            entry.resize(length);
+            found = nvs_get_blob(handle, key.c_str(), &entry[0], &length) == ESP_OK;
+        }
+
+        nvs_close(handle);
+        return found;
+    }
 
-    printf("Generating AST\n");
-    //print the error message
-    printf("Error message: %d\n", errorHandler.shouldStopExecution());
+    bool write(uint32_t slot, const std::string& entry) override {
+        nvs_handle_t handle;
+        if (nvs_open("brain", NVS_READWRITE, &handle) != ESP_OK) {
+            return false;
+        }
 
-    // Problem because we need to not have execution stopped to not throw error from the ast
-    // however, we do want to stop execution if we are reuploading code
+        std::string key = "program" + std::to_string(slot);
+        bool written = nvs_set_blob(handle, key.c_str(), entry.data(), entry.size()) == ESP_OK && nvs_commit(handle) == ESP_OK;
 
-    std::lock_guard<std::mutex> lock(interpreter_mutex);
+        nvs_close(handle);
+        return written;
+    }
+};
+
+// Compiled programs by the hash of their source, so a reboot or an identical upload does not compile again
+NvsProgramCacheStorage program_cache_storage;
+ProgramCache program_cache(program_cache_storage);
 
+// Stops the running program and frees it, the caller holds interpreter_mutex
+void clear_program() {
     errorHandler.resetStopExecution();
 
     if (interpreter != nullptr) {
@@ -95,23 +144,118 @@ void generate_ast() {
         interpreter = nullptr;
     }
 
-    printf("Deleting block\n");
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Deleting block\n");
+
+    // Frees every node of the old program at once
+    block = nullptr;
+    astArena.reset();
+
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Deleted block\n");
+
+    // Nothing refers to the old program's identifiers anymore
+    symbolTable.clear();
+
+    profiler.reset();
+
+    // So the next upload's allocations are reported on their own
+    allocationCounter.reset();
+}
+
+// Runs the program compiled from the source with this hash before, if it is still cached
+// Returns false if it is not, the caller holds interpreter_mutex
+bool start_cached_program(uint64_t source_hash) {
+#if USE_BYTECODE_VM
+    Program* program = program_cache.loadByHash(source_hash);
+    if (program == nullptr) {
+        return false;
+    }
+
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Running cached program of %u instructions\n", (unsigned)program->code.size());
+
+    interpreter = new VirtualMachine(program, outputStream, errorHandler, radioFormatter);
+    return true;
+#else
+    // Only bytecode is cached
+    return false;
+#endif
+}
+
+// Hands a freshly parsed block to an engine, the caller holds interpreter_mutex
+// What it compiles to is cached under source_hash
+void start_program(uint64_t source_hash) {
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Error message: %d\n", errorHandler.shouldStopExecution());
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Does block exist: %d\n", block != nullptr);
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "AST arena: %u bytes in %u allocations, %u bytes reserved in %u chunks\n", (unsigned)astArena.getBytesUsed(),
+          (unsigned)astArena.getAllocationCount(), (unsigned)astArena.getBytesReserved(), (unsigned)astArena.getChunkCount());
+
+    if (AllocationCounter::isEnabled()) {
+        TRACE(TRACE_INFO, TRACE_UPLOAD, "Heap allocations: %u tokenizing, %u parsing, %u bytes live\n",
+              (unsigned)allocationCounter.getPhase(AllocationPhase::TOKENIZE).allocations, (unsigned)allocationCounter.getPhase(AllocationPhase::PARSE).allocations,
+              (unsigned)allocationCounter.getLiveBytes());
+    }
+
+    if (block == nullptr) {
+        return;
+    }
 
-    if (block != nullptr) {
-        delete block;
-        block = nullptr;
+    // Fold constants once rather than on every evaluation
+    Optimizer optimizer;
+    optimizer.optimize(*block);
+
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Creating interpreter\n");
+
+    // Create the engine that runs the script
+#if USE_BYTECODE_VM
+    VirtualMachine* vm = new VirtualMachine(*block, outputStream, errorHandler, radioFormatter);
+    if (vm->getProgram() != nullptr && !program_cache.storeByHash(source_hash, *vm->getProgram())) {
+        TRACE(TRACE_INFO, TRACE_UPLOAD, "Could not cache the program\n");
     }
+    interpreter = vm;
+#else
+    Interpreter* treeWalker = new Interpreter(*block, outputStream, errorHandler, radioFormatter);
+#if PROFILE_SCRIPTS
+    treeWalker->setProfiler(&profiler);
+#endif
+    interpreter = treeWalker;
+#endif
+
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "AST generated\n");
+}
 
-    printf("Deleted block\n");
+void generate_ast() {
 
-    Tokenizer tokenizer(get_script());
+    // Yield to other tasks and let the interpreter stop
+    vTaskDelay(50 / portTICK_PERIOD_MS);
+
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Generating AST\n");
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Error message: %d\n", errorHandler.shouldStopExecution());
+
+    // Problem because we need to not have execution stopped to not throw error from the ast
+    // however, we do want to stop execution if we are reuploading code
+
+    std::lock_guard<std::mutex> lock(interpreter_mutex);
+
+    clear_program();
+
+    // Copied out from under the mutex once, the tokenizer borrows this copy rather than making another
+    std::string source = get_script();
+    uint64_t source_hash = ProgramCache::hashSource(source.data(), source.size());
+
+    // Ex. the default script on every boot after the first
+    if (start_cached_program(source_hash)) {
+        return;
+    }
+
+    Tokenizer tokenizer(source.data(), source.size());
 
     const std::vector<Token> tokens = tokenizer.tokenize();
 
-    printf("Tokens: ");
+    if (TRACE_ENABLED(TRACE_DEBUG, TRACE_UPLOAD)) {
+        TRACE(TRACE_DEBUG, TRACE_UPLOAD, "Tokens:\n");
 
-    for (auto token : tokens) {
-        std::cout << Tokenizer::tokenTypeToString(token.type) << " " << token.lexeme << std::endl;
+        for (const Token& token : tokens) {
+            TRACE(TRACE_DEBUG, TRACE_UPLOAD, "%s %.*s\n", Tokenizer::tokenTypeToString(token.type).c_str(), (int)token.lexeme.size(), token.lexeme.data());
+        }
     }
 
     if (tokens.empty()) {
@@ -121,52 +265,111 @@ void generate_ast() {
     // Create a Parser object
     Parser parser(tokens, outputStream, errorHandler);
 
-    printf("Parsing program\n");
-    printf("Error message: %d\n", errorHandler.shouldStopExecution());
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Parsing program\n");
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Error message: %d\n", errorHandler.shouldStopExecution());
 
     // Parse the source code
     block = parser.parseProgram();
 
-    printf("Program parsed\n");
-    printf("Error message: %d\n", errorHandler.shouldStopExecution());
-    printf("Does block exist: %d\n", block != nullptr);
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Program parsed\n");
 
-    if (block == nullptr) {
-        return;
-    }
+    start_program(source_hash);
+}
 
-    printf("Creating interpreter\n");
+// An upload is __SD__<script>__SD__, split over as many writes as BLE needs
+// The script is tokenized and parsed as the writes arrive, so only its tail is left once the last one does
+ScriptStream* script_stream = nullptr;
 
+// The last bytes received, held back in case they are the start of the closing flag
+std::string script_stream_tail;
 
+// Of everything fed to script_stream so far
+uint64_t script_stream_hash;
 
-    // Create an Interpreter object
-    interpreter = new Interpreter(*block, outputStream, errorHandler, radioFormatter);
+void begin_script_stream() {
+    errorHandler.triggerStopExecution();
 
-    printf("AST generated\n");
+    // Yield to other tasks and let the interpreter stop
+    vTaskDelay(50 / portTICK_PERIOD_MS);
+
+    std::lock_guard<std::mutex> lock(interpreter_mutex);
+
+    delete script_stream;
+    clear_program();
+
+    script_stream = new ScriptStream(outputStream, errorHandler);
+    script_stream_tail.clear();
+    script_stream_hash = SOURCE_HASH_SEED;
 }
 
-void set_script(const std::string& s) {
+// Returns true once the closing flag arrived and the program was handed to an engine
+bool feed_script_stream(const char* data, size_t len) {
+    size_t flag_length = strlen(SEND_SCRIPT_FLAG);
+    script_stream_tail.append(data, len);
+
+    bool complete = script_stream_tail.size() >= flag_length &&
+                    script_stream_tail.compare(script_stream_tail.size() - flag_length, flag_length, SEND_SCRIPT_FLAG) == 0;
+
+    // Everything but what could still turn out to be the closing flag
+    size_t ready = script_stream_tail.size() - std::min(script_stream_tail.size(), flag_length);
+    if (ready > 0) {
+        script_stream->feed(script_stream_tail.data(), ready);
+        script_stream_hash = ProgramCache::hashSource(script_stream_tail.data(), ready, script_stream_hash);
+        script_stream_tail.erase(0, ready);
+    }
+
+    if (!complete) {
+        return false;
+    }
+
     {
-        std::lock_guard<std::mutex> lock(script_mutex);
-        printf("Setting script to: %s\n", s.c_str());
-        script = s;
+        std::lock_guard<std::mutex> lock(interpreter_mutex);
+
+        // The script was parsed as it arrived, but an identical one is not optimized and compiled again
+        if (!start_cached_program(script_stream_hash)) {
+            block = script_stream->finish();
+
+            TRACE(TRACE_INFO, TRACE_UPLOAD, "Program parsed from %u tokens\n", (unsigned)script_stream->getTokenCount());
+
+            start_program(script_stream_hash);
+        }
     }
-    generate_ast();
+
+    // Errors carry their own line and column, so the source is not kept once it is parsed
+    delete script_stream;
+    script_stream = nullptr;
+
+    return true;
 }
 
 // Callback for when a client writes to the characteristic
 void ble_write_cb(char* data, uint16_t len) {
-    if (data && len > 2 * strlen(SEND_SCRIPT_FLAG)) {
-        printf("Received data: %s\n", data);
-        errorHandler.triggerStopExecution();
+    size_t flag_length = strlen(SEND_SCRIPT_FLAG);
 
-        printf("Error status: %d\n", errorHandler.shouldStopExecution());
+    if (data == nullptr) {
+        return;
+    }
 
-        send_string(SENT_SCRIPT_FLAG);
+    bool opening = len >= flag_length && strncmp(data, SEND_SCRIPT_FLAG, flag_length) == 0;
 
-        set_script(std::string(data + strlen(SEND_SCRIPT_FLAG), len - strlen(SEND_SCRIPT_FLAG) * 2));
+    // While an upload is in progress a write that is just the flag closes it, Ex. when the script filled the previous write
+    // Any other write starting with the flag opens a new upload, even if the last one never finished
+    if (script_stream != nullptr && (!opening || len == flag_length)) {
+        feed_script_stream(data, len);
+        return;
+    }
 
+    if (!opening) {
+        return;
     }
+
+    TRACE(TRACE_INFO, TRACE_UPLOAD, "Receiving script\n");
+
+    send_string(SENT_SCRIPT_FLAG);
+
+    begin_script_stream();
+
+    feed_script_stream(data + flag_length, len - flag_length);
 }
 
 void radio_write_cb(char* data, uint16_t len, uint8_t* src_addr) {
@@ -201,13 +404,17 @@ extern "C" void app_main(void) {
 
     while (1) {
 
-        printf("Free heap: %ld\n", esp_get_free_heap_size());
+        TRACE(TRACE_INFO, TRACE_UPLOAD, "Free heap: %ld\n", (long)esp_get_free_heap_size());
 
         // Interpret the AST
         {
             std::lock_guard<std::mutex> lock(interpreter_mutex);
-            if (interpreter != nullptr && block != nullptr && !errorHandler.shouldStopExecution()) {
+            // A cached program runs without a block
+            if (interpreter != nullptr && !errorHandler.shouldStopExecution()) {
                 interpreter->interpret();
+#if PROFILE_SCRIPTS
+                profiler.report(outputStream);
+#endif
             }
         }
         
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "allocationCounter.hpp"
+#include "ast.hpp"
+#include "interpreter.hpp"
+#include "tokenizer.hpp"
+#include "vm.hpp"
+
+// Drops what the program prints, so only the engine's own allocations are counted
+class DiscardingOutputStream : public OutputStream {
+   public:
+    void write(const std::string&) override {}
+};
+
+// Allocations made while interpreting sourceCode, after tokenizing, parsing and creating the engine
+static size_t interpretAllocations(const std::string& sourceCode, bool bytecode) {
+    DiscardingOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    Tokenizer tokenizer(sourceCode);
+    const std::vector<Token> tokens = tokenizer.tokenize();
+    Parser parser(tokens, outputStream, errorHandler);
+    BlockNode* block = parser.parseProgram();
+    EXPECT_NE(block, nullptr) << sourceCode;
+    if (block == nullptr) {
+        return 0;
+    }
+
+    size_t before = allocationCounter.getPhase(AllocationPhase::INTERPRET).allocations;
+
+    if (bytecode) {
+        VirtualMachine vm(*block, outputStream, errorHandler);
+        vm.interpret();
+    } else {
+        Interpreter interpreter(*block, outputStream, errorHandler);
+        interpreter.interpret();
+    }
+
+    EXPECT_FALSE(errorHandler.shouldStopExecution()) << sourceCode;
+
+    return allocationCounter.getPhase(AllocationPhase::INTERPRET).allocations - before;
+}
+
+TEST(AllocationTest, countByPhase)
+{
+    ASSERT_TRUE(AllocationCounter::isEnabled());
+
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+    allocationCounter.reset();
+
+    Tokenizer tokenizer("{ int x = 5; while (x > 0) { x = x - 1; } }");
+    const std::vector<Token> tokens = tokenizer.tokenize();
+    AllocationCounts tokenize = allocationCounter.getPhase(AllocationPhase::TOKENIZE);
+    EXPECT_GT(tokenize.allocations, 0);
+    EXPECT_GT(tokenize.bytes, 0);
+
+    Parser parser(tokens, outputStream, errorHandler);
+    BlockNode* block = parser.parseProgram();
+    ASSERT_NE(block, nullptr);
+    EXPECT_GT(allocationCounter.getPhase(AllocationPhase::PARSE).allocations, 0);
+
+    // Nothing was interpreted, and the phases were left again
+    EXPECT_EQ(allocationCounter.getPhase(AllocationPhase::INTERPRET).allocations, 0);
+    EXPECT_EQ(allocationCounter.getPhase(AllocationPhase::TOKENIZE).allocations, tokenize.allocations);
+
+    AllocationCounts total = allocationCounter.getTotal();
+    EXPECT_GE(total.allocations, tokenize.allocations + allocationCounter.getPhase(AllocationPhase::PARSE).allocations);
+    EXPECT_GE(allocationCounter.getPeakLiveBytes(), allocationCounter.getLiveBytes());
+}
+
+TEST(AllocationTest, noAllocationsPerIteration)
+{
+    std::string loop =
+    "{"
+        "int next(int n) { return n + 1; }"
+        "int n = 0;"
+        "float total = 0.0;"
+        "while (n < LIMIT) {"
+            "n = next(n);"
+            "if (n % 2) { total = total + sqrt(n); } else { continue; }"
+        "}"
+    "}";
+
+    std::string shortLoop = loop;
+    shortLoop.replace(shortLoop.find("LIMIT"), 5, "10");
+    std::string longLoop = loop;
+    longLoop.replace(longLoop.find("LIMIT"), 5, "1000");
+
+    // The first run may set things up for good, Ex. the Interpreter's frame stack
+    for (bool bytecode : {false, true}) {
+        EXPECT_EQ(interpretAllocations(shortLoop, bytecode), interpretAllocations(longLoop, bytecode)) << (bytecode ? "Bytecode" : "TreeWalking");
+    }
+}
+
+TEST(AllocationTest, countByNodeType)
+{
+    allocationCounter.reset();
+
+    // Printing a float builds a string too long to be kept inline, once per call
+    interpretAllocations("{ for (int i = 0; i < 10; i = i + 1) { print(2.5); } }", false);
+
+    EXPECT_GE(allocationCounter.getNodeType(ASTNodeType::FUNCTION_CALL_NODE).allocations, 10);
+    EXPECT_EQ(allocationCounter.getNodeType(ASTNodeType::BINARY_OPERATION_NODE).allocations, 0);
+    EXPECT_STREQ(nodeTypeToString(ASTNodeType::FUNCTION_CALL_NODE), "FUNCTION_CALL_NODE");
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include "tokenizer.hpp"
+#include "ast.hpp"
+#include "arena.hpp"
+
+TEST(ArenaTest, allocateAligned)
+{
+    Arena arena(64);
+
+    char* byte = (char*)arena.allocate(1, 1);
+    double* number = (double*)arena.allocate(sizeof(double), alignof(double));
+    ASSERT_NE(byte, nullptr);
+    EXPECT_EQ((uintptr_t)number % alignof(double), 0);
+
+    // The padding before the double counts as used
+    EXPECT_EQ(arena.getBytesUsed(), alignof(double) + sizeof(double));
+    EXPECT_EQ(arena.getAllocationCount(), 2);
+    EXPECT_EQ(arena.getChunkCount(), 1);
+
+    const char* copy = arena.copyString("hello");
+    EXPECT_STREQ(copy, "hello");
+}
+
+TEST(ArenaTest, growAndReset)
+{
+    Arena arena(64);
+
+    for (int i = 0; i < 10; i++) {
+        arena.allocate(32, 1);
+    }
+
+    // Too big for a regular chunk, so it gets one of its own
+    arena.allocate(1000, 1);
+
+    EXPECT_EQ(arena.getChunkCount(), 6);
+    EXPECT_EQ(arena.getBytesUsed(), 1320);
+    EXPECT_GE(arena.getBytesReserved(), 1320);
+
+    arena.reset();
+
+    // The first chunk is kept for the next program
+    EXPECT_EQ(arena.getChunkCount(), 1);
+    EXPECT_EQ(arena.getBytesUsed(), 0);
+    EXPECT_EQ(arena.getAllocationCount(), 0);
+    EXPECT_EQ(arena.getPeakBytesUsed(), 1320);
+}
+
+TEST(ArenaTest, parseIntoArena)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    Tokenizer tokenizer("{ int x = 5; void f(int a, float b) { print(a * b); } if (x > 2) { f(x, 1.5); } else { x = 0; } }");
+    const std::vector<Token> tokens = tokenizer.tokenize();
+
+    Arena arena;
+    Parser parser(tokens, outputStream, errorHandler, arena);
+    BlockNode* block = parser.parseProgram();
+    ASSERT_NE(block, nullptr);
+
+    EXPECT_GT(arena.getAllocationCount(), 0);
+    EXPECT_EQ(arena.getChunkCount(), 1);
+
+    const ArenaArray<ASTNode*>& statements = block->getStatements();
+    ASSERT_EQ(statements.size(), 3);
+    EXPECT_EQ(((VariableDeclarationNode*)statements[0])->getType(), "int");
+
+    FunctionDeclarationNode* function = (FunctionDeclarationNode*)statements[1];
+    ASSERT_EQ(function->getParameterTypes().size(), 2);
+    EXPECT_EQ(symbolTable.name(function->getParameterTypes()[1]), "float");
+
+    IfNode* ifNode = (IfNode*)statements[2];
+    EXPECT_EQ(ifNode->getExpressions().size(), 1);
+    EXPECT_EQ(ifNode->getBodies().size(), 2);
+
+    FunctionCallNode* call = (FunctionCallNode*)ifNode->getBodies()[0]->getStatements()[0];
+    EXPECT_EQ(((NumberNode*)call->getArguments()[1])->getValue(), "1.5");
+
+    arena.reset();
+    EXPECT_EQ(arena.getBytesUsed(), 0);
+}
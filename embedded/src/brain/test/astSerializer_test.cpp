@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include <regex>
+#include "astSerializer.hpp"
+#include "flags.h"
+#include "interpreter.hpp"
+#include "optimizer.hpp"
+#include "tokenizer.hpp"
+#include "vm.hpp"
+#include "testOutputStream.hpp"
+
+class ASTSerializerTest : public CapturingTest<> {
+   protected:
+    // Loaded programs get an arena of their own, so they are not mixed up with the parsed ones
+    Arena loadArena;
+
+    BlockNode* parse(const std::string& sourceCode) {
+        Tokenizer tokenizer(sourceCode);
+        const std::vector<Token> tokens = tokenizer.tokenize();
+        Parser parser(tokens, outputStream, errorHandler);
+        BlockNode* block = parser.parseProgram();
+        EXPECT_NE(block, nullptr) << outputStream.output;
+        return block;
+    }
+
+    BlockNode* load(const std::string& payload) {
+        ASTLoader loader(errorHandler, loadArena);
+        return loader.load(payload.data(), payload.size());
+    }
+
+    // The loader makes up its own names for parameters
+    static std::string withoutGeneratedNames(const std::string& tree) {
+        return std::regex_replace(tree, std::regex(GENERATED_IDENTIFIER_PREFIX "[0-9]+"), "parameter");
+    }
+
+    // What the program writes on the engine, started afresh
+    std::string run(BlockNode* block, bool bytecode) {
+        outputStream.output.clear();
+        errorHandler.resetStopExecution();
+
+        if (bytecode) {
+            VirtualMachine vm(*block, outputStream, errorHandler);
+            vm.interpret();
+        } else {
+            Interpreter interpreter(*block, outputStream, errorHandler);
+            interpreter.interpret();
+        }
+        return outputStream.output;
+    }
+};
+
+// Every kind of node the Parser produces
+static const std::string sourceCode =
+    "{\n"
+    "  int limit = 12;\n"
+    "  float scale = -1.25;\n"
+    "  int gcd(int a, int b) {\n"
+    "    while (b != 0) { int t = b; b = a % b; a = t; }\n"
+    "    return a;\n"
+    "  }\n"
+    "  void report(float value) {\n"
+    "    if (value > 100.0) { print(value); return; }\n"
+    "    else if (value < 0.5) { print(0); }\n"
+    "    else { print(round(value, 1)); }\n"
+    "  }\n"
+    "  for (int i = 1; i < limit; i = i + 1) {\n"
+    "    if (i == 3) { continue; }\n"
+    "    if (i > 9 || i < 0 - 5) { break; }\n"
+    "    report(gcd(i * 6, 84) * scale + sqrt(i) - pi() + rand() * 0);\n"
+    "  }\n"
+    "  print(1000000 / 7 + 2147483647 % 100);\n"
+    "  print(10 / (limit - 12));\n"
+    "}";
+
+TEST_F(ASTSerializerTest, roundTrip)
+{
+    BlockNode* parsed = parse(sourceCode);
+    ASSERT_NE(parsed, nullptr);
+
+    std::string payload = ASTSerializer(errorHandler).serialize(*parsed);
+    BlockNode* loaded = load(payload);
+    ASSERT_NE(loaded, nullptr) << outputStream.output;
+
+    EXPECT_EQ(withoutGeneratedNames(loaded->toString()), withoutGeneratedNames(parsed->toString()));
+
+    // Serializing the loaded tree gives the same bytes back, before the Resolver adds to either
+    EXPECT_EQ(ASTSerializer(errorHandler).serialize(*loaded), payload);
+
+    // Down to the location of the runtime error at the end
+    for (bool bytecode : {false, true}) {
+        std::string expected = run(parsed, bytecode);
+        EXPECT_NE(expected.find("line 19, column 12"), std::string::npos) << expected;
+        EXPECT_EQ(run(loaded, bytecode), expected);
+    }
+}
+
+TEST_F(ASTSerializerTest, optimizedAndResolvedTrees)
+{
+    BlockNode* parsed = parse("{ float x = 2 * 3; int y = x + 1.5; if (x) { print(y / 2); } }");
+    ASSERT_NE(parsed, nullptr);
+
+    Optimizer optimizer;
+    optimizer.optimize(*parsed);
+
+    // Creating the Interpreter runs the Resolver, which inserts ConversionNodes
+    std::string expected = run(parsed, false);
+    EXPECT_NE(parsed->toString().find("CONVERSION"), std::string::npos) << parsed->toString();
+
+    BlockNode* loaded = load(ASTSerializer(errorHandler).serialize(*parsed));
+    ASSERT_NE(loaded, nullptr) << outputStream.output;
+    EXPECT_EQ(loaded->toString(), parsed->toString());
+
+    EXPECT_EQ(run(loaded, false), expected);
+    EXPECT_EQ(run(loaded, true), expected);
+}
+
+TEST_F(ASTSerializerTest, foldedFloatsKeepTheirValue)
+{
+    BlockNode* parsed = parse("{ float a = 1.0 / 10000000; float b = 1.0 / 3; print(a * 10000000); print(b * 3); }");
+    ASSERT_NE(parsed, nullptr);
+
+    Optimizer optimizer;
+    optimizer.optimize(*parsed);
+
+    // Both initializers are folded to a single float, neither of which has a short decimal spelling
+    std::string expected = run(parsed, false);
+    EXPECT_EQ(expected, std::string(PRINT_FLAG) + "1.000000\n" + PRINT_FLAG + PRINT_FLAG + "1.000000\n" + PRINT_FLAG);
+
+    BlockNode* loaded = load(ASTSerializer(errorHandler).serialize(*parsed));
+    ASSERT_NE(loaded, nullptr) << outputStream.output;
+
+    const ArenaArray<ASTNode*>& parsedStatements = parsed->getStatements();
+    const ArenaArray<ASTNode*>& loadedStatements = loaded->getStatements();
+    for (size_t i = 0; i < 2; i++) {
+        NumberNode* folded = (NumberNode*)((VariableDeclarationNode*)parsedStatements[i])->getInitializer();
+        NumberNode* reloaded = (NumberNode*)((VariableDeclarationNode*)loadedStatements[i])->getInitializer();
+        ASSERT_EQ(reloaded->getNodeType(), ASTNodeType::NUMBER_NODE);
+        EXPECT_EQ(reloaded->getFloatValue(), folded->getFloatValue());
+    }
+
+    EXPECT_EQ(run(loaded, false), expected);
+    EXPECT_EQ(run(loaded, true), expected);
+}
+
+TEST_F(ASTSerializerTest, refusesWhatTheLoaderWouldReject)
+{
+    // The block, the assignment, a binary operation per + and the first x, so terms + 2 deep
+    auto sum = [](int terms) {
+        std::string sourceCode = "{ int x = 1; x = x";
+        for (int i = 1; i < terms; i++) {
+            sourceCode += " + x";
+        }
+        return sourceCode + "; }";
+    };
+
+    BlockNode* deepest = parse(sum(AST_MAX_DEPTH - 2));
+    ASSERT_NE(deepest, nullptr);
+    std::string payload = ASTSerializer(errorHandler).serialize(*deepest);
+    EXPECT_NE(load(payload), nullptr) << outputStream.output;
+
+    BlockNode* tooDeep = parse(sum(AST_MAX_DEPTH - 1));
+    ASSERT_NE(tooDeep, nullptr);
+    EXPECT_EQ(ASTSerializer(errorHandler).serialize(*tooDeep), "");
+    EXPECT_NE(outputStream.output.find("Serialize Error: Program nested more than 200 deep at line 1"), std::string::npos) << outputStream.output;
+    EXPECT_TRUE(errorHandler.shouldStopExecution());
+}
+
+TEST_F(ASTSerializerTest, smallerThanSource)
+{
+    BlockNode* parsed = parse(sourceCode);
+    ASSERT_NE(parsed, nullptr);
+
+    std::string payload = ASTSerializer(errorHandler).serialize(*parsed);
+    // The source above is already terse, generated scripts are indented and spaced out
+    EXPECT_LT(payload.size(), sourceCode.size() * 4 / 5);
+    EXPECT_LT(payload.size(), parsed->toString().size() / 5);
+}
+
+TEST_F(ASTSerializerTest, rejectsMalformedPayloads)
+{
+    BlockNode* parsed = parse(sourceCode);
+    ASSERT_NE(parsed, nullptr);
+    std::string payload = ASTSerializer(errorHandler).serialize(*parsed);
+
+    // Cut off anywhere
+    for (size_t size = 0; size < payload.size(); size++) {
+        errorHandler.resetStopExecution();
+        EXPECT_EQ(load(payload.substr(0, size)), nullptr) << size;
+        EXPECT_TRUE(errorHandler.shouldStopExecution());
+    }
+
+    errorHandler.resetStopExecution();
+    EXPECT_EQ(load(payload + "x"), nullptr);
+
+    // Cut off within a number of more than one byte, Ex. the length of a name
+    for (const std::string& truncated : {std::string("BAST\x01\x01\xff", 7), std::string("BAST\x01\x01\xff\xff\xff", 9), std::string("BAST\x81", 5)}) {
+        errorHandler.resetStopExecution();
+        EXPECT_EQ(load(truncated), nullptr);
+        EXPECT_TRUE(errorHandler.shouldStopExecution());
+    }
+
+    errorHandler.resetStopExecution();
+    outputStream.output.clear();
+    EXPECT_EQ(load("{ print(1); }"), nullptr);
+    EXPECT_EQ(outputStream.output, std::string(ERROR_FLAG) + "Load Error: Not a compiled program\n" + ERROR_FLAG);
+
+    // Another version
+    std::string otherVersion = payload;
+    otherVersion[4] = AST_FORMAT_VERSION + 1;
+    errorHandler.resetStopExecution();
+    EXPECT_EQ(load(otherVersion), nullptr);
+
+    // A number where a statement belongs, a name that was never listed and a node type that does not exist
+    std::string header = std::string("BAST") + (char)AST_FORMAT_VERSION + (char)0;
+    std::string blockOf = std::string(1, (char)ASTNodeType::BLOCK_NODE) + (char)1;
+    for (const std::string& body : {blockOf + (char)ASTNodeType::NUMBER_NODE + (char)0 + (char)2,
+                                     blockOf + (char)ASTNodeType::ASSIGNMENT_NODE + (char)1 + (char)1,
+                                     blockOf + (char)30}) {
+        errorHandler.resetStopExecution();
+        EXPECT_EQ(load(header + body), nullptr);
+        EXPECT_TRUE(errorHandler.shouldStopExecution());
+    }
+
+    // Nesting deeper than the loader allows
+    std::string deep;
+    for (int i = 0; i < AST_MAX_DEPTH + 1; i++) {
+        deep += std::string(1, (char)ASTNodeType::MONO_OPERATION_NODE) + (char)1 + (char)Operator::NOT;
+    }
+    errorHandler.resetStopExecution();
+    EXPECT_EQ(load(header + blockOf + (char)ASTNodeType::RETURN_NODE + (char)1 + deep), nullptr);
+    EXPECT_TRUE(errorHandler.shouldStopExecution());
+}
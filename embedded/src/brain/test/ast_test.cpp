@@ -3,105 +3,27 @@
 #include "ast.hpp"
 #include "outputStream.hpp"
 #include "error.hpp"
+#include "testOutputStream.hpp"
 
-TEST(ASTTest, gatherTokensUntilSimple)
-{
-    std::string sourceCode = "int sum = 5;";
-    Tokenizer tokenizer(sourceCode);
-    const std::vector<Token> tokens = tokenizer.tokenize();
-
-    StandardOutputStream outputStream;
-    ErrorHandler errorHandler(outputStream);
-
-    Parser parser(tokens, outputStream, errorHandler);
-
-    std::vector<const Token *> until = parser.gatherTokensUntil(TokenType::SEMICOLON);
-
-    // We just gathered all tokens up to and including the semicolon, so we should have 5 tokens
-    ASSERT_EQ(until.size(), 5);
-
-    // Check that the last one is indeed the semicolon
-    EXPECT_EQ(until[4]->type, TokenType::SEMICOLON);
-    EXPECT_EQ(until[4]->lexeme, ";");
-}
-
-TEST(ASTTest, gatherTokensUntilSlice)
-{
-    std::string sourceCode = "int sum = 5; float pi = 3.14; //this is a comment\n while (sum < 5) {sum = sum + 1;};";
-    Tokenizer tokenizer(sourceCode);
-    const std::vector<Token> tokens = tokenizer.tokenize();
-
-    StandardOutputStream outputStream;
-    ErrorHandler errorHandler(outputStream);
-
-    Parser parser(tokens, outputStream, errorHandler);
-
-    std::vector<const Token *> until = parser.gatherTokensUntil(TokenType::SEMICOLON);
-
-    // We just gathered all tokens up to and including the semicolon, so we should have 5 tokens
-    ASSERT_EQ(until.size(), 5);
-
-    // Check that the last one is indeed the semicolon
-    EXPECT_EQ(until[4]->type, TokenType::SEMICOLON);
-    EXPECT_EQ(until[4]->lexeme, ";");
-}
-
-TEST(ASTTest, gatherTokensUntilSemicolon)
-{
-    std::string sourceCode = "{ sum = 20;} float w = 5.3;";
-    Tokenizer tokenizer(sourceCode);
-    const std::vector<Token> tokens = tokenizer.tokenize();
-
-    StandardOutputStream outputStream;
-    ErrorHandler errorHandler(outputStream);
-
-    Parser parser(tokens, outputStream, errorHandler);
-
-    std::vector<const Token *> until = parser.gatherTokensUntil(TokenType::SEMICOLON);
-
-    // We just gathered all tokens up to and including the semicolon, so we should have 4 tokens
-    ASSERT_EQ(until.size(), 5);
-}
-
-TEST(ASTTest, gatherTokensUntilComplicated)
-{
-    std::string sourceCode = "(x == 10)) {x = x + 2} \n //this is my annoying comment {()(){}{} \nfloat z = y + 2.0;}";
+TEST(ASTTest, parseConstantInt) {
+    std::string sourceCode = "5;";
     Tokenizer tokenizer(sourceCode);
-    const std::vector<Token> tokens = tokenizer.tokenize();
+    std::vector<Token> tokens = tokenizer.tokenize();
 
     StandardOutputStream outputStream;
     ErrorHandler errorHandler(outputStream);
 
     Parser parser(tokens, outputStream, errorHandler);
 
-    std::vector<const Token *> until = parser.gatherTokensUntil(TokenType::RIGHT_PARENTHESIS);
-
-    // We just gathered all tokens up to and including the parenthesis, so we should have 6 tokens
-    // This is 23 tokens
-    ASSERT_EQ(until.size(), 6);
-
-    // The first and last should be parentheses
-    EXPECT_EQ(until[0]->type, TokenType::LEFT_PARENTHESIS);
-    EXPECT_EQ(until[0]->lexeme, "(");
-    EXPECT_EQ(until[5]->type, TokenType::RIGHT_PARENTHESIS);
-    EXPECT_EQ(until[5]->lexeme, ")");
-
-    // The second is an identifier
-    EXPECT_EQ(until[1]->type, TokenType::IDENTIFIER);
-    EXPECT_EQ(until[1]->lexeme, "x");
-
-    // The third is an operator
-    EXPECT_EQ(until[2]->type, TokenType::OPERATOR);
-    EXPECT_EQ(until[2]->lexeme, "==");
-
-    // The fourth is an integer
-    EXPECT_EQ(until[3]->type, TokenType::INTEGER);
-    EXPECT_EQ(until[3]->lexeme, "10");
+    NumberNode* node = parser.parseConstant();
 
+    EXPECT_EQ((*node).getValue(), "5");
+    EXPECT_EQ((*node).getType(), TokenType::INTEGER);
+    EXPECT_EQ((*node).getIntValue(), 5);
 }
 
-TEST(ASTTest, parseConstantInt) {
-    std::string sourceCode = "5;";
+TEST(ASTTest, parseConstantFloat) {
+    std::string sourceCode = "5.43;";
     Tokenizer tokenizer(sourceCode);
     std::vector<Token> tokens = tokenizer.tokenize();
 
@@ -112,12 +34,13 @@ TEST(ASTTest, parseConstantInt) {
 
     NumberNode* node = parser.parseConstant();
 
-    EXPECT_EQ((*node).getValue(), "5");
-    EXPECT_EQ((*node).getType(), TokenType::INTEGER);
+    EXPECT_EQ((*node).getValue(), "5.43");
+    EXPECT_EQ((*node).getType(), TokenType::FLOAT);
+    EXPECT_FLOAT_EQ((*node).getFloatValue(), 5.43f);
 }
 
-TEST(ASTTest, parseConstantFloat) {
-    std::string sourceCode = "5.43;";
+TEST(ASTTest, parseConstantOutOfRange) {
+    std::string sourceCode = "{int x = 2147483648;}";
     Tokenizer tokenizer(sourceCode);
     std::vector<Token> tokens = tokenizer.tokenize();
 
@@ -126,10 +49,12 @@ TEST(ASTTest, parseConstantFloat) {
 
     Parser parser(tokens, outputStream, errorHandler);
 
-    NumberNode* node = parser.parseConstant();
+    BlockNode* node = parser.parseProgram();
 
-    EXPECT_EQ((*node).getValue(), "5.43");
-    EXPECT_EQ((*node).getType(), TokenType::FLOAT);
+    // Too big for an int, rather than silently wrapping
+    EXPECT_EQ(errorHandler.shouldStopExecution(), true);
+
+    errorHandler.resetStopExecution();
 }
 
 TEST(ASTTest, parseConstantInvalid) {
@@ -316,3 +241,176 @@ TEST(ASTTest, missedSemicolon) {
 
     errorHandler.resetStopExecution();
 }
+
+TEST(ASTTest, parseOperatorsDecoded) {
+    std::string sourceCode = "{int x = 1 + 2 * 3 <= 4 && 5;}";
+    Tokenizer tokenizer(sourceCode);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+
+    Parser parser(tokens, outputStream, errorHandler);
+    BlockNode* node = parser.parseProgram();
+
+    ASSERT_FALSE(errorHandler.shouldStopExecution());
+
+    // Lowest precedence ends up at the root: ((1 + (2 * 3)) <= 4) && 5
+    VariableDeclarationNode* declaration = (VariableDeclarationNode*)node->getStatements()[0];
+    BinaryOperationNode* andNode = (BinaryOperationNode*)declaration->getInitializer();
+    EXPECT_EQ(andNode->getOperator(), Operator::AND);
+
+    BinaryOperationNode* lessEqualNode = (BinaryOperationNode*)andNode->getLeftExpression();
+    EXPECT_EQ(lessEqualNode->getOperator(), Operator::LESS_EQUAL);
+
+    BinaryOperationNode* addNode = (BinaryOperationNode*)lessEqualNode->getLeftExpression();
+    EXPECT_EQ(addNode->getOperator(), Operator::ADD);
+    EXPECT_EQ(((BinaryOperationNode*)addNode->getRightExpression())->getOperator(), Operator::MULTIPLY);
+}
+
+TEST(ASTTest, parseUnknownOperator) {
+    std::string sourceCode = "{int x = 1 = 2;}";
+    Tokenizer tokenizer(sourceCode);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+
+    Parser parser(tokens, outputStream, errorHandler);
+    BlockNode* node = parser.parseProgram();
+
+    EXPECT_EQ(errorHandler.shouldStopExecution(), true);
+
+    errorHandler.resetStopExecution();
+}
+
+TEST(ASTTest, parseLeftAssociative) {
+    std::string sourceCode = "{int x = 8 - 4 - 2 * (1 + 3) / 2;}";
+    Tokenizer tokenizer(sourceCode);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+
+    Parser parser(tokens, outputStream, errorHandler);
+    BlockNode* node = parser.parseProgram();
+
+    ASSERT_FALSE(errorHandler.shouldStopExecution());
+
+    // (8 - 4) - ((2 * (1 + 3)) / 2)
+    EXPECT_EQ(node->toString(), "BLOCK NODE {\nVARIABLE DECLARATION int x = BINARY OPERATION (BINARY OPERATION (NUMBER 8 - NUMBER 4) - BINARY OPERATION (BINARY OPERATION (NUMBER 2 * BINARY OPERATION (NUMBER 1 + NUMBER 3)) / NUMBER 2))\n}");
+}
+
+TEST(ASTTest, parseLongExpression) {
+    // Generated programs chain many terms, each one should only be looked at once
+    std::string sourceCode = "{int x = 0";
+    for (int i = 0; i < 5000; i++) {
+        sourceCode += " + (x * 2)";
+    }
+    sourceCode += ";}";
+
+    Tokenizer tokenizer(sourceCode);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+
+    Parser parser(tokens, outputStream, errorHandler);
+    BlockNode* node = parser.parseProgram();
+
+    ASSERT_FALSE(errorHandler.shouldStopExecution());
+
+    // Left associative, so the last term is on the right of the root
+    BinaryOperationNode* root = (BinaryOperationNode*)((VariableDeclarationNode*)node->getStatements()[0])->getInitializer();
+    EXPECT_EQ(root->getOperator(), Operator::ADD);
+    EXPECT_EQ(root->getRightExpression()->getNodeType(), ASTNodeType::BINARY_OPERATION_NODE);
+    EXPECT_EQ(root->getLeftExpression()->getNodeType(), ASTNodeType::BINARY_OPERATION_NODE);
+}
+
+TEST(ASTTest, parseMalformedExpressions) {
+    const char* sources[] = {"{int x = (1 + 2;}", "{int x = 1 +;}", "{int x = 1 2;}", "{print(1,);}", "{print(1 2);}", "{int x = ();}"};
+
+    for (const char* sourceCode : sources) {
+        Tokenizer tokenizer(sourceCode);
+        std::vector<Token> tokens = tokenizer.tokenize();
+
+        StandardOutputStream outputStream;
+        ErrorHandler errorHandler(outputStream);
+
+        Parser parser(tokens, outputStream, errorHandler);
+        BlockNode* node = parser.parseProgram();
+
+        EXPECT_EQ(node, nullptr) << sourceCode;
+        EXPECT_TRUE(errorHandler.shouldStopExecution()) << sourceCode;
+
+        errorHandler.resetStopExecution();
+    }
+}
+
+TEST(ASTTest, matchBrackets) {
+    std::string sourceCode = "{ if (x) { f((1), 2); } }";
+    Tokenizer tokenizer(sourceCode);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+
+    Parser parser(tokens, outputStream, errorHandler);
+
+    // { if ( x ) { f ( ( 1 ) , 2 ) ; } }
+    // 0 1  2 3 4 5 6 7 8 9 10 11 12 13 14 15 16
+    EXPECT_EQ(parser.getMatchingBracket(0), 16);
+    EXPECT_EQ(parser.getMatchingBracket(16), 0);
+    EXPECT_EQ(parser.getMatchingBracket(2), 4);
+    EXPECT_EQ(parser.getMatchingBracket(5), 15);
+    EXPECT_EQ(parser.getMatchingBracket(7), 13);
+    EXPECT_EQ(parser.getMatchingBracket(8), 10);
+    EXPECT_EQ(parser.getMatchingBracket(1), NO_MATCHING_BRACKET);
+}
+
+// Keeps the error messages so their location can be checked
+TEST(ASTTest, reportUnbalancedBrackets) {
+    // Each mismatch is reported at the bracket responsible, before any statement is parsed
+    std::vector<std::pair<std::string, std::string>> cases = {
+        {"{ int x = (1 + 2; }", "Syntax Error: }: Unexpected brace or parenthesis }, expected RIGHT_PARENTHESIS to close the ( on line 1, column 11 at line 1, column 19"},
+        {"{ int x = 1; } }", "Syntax Error: }: Unexpected brace or parenthesis } at line 1, column 16"},
+        {"{ while (1) {\n  x = 1;\n}", "Syntax Error: {: Unclosed brace or parenthesis { at line 1, column 1"},
+    };
+
+    for (const auto& testCase : cases) {
+        Tokenizer tokenizer(testCase.first);
+        std::vector<Token> tokens = tokenizer.tokenize();
+
+        CapturingOutputStream outputStream;
+        ErrorHandler errorHandler(outputStream);
+
+        Parser parser(tokens, outputStream, errorHandler);
+        BlockNode* node = parser.parseProgram();
+
+        EXPECT_EQ(node, nullptr) << testCase.first;
+        EXPECT_NE(outputStream.output.find(testCase.second), std::string::npos) << outputStream.output;
+
+        errorHandler.resetStopExecution();
+    }
+}
+
+TEST(ASTTest, reparseKeepsSymbolTableSize) {
+    // Parameters are renamed, but every parse reuses the names the previous one made up
+    std::string sourceCode = "{ int add(int a, int b) { return a + b; } int twice(int a) { return add(a, a); } print(twice(3)); }";
+    CapturingOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+
+    size_t size = 0;
+    for (int i = 0; i < 3; i++) {
+        Tokenizer tokenizer(sourceCode);
+        std::vector<Token> tokens = tokenizer.tokenize();
+
+        Parser parser(tokens, outputStream, errorHandler);
+        ASSERT_NE(parser.parseProgram(), nullptr) << outputStream.output;
+
+        if (i == 0) {
+            size = symbolTable.size();
+        }
+        EXPECT_EQ(symbolTable.size(), size);
+    }
+}
@@ -0,0 +1,23 @@
+#include <gtest/gtest.h>
+#include "error.hpp"
+#include "outputStream.hpp"
+
+TEST(ErrorHandlerTest, stopFlagPerHandler)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler first(outputStream);
+    ErrorHandler second(outputStream);
+
+    EXPECT_FALSE(first.shouldStopExecution());
+
+    // An error in one program does not stop another
+    first.handleError("Test error");
+    EXPECT_TRUE(first.shouldStopExecution());
+    EXPECT_FALSE(second.shouldStopExecution());
+
+    first.resetStopExecution();
+    EXPECT_FALSE(first.shouldStopExecution());
+
+    second.triggerStopExecution();
+    EXPECT_TRUE(second.shouldStopExecution());
+}
@@ -2,9 +2,62 @@
 #include "tokenizer.hpp"
 #include "ast.hpp"
 #include "interpreter.hpp"
+#include "optimizer.hpp"
+#include "vm.hpp"
 #include "flags.h"
+#include "profiler.hpp"
+#include "testOutputStream.hpp"
 
-TEST(InterpreterTest, testCollatz)
+// Every program below is run by both the tree-walking interpreter and the bytecode VM
+enum class Engine { TREE_WALKING, BYTECODE };
+
+class InterpreterTest : public CapturingTest<::testing::TestWithParam<Engine>> {
+   protected:
+    // Tokenizes, parses, optimizes and runs the program, returning everything it wrote
+    // configure gets a chance to set the engine up before it runs
+    std::string run(const std::string& sourceCode, const std::function<void(Executor&)>& configure = nullptr) {
+        Tokenizer tokenizer(sourceCode);
+        const std::vector<Token> tokens = tokenizer.tokenize();
+
+        Parser parser(tokens, outputStream, errorHandler);
+        BlockNode* block = parser.parseProgram();
+
+        if (block == nullptr) {
+            ADD_FAILURE() << "Parsing failed: " << outputStream.output;
+            return outputStream.output;
+        }
+
+        Optimizer optimizer;
+        optimizer.optimize(*block);
+
+        Executor* executor;
+        if (GetParam() == Engine::BYTECODE) {
+            executor = new VirtualMachine(*block, outputStream, errorHandler);
+        } else {
+            executor = new Interpreter(*block, outputStream, errorHandler);
+        }
+
+        if (configure) {
+            configure(*executor);
+        }
+
+        executor->interpret();
+
+        delete executor;
+
+        return outputStream.output;
+    }
+};
+
+static std::string printed(const std::string& value) {
+    return PRINT_FLAG + value + "\n" + PRINT_FLAG;
+}
+
+static std::string error(const std::string& message) {
+    return ERROR_FLAG + message + "\n" + ERROR_FLAG;
+}
+
+TEST_P(InterpreterTest, testCollatz)
 {
     std::string sourceCode = 
     "{"
@@ -24,32 +77,414 @@ TEST(InterpreterTest, testCollatz)
         "}"
         "print(count);"
     "}";
-    Tokenizer tokenizer(sourceCode);
-    const std::vector<Token> tokens = tokenizer.tokenize();
 
-    StandardOutputStream outputStream;
+    EXPECT_EQ(run(sourceCode), "__P__125\n__P__");
+}
+
+TEST_P(InterpreterTest, testExpressions)
+{
+    std::string sourceCode =
+    "{"
+        "int x = 2 - -5;"
+        "print(x);"
+        "print(2 * 1 * (2 - 5 * 1));"
+        "print((2 * 4) + (-12 - -8 / 2));"
+        "print(7 % 3 + 1 > 2 && 3 < 2 || 0 == 0);"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("7") + printed("-6") + printed("0") + printed("1"));
+}
+
+TEST_P(InterpreterTest, testFloatPromotion)
+{
+    std::string sourceCode =
+    "{"
+        "float f = 1.5;"
+        "int i = 2;"
+        "print(f * i);"
+        "print(i / 4);"
+        "print(i / 4.0);"
+        "i = float_to_int(f * 3);"
+        "print(i);"
+        "print(int_to_float(i) + 0.25);"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("3.000000") + printed("0") + printed("0.500000") + printed("4") + printed("4.250000"));
+}
+
+TEST_P(InterpreterTest, testIntegerLiteralsAreExact)
+{
+    // Neither survives a round trip through a float
+    std::string sourceCode =
+    "{"
+        "print(16777217);"
+        "print(2147483647);"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("16777217") + printed("2147483647"));
+}
+
+TEST_P(InterpreterTest, testIntegerArithmeticWraps)
+{
+    // In variables so the Optimizer does not fold them, both engines wrap at run time
+    std::string sourceCode =
+    "{"
+        "int big = 2147483647;"
+        "int minusOne = 0 - 1;"
+        "int smallest = big + 1;"
+        "print(smallest);"
+        "print(smallest - 1);"
+        "print(big * 2);"
+        "print(smallest / minusOne);"
+        "print(smallest % minusOne);"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("-2147483648") + printed("2147483647") + printed("-2") + printed("-2147483648") + printed("0"));
+}
+
+TEST_P(InterpreterTest, testLoopsWithBreakAndContinue)
+{
+    std::string sourceCode =
+    "{"
+        "int sum = 0;"
+        "for (int i = 0; i < 10; i = i + 1) {"
+            "if (i % 2) { continue; }"
+            "if (i > 6) { break; }"
+            "sum = sum + i;"
+        "}"
+        "print(sum);"
+        "int n = 0;"
+        "while (1) {"
+            "n = n + 1;"
+            "if (n == 5) { break; }"
+        "}"
+        "print(n);"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("12") + printed("5"));
+}
+
+TEST_P(InterpreterTest, testLoopVariableScopedToLoop)
+{
+    std::string sourceCode =
+    "{"
+        "int total = 0;"
+        "for (int i = 0; i < 3; i = i + 1) { total = total + i; }"
+        "for (int i = 10; i < 12; i = i + 1) { total = total + i; }"
+        "print(total);"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("24"));
+}
+
+TEST_P(InterpreterTest, testIfElseChain)
+{
+    std::string sourceCode =
+    "{"
+        "for (int i = 0; i < 3; i = i + 1) {"
+            "if (i == 0) { print(10); } else if (i == 1) { print(11); } else { print(12); }"
+        "}"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("10") + printed("11") + printed("12"));
+}
+
+TEST_P(InterpreterTest, testRecursiveFunction)
+{
+    std::string sourceCode =
+    "{"
+        "int fib(int n) {"
+            "if (n < 2) { return n; }"
+            "return fib(n - 1) + fib(n - 2);"
+        "}"
+        "print(fib(15));"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("610"));
+}
+
+TEST_P(InterpreterTest, testFunctionsSeeEnclosingVariables)
+{
+    std::string sourceCode =
+    "{"
+        "int total = 0;"
+        "void add(int amount) { total = total + amount; }"
+        "float half(float value) { return value / 2; }"
+        "add(3);"
+        "add(4);"
+        "print(total);"
+        "print(half(total));"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("7") + printed("3.500000"));
+}
+
+TEST_P(InterpreterTest, testNestedFunctionsAndDeepScopes)
+{
+    std::string sourceCode =
+    "{"
+        "int depth = 0;"
+        "int outer(int n) {"
+            "int scale = 10;"
+            "int inner(int m) { return m * scale + depth; }"
+            "if (n > 0) { while (1) { if (1) { return inner(n); } } }"
+            "return 0;"
+        "}"
+        "depth = 3;"
+        "print(outer(4));"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("43"));
+}
+
+TEST_P(InterpreterTest, testLaterDeclarationsDoNotClashWithFunctionLocals)
+{
+    // The body is checked once the block closes, but only names declared before the function are in its way
+    std::string sourceCode =
+    "{"
+        "void f() { int y = 1; print(y); }"
+        "f();"
+        "int y = 2;"
+        "print(y);"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("1") + printed("2"));
+}
+
+TEST_P(InterpreterTest, testBareReturnGivesZero)
+{
+    std::string sourceCode =
+    "{"
+        "int early(int n) {"
+            "if (n > 0) { return; }"
+            "return n - 1;"
+        "}"
+        "print(early(5));"
+        "print(early(0));"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("0") + printed("-1"));
+}
+
+TEST_P(InterpreterTest, testStaticConversions)
+{
+    std::string sourceCode =
+    "{"
+        "int truncate(float x) { return x * 2; }"
+        "float half(float x) { return x / 2; }"
+        "float nothing() { }"
+        "print(truncate(1.3));"
+        "print(half(3));"
+        "print(nothing());"
+        "if (0.5 && 2) { print(1); }"
+    "}";
+
+    // Arguments and return values take the declared type, floats are truthy when not 0
+    EXPECT_EQ(run(sourceCode), printed("2") + printed("1.500000") + printed("0.000000") + printed("1"));
+}
+
+TEST_P(InterpreterTest, testBuiltins)
+{
+    std::string sourceCode =
+    "{"
+        "print(pow(2, 10));"
+        "print(sqrt(16));"
+        "print(max(3, 7.5));"
+        "print(abs(-2));"
+        "print(floor(2.7) + ceil(2.2));"
+        "print(round(pi(), 2));"
+    "}";
+
+    EXPECT_EQ(run(sourceCode), printed("1024.000000") + printed("4.000000") + printed("7.500000") + printed("2.000000") + printed("5.000000") + printed("3.140000"));
+}
+
+TEST_P(InterpreterTest, testDivisionByZero)
+{
+    std::string sourceCode =
+    "{"
+        "int zero = 0;"
+        "print(1);"
+        "print(5 / zero);"
+        "print(2);"
+    "}";
+
+    // Reported at the operator
+    EXPECT_EQ(run(sourceCode), printed("1") + error("Runtime Error: Division by zero at line 1, column 32"));
+    EXPECT_TRUE(errorHandler.shouldStopExecution());
+}
+
+TEST_P(InterpreterTest, testErrorLocations)
+{
+    std::string sourceCode =
+    "{\n"
+    "    int x = 2;\n"
+    "    void f(int n) {\n"
+    "        print(sqrt(n - 3));\n"
+    "    }\n"
+    "    f(x);\n"
+    "}";
+
+    // The builtin's error points at its call, inside the function
+    EXPECT_EQ(run(sourceCode), error("Runtime Error: sqrt() takes a positive argument at line 4, column 15"));
+
+    errorHandler.resetStopExecution();
+    outputStream.output.clear();
+
+    std::string output = run("{\n  int x = 1;\n  x = x + y;\n}");
+    EXPECT_NE(output.find("Variable y does not exist in this scope at line 3, column 11"), std::string::npos) << output;
+}
+
+TEST_P(InterpreterTest, testNoTraceByDefault)
+{
+    std::string sourceCode = "{ int n = 0; while (n < 3) { if (n % 2) { print(n); } n = n + 1; } }";
+
+    // Conditions used to be printed to stdout on every if
+    testing::internal::CaptureStdout();
+    std::string output = run(sourceCode);
+    std::string console = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(output, printed("1"));
+    EXPECT_EQ(console, "");
+}
+
+TEST_P(InterpreterTest, testUndeclaredVariable)
+{
+    std::string output = run("{ x = 5; }");
+
+    EXPECT_NE(output.find("Variable x does not exist in this scope"), std::string::npos);
+    EXPECT_TRUE(errorHandler.shouldStopExecution());
+}
+
+TEST_P(InterpreterTest, testMissingArguments)
+{
+    std::string output = run("{ int f(int a) { return a; } print(f()); }");
+
+    EXPECT_NE(output.find("Function f takes 1 arguments, but 0 were given"), std::string::npos);
+    EXPECT_TRUE(errorHandler.shouldStopExecution());
+}
+
+TEST_P(InterpreterTest, testYieldBudgetInstructions)
+{
+    std::string sourceCode = "{ int n = 0; while (n < 1000) { n = n + 1; } print(n); }";
+
+    // Runs the program with the given slice, returning how many times it yielded
+    auto countYields = [&](uint32_t slice) {
+        uint32_t hookCalls = 0;
+
+        outputStream.output.clear();
+        EXPECT_EQ(run(sourceCode, [&](Executor& executor) {
+                      executor.setYieldSlice(YieldPolicy::INSTRUCTIONS, slice);
+                      executor.setYieldHook([&]() { hookCalls++; });
+                  }),
+                  printed("1000"));
+
+        return hookCalls;
+    };
+
+    uint32_t everyCheck = countYields(1);
+    uint32_t everyTenth = countYields(10);
+
+    // Every iteration passes through at least one yield point
+    EXPECT_GE(everyCheck, 1000);
+    EXPECT_EQ(everyTenth, everyCheck / 10);
+}
+
+TEST_P(InterpreterTest, testYieldBudgetTime)
+{
+    uint32_t hookCalls = 0;
+    uint32_t yieldCount = 1;
+
+    std::string output = run("{ int n = 0; while (n < 1000) { n = n + 1; } print(n); }", [&](Executor& executor) {
+        // An hour is far longer than the program takes
+        executor.setYieldSlice(YieldPolicy::TIME, 3600000000u);
+        executor.setYieldHook([&]() { hookCalls++; });
+        EXPECT_EQ(executor.getYieldPolicy(), YieldPolicy::TIME);
+        EXPECT_EQ(executor.getYieldSlice(), 3600000000u);
+        yieldCount = executor.getYieldCount();
+    });
+
+    EXPECT_EQ(output, printed("1000"));
+    EXPECT_EQ(yieldCount, 0);
+    EXPECT_EQ(hookCalls, 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, InterpreterTest, ::testing::Values(Engine::TREE_WALKING, Engine::BYTECODE),
+                         [](const ::testing::TestParamInfo<Engine>& info) {
+                             return info.param == Engine::BYTECODE ? std::string("Bytecode") : std::string("TreeWalking");
+                         });
+
+// The profiler only hooks into the tree-walking interpreter
+TEST(ProfilerTest, countsAndReportsStatements)
+{
+    CapturingOutputStream outputStream;
     ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
 
-    Parser parser(tokens, outputStream, errorHandler);
+    std::string sourceCode =
+        "{\n"
+        "int total = 0;\n"
+        "for (int i = 0; i < 100; i = i + 1) {\n"
+        "  total = total + i;\n"
+        "}\n"
+        "print(total);\n"
+        "}";
 
+    Tokenizer tokenizer(sourceCode);
+    const std::vector<Token> tokens = tokenizer.tokenize();
+    Parser parser(tokens, outputStream, errorHandler);
     BlockNode* block = parser.parseProgram();
+    ASSERT_NE(block, nullptr);
+
+    Profiler profiler;
+    Interpreter interpreter(*block, outputStream, errorHandler);
+    interpreter.setProfiler(&profiler);
+    interpreter.interpret();
+    EXPECT_EQ(outputStream.output, std::string(PRINT_FLAG) + "4950\n" + PRINT_FLAG);
+
+    std::vector<ProfileEntry> entries = profiler.getEntries();
+    ASSERT_EQ(entries.size(), 4);
+
+    const ProfileEntry* loop = nullptr;
+    const ProfileEntry* body = nullptr;
+    for (const ProfileEntry& entry : entries) {
+        if (entry.statement->getNodeType() == ASTNodeType::FOR_NODE) {
+            loop = &entry;
+        } else if (entry.statement->getSourceLocation().line == 4) {
+            body = &entry;
+        } else {
+            EXPECT_EQ(entry.count, 1);
+        }
+
+        EXPECT_GE(entry.totalNanoseconds, entry.selfNanoseconds);
+    }
 
-    // Redirect stdout to a stringstream to capture the printed output
-    std::stringstream capturedOutput;
-    std::streambuf* originalStdout = std::cout.rdbuf(capturedOutput.rdbuf());
+    ASSERT_NE(loop, nullptr);
+    ASSERT_NE(body, nullptr);
+    EXPECT_EQ(loop->count, 1);
+    EXPECT_EQ(body->count, 100);
+    EXPECT_GE(loop->totalNanoseconds, body->totalNanoseconds);
 
-    if(block != nullptr) {
-        Interpreter interpreter(*block, outputStream, errorHandler);
+    // Sorted hottest first
+    for (size_t i = 1; i < entries.size(); i++) {
+        EXPECT_GE(entries[i - 1].selfNanoseconds, entries[i].selfNanoseconds);
+    }
 
-        // Call interpret and restore the original stdout
-        interpreter.interpret();
-        std::cout.rdbuf(originalStdout);
+    outputStream.output.clear();
+    profiler.report(outputStream, 2);
+    EXPECT_EQ(outputStream.output.compare(0, strlen(PROFILE_FLAG), PROFILE_FLAG), 0);
+    EXPECT_EQ(std::count(outputStream.output.begin(), outputStream.output.end(), '\n'), 2);
 
-        // Check that the captured output contains "125"
-        EXPECT_EQ(capturedOutput.str(), "__P__125\n__P__");
-    } else {
-        FAIL();
-    }
+    outputStream.output.clear();
+    profiler.report(outputStream);
+    EXPECT_NE(outputStream.output.find("4:3 ASSIGNMENT_NODE ran 100 times"), std::string::npos) << outputStream.output;
+
+    // Detached, running again leaves the counts alone
+    interpreter.setProfiler(nullptr);
+    interpreter.interpret();
+    EXPECT_EQ(profiler.getEntries().size(), 4);
+
+    profiler.reset();
+    EXPECT_TRUE(profiler.getEntries().empty());
 }
 
 // TEST(InterpreterTest, testExpression1)
@@ -185,4 +620,3 @@ TEST(InterpreterTest, testCollatz)
 //     // Check that the captured output contains "125"
 //     EXPECT_EQ(capturedOutput.str(), "0\n");
 
-// }
\ No newline at end of file
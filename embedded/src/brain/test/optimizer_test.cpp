@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "tokenizer.hpp"
+#include "ast.hpp"
+#include "optimizer.hpp"
+
+static BlockNode* parse(const std::string& sourceCode, OutputStream& outputStream, ErrorHandler& errorHandler) {
+    Tokenizer tokenizer(sourceCode);
+    const std::vector<Token> tokens = tokenizer.tokenize();
+
+    Parser parser(tokens, outputStream, errorHandler);
+    return parser.parseProgram();
+}
+
+TEST(OptimizerTest, foldConstantExpressions)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    BlockNode* block = parse("{ int a = 3 * 1000 + 7; float b = 1 + 0.5; int c = 7 % 3 > 0 && 2 <= 1; }", outputStream, errorHandler);
+    ASSERT_NE(block, nullptr);
+
+    Optimizer optimizer;
+    optimizer.optimize(*block);
+
+    const ArenaArray<ASTNode*>& statements = block->getStatements();
+
+    NumberNode* a = (NumberNode*)((VariableDeclarationNode*)statements[0])->getInitializer();
+    ASSERT_EQ(a->getNodeType(), ASTNodeType::NUMBER_NODE);
+    EXPECT_EQ(a->getType(), TokenType::INTEGER);
+    EXPECT_EQ(a->getIntValue(), 3007);
+
+    NumberNode* b = (NumberNode*)((VariableDeclarationNode*)statements[1])->getInitializer();
+    ASSERT_EQ(b->getNodeType(), ASTNodeType::NUMBER_NODE);
+    EXPECT_EQ(b->getType(), TokenType::FLOAT);
+    EXPECT_FLOAT_EQ(b->getFloatValue(), 1.5f);
+
+    NumberNode* c = (NumberNode*)((VariableDeclarationNode*)statements[2])->getInitializer();
+    ASSERT_EQ(c->getNodeType(), ASTNodeType::NUMBER_NODE);
+    EXPECT_EQ(c->getIntValue(), 0);
+}
+
+TEST(OptimizerTest, foldPureBuiltins)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    BlockNode* block = parse("{ float a = pi() / 2; float b = int_to_float(5); float c = rand(); }", outputStream, errorHandler);
+    ASSERT_NE(block, nullptr);
+
+    Optimizer optimizer;
+    optimizer.optimize(*block);
+
+    const ArenaArray<ASTNode*>& statements = block->getStatements();
+
+    NumberNode* a = (NumberNode*)((VariableDeclarationNode*)statements[0])->getInitializer();
+    ASSERT_EQ(a->getNodeType(), ASTNodeType::NUMBER_NODE);
+    EXPECT_FLOAT_EQ(a->getFloatValue(), 3.14159265f / 2);
+
+    NumberNode* b = (NumberNode*)((VariableDeclarationNode*)statements[1])->getInitializer();
+    ASSERT_EQ(b->getNodeType(), ASTNodeType::NUMBER_NODE);
+    EXPECT_FLOAT_EQ(b->getFloatValue(), 5.0f);
+
+    // rand() differs every call
+    EXPECT_EQ(((VariableDeclarationNode*)statements[2])->getInitializer()->getNodeType(), ASTNodeType::FUNCTION_CALL_NODE);
+}
+
+TEST(OptimizerTest, simplifyIdentities)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    BlockNode* block = parse("{ int x = 4; x = x * 1 + 0; x = 1 * (x - 0); float y = x * 1.0; }", outputStream, errorHandler);
+    ASSERT_NE(block, nullptr);
+
+    Optimizer optimizer;
+    optimizer.optimize(*block);
+
+    const ArenaArray<ASTNode*>& statements = block->getStatements();
+
+    EXPECT_EQ(((AssignmentNode*)statements[1])->getExpression()->getNodeType(), ASTNodeType::VARIABLE_ACCESS_NODE);
+    EXPECT_EQ(((AssignmentNode*)statements[2])->getExpression()->getNodeType(), ASTNodeType::VARIABLE_ACCESS_NODE);
+
+    // x * 1.0 promotes x to a float, so it has to stay
+    EXPECT_EQ(((VariableDeclarationNode*)statements[3])->getInitializer()->getNodeType(), ASTNodeType::BINARY_OPERATION_NODE);
+
+    EXPECT_EQ(optimizer.getFoldCount(), 4);
+}
+
+TEST(OptimizerTest, keepRuntimeErrors)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    BlockNode* block = parse("{ int a = 5 / 0; float b = 2.5 % 0.5; float c = sqrt(0 - 1); }", outputStream, errorHandler);
+    ASSERT_NE(block, nullptr);
+
+    Optimizer optimizer;
+    optimizer.optimize(*block);
+
+    const ArenaArray<ASTNode*>& statements = block->getStatements();
+
+    EXPECT_EQ(((VariableDeclarationNode*)statements[0])->getInitializer()->getNodeType(), ASTNodeType::BINARY_OPERATION_NODE);
+    EXPECT_EQ(((VariableDeclarationNode*)statements[1])->getInitializer()->getNodeType(), ASTNodeType::BINARY_OPERATION_NODE);
+
+    // 0 - 1 is still folded, only the sqrt of it is left for the engine to report
+    FunctionCallNode* c = (FunctionCallNode*)((VariableDeclarationNode*)statements[2])->getInitializer();
+    ASSERT_EQ(c->getNodeType(), ASTNodeType::FUNCTION_CALL_NODE);
+    EXPECT_EQ(c->getArguments()[0]->getNodeType(), ASTNodeType::NUMBER_NODE);
+}
@@ -0,0 +1,272 @@
+#include <gtest/gtest.h>
+#include "flags.h"
+#include "programCache.hpp"
+#include "tokenizer.hpp"
+#include "vm.hpp"
+#include "testOutputStream.hpp"
+
+// Storage that keeps its entries in memory, so tests can tamper with them
+class MemoryProgramCacheStorage : public ProgramCacheStorage {
+   public:
+    std::string entries[PROGRAM_CACHE_SLOTS];
+    bool filled[PROGRAM_CACHE_SLOTS] = {};
+
+    bool read(uint32_t slot, std::string& entry) override {
+        entry = entries[slot];
+        return filled[slot];
+    }
+
+    bool write(uint32_t slot, const std::string& entry) override {
+        entries[slot] = entry;
+        filled[slot] = true;
+        return true;
+    }
+};
+
+class ProgramCacheTest : public CapturingTest<> {
+   protected:
+    // A copy of what the VM compiled sourceCode to
+    Program compile(const std::string& sourceCode) {
+        Tokenizer tokenizer(sourceCode);
+        const std::vector<Token> tokens = tokenizer.tokenize();
+        Parser parser(tokens, outputStream, errorHandler);
+        BlockNode* block = parser.parseProgram();
+
+        Program program;
+        if (block == nullptr) {
+            ADD_FAILURE() << "Parsing failed: " << outputStream.output;
+            return program;
+        }
+
+        VirtualMachine vm(*block, outputStream, errorHandler);
+        EXPECT_NE(vm.getProgram(), nullptr);
+        if (vm.getProgram() != nullptr) {
+            program = *vm.getProgram();
+        }
+
+        return program;
+    }
+
+    // Runs program on a VM of its own, which takes ownership, and returns what it wrote
+    std::string run(Program* program) {
+        outputStream.output.clear();
+        errorHandler.resetStopExecution();
+
+        VirtualMachine vm(program, outputStream, errorHandler);
+        vm.interpret();
+        return outputStream.output;
+    }
+};
+
+static const std::string sourceCode =
+    "{\n"
+    "int square(int n) { return n * n; }\n"
+    "float total = 0.5;\n"
+    "for (int i = 0; i < 5; i = i + 1) { total = total + square(i); }\n"
+    "print(total);\n"
+    "print(10 / float_to_int(total - 30.5));\n"
+    "}";
+
+TEST_F(ProgramCacheTest, roundTrip)
+{
+    Program program = compile(sourceCode);
+    uint64_t hash = ProgramCache::hashSource(sourceCode.data(), sourceCode.size());
+
+    std::string entry = ProgramCache::serialize(hash, program);
+    Program* loaded = ProgramCache::deserialize(hash, entry);
+    ASSERT_NE(loaded, nullptr);
+
+    ASSERT_EQ(loaded->code.size(), program.code.size());
+    for (size_t i = 0; i < program.code.size(); i++) {
+        EXPECT_EQ(loaded->code[i].op, program.code[i].op);
+        EXPECT_EQ(loaded->code[i].operand, program.code[i].operand);
+    }
+
+    ASSERT_EQ(loaded->functions.size(), program.functions.size());
+    EXPECT_EQ(loaded->functions[1].name, program.functions[1].name);
+    EXPECT_EQ(loaded->functions[1].parent, program.functions[1].parent);
+    EXPECT_EQ(loaded->functions[1].numSlots, program.functions[1].numSlots);
+    EXPECT_EQ(loaded->locations.size(), program.locations.size());
+    EXPECT_EQ(loaded->maxLevel, program.maxLevel);
+
+    // Runs like the freshly compiled program, down to where the runtime error is reported
+    std::string expected = run(new Program(program));
+    EXPECT_NE(expected.find("line 6"), std::string::npos) << expected;
+    EXPECT_EQ(run(loaded), expected);
+}
+
+TEST_F(ProgramCacheTest, rejectsStaleOrCorruptEntries)
+{
+    Program program = compile(sourceCode);
+    uint64_t hash = ProgramCache::hashSource(sourceCode.data(), sourceCode.size());
+    std::string entry = ProgramCache::serialize(hash, program);
+
+    // Another source
+    EXPECT_EQ(ProgramCache::deserialize(hash + 1, entry), nullptr);
+
+    // Another version
+    std::string otherVersion = entry;
+    otherVersion[4] = (char)(PROGRAM_CACHE_VERSION + 1);
+    EXPECT_EQ(ProgramCache::deserialize(hash, otherVersion), nullptr);
+
+    // A flipped bit in the payload
+    std::string corrupt = entry;
+    corrupt[corrupt.size() / 2] ^= 0x10;
+    EXPECT_EQ(ProgramCache::deserialize(hash, corrupt), nullptr);
+
+    // Cut short
+    EXPECT_EQ(ProgramCache::deserialize(hash, entry.substr(0, entry.size() - 1)), nullptr);
+    EXPECT_EQ(ProgramCache::deserialize(hash, entry.substr(0, 10)), nullptr);
+    EXPECT_EQ(ProgramCache::deserialize(hash, ""), nullptr);
+}
+
+TEST_F(ProgramCacheTest, rejectsOperandsOutsideTheirFrame)
+{
+    // add reads base from main's frame, helper is declared in add and only callable from there
+    std::string source = "{ int base = 3; int add(int n) { int helper(int m) { return m + base; } return helper(n); } print(add(4)); }";
+    Program program = compile(source);
+    uint64_t hash = ProgramCache::hashSource(source.data(), source.size());
+    Program* untouched = ProgramCache::deserialize(hash, ProgramCache::serialize(hash, program));
+    ASSERT_NE(untouched, nullptr);
+    delete untouched;
+
+    // Every entry below has a valid checksum, only the program in it is wrong
+    auto rejected = [&](const Program& tampered) {
+        Program* loaded = ProgramCache::deserialize(hash, ProgramCache::serialize(hash, tampered));
+        bool wasRejected = loaded == nullptr;
+        delete loaded;
+        return wasRejected;
+    };
+
+    bool sawLocal = false, sawOuter = false, sawCall = false;
+    for (size_t pc = 0; pc < program.code.size(); pc++) {
+        Program tampered = program;
+        Instruction& instruction = tampered.code[pc];
+
+        // The function pc belongs to
+        size_t function = 0;
+        while (function + 1 < program.functions.size() && program.functions[function + 1].entry <= pc) {
+            function++;
+        }
+
+        if (instruction.op == OpCode::LOAD_LOCAL || instruction.op == OpCode::STORE_LOCAL) {
+            instruction.operand = program.functions[function].numSlots;
+            EXPECT_TRUE(rejected(tampered)) << pc;
+            sawLocal = true;
+        } else if (instruction.op == OpCode::LOAD_OUTER || instruction.op == OpCode::STORE_OUTER) {
+            // base is in main's frame, one slot past its end
+            instruction.operand = (instruction.operand & ~0xFFFF) | program.functions[0].numSlots;
+            EXPECT_TRUE(rejected(tampered)) << pc;
+            sawOuter = true;
+        } else if (instruction.op == OpCode::CALL && function == 0) {
+            // Calling helper from main would leave add's level of the display unset
+            instruction.operand = 2;
+            ASSERT_EQ(program.functions[2].name, "helper");
+            EXPECT_TRUE(rejected(tampered)) << pc;
+            sawCall = true;
+        }
+    }
+
+    EXPECT_TRUE(sawLocal && sawOuter && sawCall);
+}
+
+TEST_F(ProgramCacheTest, rejectsUnbalancedStacks)
+{
+    Program program = compile(sourceCode);
+    uint64_t hash = ProgramCache::hashSource(sourceCode.data(), sourceCode.size());
+
+    // Every entry below has a valid checksum and operands in range, only the stack is off
+    auto rejected = [&](const Program& tampered) {
+        Program* loaded = ProgramCache::deserialize(hash, ProgramCache::serialize(hash, tampered));
+        bool wasRejected = loaded == nullptr;
+        delete loaded;
+        return wasRejected;
+    };
+
+    // Claims less stack than main uses, the VM would only reserve that much
+    Program shallow = program;
+    shallow.functions[0].maxStackDepth--;
+    EXPECT_TRUE(rejected(shallow));
+
+    // square is laid out last, without its returns it runs off the end of the code
+    Program fallsOff = program;
+    ASSERT_EQ(fallsOff.functions.size(), 2u);
+    for (size_t pc = fallsOff.functions[1].entry; pc < fallsOff.code.size(); pc++) {
+        if (fallsOff.code[pc].op == OpCode::RETURN) {
+            fallsOff.code[pc].op = OpCode::POP;
+        }
+    }
+    EXPECT_TRUE(rejected(fallsOff));
+
+    bool sawLoop = false, sawHalt = false;
+    for (size_t pc = 0; pc < program.code.size(); pc++) {
+        Program tampered = program;
+        Instruction& instruction = tampered.code[pc];
+
+        if (instruction.op == OpCode::STORE_LOCAL && program.code[pc + 1].op == OpCode::LOOP) {
+            // The increment leaves i and pushes it again, so the loop comes back around two values deeper
+            instruction.op = OpCode::LOAD_LOCAL;
+            EXPECT_TRUE(rejected(tampered)) << pc;
+            sawLoop = true;
+        } else if (instruction.op == OpCode::HALT) {
+            // main would run on into square
+            instruction.op = OpCode::POP;
+            EXPECT_TRUE(rejected(tampered)) << pc;
+            sawHalt = true;
+        }
+    }
+
+    EXPECT_TRUE(sawLoop && sawHalt);
+}
+
+TEST_F(ProgramCacheTest, hashesSourceInPieces)
+{
+    uint64_t whole = ProgramCache::hashSource(sourceCode.data(), sourceCode.size());
+    uint64_t pieces = ProgramCache::hashSource(sourceCode.data(), 7);
+    pieces = ProgramCache::hashSource(sourceCode.data() + 7, sourceCode.size() - 7, pieces);
+
+    EXPECT_EQ(pieces, whole);
+    EXPECT_NE(ProgramCache::hashSource(sourceCode.data(), sourceCode.size() - 1), whole);
+}
+
+TEST_F(ProgramCacheTest, loadsAcrossInstances)
+{
+    MemoryProgramCacheStorage storage;
+    Program program = compile(sourceCode);
+
+    {
+        ProgramCache cache(storage);
+        EXPECT_EQ(cache.load(sourceCode.data(), sourceCode.size()), nullptr);
+        EXPECT_TRUE(cache.store(sourceCode.data(), sourceCode.size(), program));
+    }
+
+    // Like after a reboot, only the storage is left
+    ProgramCache cache(storage);
+    Program* loaded = cache.load(sourceCode.data(), sourceCode.size());
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(loaded->code.size(), program.code.size());
+    delete loaded;
+
+    std::string otherSource = sourceCode + " ";
+    EXPECT_EQ(cache.load(otherSource.data(), otherSource.size()), nullptr);
+}
+
+TEST_F(ProgramCacheTest, fileStorage)
+{
+    FileProgramCacheStorage storage(::testing::TempDir());
+    Program program = compile(sourceCode);
+
+    ProgramCache writer(storage);
+    ASSERT_TRUE(writer.store(sourceCode.data(), sourceCode.size(), program));
+
+    FileProgramCacheStorage reopened(::testing::TempDir());
+    ProgramCache reader(reopened);
+    Program* loaded = reader.load(sourceCode.data(), sourceCode.size());
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(run(loaded), run(new Program(program)));
+
+    FileProgramCacheStorage missing("/nonexistent/directory");
+    std::string entry;
+    EXPECT_FALSE(missing.read(0, entry));
+    EXPECT_FALSE(missing.write(0, "entry"));
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include "tokenizer.hpp"
+#include "ast.hpp"
+#include "resolver.hpp"
+#include "builtins.hpp"
+
+static BlockNode* parse(const std::string& sourceCode, OutputStream& outputStream, ErrorHandler& errorHandler) {
+    Tokenizer tokenizer(sourceCode);
+    const std::vector<Token> tokens = tokenizer.tokenize();
+
+    Parser parser(tokens, outputStream, errorHandler);
+    return parser.parseProgram();
+}
+
+TEST(ResolverTest, resolveNestedBlocks)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    BlockNode* block = parse("{ int a = 1; float b = 2.0; while (a) { int c = a; b = c; } }", outputStream, errorHandler);
+    ASSERT_NE(block, nullptr);
+
+    Resolver resolver(outputStream, errorHandler);
+    ASSERT_TRUE(resolver.resolve(*block));
+
+    const ArenaArray<ASTNode*>& statements = block->getStatements();
+    ASSERT_EQ(statements.size(), 3);
+    EXPECT_EQ(block->getFrameSize(), 2);
+
+    VariableDeclarationNode* b = (VariableDeclarationNode*)statements[1];
+    EXPECT_EQ(b->getLocation().slot, 1);
+    EXPECT_EQ(b->getLocation().type, ValueType::FLOAT);
+
+    BlockNode* body = ((WhileNode*)statements[2])->getBody();
+    EXPECT_EQ(body->getFrameSize(), 1);
+
+    // int c = a; reads a one frame out
+    VariableDeclarationNode* c = (VariableDeclarationNode*)body->getStatements()[0];
+    VariableAccessNode* a = (VariableAccessNode*)c->getInitializer();
+    EXPECT_EQ(c->getLocation().slot, 0);
+    EXPECT_EQ(a->getLocation().depth, 1);
+    EXPECT_EQ(a->getLocation().slot, 0);
+    EXPECT_EQ(a->getLocation().type, ValueType::INTEGER);
+
+    // b = c; writes b one frame out
+    AssignmentNode* assignment = (AssignmentNode*)body->getStatements()[1];
+    EXPECT_EQ(assignment->getLocation().depth, 1);
+    EXPECT_EQ(assignment->getLocation().slot, 1);
+    EXPECT_EQ(assignment->getLocation().type, ValueType::FLOAT);
+}
+
+TEST(ResolverTest, resolveForLoopInEnclosingFrame)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    // Both loops may use i, each gets its own slot in the program's frame
+    BlockNode* block = parse("{ for (int i = 0; i < 2; i = i + 1) { } for (int i = 0; i < 2; i = i + 1) { int x = i; } }", outputStream, errorHandler);
+    ASSERT_NE(block, nullptr);
+
+    Resolver resolver(outputStream, errorHandler);
+    ASSERT_TRUE(resolver.resolve(*block));
+
+    EXPECT_EQ(block->getFrameSize(), 2);
+
+    ForNode* second = (ForNode*)block->getStatements()[1];
+    EXPECT_EQ(((VariableDeclarationNode*)second->getInitializer())->getLocation().slot, 1);
+
+    VariableDeclarationNode* x = (VariableDeclarationNode*)second->getBody()->getStatements()[0];
+    EXPECT_EQ(((VariableAccessNode*)x->getInitializer())->getLocation().depth, 1);
+    EXPECT_EQ(((VariableAccessNode*)x->getInitializer())->getLocation().slot, 1);
+}
+
+TEST(ResolverTest, resolveFunctionCallTarget)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    BlockNode* block = parse("{ int twice(int n) { return n * 2; } if (1) { print(twice(2)); } }", outputStream, errorHandler);
+    ASSERT_NE(block, nullptr);
+
+    Resolver resolver(outputStream, errorHandler);
+    ASSERT_TRUE(resolver.resolve(*block));
+
+    FunctionDeclarationNode* twice = (FunctionDeclarationNode*)block->getStatements()[0];
+    EXPECT_EQ(twice->getBody()->getFrameSize(), 1);
+    ASSERT_EQ(twice->getParameterValueTypes().size(), 1);
+    EXPECT_EQ(twice->getParameterValueTypes()[0], ValueType::INTEGER);
+
+    IfNode* ifStatement = (IfNode*)block->getStatements()[1];
+    FunctionCallNode* print = (FunctionCallNode*)ifStatement->getBodies()[0]->getStatements()[0];
+    FunctionCallNode* call = (FunctionCallNode*)print->getArguments()[0];
+
+    // Builtins were tied to their table entry by the Parser
+    ASSERT_NE(print->getBuiltin(), nullptr);
+    EXPECT_EQ(print->getBuiltin()->id, Builtin::PRINT_INT);
+    EXPECT_FALSE(print->getBuiltin()->pure);
+    EXPECT_EQ(call->getBuiltin(), nullptr);
+
+    // Builtins stay unresolved, user functions know how many frames out they were declared
+    EXPECT_EQ(print->getTarget(), nullptr);
+    EXPECT_EQ(call->getTarget(), twice);
+    EXPECT_EQ(call->getTargetDepth(), 1);
+}
+
+TEST(ResolverTest, insertConversions)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    BlockNode* block = parse("{ float f = 1; int i = 2.5; print(i + f); while (f) { i = sqrt(i); } }", outputStream, errorHandler);
+    ASSERT_NE(block, nullptr);
+
+    Resolver resolver(outputStream, errorHandler);
+    ASSERT_TRUE(resolver.resolve(*block));
+
+    const ArenaArray<ASTNode*>& statements = block->getStatements();
+
+    ConversionNode* toFloat = (ConversionNode*)((VariableDeclarationNode*)statements[0])->getInitializer();
+    ASSERT_EQ(toFloat->getNodeType(), ASTNodeType::CONVERSION_NODE);
+    EXPECT_EQ(toFloat->getConversion(), Conversion::INT_TO_FLOAT);
+    EXPECT_EQ(toFloat->getValueType(), ValueType::FLOAT);
+
+    ConversionNode* toInt = (ConversionNode*)((VariableDeclarationNode*)statements[1])->getInitializer();
+    ASSERT_EQ(toInt->getNodeType(), ASTNodeType::CONVERSION_NODE);
+    EXPECT_EQ(toInt->getConversion(), Conversion::FLOAT_TO_INT);
+
+    // Only the int operand of a mixed operation is converted
+    BinaryOperationNode* sum = (BinaryOperationNode*)((FunctionCallNode*)statements[2])->getArguments()[0];
+    EXPECT_EQ(sum->getValueType(), ValueType::FLOAT);
+    EXPECT_EQ(sum->getLeftExpression()->getNodeType(), ASTNodeType::CONVERSION_NODE);
+    EXPECT_EQ(sum->getRightExpression()->getNodeType(), ASTNodeType::VARIABLE_ACCESS_NODE);
+
+    WhileNode* loop = (WhileNode*)statements[3];
+    EXPECT_EQ(((ConversionNode*)loop->getExpression())->getConversion(), Conversion::FLOAT_TO_TRUTH);
+
+    // sqrt takes a float and returns one, which is converted back for i
+    AssignmentNode* assignment = (AssignmentNode*)loop->getBody()->getStatements()[0];
+    ConversionNode* result = (ConversionNode*)assignment->getExpression();
+    ASSERT_EQ(result->getNodeType(), ASTNodeType::CONVERSION_NODE);
+    EXPECT_EQ(result->getConversion(), Conversion::FLOAT_TO_INT);
+    FunctionCallNode* call = (FunctionCallNode*)result->getExpression();
+    EXPECT_EQ(((ConversionNode*)call->getArguments()[0])->getConversion(), Conversion::INT_TO_FLOAT);
+
+    // Resolving again finds everything already converted
+    ASSERT_TRUE(resolver.resolve(*block));
+    EXPECT_EQ(((VariableDeclarationNode*)statements[0])->getInitializer(), toFloat);
+    EXPECT_EQ(toFloat->getExpression()->getNodeType(), ASTNodeType::NUMBER_NODE);
+}
+
+TEST(ResolverTest, resolveErrors)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+
+    std::vector<std::string> programs = {
+        "{ x = 1; }",
+        "{ int x = y; }",
+        "{ int x = 1; if (x) { float x = 2.0; } }",
+        "{ int y = 1; void f() { int y = 2; } }",
+        "{ int print = 1; }",
+        "{ missing(); }",
+        "{ int f(int a) { return a; } f(1, 2); }",
+        "{ int f(int a) { return a; } f(); }",
+        "{ void g() { } g(1); }",
+        "{ wait(1.5); }",
+        "{ float_to_int(1); }",
+        "{ print(1, 2); }",
+        "{ int x = rand(1); }",
+    };
+
+    for (const std::string& program : programs) {
+        errorHandler.resetStopExecution();
+
+        BlockNode* block = parse(program, outputStream, errorHandler);
+        ASSERT_NE(block, nullptr) << program;
+
+        Resolver resolver(outputStream, errorHandler);
+        EXPECT_FALSE(resolver.resolve(*block)) << program;
+        EXPECT_TRUE(errorHandler.shouldStopExecution()) << program;
+    }
+
+    errorHandler.resetStopExecution();
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "tokenizer.hpp"
+#include "ast.hpp"
+#include "scriptStream.hpp"
+#include "testOutputStream.hpp"
+
+static BlockNode* stream(ScriptStream& scriptStream, const std::string& sourceCode, size_t chunkSize) {
+    for (size_t i = 0; i < sourceCode.size(); i += chunkSize) {
+        scriptStream.feed(sourceCode.data() + i, std::min(chunkSize, sourceCode.size() - i));
+    }
+    return scriptStream.finish();
+}
+
+TEST(ScriptStreamTest, streamMatchesWholeParse)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    std::string sourceCode = "{ int x = -5; void f() { print(x * 1.5); } if (x > 2) { f(); } else if (x) { x = 0; } else { x = 1; } "
+                             "for (int i = 0; i < 3; i = i + 1) { while (x < i) { x = x + 1; } } print(x); }";
+
+    Tokenizer tokenizer(sourceCode);
+    const std::vector<Token> tokens = tokenizer.tokenize();
+    Parser parser(tokens, outputStream, errorHandler);
+    BlockNode* whole = parser.parseProgram();
+    ASSERT_NE(whole, nullptr);
+
+    for (size_t chunkSize = 1; chunkSize <= sourceCode.size(); chunkSize++) {
+        ScriptStream scriptStream(outputStream, errorHandler);
+        BlockNode* block = stream(scriptStream, sourceCode, chunkSize);
+
+        ASSERT_NE(block, nullptr) << chunkSize;
+        EXPECT_EQ(block->toString(), whole->toString()) << chunkSize;
+        EXPECT_EQ(scriptStream.getTokenCount(), tokens.size()) << chunkSize;
+    }
+}
+
+TEST(ScriptStreamTest, parseBeforeLastChunk)
+{
+    StandardOutputStream outputStream;
+    ErrorHandler errorHandler(outputStream);
+    errorHandler.resetStopExecution();
+
+    ScriptStream scriptStream(outputStream, errorHandler);
+
+    scriptStream.feed("{ int x = 1; if (x) { x = 2; }", 30);
+    EXPECT_EQ(scriptStream.getStatementCount(), 1);
+
+    // The if is only complete once it is clear no else follows
+    scriptStream.feed(" print(x)", 9);
+    EXPECT_EQ(scriptStream.getStatementCount(), 2);
+
+    scriptStream.feed("; }", 3);
+    EXPECT_EQ(scriptStream.getStatementCount(), 3);
+
+    BlockNode* block = scriptStream.finish();
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(block->getStatements().size(), 3);
+    EXPECT_EQ(scriptStream.getSource(), "{ int x = 1; if (x) { x = 2; } print(x); }");
+}
+
+TEST(ScriptStreamTest, streamErrors)
+{
+    // Broken anywhere, a streamed program is rejected just like a whole one
+    std::vector<std::string> programs = {
+        "{ int x = 1; x = ; print(x); }",
+        "{ int x = (1 + 2; }",
+        "{ int x = 1; } }",
+        "{ while (1) { x = 1; }",
+        "int x = 1;",
+        "{ else { } }",
+        "{ print(1) }",
+    };
+
+    for (const std::string& program : programs) {
+        for (size_t chunkSize = 1; chunkSize <= program.size(); chunkSize++) {
+            CapturingOutputStream outputStream;
+            ErrorHandler errorHandler(outputStream);
+            errorHandler.resetStopExecution();
+
+            ScriptStream scriptStream(outputStream, errorHandler);
+            EXPECT_EQ(stream(scriptStream, program, chunkSize), nullptr) << program << " " << chunkSize;
+            EXPECT_TRUE(errorHandler.shouldStopExecution()) << program;
+            EXPECT_NE(outputStream.output.find("Syntax Error"), std::string::npos) << program;
+        }
+    }
+
+    StandardOutputStream outputStream;
+    ErrorHandler(outputStream).resetStopExecution();
+}
@@ -0,0 +1,41 @@
+// Shared by the tests that check what a program prints or reports
+
+#ifndef TEST_OUTPUT_STREAM_HPP
+#define TEST_OUTPUT_STREAM_HPP
+
+#include <gtest/gtest.h>
+#include <string>
+
+#include "error.hpp"
+#include "outputStream.hpp"
+
+/**
+ * @brief Collects everything written to it, instead of redirecting std::cout
+ *
+ */
+class CapturingOutputStream : public OutputStream {
+   public:
+    void write(const std::string& message) override { output += message; }
+    std::string output;
+};
+
+/**
+ * @brief A fixture whose ErrorHandler writes to a CapturingOutputStream
+ *
+ * The stop flag is cleared before and after each test, so an error in one test does not stop the next.
+ * Base is ::testing::Test, or ::testing::TestWithParam<T> for a parameterized fixture.
+ *
+ * Ex. class VMTest : public CapturingTest<> {};
+ *
+ */
+template <typename Base = ::testing::Test>
+class CapturingTest : public Base {
+   protected:
+    CapturingOutputStream outputStream;
+    ErrorHandler errorHandler{outputStream};
+
+    void SetUp() override { errorHandler.resetStopExecution(); }
+    void TearDown() override { errorHandler.resetStopExecution(); }
+};
+
+#endif  // TEST_OUTPUT_STREAM_HPP
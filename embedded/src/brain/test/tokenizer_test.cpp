@@ -564,3 +564,113 @@ TEST(TokenizerTest, TestEmptySourceCode) {
 
     EXPECT_EQ(tokens.size(), 0);
 }
+
+TEST(TokenizerTest, TestIdentifiersAreInterned) {
+    std::string sourceCode = "int count = count + other;";
+    Tokenizer tokenizer(sourceCode);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    ASSERT_EQ(tokens.size(), 7);
+
+    // The same name gets the same symbol, a different name a different one
+    EXPECT_NE(tokens[1].symbol, NO_SYMBOL);
+    EXPECT_EQ(tokens[1].symbol, tokens[3].symbol);
+    EXPECT_NE(tokens[1].symbol, tokens[5].symbol);
+    EXPECT_EQ(symbolTable.name(tokens[1].symbol), "count");
+
+    // Only identifiers carry a symbol
+    EXPECT_EQ(tokens[0].symbol, NO_SYMBOL);
+    EXPECT_EQ(tokens[2].symbol, NO_SYMBOL);
+}
+
+TEST(TokenizerTest, TestBorrowedSource) {
+    std::string sourceCode = "while (x >= -1.5) { returned = x && y; }";
+    Tokenizer tokenizer(sourceCode.data(), sourceCode.size());
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    ASSERT_EQ(tokens.size(), 14);
+
+    // Lexemes point into the borrowed source, at their offsets
+    for (const Token& token : tokens) {
+        EXPECT_EQ(token.lexeme.data(), sourceCode.data() + token.offset);
+    }
+
+    EXPECT_EQ(tokens[0].type, TokenType::KEYWORD);
+    EXPECT_EQ(tokens[3].type, TokenType::OPERATOR);
+    EXPECT_EQ(tokens[3].lexeme, ">=");
+    EXPECT_EQ(tokens[4].type, TokenType::FLOAT);
+    EXPECT_EQ(tokens[4].lexeme, "-1.5");
+    EXPECT_EQ(tokens[4].offset, 12);
+
+    // Starting with a keyword does not make it one
+    EXPECT_EQ(tokens[7].type, TokenType::IDENTIFIER);
+    EXPECT_EQ(tokens[7].lexeme, "returned");
+    EXPECT_EQ(tokens[10].lexeme, "&&");
+}
+
+TEST(TokenizerTest, TestKeywordsAndOperators) {
+    const char* keywords[] = {"int", "float", "string", "if", "while", "for", "break", "continue", "else", "return", "void"};
+    for (const char* keyword : keywords) {
+        EXPECT_TRUE(Tokenizer::isKeyword(keyword)) << keyword;
+    }
+    EXPECT_FALSE(Tokenizer::isKeyword("iff"));
+    EXPECT_FALSE(Tokenizer::isKeyword("Int"));
+
+    EXPECT_EQ(Tokenizer::operatorLength('!', '='), 2);
+    EXPECT_EQ(Tokenizer::operatorLength('!', 'x'), 1);
+    EXPECT_EQ(Tokenizer::operatorLength('|', '|'), 2);
+    EXPECT_EQ(Tokenizer::operatorLength('&', ' '), 0);
+    EXPECT_EQ(Tokenizer::operatorLength(';', ' '), 0);
+}
+
+TEST(TokenizerTest, TestLocations) {
+    std::string sourceCode = "{\n  int x = 5; // five\n\n\tprint(x);\n}";
+    Tokenizer tokenizer(sourceCode);
+    std::vector<Token> tokens = tokenizer.tokenize();
+
+    ASSERT_EQ(tokens.size(), 12);
+    EXPECT_EQ(tokens[0].location.line, 1);
+    EXPECT_EQ(tokens[0].location.column, 1);
+
+    // int
+    EXPECT_EQ(tokens[1].location.line, 2);
+    EXPECT_EQ(tokens[1].location.column, 3);
+
+    // 5
+    EXPECT_EQ(tokens[4].location.line, 2);
+    EXPECT_EQ(tokens[4].location.column, 11);
+
+    // print, columns count bytes so the tab is one
+    EXPECT_EQ(tokens[6].location.line, 4);
+    EXPECT_EQ(tokens[6].location.column, 2);
+
+    EXPECT_EQ(tokens[11].location.line, 5);
+    EXPECT_EQ(tokens[11].location.column, 1);
+}
+
+TEST(TokenizerTest, TestStreamedChunks) {
+    // Every chunk boundary lands inside some lexeme, comment or lookahead at least once
+    std::string sourceCode = "{ int whilex = -12; // x - 1.5\nfloat y=.5*-3.25; if (y>=whilex&&1) { y = y-1; } }";
+    Tokenizer whole(sourceCode);
+    std::vector<Token> expected = whole.tokenize();
+
+    for (size_t chunkSize = 1; chunkSize <= sourceCode.size(); chunkSize++) {
+        Tokenizer tokenizer;
+        for (size_t i = 0; i < sourceCode.size(); i += chunkSize) {
+            tokenizer.feed(sourceCode.data() + i, std::min(chunkSize, sourceCode.size() - i));
+        }
+        tokenizer.finish();
+
+        const std::vector<Token>& tokens = tokenizer.getTokens();
+        ASSERT_EQ(tokens.size(), expected.size()) << chunkSize;
+        for (size_t i = 0; i < tokens.size(); i++) {
+            EXPECT_EQ(tokens[i].type, expected[i].type) << chunkSize;
+            EXPECT_EQ(tokens[i].lexeme, expected[i].lexeme) << chunkSize;
+            EXPECT_EQ(tokens[i].symbol, expected[i].symbol) << chunkSize;
+            EXPECT_EQ(tokens[i].offset, expected[i].offset) << chunkSize;
+            EXPECT_EQ(tokens[i].location.line, expected[i].location.line) << chunkSize;
+            EXPECT_EQ(tokens[i].location.column, expected[i].location.column) << chunkSize;
+        }
+        EXPECT_EQ(tokenizer.getSource(), sourceCode);
+    }
+}
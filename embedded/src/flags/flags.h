@@ -9,6 +9,7 @@ extern "C" {
 
 #define PRINT_FLAG "__P__"         // Printing to web console
 #define ERROR_FLAG "__ER__"        // Printing error to web console
+#define PROFILE_FLAG "__PF__"      // Printing a profile of the running script to web console
 #define SEND_SCRIPT_FLAG "__SD__"  // Sending script to ESP32
 #define SENT_SCRIPT_FLAG "__SS__"  // Acknowledging that the script has been sent to the ESP32
 #define QUERY_FLAG "__Q__"         // Brain is querying for peripherals